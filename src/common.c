@@ -22,6 +22,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -1458,8 +1459,24 @@ size_t
 ly_strlen_utf8(const char *str)
 {
     size_t clen, len;
-    const char *ptr;
+    const char *ptr, *end;
+    uint64_t word;
+
+    clen = strlen(str);
+    end = str + clen;
+    for (len = 0, ptr = str; *ptr && len < clen; ) {
+        if ((size_t)(end - ptr) >= sizeof word) {
+            /* skip 8 ASCII characters at once */
+            memcpy(&word, ptr, sizeof word);
+            if (!(word & 0x8080808080808080ULL)) {
+                len += sizeof word;
+                ptr += sizeof word;
+                continue;
+            }
+        }
 
-    for (len = 0, clen = strlen(str), ptr = str; *ptr && len < clen; ++len, ptr += UTF8LEN(*ptr));
+        ++len;
+        ptr += UTF8LEN(*ptr);
+    }
     return len;
 }
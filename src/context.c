@@ -15,6 +15,7 @@
 #define _GNU_SOURCE
 #include <pthread.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
@@ -69,6 +70,23 @@ static struct internal_modules_s {
     {"ietf-yang-library", IETF_YANG_LIB_REV, (const char*)ietf_yang_library_2019_01_04_yin, 1, LYS_IN_YIN}
 };
 
+/**
+ * @brief Get the index of the internal modules snapshot for the context options affecting them.
+ */
+#define LY_INTERNAL_SNAPSHOT_IDX(options) ((((options) & LY_CTX_NOYANGLIBRARY) ? 1 : 0) \
+                                           | (((options) & LY_CTX_ALLIMPLEMENTED) ? 2 : 0))
+#define LY_INTERNAL_SNAPSHOT_COUNT 4
+
+/*
+ * snapshots of the parsed internal modules created once per process and loaded into every
+ * new context instead of parsing the modules again, never changed once created
+ */
+static struct {
+    char *data;
+    size_t len;
+} internal_snapshots[LY_INTERNAL_SNAPSHOT_COUNT];
+static pthread_mutex_t internal_snapshots_lock = PTHREAD_MUTEX_INITIALIZER;
+
 API unsigned int
 ly_ctx_internal_modules_count(struct ly_ctx *ctx)
 {
@@ -80,17 +98,93 @@ ly_ctx_internal_modules_count(struct ly_ctx *ctx)
     return ctx->internal_module_count;
 }
 
-API struct ly_ctx *
-ly_ctx_new(const char *search_dir, int options)
+/**
+ * @brief Key of a module lookup in the context module indexes.
+ */
+struct ctx_modules_key {
+    const char *value;
+    size_t len;
+};
+
+/**
+ * @brief Hash table callback for the context module indexes. Values are always compared
+ * when modifying the index, otherwise \p val1_p is the lookup key.
+ */
+static int
+ctx_modules_equal(void *val1_p, void *val2_p, int mod, const char *val2)
 {
-    FUN_IN;
+    struct ctx_modules_key *key;
+
+    if (mod) {
+        return *(struct lys_module **)val1_p == *(struct lys_module **)val2_p;
+    }
+
+    key = val1_p;
+    return !strncmp(val2, key->value, key->len) && !val2[key->len];
+}
+
+static int
+ctx_modules_name_equal(void *val1_p, void *val2_p, int mod, void *UNUSED(cb_data))
+{
+    return ctx_modules_equal(val1_p, val2_p, mod, (*(struct lys_module **)val2_p)->name);
+}
+
+static int
+ctx_modules_ns_equal(void *val1_p, void *val2_p, int mod, void *UNUSED(cb_data))
+{
+    return ctx_modules_equal(val1_p, val2_p, mod, (*(struct lys_module **)val2_p)->ns);
+}
+
+static uint32_t
+ctx_modules_hash(const char *value, size_t len)
+{
+    return dict_hash_multi(dict_hash_multi(0, value, len), NULL, len);
+}
+
+int
+ctx_modules_index_add(struct lys_module *module)
+{
+    struct ly_modules_list *models = &module->ctx->models;
+    uint32_t hash;
+
+    lys_child_index_clear(module->ctx);
 
+    hash = ctx_modules_hash(module->name, strlen(module->name));
+    if (lyht_insert(models->name_ht, &module, hash, NULL) == -1) {
+        return -1;
+    }
+    if (lyht_insert(models->ns_ht, &module, ctx_modules_hash(module->ns, strlen(module->ns)), NULL) == -1) {
+        lyht_remove(models->name_ht, &module, hash);
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+ctx_modules_index_remove(struct lys_module *module)
+{
+    struct ly_modules_list *models = &module->ctx->models;
+
+    lys_child_index_clear(module->ctx);
+    lyht_remove(models->name_ht, &module, ctx_modules_hash(module->name, strlen(module->name)));
+    lyht_remove(models->ns_ht, &module, ctx_modules_hash(module->ns, strlen(module->ns)));
+}
+
+/**
+ * @brief Create a context without any modules.
+ *
+ * @param[in] search_dir Search directories separated by ':', NULL if none.
+ * @param[in] options Context options.
+ * @return Empty context, NULL on error.
+ */
+static struct ly_ctx *
+ly_ctx_new_empty(const char *search_dir, int options)
+{
     struct ly_ctx *ctx = NULL;
-    struct lys_module *module;
     char *search_dir_list;
     char *sep, *dir;
     int rc = EXIT_SUCCESS;
-    int i;
 
     ctx = calloc(1, sizeof *ctx);
     LY_CHECK_ERR_RETURN(!ctx, LOGMEM(NULL), NULL);
@@ -98,6 +192,12 @@ ly_ctx_new(const char *search_dir, int options)
     /* dictionary */
     lydict_init(&ctx->dict);
 
+    /* data journals */
+    pthread_mutex_init(&ctx->journal_lock, NULL);
+
+    /* schema child indexes */
+    pthread_rwlock_init(&ctx->schema_index_lock, NULL);
+
     /* plugins */
     ly_load_plugins();
 
@@ -113,6 +213,10 @@ ly_ctx_new(const char *search_dir, int options)
     ctx->models.flags = options;
     ctx->models.used = 0;
     ctx->models.size = 16;
+    ctx->models.name_ht = lyht_new(16, sizeof(struct lys_module *), ctx_modules_name_equal, NULL, 1);
+    LY_CHECK_ERR_GOTO(!ctx->models.name_ht, LOGMEM(NULL), error);
+    ctx->models.ns_ht = lyht_new(16, sizeof(struct lys_module *), ctx_modules_ns_equal, NULL, 1);
+    LY_CHECK_ERR_GOTO(!ctx->models.ns_ht, LOGMEM(NULL), error);
     if (search_dir) {
         search_dir_list = strdup(search_dir);
         LY_CHECK_ERR_GOTO(!search_dir_list, LOGMEM(NULL), error);
@@ -132,8 +236,27 @@ ly_ctx_new(const char *search_dir, int options)
     }
     ctx->models.module_set_id = 1;
 
-    /* load internal modules */
-    if (options & LY_CTX_NOYANGLIBRARY) {
+    return ctx;
+
+error:
+    /* cleanup */
+    ly_ctx_destroy(ctx, NULL);
+    return NULL;
+}
+
+/**
+ * @brief Parse the internal modules into an empty context.
+ *
+ * @param[in] ctx Empty context.
+ * @return EXIT_SUCCESS or EXIT_FAILURE.
+ */
+static int
+ly_ctx_parse_internal_modules(struct ly_ctx *ctx)
+{
+    struct lys_module *module;
+    int i;
+
+    if (ctx->models.flags & LY_CTX_NOYANGLIBRARY) {
         ctx->internal_module_count = LY_INTERNAL_MODULE_COUNT - 2;
     } else {
         ctx->internal_module_count = LY_INTERNAL_MODULE_COUNT;
@@ -141,11 +264,72 @@ ly_ctx_new(const char *search_dir, int options)
     for (i = 0; i < ctx->internal_module_count; i++) {
         module = (struct lys_module *)lys_parse_mem(ctx, internal_modules[i].data, internal_modules[i].format);
         if (!module) {
-            goto error;
+            return EXIT_FAILURE;
         }
         module->implemented = internal_modules[i].implemented;
     }
 
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Get the snapshot of the internal modules, create it on first use.
+ *
+ * The internal modules are always taken from the context (they import only each other),
+ * so only #LY_CTX_NOYANGLIBRARY and #LY_CTX_ALLIMPLEMENTED options affect the result.
+ *
+ * @param[in] options Context options.
+ * @param[out] len Length of the snapshot.
+ * @return Snapshot data, NULL if it could not be created.
+ */
+static const char *
+ly_ctx_internal_snapshot(int options, size_t *len)
+{
+    struct ly_ctx *ctx;
+    int idx = LY_INTERNAL_SNAPSHOT_IDX(options);
+
+    pthread_mutex_lock(&internal_snapshots_lock);
+
+    if (!internal_snapshots[idx].data) {
+        ctx = ly_ctx_new_empty(NULL, (options & (LY_CTX_NOYANGLIBRARY | LY_CTX_ALLIMPLEMENTED)) | LY_CTX_DISABLE_SEARCHDIRS);
+        if (ctx && !ly_ctx_parse_internal_modules(ctx)) {
+            ctx_snapshot_print(ctx, &internal_snapshots[idx].data, &internal_snapshots[idx].len);
+        }
+        ly_ctx_destroy(ctx, NULL);
+    }
+
+    *len = internal_snapshots[idx].len;
+
+    pthread_mutex_unlock(&internal_snapshots_lock);
+    return internal_snapshots[idx].data;
+}
+
+API struct ly_ctx *
+ly_ctx_new(const char *search_dir, int options)
+{
+    FUN_IN;
+
+    struct ly_ctx *ctx = NULL;
+    const char *snapshot;
+    size_t len;
+
+    /* get the snapshot first, with static plugins, destroying its temporary context unloads all the plugins */
+    snapshot = ly_ctx_internal_snapshot(options, &len);
+
+    ctx = ly_ctx_new_empty(search_dir, options);
+    if (!ctx) {
+        return NULL;
+    }
+
+    /* load internal modules, parse them only if their snapshot is not available */
+    if (snapshot) {
+        if (ctx_snapshot_load(ctx, snapshot, len)) {
+            goto error;
+        }
+    } else if (ly_ctx_parse_internal_modules(ctx)) {
+        goto error;
+    }
+
     return ctx;
 
 error:
@@ -154,6 +338,94 @@ error:
     return NULL;
 }
 
+API struct ly_ctx *
+ly_ctx_new_snapshot(const char *search_dir, const char *path, int options)
+{
+    FUN_IN;
+
+    struct ly_ctx *ctx;
+    void *addr = NULL;
+    size_t length = 0;
+    int fd, r;
+
+    if (!path) {
+        LOGARG;
+        return NULL;
+    }
+
+    ctx = ly_ctx_new_empty(search_dir, options);
+    if (!ctx) {
+        return NULL;
+    }
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        LOGERR(ctx, LY_ESYS, "Opening file \"%s\" failed (%s).", path, strerror(errno));
+        goto error;
+    }
+    r = lyp_mmap(ctx, fd, 0, &length, &addr);
+    close(fd);
+    if (r) {
+        goto error;
+    } else if (!addr) {
+        LOGERR(ctx, LY_EINVAL, "Empty schema snapshot \"%s\".", path);
+        goto error;
+    }
+
+    r = ctx_snapshot_load(ctx, addr, length);
+    lyp_munmap(addr, length);
+    if (r) {
+        goto error;
+    }
+
+    /* the snapshot decides whether ietf-yang-library is present */
+    if (ctx->internal_module_count == LY_INTERNAL_MODULE_COUNT) {
+        ctx->models.flags &= ~LY_CTX_NOYANGLIBRARY;
+    } else {
+        ctx->models.flags |= LY_CTX_NOYANGLIBRARY;
+    }
+
+    return ctx;
+
+error:
+    ly_ctx_destroy(ctx, NULL);
+    return NULL;
+}
+
+API int
+ly_ctx_print_snapshot(const struct ly_ctx *ctx, const char *path)
+{
+    FUN_IN;
+
+    char *data;
+    size_t len, written;
+    FILE *f;
+
+    if (!ctx || !path) {
+        LOGARG;
+        return EXIT_FAILURE;
+    }
+
+    if (ctx_snapshot_print(ctx, &data, &len)) {
+        return EXIT_FAILURE;
+    }
+
+    f = fopen(path, "w");
+    if (!f) {
+        LOGERR(ctx, LY_ESYS, "Failed to open file \"%s\" (%s).", path, strerror(errno));
+        free(data);
+        return EXIT_FAILURE;
+    }
+    written = fwrite(data, 1, len, f);
+    free(data);
+    if ((fclose(f) == EOF) || (written != len)) {
+        LOGERR(ctx, LY_ESYS, "Failed to write schema snapshot into \"%s\".", path);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 static int
 ly_ctx_new_yl_legacy(struct ly_ctx *ctx, struct lyd_node *yltree)
 {
@@ -161,7 +433,7 @@ ly_ctx_new_yl_legacy(struct ly_ctx *ctx, struct lyd_node *yltree)
     struct lyd_node *module, *node;
     struct ly_set *set;
     const char *name, *revision;
-    struct ly_set features = {0, 0, {NULL}};
+    struct ly_set features = {0, 0, {NULL}, NULL};
     const struct lys_module *mod;
 
     set = lyd_find_path(yltree, "/ietf-yang-library:yang-library/modules-state/module");
@@ -218,7 +490,7 @@ ly_ctx_new_yl_common(const char *search_dir, const char *input, LYD_FORMAT forma
     unsigned int i, u;
     struct lyd_node *module, *node;
     const char *name, *revision;
-    struct ly_set features = {0, 0, {NULL}};
+    struct ly_set features = {0, 0, {NULL}, NULL};
     const struct lys_module *mod;
     struct lyd_node *yltree = NULL;
     struct ly_ctx *ctx = NULL;
@@ -537,6 +809,7 @@ ly_ctx_destroy(struct ly_ctx *ctx, void (*private_destructor)(const struct lys_n
         /* remove the applied deviations and augments */
         lys_sub_module_remove_devs_augs(ctx->models.list[ctx->models.used - 1]);
         /* remove the module */
+        ctx_modules_index_remove(ctx->models.list[ctx->models.used - 1]);
         lys_free(ctx->models.list[ctx->models.used - 1], private_destructor, 1, 0);
     }
     if (ctx->models.search_paths) {
@@ -546,11 +819,21 @@ ly_ctx_destroy(struct ly_ctx *ctx, void (*private_destructor)(const struct lys_n
         free(ctx->models.search_paths);
     }
     free(ctx->models.list);
+    lyht_free(ctx->models.name_ht);
+    lyht_free(ctx->models.ns_ht);
 
     /* clean the error list */
     ly_err_clean(ctx, 0);
     pthread_key_delete(ctx->errlist_key);
 
+    /* data journals, should have been freed already */
+    lyht_free(ctx->journals);
+    pthread_mutex_destroy(&ctx->journal_lock);
+
+    /* schema child indexes */
+    lys_child_index_clear(ctx);
+    pthread_rwlock_destroy(&ctx->schema_index_lock);
+
     /* dictionary */
     lydict_clean(&ctx->dict);
 
@@ -644,69 +927,60 @@ ly_ctx_get_submodule(const struct ly_ctx *ctx, const char *module, const char *r
 }
 
 static const struct lys_module *
-ly_ctx_get_module_by(const struct ly_ctx *ctx, const char *key, size_t key_len, int offset, const char *revision,
+ly_ctx_get_module_by(const struct ly_ctx *ctx, const char *key, size_t key_len, int by_ns, const char *revision,
                      int with_disabled, int implemented)
 {
-    int i;
-    char *val;
-    struct lys_module *result = NULL;
+    struct hash_table *ht;
+    struct ctx_modules_key lookup;
+    struct lys_module **mod_p, *mod, *result = NULL;
+    const char *val;
+    uint32_t hash;
 
     if (!ctx || !key) {
         LOGARG;
         return NULL;
     }
 
-    for (i = 0; i < ctx->models.used; i++) {
-        if (!with_disabled && ctx->models.list[i]->disabled) {
-            /* skip the disabled modules */
+    lookup.value = key;
+    lookup.len = key_len ? key_len : strlen(key);
+    hash = ctx_modules_hash(lookup.value, lookup.len);
+    ht = by_ns ? ctx->models.ns_ht : ctx->models.name_ht;
+
+    /* go through all the revisions of the module, other modules with the same hash are skipped */
+    if (lyht_find(ht, &lookup, hash, (void **)&mod_p)) {
+        return NULL;
+    }
+    do {
+        mod = *mod_p;
+        val = by_ns ? mod->ns : mod->name;
+        if (strncmp(val, lookup.value, lookup.len) || val[lookup.len]) {
             continue;
         }
-        /* use offset to get address of the pointer to string (char**), remember that offset is in
-         * bytes, so we have to cast the pointer to the module to (char*), finally, we want to have
-         * string not the pointer to string
-         */
-        val = *(char **)(((char *)ctx->models.list[i]) + offset);
-        if (!ctx->models.list[i] || (!key_len && strcmp(key, val)) || (key_len && (strncmp(key, val, key_len) || val[key_len]))) {
+        if (!with_disabled && mod->disabled) {
+            /* skip the disabled modules */
             continue;
         }
 
         if (!revision) {
-            /* compare revisons and remember the newest one */
-            if (result) {
-                if (!ctx->models.list[i]->rev_size) {
-                    /* the current have no revision, keep the previous with some revision */
-                    continue;
-                }
-                if (result->rev_size && strcmp(ctx->models.list[i]->rev[0].date, result->rev[0].date) < 0) {
-                    /* the previous found matching module has a newer revision */
-                    continue;
-                }
-            }
             if (implemented) {
-                if (ctx->models.list[i]->implemented) {
-                    /* we have the implemented revision */
-                    result = ctx->models.list[i];
-                    break;
-                } else {
-                    /* do not remember the result, we are supposed to return the implemented revision
-                     * not the newest one */
-                    continue;
+                if (mod->implemented) {
+                    /* there can be only a single implemented revision */
+                    return mod;
                 }
+                continue;
             }
 
-            /* remember the current match and search for newer version */
-            result = ctx->models.list[i];
-        } else {
-            if (ctx->models.list[i]->rev_size && !strcmp(revision, ctx->models.list[i]->rev[0].date)) {
-                /* matching revision */
-                result = ctx->models.list[i];
-                break;
+            /* remember the newest revision, a module without revision only if there is nothing else */
+            if (!result || (mod->rev_size && (!result->rev_size || (strcmp(mod->rev[0].date, result->rev[0].date) >= 0)))) {
+                result = mod;
             }
+        } else if (mod->rev_size && !strcmp(revision, mod->rev[0].date)) {
+            /* matching revision */
+            return mod;
         }
-    }
+    } while (!lyht_find_next(ht, mod_p, hash, (void **)&mod_p));
 
     return result;
-
 }
 
 API const struct lys_module *
@@ -714,7 +988,7 @@ ly_ctx_get_module_by_ns(const struct ly_ctx *ctx, const char *ns, const char *re
 {
     FUN_IN;
 
-    return ly_ctx_get_module_by(ctx, ns, 0, offsetof(struct lys_module, ns), revision, 0, implemented);
+    return ly_ctx_get_module_by(ctx, ns, 0, 1, revision, 0, implemented);
 }
 
 API const struct lys_module *
@@ -722,13 +996,13 @@ ly_ctx_get_module(const struct ly_ctx *ctx, const char *name, const char *revisi
 {
     FUN_IN;
 
-    return ly_ctx_get_module_by(ctx, name, 0, offsetof(struct lys_module, name), revision, 0, implemented);
+    return ly_ctx_get_module_by(ctx, name, 0, 0, revision, 0, implemented);
 }
 
 const struct lys_module *
 ly_ctx_nget_module(const struct ly_ctx *ctx, const char *name, size_t name_len, const char *revision, int implemented)
 {
-    return ly_ctx_get_module_by(ctx, name, name_len, offsetof(struct lys_module, name), revision, 0, implemented);
+    return ly_ctx_get_module_by(ctx, name, name_len, 0, revision, 0, implemented);
 }
 
 API const struct lys_module *
@@ -1560,6 +1834,9 @@ imported:
     }
     ctx->models.used = o + 1;
     ctx->models.module_set_id++;
+    for (u = 0; u < mods->number; u++) {
+        ctx_modules_index_remove((struct lys_module *)mods->set.g[u]);
+    }
 
     /* maintain backlinks (start with internal ietf-yang-library which have leafs as possible targets of leafrefs */
     ctx_modules_undo_backlinks(ctx, mods);
@@ -1590,6 +1867,7 @@ ly_ctx_clean(struct ly_ctx *ctx, void (*private_destructor)(const struct lys_nod
         /* remove the applied deviations and augments */
         lys_sub_module_remove_devs_augs(ctx->models.list[ctx->models.used - 1]);
         /* remove the module */
+        ctx_modules_index_remove(ctx->models.list[ctx->models.used - 1]);
         lys_free(ctx->models.list[ctx->models.used - 1], private_destructor, 1, 0);
         /* clean it for safer future use */
         ctx->models.list[ctx->models.used - 1] = NULL;
@@ -35,6 +35,9 @@ struct ly_modules_list {
     uint8_t parsed_submodules_count;
     uint16_t module_set_id;
     int flags; /* see @ref contextoptions. */
+    /* all the modules in list indexed by their name and namespace (struct lys_module *) */
+    struct hash_table *name_ht;
+    struct hash_table *ns_ht;
 };
 
 struct ly_ctx {
@@ -49,6 +52,75 @@ struct ly_ctx {
 #endif
     pthread_key_t errlist_key;
     uint8_t internal_module_count;
+    struct hash_table *journals;     /* top-level nodes of the data trees with a journal, created on demand, read
+                                        without journal_lock only atomically */
+    pthread_mutex_t journal_lock;
+    struct hash_table *schema_index; /* indexes of the schema node children, created on demand (see lys_child_find()) */
+    pthread_rwlock_t schema_index_lock;
 };
 
+/**
+ * @brief Add a module into the context module indexes, must be called whenever
+ * a module is added into the context modules list.
+ *
+ * @param[in] module Module to add.
+ * @return 0 on success, -1 on error.
+ */
+int ctx_modules_index_add(struct lys_module *module);
+
+/**
+ * @brief Remove a module from the context module indexes, must be called whenever
+ * a module is removed from the context modules list.
+ *
+ * @param[in] module Module to remove.
+ */
+void ctx_modules_index_remove(struct lys_module *module);
+
+/**
+ * @brief Align the size of a binary snapshot section.
+ */
+#define LYSNAP_ALIGN(size) (((size) + 7) & ~((size_t)7))
+
+/**
+ * @brief Header of a binary snapshot, followed by the aligned uint32_t sizes of all the objects
+ * and the other sections (see snapshot.c).
+ */
+struct lysnap_hdr {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t layout;
+    uint32_t obj_count;
+    uint32_t rel_count;
+    uint32_t mod_count;
+    uint32_t str_count;
+    uint32_t str_size;
+    uint32_t module_set_id;
+    uint32_t internal_module_count;
+    uint64_t obj_size;              /**< size of the objects section */
+};
+
+/**
+ * @brief Store all the modules of a context into a binary snapshot.
+ *
+ * The snapshot uses the native byte order and structure layout so it can be loaded only
+ * by the same libyang build on the same architecture.
+ *
+ * @param[in] ctx Context to store.
+ * @param[out] data Allocated snapshot.
+ * @param[out] len Length of \p data.
+ * @return 0 on success, -1 on error.
+ */
+int ctx_snapshot_print(const struct ly_ctx *ctx, char **data, size_t *len);
+
+/**
+ * @brief Load all the modules from a binary snapshot into a context.
+ *
+ * @param[in] ctx Context without any modules.
+ * @param[in] data Snapshot created by ctx_snapshot_print(), it is not referenced after the function returns.
+ * @param[in] len Length of \p data.
+ * @return 0 on success, -1 on error.
+ */
+int ctx_snapshot_load(struct ly_ctx *ctx, const char *data, size_t len);
+
 #endif /* LY_CONTEXT_H_ */
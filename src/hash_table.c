@@ -48,49 +48,57 @@ lydict_val_eq(void *val1_p, void *val2_p, int UNUSED(mod), void *cb_data)
 void
 lydict_init(struct dict_table *dict)
 {
+    unsigned int i;
+
     if (!dict) {
         LOGARG;
         return;
     }
 
-    dict->hash_tab = lyht_new(1024, sizeof(struct dict_rec), lydict_val_eq, NULL, 1);
-    LY_CHECK_ERR_RETURN(!dict->hash_tab, LOGINT(NULL), );
-    pthread_mutex_init(&dict->lock, NULL);
+    for (i = 0; i < LYDICT_SHARD_COUNT; ++i) {
+        dict->shards[i].hash_tab = lyht_new(LYDICT_SHARD_SIZE, sizeof(struct dict_rec), lydict_val_eq, NULL, 1);
+        LY_CHECK_ERR_RETURN(!dict->shards[i].hash_tab, LOGINT(NULL), );
+        pthread_mutex_init(&dict->shards[i].lock, NULL);
+    }
 }
 
 void
 lydict_clean(struct dict_table *dict)
 {
-    unsigned int i;
+    unsigned int i, j;
     struct dict_rec *dict_rec  = NULL;
     struct ht_rec *rec = NULL;
+    struct hash_table *ht;
 
     if (!dict) {
         LOGARG;
         return;
     }
 
-    for (i = 0; i < dict->hash_tab->size; i++) {
-        /* get ith record */
-        rec = (struct ht_rec *)&dict->hash_tab->recs[i * dict->hash_tab->rec_size];
-        if (rec->hits == 1) {
-            /*
-             * this should not happen, all records inserted into
-             * dictionary are supposed to be removed using lydict_remove()
-             * before calling lydict_clean()
-             */
-            dict_rec  = (struct dict_rec *)rec->val;
-            LOGWRN(NULL, "String \"%s\" not freed from the dictionary, refcount %d", dict_rec->value, dict_rec->refcount);
-            /* if record wasn't removed before free string allocated for that record */
+    for (j = 0; j < LYDICT_SHARD_COUNT; ++j) {
+        ht = dict->shards[j].hash_tab;
+        for (i = 0; i < ht->size; i++) {
+            /* get ith record */
+            rec = (struct ht_rec *)&ht->recs[i * ht->rec_size];
+            if (rec->hits == 1) {
+                /*
+                 * this should not happen, all records inserted into
+                 * dictionary are supposed to be removed using lydict_remove()
+                 * before calling lydict_clean()
+                 */
+                dict_rec  = (struct dict_rec *)rec->val;
+                LOGWRN(NULL, "String \"%s\" not freed from the dictionary, refcount %d", dict_rec->value, dict_rec->refcount);
+                /* if record wasn't removed before free string allocated for that record */
 #ifdef NDEBUG
-            free(dict_rec->value);
+                free(dict_rec->value);
 #endif
+            }
         }
-    }
 
-    /* free table and destroy mutex */
-    lyht_free(dict->hash_tab);
-    pthread_mutex_destroy(&dict->lock);
+        /* free table and destroy mutex */
+        lyht_free(ht);
+        pthread_mutex_destroy(&dict->shards[j].lock);
+    }
 }
 
 /*
@@ -179,6 +187,7 @@ lydict_remove(struct ly_ctx *ctx, const char *value)
     int ret;
     uint32_t hash;
     struct dict_rec rec, *match = NULL;
+    struct dict_shard *shard;
     char *val_p;
 
     if (!value || !ctx) {
@@ -187,16 +196,17 @@ lydict_remove(struct ly_ctx *ctx, const char *value)
 
     len = strlen(value);
     hash = dict_hash(value, len);
+    shard = &ctx->dict.shards[LYDICT_SHARD_IDX(hash)];
 
     /* create record for lyht_find call */
     rec.value = (char *)value;
     rec.refcount = 0;
 
-    pthread_mutex_lock(&ctx->dict.lock);
+    pthread_mutex_lock(&shard->lock);
     /* set len as data for compare callback */
-    lyht_set_cb_data(ctx->dict.hash_tab, (void *)&len);
+    lyht_set_cb_data(shard->hash_tab, (void *)&len);
     /* check if value is already inserted */
-    ret = lyht_find(ctx->dict.hash_tab, &rec, hash, (void **)&match);
+    ret = lyht_find(shard->hash_tab, &rec, hash, (void **)&match);
 
     if (ret == 0) {
         LY_CHECK_ERR_GOTO(!match, LOGINT(ctx), finish);
@@ -210,34 +220,34 @@ lydict_remove(struct ly_ctx *ctx, const char *value)
              * free it after it is removed from hash table
              */
             val_p = match->value;
-            ret = lyht_remove_with_resize_cb(ctx->dict.hash_tab, &rec, hash, lydict_resize_val_eq);
+            ret = lyht_remove_with_resize_cb(shard->hash_tab, &rec, hash, lydict_resize_val_eq);
             free(val_p);
             LY_CHECK_ERR_GOTO(ret, LOGINT(ctx), finish);
         }
     }
 
 finish:
-    pthread_mutex_unlock(&ctx->dict.lock);
+    pthread_mutex_unlock(&shard->lock);
 }
 
+/* the shard of the dictionary must be locked */
 static char *
-dict_insert(struct ly_ctx *ctx, char *value, size_t len, int zerocopy)
+dict_insert(struct ly_ctx *ctx, struct dict_shard *shard, char *value, size_t len, uint32_t hash, uint32_t refs,
+            int zerocopy)
 {
     struct dict_rec *match = NULL, rec;
     int ret = 0;
-    uint32_t hash;
 
-    hash = dict_hash(value, len);
     /* set len as data for compare callback */
-    lyht_set_cb_data(ctx->dict.hash_tab, (void *)&len);
+    lyht_set_cb_data(shard->hash_tab, (void *)&len);
     /* create record for lyht_insert */
     rec.value = value;
-    rec.refcount = 1;
+    rec.refcount = refs;
 
-    LOGDBG(LY_LDGDICT, "inserting \"%s\"", rec.value);
-    ret = lyht_insert_with_resize_cb(ctx->dict.hash_tab, (void *)&rec, hash, lydict_resize_val_eq, (void **)&match);
+    LOGDBG(LY_LDGDICT, "inserting \"%.*s\"", (int)len, rec.value);
+    ret = lyht_insert_with_resize_cb(shard->hash_tab, (void *)&rec, hash, lydict_resize_val_eq, (void **)&match);
     if (ret == 1) {
-        match->refcount++;
+        match->refcount += refs;
         if (zerocopy) {
             free(value);
         }
@@ -267,6 +277,8 @@ lydict_insert(struct ly_ctx *ctx, const char *value, size_t len)
     FUN_IN;
 
     const char *result;
+    struct dict_shard *shard;
+    uint32_t hash;
 
     if (!value) {
         return NULL;
@@ -276,9 +288,13 @@ lydict_insert(struct ly_ctx *ctx, const char *value, size_t len)
         len = strlen(value);
     }
 
-    pthread_mutex_lock(&ctx->dict.lock);
-    result = dict_insert(ctx, (char *)value, len, 0);
-    pthread_mutex_unlock(&ctx->dict.lock);
+    /* the hash is computed before locking, it selects the shard */
+    hash = dict_hash(value, len);
+    shard = &ctx->dict.shards[LYDICT_SHARD_IDX(hash)];
+
+    pthread_mutex_lock(&shard->lock);
+    result = dict_insert(ctx, shard, (char *)value, len, hash, 1, 0);
+    pthread_mutex_unlock(&shard->lock);
 
     return result;
 }
@@ -289,14 +305,40 @@ lydict_insert_zc(struct ly_ctx *ctx, char *value)
     FUN_IN;
 
     const char *result;
+    struct dict_shard *shard;
+    uint32_t hash;
+    size_t len;
 
     if (!value) {
         return NULL;
     }
 
-    pthread_mutex_lock(&ctx->dict.lock);
-    result = dict_insert(ctx, value, strlen(value), 1);
-    pthread_mutex_unlock(&ctx->dict.lock);
+    len = strlen(value);
+    hash = dict_hash(value, len);
+    shard = &ctx->dict.shards[LYDICT_SHARD_IDX(hash)];
+
+    pthread_mutex_lock(&shard->lock);
+    result = dict_insert(ctx, shard, value, len, hash, 1, 1);
+    pthread_mutex_unlock(&shard->lock);
+
+    return result;
+}
+
+const char *
+lydict_insert_refs(struct ly_ctx *ctx, const char *value, size_t len, uint32_t refs)
+{
+    const char *result;
+    struct dict_shard *shard;
+    uint32_t hash;
+
+    assert(value && refs);
+
+    hash = dict_hash(value, len);
+    shard = &ctx->dict.shards[LYDICT_SHARD_IDX(hash)];
+
+    pthread_mutex_lock(&shard->lock);
+    result = dict_insert(ctx, shard, (char *)value, len, hash, refs, 0);
+    pthread_mutex_unlock(&shard->lock);
 
     return result;
 }
@@ -426,10 +468,12 @@ lyht_resize(struct hash_table *ht, int enlarge)
     return 0;
 }
 
-/* return: 0 - hash found, returned its record,
+/* move: whether the found record can be moved to a previous invalid record, never for lookups
+ *       so that concurrent readers of the hash table do not modify it
+ * return: 0 - hash found, returned its record,
  *         1 - hash not found, returned the record where it would be inserted */
 static int
-lyht_find_first(struct hash_table *ht, uint32_t hash, struct ht_rec **rec_p)
+lyht_find_first(struct hash_table *ht, uint32_t hash, int move, struct ht_rec **rec_p)
 {
     struct ht_rec *rec, *inval_rec = NULL;
     uint32_t i, idx;
@@ -471,7 +515,7 @@ lyht_find_first(struct hash_table *ht, uint32_t hash, struct ht_rec **rec_p)
 
     /* we have found a record with equal (shortened) hash,
      * move it to the first invalid record so that the next search is faster */
-    if (inval_rec) {
+    if (move && inval_rec) {
         memcpy(inval_rec, rec, ht->rec_size);
         rec->hits = -1;
         rec = inval_rec;
@@ -488,11 +532,12 @@ lyht_find_first(struct hash_table *ht, uint32_t hash, struct ht_rec **rec_p)
  * @param[in] ht Hash table to search in.
  * @param[in,out] last Last returned collision record.
  * @param[in] first First collision record (hits > 1).
+ * @param[in] move Whether the found collision can be moved to a previous invalid record.
  * @return 0 when hash collision found, \p last points to this next collision,
  *         1 when hash collision not found, \p last points to the record where it would be inserted.
  */
 static int
-lyht_find_collision(struct hash_table *ht, struct ht_rec **last, struct ht_rec *first)
+lyht_find_collision(struct hash_table *ht, struct ht_rec **last, struct ht_rec *first, int move)
 {
     struct ht_rec *inval_rec = NULL;
     uint32_t i, idx;
@@ -521,7 +566,7 @@ lyht_find_collision(struct hash_table *ht, struct ht_rec **last, struct ht_rec *
     if ((*last)->hits > 0) {
         /* we found a collision, so move it to the first invalid record so the next search is faster */
         assert((*last)->hits == 1);
-        if (inval_rec) {
+        if (move && inval_rec) {
             memcpy(inval_rec, *last, ht->rec_size);
             (*last)->hits = -1;
             *last = inval_rec;
@@ -537,17 +582,17 @@ lyht_find_collision(struct hash_table *ht, struct ht_rec **last, struct ht_rec *
 }
 
 int
-lyht_find(struct hash_table *ht, void *val_p, uint32_t hash, void **match_p)
+lyht_find_with_val_cb(struct hash_table *ht, void *val_p, uint32_t hash, values_equal_cb val_equal, void **match_p)
 {
     struct ht_rec *rec, *crec;
     uint32_t i, c;
     int r;
 
-    if (lyht_find_first(ht, hash, &rec)) {
+    if (lyht_find_first(ht, hash, 0, &rec)) {
         /* not found */
         return 1;
     }
-    if ((rec->hash == hash) && ht->val_equal(val_p, &rec->val, 0, ht->cb_data)) {
+    if ((rec->hash == hash) && val_equal(val_p, &rec->val, 0, ht->cb_data)) {
         /* even the value matches */
         if (match_p) {
             *match_p = rec->val;
@@ -559,12 +604,12 @@ lyht_find(struct hash_table *ht, void *val_p, uint32_t hash, void **match_p)
     crec = rec;
     c = rec->hits;
     for (i = 1; i < c; ++i) {
-        r = lyht_find_collision(ht, &rec, crec);
+        r = lyht_find_collision(ht, &rec, crec, 0);
         assert(!r);
         (void)r;
 
         /* compare values */
-        if ((rec->hash == hash) && ht->val_equal(val_p, &rec->val, 0, ht->cb_data)) {
+        if ((rec->hash == hash) && val_equal(val_p, &rec->val, 0, ht->cb_data)) {
             if (match_p) {
                 *match_p = rec->val;
             }
@@ -576,6 +621,12 @@ lyht_find(struct hash_table *ht, void *val_p, uint32_t hash, void **match_p)
     return 1;
 }
 
+int
+lyht_find(struct hash_table *ht, void *val_p, uint32_t hash, void **match_p)
+{
+    return lyht_find_with_val_cb(ht, val_p, hash, ht->val_equal, match_p);
+}
+
 int
 lyht_find_next(struct hash_table *ht, void *val_p, uint32_t hash, void **match_p)
 {
@@ -583,7 +634,7 @@ lyht_find_next(struct hash_table *ht, void *val_p, uint32_t hash, void **match_p
     uint32_t i, c;
     int r, found = 0;
 
-    if (lyht_find_first(ht, hash, &rec)) {
+    if (lyht_find_first(ht, hash, 0, &rec)) {
         /* not found, cannot happen */
         assert(0);
     }
@@ -604,7 +655,7 @@ lyht_find_next(struct hash_table *ht, void *val_p, uint32_t hash, void **match_p
     crec = rec;
     c = rec->hits;
     for (i = 1; i < c; ++i) {
-        r = lyht_find_collision(ht, &rec, crec);
+        r = lyht_find_collision(ht, &rec, crec, 0);
         assert(!r);
         (void)r;
 
@@ -730,7 +781,7 @@ lyht_insert_with_resize_cb(struct hash_table *ht, void *val_p, uint32_t hash,
     lyht_dbgprint_ht(ht, "before");
     lyht_dbgprint_value(val_p, hash, ht->rec_size, "inserting");
 
-    if (!lyht_find_first(ht, hash, &rec)) {
+    if (!lyht_find_first(ht, hash, 1, &rec)) {
         /* we found matching shortened hash */
         if ((rec->hash == hash) && ht->val_equal(val_p, &rec->val, 1, ht->cb_data)) {
             /* even the value matches */
@@ -743,7 +794,7 @@ lyht_insert_with_resize_cb(struct hash_table *ht, void *val_p, uint32_t hash,
         /* some collisions, we need to go through them, too */
         crec = rec;
         for (i = 1; i < crec->hits; ++i) {
-            r = lyht_find_collision(ht, &rec, crec);
+            r = lyht_find_collision(ht, &rec, crec, 1);
             assert(!r);
 
             /* compare values */
@@ -756,7 +807,7 @@ lyht_insert_with_resize_cb(struct hash_table *ht, void *val_p, uint32_t hash,
         }
 
         /* value not found, get the record where it will be inserted */
-        r = lyht_find_collision(ht, &rec, crec);
+        r = lyht_find_collision(ht, &rec, crec, 1);
         assert(r);
     }
 
@@ -825,7 +876,7 @@ lyht_remove_with_resize_cb(struct hash_table *ht, void *val_p, uint32_t hash, va
     lyht_dbgprint_ht(ht, "before");
     lyht_dbgprint_value(val_p, hash, ht->rec_size, "removing");
 
-    if (lyht_find_first(ht, hash, &rec)) {
+    if (lyht_find_first(ht, hash, 1, &rec)) {
         /* hash not found */
         LOGDBG(LY_LDGHASH, "remove failed");
         return 1;
@@ -838,7 +889,7 @@ lyht_remove_with_resize_cb(struct hash_table *ht, void *val_p, uint32_t hash, va
     /* we always need to go through collisions */
     crec = rec;
     for (i = 1; i < crec->hits; ++i) {
-        r = lyht_find_collision(ht, &rec, crec);
+        r = lyht_find_collision(ht, &rec, crec, 1);
         assert(!r);
 
         /* compare values */
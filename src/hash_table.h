@@ -89,12 +89,35 @@ struct dict_rec {
     uint32_t refcount;
 } _PACKED;
 
+/** number of independently locked dictionary shards, must be power of 2 */
+#define LYDICT_SHARD_BITS 5
+#define LYDICT_SHARD_COUNT (1 << LYDICT_SHARD_BITS)
+
+/** starting size of the hash table of every dictionary shard */
+#define LYDICT_SHARD_SIZE 64
+
 /**
- * dictionary to store repeating strings
+ * @brief Get the dictionary shard index of a string hash.
+ *
+ * The highest bits are used so that the shard selection is independent
+ * of the (lowest) bits used for indexing the shard hash table.
  */
-struct dict_table {
+#define LYDICT_SHARD_IDX(hash) ((hash) >> (32 - LYDICT_SHARD_BITS))
+
+/**
+ * one part of the dictionary with its own lock, aligned to avoid false sharing between the locks
+ */
+struct dict_shard {
     struct hash_table *hash_tab;
     pthread_mutex_t lock;
+} __attribute__((aligned(64)));
+
+/**
+ * dictionary to store repeating strings, split into shards by the string hash
+ * so that threads working with different strings do not contend for a single lock
+ */
+struct dict_table {
+    struct dict_shard shards[LYDICT_SHARD_COUNT];
 };
 
 /**
@@ -111,6 +134,17 @@ void lydict_init(struct dict_table *dict);
  */
 void lydict_clean(struct dict_table *dict);
 
+/**
+ * @brief Insert a string into the dictionary adding several references at once.
+ *
+ * @param[in] ctx Context with the dictionary.
+ * @param[in] value String to insert, does not need to be terminated.
+ * @param[in] len Length of \p value.
+ * @param[in] refs Number of references to add, must not be 0.
+ * @return Pointer to the string in the dictionary, NULL on error.
+ */
+const char *lydict_insert_refs(struct ly_ctx *ctx, const char *value, size_t len, uint32_t refs);
+
 /**
  * @brief Get a specific record from a hash table.
  *
@@ -177,6 +211,20 @@ void lyht_free(struct hash_table *ht);
  */
 int lyht_find(struct hash_table *ht, void *val_p, uint32_t hash, void **match_p);
 
+/**
+ * @brief Find a value in a hash table. Same functionality as lyht_find()
+ * but allows to specify a different val equal callback so that the values can be searched for
+ * using a value of another type.
+ *
+ * @param[in] ht Hash table to search in.
+ * @param[in] val_p Pointer to the value to find, passed as the first argument of \p val_equal.
+ * @param[in] hash Hash of the stored value.
+ * @param[in] val_equal Val equal callback to use for this search.
+ * @param[out] match_p Pointer to the matching value, optional.
+ * @return 0 on success, 1 on not found.
+ */
+int lyht_find_with_val_cb(struct hash_table *ht, void *val_p, uint32_t hash, values_equal_cb val_equal, void **match_p);
+
 /**
  * @brief Find another equal value in the hash table.
  *
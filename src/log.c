@@ -1061,6 +1061,43 @@ ly_ilo_restore(struct ly_ctx *ctx, enum int_log_opts prev_ilo, struct ly_err_ite
     err_clean(ctx, prev_last_eitem, keep_and_print);
 }
 
+/**
+ * @brief Take all the error items of the current thread so that they can be moved to another thread.
+ */
+struct ly_err_item *
+ly_err_detach(const struct ly_ctx *ctx)
+{
+    struct ly_err_item *eitem;
+
+    eitem = pthread_getspecific(ctx->errlist_key);
+    pthread_setspecific(ctx->errlist_key, NULL);
+    return eitem;
+}
+
+/**
+ * @brief Append error items detached in another thread to the error items of the current thread.
+ */
+void
+ly_err_attach(const struct ly_ctx *ctx, struct ly_err_item *eitem)
+{
+    struct ly_err_item *first, *last;
+
+    if (!eitem) {
+        return;
+    }
+
+    first = pthread_getspecific(ctx->errlist_key);
+    if (!first) {
+        pthread_setspecific(ctx->errlist_key, eitem);
+        return;
+    }
+
+    last = eitem->prev;
+    first->prev->next = eitem;
+    eitem->prev = first->prev;
+    first->prev = last;
+}
+
 void
 ly_err_last_set_apptag(const struct ly_ctx *ctx, const char *apptag)
 {
@@ -21,12 +21,16 @@
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
+#include <poll.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <pcre.h>
 #include <time.h>
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
 
 #include "common.h"
 #include "context.h"
@@ -248,6 +252,110 @@ lyp_data_check_options(struct ly_ctx *ctx, int options, const char *func)
     return 0;
 }
 
+int
+lyp_data_clb_node(const struct lyd_parse_clb *clb, struct lyd_node *node, struct unres_data *unres)
+{
+    int r = 0;
+
+    if (node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST)) {
+        if (clb->leaf_value) {
+            r = clb->leaf_value((struct lyd_node_leaf_list *)node, clb->data);
+        }
+        lyd_free(node);
+    } else if (clb->subtree) {
+        r = clb->subtree(node, clb->data);
+    } else {
+        lyd_free(node);
+    }
+
+    /* the node is not a part of any data tree, so there is nothing to resolve the references against */
+    unres->count = 0;
+
+    return (r < 0) ? -1 : 0;
+}
+
+/* reads all the data from a file descriptor that cannot be mapped (pipe, socket) as they arrive, the memory
+ * is allocated by mmap() so that it can be freed by lyp_munmap() the same way as a file mapping */
+static int
+lyp_mmap_read(struct ly_ctx *ctx, int fd, size_t addsize, size_t *length, void **addr)
+{
+    struct pollfd pfd;
+    size_t pagesize, size = 0, alloc = 0, new_alloc;
+    char *buf = NULL;
+    void *mem;
+    ssize_t r;
+
+    pagesize = sysconf(_SC_PAGESIZE);
+    ++addsize;                       /* at least one additional byte for terminating NULL byte */
+
+    while (1) {
+        if (alloc - size < addsize + pagesize) {
+            /* make room for at least a page of data, the memory is zeroed */
+            new_alloc = alloc ? alloc * 2 : 16 * pagesize;
+            while (new_alloc - size < addsize + pagesize) {
+                new_alloc *= 2;
+            }
+#ifdef MREMAP_MAYMOVE
+            if (buf) {
+                mem = mremap(buf, alloc, new_alloc, MREMAP_MAYMOVE);
+            } else
+#endif
+            {
+                mem = mmap(NULL, new_alloc, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifndef MREMAP_MAYMOVE
+                if ((mem != MAP_FAILED) && buf) {
+                    memcpy(mem, buf, size);
+                    munmap(buf, alloc);
+                }
+#endif
+            }
+            if (mem == MAP_FAILED) {
+                LOGERR(ctx, LY_ESYS, "mmap() failed (%s).", strerror(errno));
+                goto error;
+            }
+            buf = mem;
+            alloc = new_alloc;
+        }
+
+        r = read(fd, buf + size, alloc - size - addsize);
+        if (r > 0) {
+            size += r;
+        } else if (!r) {
+            /* EOF */
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            /* non-blocking descriptor, wait for more data */
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            if ((poll(&pfd, 1, -1) == -1) && (errno != EINTR)) {
+                LOGERR(ctx, LY_ESYS, "Failed to poll the file descriptor (%s).", strerror(errno));
+                goto error;
+            }
+        } else {
+            LOGERR(ctx, LY_ESYS, "Failed to read the file descriptor (%s).", strerror(errno));
+            goto error;
+        }
+    }
+
+    if (!size) {
+        munmap(buf, alloc);
+        *addr = NULL;
+        return 0;
+    }
+
+    *length = alloc;
+    *addr = buf;
+    return 0;
+
+error:
+    if (buf) {
+        munmap(buf, alloc);
+    }
+    return 1;
+}
+
 int
 lyp_mmap(struct ly_ctx *ctx, int fd, size_t addsize, size_t *length, void **addr)
 {
@@ -261,8 +369,8 @@ lyp_mmap(struct ly_ctx *ctx, int fd, size_t addsize, size_t *length, void **addr
         return 1;
     }
     if (!S_ISREG(sb.st_mode)) {
-        LOGERR(ctx, LY_EINVAL, "File to mmap() is not a regular file.");
-        return 1;
+        /* pipe, socket, ... */
+        return lyp_mmap_read(ctx, fd, addsize, length, addr);
     }
     if (!sb.st_size) {
         *addr = NULL;
@@ -2106,7 +2214,7 @@ lyp_fill_attr(struct ly_ctx *ctx, struct lyd_node *parent, const char *module_ns
     }
 
     /* allocate and fill the data attribute structure */
-    dattr = calloc(1, sizeof *dattr);
+    dattr = lyd_attr_calloc(parent);
     LY_CHECK_ERR_RETURN(!dattr, LOGMEM(ctx), -1);
 
     dattr->parent = parent;
@@ -2122,7 +2230,7 @@ lyp_fill_attr(struct ly_ctx *ctx, struct lyd_node *parent, const char *module_ns
     if (!type || !lyp_parse_value(*type, &dattr->value_str, xml, NULL, dattr, NULL, 1, 0)) {
         lydict_remove(ctx, dattr->name);
         lydict_remove(ctx, dattr->value_str);
-        free(dattr);
+        lyd_attr_mem_free(dattr);
         return -1;
     }
 
@@ -3697,6 +3805,10 @@ lyp_ctx_add_module(struct lys_module *module)
         module->ctx->models.size *= 2;
         module->ctx->models.list = newlist;
     }
+    if (ctx_modules_index_add(module)) {
+        LOGMEM(module->ctx);
+        return -1;
+    }
     module->ctx->models.list[module->ctx->models.used++] = module;
     module->ctx->models.module_set_id++;
 
@@ -3836,6 +3948,74 @@ copyutf8(struct ly_ctx *ctx, char *dst, const char *src)
     }
 }
 
+#ifdef __SSE2__
+
+/* the aligned loads may read the bytes following the terminating NULL byte (in the same 16-byte block) */
+#if defined(__SANITIZE_ADDRESS__)
+__attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#   if __has_feature(address_sanitizer)
+__attribute__((no_sanitize_address))
+#   endif
+#endif
+unsigned int
+lyp_plain_len(const char *str, const char *special, unsigned int max)
+{
+    __m128i spec[LYP_PLAIN_SPECIAL_MAX], ctrl, block, stop;
+    const char *p;
+    unsigned int i, count, mask, len;
+
+    for (count = 0; special[count]; ++count) {
+        assert(count < LYP_PLAIN_SPECIAL_MAX);
+        spec[count] = _mm_set1_epi8(special[count]);
+    }
+    ctrl = _mm_set1_epi8(0x20);
+
+    /* aligned loads never cross a page boundary, so no unmapped memory after the string is ever touched */
+    p = (const char *)((uintptr_t)str & ~(uintptr_t)0xf);
+    mask = 0xffff << (str - p);
+    while (1) {
+        block = _mm_load_si128((const __m128i *)p);
+
+        /* as signed chars, all the non-ASCII bytes are negative, so they are caught together with the control
+         * characters and the terminating NULL byte */
+        stop = _mm_cmplt_epi8(block, ctrl);
+        for (i = 0; i < count; ++i) {
+            stop = _mm_or_si128(stop, _mm_cmpeq_epi8(block, spec[i]));
+        }
+
+        mask &= _mm_movemask_epi8(stop);
+        if (mask) {
+            len = p + __builtin_ctz(mask) - str;
+            break;
+        }
+
+        p += 16;
+        if ((unsigned int)(p - str) >= max) {
+            len = max;
+            break;
+        }
+        mask = 0xffff;
+    }
+
+    return (len < max) ? len : max;
+}
+
+#else
+
+unsigned int
+lyp_plain_len(const char *str, const char *special, unsigned int max)
+{
+    unsigned int len;
+
+    for (len = 0; (len < max) && ((unsigned char)str[len] >= 0x20) && ((unsigned char)str[len] < 0x80)
+            && !strchr(special, str[len]); ++len);
+
+    return len;
+}
+
+#endif
+
 const struct lys_module *
 lyp_get_module(const struct lys_module *module, const char *prefix, int pref_len, const char *name, int name_len, int in_data)
 {
@@ -41,7 +41,24 @@ struct lys_submodule *yin_read_submodule(struct lys_module *module, const char *
  * @defgroup xmldata XML data format support
  * @{
  */
-struct lyd_node *xml_read_data(struct ly_ctx *ctx, const char *data, int options);
+struct lyd_node *xml_read_data(struct ly_ctx *ctx, const char *data, int options, const struct lyd_node *rpc_act,
+                               const struct lyd_node *data_tree, const char *yang_data_name);
+int xml_read_data_clb(struct ly_ctx *ctx, const char *data, int options, const struct lyd_parse_clb *clb);
+
+/**
+ * @brief Parse a part of XML data with top-level elements into data trees without the final validation
+ * (defaults, unres, mandatory nodes and top-level instance checks), which is left for the caller.
+ *
+ * @param[in] ctx Context to use.
+ * @param[in] data Start of the part, the document beginning or a top-level element.
+ * @param[in] end End of the part (start of the next top-level element), NULL for the rest of the data.
+ * @param[in] options Parser options.
+ * @param[in] unres Unres structure to add the unresolved items into.
+ * @param[out] result First top-level node of the parsed data trees, NULL if none.
+ * @return EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int xml_read_data_part(struct ly_ctx *ctx, const char *data, const char *end, int options, struct unres_data *unres,
+                       struct lyd_node **result);
 
 /**@} xmldata */
 
@@ -51,6 +68,43 @@ struct lyd_node *xml_read_data(struct ly_ctx *ctx, const char *data, int options
  */
 struct lyd_node *lyd_parse_json(struct ly_ctx *ctx, const char *data, int options, const struct lyd_node *rpc_act,
                                 const struct lyd_node *data_tree, const char *yang_data_name);
+int lyd_parse_json_clb(struct ly_ctx *ctx, const char *data, int options, const struct lyd_parse_clb *clb);
+
+/**
+ * @brief Find the next top-level member in JSON data without parsing them.
+ *
+ * The returned position is never between a metadata (attribute) member and another member.
+ *
+ * @param[in] data JSON data at the top-level begin-object or a top-level value separator.
+ * @param[in] min Minimal position of the returned member.
+ * @return Value separator before the first top-level member at or after \p min, NULL if there is none
+ * or the data are invalid.
+ */
+const char *lyjson_next_member(const char *data, const char *min);
+
+/**
+ * @brief Check that all the top-level metadata (attribute) members in JSON data are adjacent to the members
+ * they belong to so that they are never split by lyjson_next_member().
+ *
+ * @param[in] data JSON data at the top-level begin-object.
+ * @return Whether all the metadata members are adjacent, 0 also if the data are invalid.
+ */
+int lyjson_attrs_adjacent(const char *data);
+
+/**
+ * @brief Parse a part of JSON data with top-level members into data trees without the final validation,
+ * see xml_read_data_part().
+ *
+ * @param[in] ctx Context to use.
+ * @param[in] data Start of the part, the top-level begin-object or a top-level value separator.
+ * @param[in] end End of the part (value separator before the next part), NULL for the rest of the data.
+ * @param[in] options Parser options.
+ * @param[in] unres Unres structure to add the unresolved items into.
+ * @param[out] result First top-level node of the parsed data trees, NULL if none.
+ * @return EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int lyd_parse_json_part(struct ly_ctx *ctx, const char *data, const char *end, int options, struct unres_data *unres,
+                        struct lyd_node **result);
 
 /**@} jsondata */
 
@@ -140,6 +194,16 @@ int lyp_is_rpc_action(struct lys_node *node);
  */
 int lyp_data_check_options(struct ly_ctx *ctx, int options, const char *func);
 
+/**
+ * @brief Pass a parsed terminal node or a subtree to the data parser callbacks, the node is always consumed.
+ *
+ * @param[in] clb Data parser callbacks.
+ * @param[in] node Parsed node with no parent.
+ * @param[in] unres Unresolved items of the parsed nodes, they are discarded.
+ * @return 0 on success, -1 if the parsing is supposed to stop.
+ */
+int lyp_data_clb_node(const struct lyd_parse_clb *clb, struct lyd_node *node, struct unres_data *unres);
+
 int lyp_check_identifier(struct ly_ctx *ctx, const char *id, enum LY_IDENT type, struct lys_module *module, struct lys_node *parent);
 int lyp_check_date(struct ly_ctx *ctx, const char *date);
 int lyp_check_mandatory_augment(struct lys_node_augment *node, const struct lys_node *target);
@@ -184,6 +248,8 @@ int lyp_add_ietf_netconf_annotations_config(struct lys_module *mod);
 /**
  * @brief mmap() wrapper for parsers. To unmap, use lyp_munmap().
  *
+ * File descriptors that cannot be mapped (pipes, sockets) are read until EOF into an anonymous mapping instead.
+ *
  * @param[in] prot The desired memory protection as in case of mmap().
  * @param[in] fd File descriptor for getting data.
  * @param[in] addsize Number of additional bytes to be allocated (and zeroed) after the implicitly added
@@ -213,6 +279,24 @@ int lyp_munmap(void *addr, size_t length);
 unsigned int pututf8(struct ly_ctx *ctx, char *dst, int32_t value);
 unsigned int copyutf8(struct ly_ctx *ctx, char *dst, const char *src);
 
+/**
+ * @brief Maximum number of special characters accepted by lyp_plain_len().
+ */
+#define LYP_PLAIN_SPECIAL_MAX 8
+
+/**
+ * @brief Get the length of the plain text at the beginning of a string, which can be copied as it is.
+ *
+ * The text ends with the first control character (including the terminating NULL byte), non-ASCII byte
+ * or any of the \p special characters. Uses SSE2 to check 16 bytes at once, if available.
+ *
+ * @param[in] str String to examine.
+ * @param[in] special Additional characters ending the plain text, at most #LYP_PLAIN_SPECIAL_MAX.
+ * @param[in] max Maximum length to return.
+ * @return Number of plain ASCII characters at the beginning of \p str, at most \p max.
+ */
+unsigned int lyp_plain_len(const char *str, const char *special, unsigned int max);
+
 /**
  * @brief Find a module. First, imports from \p module with matching \p prefix, \p name, or both are checked,
  * \p module itself is also compared, and lastly a callback is used if allowed.
@@ -155,6 +155,12 @@ lyjson_parse_text(struct ly_ctx *ctx, const char *data, unsigned int *len)
             /* control characters must be escaped */
             LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "control character (unescaped)");
             goto error;
+        } else if ((r = lyp_plain_len(&data[*len], "\"\\", BUFSIZE - o))) {
+            /* run of unescaped ASCII characters */
+            memcpy(&buf[o], &data[*len], r);
+
+            o += r - 1;     /* o is ++ in for loop */
+            (*len) += r;
         } else {
             /* unescaped character */
             r = copyutf8(ctx, &buf[o], &data[*len]);
@@ -419,34 +425,16 @@ json_get_anydata(struct lyd_node_anydata *any, const char *data)
     return len;
 }
 
+/* parses a single value of a leaf or a leaf-list instance, returns the length of the value (0 on error) */
 static unsigned int
-json_get_value(struct lyd_node_leaf_list *leaf, struct lyd_node **first_sibling, const char *data, int options,
-               struct unres_data *unres)
+json_get_leaf_value(struct lyd_node_leaf_list *leaf, const char *data)
 {
-    struct lyd_node_leaf_list *new;
-    struct lys_type *stype;
-    struct ly_ctx *ctx;
+    struct ly_ctx *ctx = leaf->schema->module->ctx;
     unsigned int len = 0, r;
     char *str;
 
-    assert(leaf && data);
-    ctx = leaf->schema->module->ctx;
-
-    stype = &((struct lys_node_leaf *)leaf->schema)->type;
-
-    if (leaf->schema->nodetype == LYS_LEAFLIST) {
-        /* expecting begin-array */
-        if (data[len++] != '[') {
-            LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_LYD, leaf, "JSON data (expected begin-array)");
-            return 0;
-        }
-
-repeat:
-        len += skip_ws(&data[len]);
-    }
-
     /* will be changed in case of union */
-    leaf->value_type = stype->base;
+    leaf->value_type = ((struct lys_node_leaf *)leaf->schema)->type.base;
 
     if (data[len] == '"') {
         /* string representations */
@@ -515,6 +503,37 @@ inval:
         return 0;
     }
 
+    return len;
+}
+
+static unsigned int
+json_get_value(struct lyd_node_leaf_list *leaf, struct lyd_node **first_sibling, const char *data, int options,
+               struct unres_data *unres)
+{
+    struct lyd_node_leaf_list *new;
+    struct ly_ctx *ctx;
+    unsigned int len = 0, r;
+
+    assert(leaf && data);
+    ctx = leaf->schema->module->ctx;
+
+    if (leaf->schema->nodetype == LYS_LEAFLIST) {
+        /* expecting begin-array */
+        if (data[len++] != '[') {
+            LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_LYD, leaf, "JSON data (expected begin-array)");
+            return 0;
+        }
+
+repeat:
+        len += skip_ws(&data[len]);
+    }
+
+    r = json_get_leaf_value(leaf, &data[len]);
+    if (!r) {
+        return 0;
+    }
+    len += r;
+
 #ifdef LY_ENABLED_CACHE
     /* calculate the hash and insert it into parent */
     lyd_hash((struct lyd_node *)leaf);
@@ -533,7 +552,7 @@ inval:
             }
 
             /* another instance of the leaf-list */
-            new = calloc(1, sizeof(struct lyd_node_leaf_list));
+            new = lyd_node_calloc(unres->arena, sizeof(struct lyd_node_leaf_list));
             LY_CHECK_ERR_RETURN(!new, LOGMEM(ctx), 0);
 
             new->parent = leaf->parent;
@@ -849,55 +868,47 @@ json_skip_unknown(struct ly_ctx *ctx, struct lyd_node *parent, const char *data,
     return 0;
 }
 
+/* parses the name of an object member up to its value, \p str is the name to be freed, \p prefix and \p name point
+ * into it, returns the length of the name with the name-separator (0 on error) */
 static unsigned int
-json_parse_data(struct ly_ctx *ctx, const char *data, const struct lys_node *schema_parent, struct lyd_node **parent,
-                struct lyd_node *first_sibling, struct lyd_node *prev, struct attr_cont **attrs, int options,
-                struct unres_data *unres, struct lyd_node **act_notif, const char *yang_data_name)
+json_get_name(struct ly_ctx *ctx, const char *data, struct lyd_node *parent, char **str, char **prefix, char **name)
 {
-    unsigned int len = 0;
-    unsigned int r;
-    unsigned int flag_leaflist = 0;
-    int i;
-    uint8_t pos;
-    char *name, *prefix = NULL, *str = NULL;
-    const struct lys_module *module = NULL;
-    struct lys_node *schema = NULL;
-    const struct lys_node *sparent = NULL;
-    struct lyd_node *result = NULL, *new, *list, *diter = NULL;
-    struct lyd_attr *attr;
-    struct attr_cont *attrs_aux;
+    unsigned int len = 0, r;
+
+    *str = NULL;
+    *prefix = NULL;
 
     /* each YANG data node representation starts with string (node identifier) */
     if (data[len] != '"') {
-        LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_LYD, (*parent),
+        LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_LYD, parent,
                "JSON data (missing quotation-mark at the beginning of string)");
         return 0;
     }
     len++;
 
-    str = lyjson_parse_text(ctx, &data[len], &r);
-    if (!str) {
-        goto error;
+    *str = lyjson_parse_text(ctx, &data[len], &r);
+    if (!*str) {
+        return 0;
     }
 
     if (!r) {
-        goto error;
+        return 0;
     } else if (data[len + r] != '"') {
-        LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_LYD, (*parent),
+        LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_LYD, parent,
                "JSON data (missing quotation-mark at the end of string)");
-        goto error;
+        return 0;
     }
-    if ((name = strchr(str, ':'))) {
-        *name = '\0';
-        name++;
-        prefix = str;
-        if (prefix[0] == '@') {
-            prefix++;
+    if ((*name = strchr(*str, ':'))) {
+        **name = '\0';
+        (*name)++;
+        *prefix = *str;
+        if ((*prefix)[0] == '@') {
+            (*prefix)++;
         }
     } else {
-        name = str;
-        if (name[0] == '@') {
-            name++;
+        *name = *str;
+        if ((*name)[0] == '@') {
+            (*name)++;
         }
     }
 
@@ -905,46 +916,25 @@ json_parse_data(struct ly_ctx *ctx, const char *data, const struct lys_node *sch
     len += r + 1;
     len += skip_ws(&data[len]);
     if (data[len] != ':') {
-        LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_LYD, (*parent), "JSON data (missing name-separator)");
-        goto error;
+        LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_LYD, parent, "JSON data (missing name-separator)");
+        return 0;
     }
     len++;
     len += skip_ws(&data[len]);
 
-    if (str[0] == '@' && !str[1]) {
-        /* process attribute of the parent object (container or list) */
-        if (!(*parent)) {
-            LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "attribute with no corresponding element to belongs to");
-            goto error;
-        }
-
-        r = json_parse_attr((*parent)->schema->module, &attr, &data[len], options);
-        if (!r) {
-            LOGPATH(ctx, LY_VLOG_LYD, *parent);
-            goto error;
-        }
-        len += r;
-
-        if ((*parent)->attr) {
-            lyd_free_attr(ctx, NULL, attr, 1);
-        } else {
-            (*parent)->attr = attr;
-            for (; attr; attr = attr->next) {
-                attr->parent = *parent;
-            }
-        }
-
-        /* check edit-config attribute correctness */
-        if ((options & LYD_OPT_EDIT) && lyp_check_edit_attr(ctx, (*parent)->attr, *parent, NULL)) {
-            goto error;
-        }
+    return len;
+}
 
-        free(str);
-        return len;
-    }
+/* finds the schema node of an object member, \p sparent is NULL for top-level members */
+static struct lys_node *
+json_get_schema(struct ly_ctx *ctx, const char *prefix, const char *name, const struct lys_node *sparent, int options,
+                const char *yang_data_name)
+{
+    const struct lys_module *module = NULL;
+    struct lys_node *schema = NULL;
+    const struct lys_node *parent;
 
-    /* find schema node */
-    if (!(*parent)) {
+    if (!sparent) {
         /* starting in root */
         /* get the proper schema */
         module = ly_ctx_get_module(ctx, prefix, NULL, 0);
@@ -957,11 +947,10 @@ json_parse_data(struct ly_ctx *ctx, const char *data, const struct lys_node *sch
         }
         if (module && module->implemented) {
             if (yang_data_name) {
-                sparent = lyp_get_yang_data_template(module, yang_data_name, strlen(yang_data_name));
-                schema = NULL;
-                if (sparent) {
+                parent = lyp_get_yang_data_template(module, yang_data_name, strlen(yang_data_name));
+                if (parent) {
                     /* get the proper schema node */
-                    while ((schema = (struct lys_node *) lys_getnext(schema, sparent, module, 0))) {
+                    while ((schema = (struct lys_node *) lys_getnext(schema, parent, module, 0))) {
                         if (!strcmp(schema->name, name)) {
                             break;
                         }
@@ -969,58 +958,101 @@ json_parse_data(struct ly_ctx *ctx, const char *data, const struct lys_node *sch
                 }
             } else {
                 /* get the proper schema node */
-                while ((schema = (struct lys_node *) lys_getnext(schema, NULL, module, 0))) {
-                    if (!strcmp(schema->name, name)) {
-                        break;
-                    }
-                }
+                schema = (struct lys_node *)lys_child_find(NULL, module, NULL, NULL, name, strlen(name), 0);
             }
         }
-    } else {
-        if (prefix) {
-            /* get the proper module to give the chance to load/implement it */
-            module = ly_ctx_get_module(ctx, prefix, NULL, 1);
-            if (ctx->data_clb) {
-                if (!module) {
-                    ctx->data_clb(ctx, prefix, NULL, 0, ctx->data_clb_data);
-                } else if (!module->implemented) {
-                    ctx->data_clb(ctx, module->name, module->ns, LY_MODCLB_NOT_IMPLEMENTED, ctx->data_clb_data);
-                }
+        return schema;
+    }
+
+    if (prefix) {
+        /* get the proper module to give the chance to load/implement it */
+        module = ly_ctx_get_module(ctx, prefix, NULL, 1);
+        if (ctx->data_clb) {
+            if (!module) {
+                ctx->data_clb(ctx, prefix, NULL, 0, ctx->data_clb_data);
+            } else if (!module->implemented) {
+                ctx->data_clb(ctx, module->name, module->ns, LY_MODCLB_NOT_IMPLEMENTED, ctx->data_clb_data);
             }
         }
+    }
 
+    parent = sparent;
+    if (sparent->nodetype & (LYS_RPC | LYS_ACTION)) {
         /* go through RPC's input/output following the options' data type */
-        if ((*parent)->schema->nodetype == LYS_RPC || (*parent)->schema->nodetype == LYS_ACTION) {
-            while ((schema = (struct lys_node *)lys_getnext(schema, (*parent)->schema, NULL, LYS_GETNEXT_WITHINOUT))) {
-                if ((options & LYD_OPT_RPC) && (schema->nodetype == LYS_INPUT)) {
-                    break;
-                } else if ((options & LYD_OPT_RPCREPLY) && (schema->nodetype == LYS_OUTPUT)) {
-                    break;
-                }
+        while ((schema = (struct lys_node *)lys_getnext(schema, sparent, NULL, LYS_GETNEXT_WITHINOUT))) {
+            if ((options & LYD_OPT_RPC) && (schema->nodetype == LYS_INPUT)) {
+                break;
+            } else if ((options & LYD_OPT_RPCREPLY) && (schema->nodetype == LYS_OUTPUT)) {
+                break;
             }
-            schema_parent = schema;
-            schema = NULL;
         }
+        if (schema) {
+            parent = schema;
+        }
+        schema = NULL;
+    }
 
-        if (schema_parent) {
-            while ((schema = (struct lys_node *)lys_getnext(schema, schema_parent, NULL, 0))) {
-                if (!strcmp(schema->name, name)
-                        && ((prefix && !strcmp(lys_node_module(schema)->name, prefix))
-                        || (!prefix && (lys_node_module(schema) == lys_node_module(schema_parent))))) {
-                    break;
-                }
-            }
+    return (struct lys_node *)lys_child_find(parent, NULL, prefix ? prefix : lys_node_module(sparent)->name, NULL, name,
+                                             strlen(name), 0);
+}
+
+static unsigned int
+json_parse_data(struct ly_ctx *ctx, const char *data, struct lyd_node **parent, struct lyd_node *first_sibling,
+                struct lyd_node *prev, struct attr_cont **attrs, int options, struct unres_data *unres,
+                struct lyd_node **act_notif, const char *yang_data_name)
+{
+    unsigned int len = 0;
+    unsigned int r;
+    unsigned int flag_leaflist = 0;
+    int i;
+    uint8_t pos;
+    char *name, *prefix = NULL, *str = NULL;
+    const struct lys_module *module = NULL;
+    struct lys_node *schema = NULL;
+    struct lyd_node *result = NULL, *new, *list, *diter = NULL;
+    struct lyd_attr *attr;
+    struct attr_cont *attrs_aux;
+
+    len = json_get_name(ctx, data, *parent, &str, &prefix, &name);
+    if (!len) {
+        goto error;
+    }
+
+    if (str[0] == '@' && !str[1]) {
+        /* process attribute of the parent object (container or list) */
+        if (!(*parent)) {
+            LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "attribute with no corresponding element to belongs to");
+            goto error;
+        }
+
+        r = json_parse_attr((*parent)->schema->module, &attr, &data[len], options);
+        if (!r) {
+            LOGPATH(ctx, LY_VLOG_LYD, *parent);
+            goto error;
+        }
+        len += r;
+
+        if ((*parent)->attr) {
+            lyd_free_attr(ctx, NULL, attr, 1);
         } else {
-            while ((schema = (struct lys_node *)lys_getnext(schema, (*parent)->schema, NULL, 0))) {
-                if (!strcmp(schema->name, name)
-                        && ((prefix && !strcmp(lys_node_module(schema)->name, prefix))
-                        || (!prefix && (lys_node_module(schema) == lyd_node_module(*parent))))) {
-                    break;
-                }
+            (*parent)->attr = attr;
+            for (; attr; attr = attr->next) {
+                attr->parent = *parent;
             }
         }
+
+        /* check edit-config attribute correctness */
+        if ((options & LYD_OPT_EDIT) && lyp_check_edit_attr(ctx, (*parent)->attr, *parent, NULL)) {
+            goto error;
+        }
+
+        free(str);
+        return len;
     }
 
+    /* find schema node */
+    schema = json_get_schema(ctx, prefix, name, *parent ? (*parent)->schema : NULL, options, yang_data_name);
+
     module = lys_node_module(schema);
     if (!module || !module->implemented || module->disabled) {
         if (options & LYD_OPT_STRICT) {
@@ -1085,15 +1117,15 @@ attr_repeat:
     case LYS_NOTIF:
     case LYS_RPC:
     case LYS_ACTION:
-        result = calloc(1, sizeof *result);
+        result = lyd_node_calloc(unres->arena, sizeof *result);
         break;
     case LYS_LEAF:
     case LYS_LEAFLIST:
-        result = calloc(1, sizeof(struct lyd_node_leaf_list));
+        result = lyd_node_calloc(unres->arena, sizeof(struct lyd_node_leaf_list));
         break;
     case LYS_ANYXML:
     case LYS_ANYDATA:
-        result = calloc(1, sizeof(struct lyd_node_anydata));
+        result = lyd_node_calloc(unres->arena, sizeof(struct lyd_node_anydata));
         break;
     default:
         LOGINT(ctx);
@@ -1223,7 +1255,7 @@ attr_repeat:
                 len++;
                 len += skip_ws(&data[len]);
 
-                r = json_parse_data(ctx, &data[len], NULL, &result, result->child, diter, &attrs_aux, options, unres, act_notif, yang_data_name);
+                r = json_parse_data(ctx, &data[len], &result, result->child, diter, &attrs_aux, options, unres, act_notif, yang_data_name);
                 if (!r) {
                     goto error;
                 }
@@ -1275,7 +1307,7 @@ attr_repeat:
                 len++;
                 len += skip_ws(&data[len]);
 
-                r = json_parse_data(ctx, &data[len], NULL, &list, list->child, diter, &attrs_aux, options, unres, act_notif, yang_data_name);
+                r = json_parse_data(ctx, &data[len], &list, list->child, diter, &attrs_aux, options, unres, act_notif, yang_data_name);
                 if (!r) {
                     goto error;
                 }
@@ -1317,7 +1349,7 @@ attr_repeat:
                 }
 
                 /* another instance of the list */
-                new = calloc(1, sizeof *new);
+                new = lyd_node_calloc(unres->arena, sizeof *new);
                 LY_CHECK_ERR_GOTO(!new, LOGMEM(ctx), error);
                 new->parent = list->parent;
                 new->prev = list;
@@ -1427,6 +1459,10 @@ lyd_parse_json(struct ly_ctx *ctx, const char *data, int options, const struct l
 
     unres = calloc(1, sizeof *unres);
     LY_CHECK_ERR_RETURN(!unres, LOGMEM(ctx), NULL);
+    if (options & LYD_OPT_ARENA) {
+        unres->arena = lyd_arena_new();
+        LY_CHECK_ERR_RETURN(!unres->arena, LOGMEM(ctx); free(unres), NULL);
+    }
 
     /* create RPC/action reply part that is not in the parsed data */
     if (rpc_act) {
@@ -1480,7 +1516,7 @@ lyd_parse_json(struct ly_ctx *ctx, const char *data, int options, const struct l
             }
         }
 
-        r = json_parse_data(ctx, &data[len], NULL, &next, result, iter, &attrs, options, unres, &act_notif, yang_data_name);
+        r = json_parse_data(ctx, &data[len], &next, result, iter, &attrs, options, unres, &act_notif, yang_data_name);
         if (!r) {
             goto error;
         }
@@ -1586,6 +1622,7 @@ lyd_parse_json(struct ly_ctx *ctx, const char *data, int options, const struct l
 
     free(unres->node);
     free(unres->type);
+    lyd_arena_release(unres->arena);
     free(unres);
 
     return result;
@@ -1597,7 +1634,565 @@ error:
     }
     free(unres->node);
     free(unres->type);
+    lyd_arena_release(unres->arena);
     free(unres);
 
     return NULL;
 }
+
+/* whether the member starting after a begin-object or a value separator is metadata (attributes) */
+static int
+json_member_is_attr(const char *data)
+{
+    data += 1 + skip_ws(data + 1);
+    return !strncmp(data, "\"@", 2);
+}
+
+/* skip a string with any escaped characters starting after its opening quote, NULL if it is not terminated */
+static const char *
+json_skip_string(const char *c)
+{
+    for (; *(c += strcspn(c, "\"\\")) == '\\'; c += 2) {
+        LY_CHECK_RETURN(!c[1], NULL);
+    }
+    LY_CHECK_RETURN(!*c, NULL);
+    return c + 1;
+}
+
+const char *
+lyjson_next_member(const char *data, const char *min)
+{
+    const char *c = data + 1;
+    uint32_t depth = 1;
+    int attr, next_attr;
+
+    attr = json_member_is_attr(data);
+    while (1) {
+        c += strcspn(c, "\"{}[],");
+        switch (*c) {
+        case '"':
+            c = json_skip_string(c + 1);
+            LY_CHECK_RETURN(!c, NULL);
+            break;
+        case '{':
+        case '[':
+            ++depth;
+            ++c;
+            break;
+        case '}':
+        case ']':
+            if (!--depth) {
+                /* end of the top-level object */
+                return NULL;
+            }
+            ++c;
+            break;
+        case ',':
+            if (depth == 1) {
+                next_attr = json_member_is_attr(c);
+                if ((c >= min) && !attr && !next_attr) {
+                    return c;
+                }
+                attr = next_attr;
+            }
+            ++c;
+            break;
+        default:
+            /* unexpected end of data */
+            return NULL;
+        }
+    }
+}
+
+int
+lyjson_attrs_adjacent(const char *data)
+{
+    const char *c = data + 1, *name, *prev = NULL, *attr = NULL;
+    size_t name_len, prev_len = 0, attr_len = 0;
+    uint32_t depth = 1;
+    int key = 1;
+
+    while (1) {
+        c += strcspn(c, "\"{}[],");
+        switch (*c) {
+        case '"':
+            name = c + 1;
+            c = json_skip_string(name);
+            LY_CHECK_RETURN(!c, 0);
+            if ((depth > 1) || !key) {
+                break;
+            }
+
+            /* top-level member name */
+            key = 0;
+            name_len = c - 1 - name;
+            if (attr) {
+                /* the metadata of the previous member belong to this one */
+                if ((name_len != attr_len) || strncmp(name, attr, attr_len)) {
+                    return 0;
+                }
+                attr = NULL;
+            } else if ((name[0] == '@') && (!prev || (prev_len != name_len - 1) || strncmp(prev, name + 1, prev_len))) {
+                /* the metadata must belong to the next member */
+                attr = name + 1;
+                attr_len = name_len - 1;
+            }
+            prev = name;
+            prev_len = name_len;
+            break;
+        case '{':
+        case '[':
+            ++depth;
+            ++c;
+            break;
+        case '}':
+        case ']':
+            if (!--depth) {
+                /* end of the top-level object */
+                return !attr;
+            }
+            ++c;
+            break;
+        case ',':
+            if (depth == 1) {
+                key = 1;
+            }
+            ++c;
+            break;
+        default:
+            /* unexpected end of data */
+            return 0;
+        }
+    }
+}
+
+int
+lyd_parse_json_part(struct ly_ctx *ctx, const char *data, const char *end, int options, struct unres_data *unres,
+                    struct lyd_node **result)
+{
+    struct lyd_node *first = NULL, *next = NULL, *iter = NULL, *act_notif = NULL;
+    struct attr_cont *attrs = NULL;
+    unsigned int len = 0, r;
+
+    *result = NULL;
+
+    do {
+        len++;
+        len += skip_ws(&data[len]);
+
+        r = json_parse_data(ctx, &data[len], &next, first, iter, &attrs, options, unres, &act_notif, NULL);
+        if (!r) {
+            goto error;
+        }
+        len += r;
+
+        if (!first) {
+            for (iter = next; iter && iter->prev->next; iter = iter->prev);
+            first = iter;
+            iter = next;
+        } else {
+            iter = first->prev;
+        }
+        next = NULL;
+    } while ((data[len] == ',') && (!end || (&data[len] < end)));
+
+    if ((end && (&data[len] != end)) || (!end && (data[len] != '}'))) {
+        /* the part does not end where expected */
+        LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "JSON data (top-level member boundary)");
+        goto error;
+    }
+
+    /* store attributes */
+    if (store_attrs(ctx, attrs, first, options)) {
+        goto error;
+    }
+
+    *result = first;
+    return EXIT_SUCCESS;
+
+error:
+    lyd_free_withsiblings(first);
+    return EXIT_FAILURE;
+}
+
+/**
+ * @brief Context of the JSON data parser passing the parsed nodes to callbacks instead of building a data tree.
+ */
+struct json_clb {
+    struct ly_ctx *ctx;
+    int options;
+    const struct lyd_parse_clb *clb;
+    struct unres_data unres;    /**< unresolved items of the parsed nodes, discarded with every reported node */
+    struct lyd_node *act_notif;
+};
+
+static unsigned int json_clb_object(struct json_clb *jc, const char *data, const struct lys_node *sparent);
+
+/* creates a data node with no parent */
+static struct lyd_node *
+json_clb_new(struct json_clb *jc, struct lys_node *schema)
+{
+    struct lyd_node *node;
+
+    switch (schema->nodetype) {
+    case LYS_LEAF:
+    case LYS_LEAFLIST:
+        node = lyd_node_calloc(NULL, sizeof(struct lyd_node_leaf_list));
+        break;
+    case LYS_ANYXML:
+    case LYS_ANYDATA:
+        node = lyd_node_calloc(NULL, sizeof(struct lyd_node_anydata));
+        break;
+    default:
+        node = lyd_node_calloc(NULL, sizeof *node);
+        break;
+    }
+    LY_CHECK_ERR_RETURN(!node, LOGMEM(jc->ctx), NULL);
+
+    node->prev = node;
+    node->schema = schema;
+    node->validity = ly_new_node_validity(schema);
+    if (resolve_applies_when(schema, 0, NULL)) {
+        node->when_status = LYD_WHEN;
+    }
+
+    return node;
+}
+
+/* validates a parsed node and passes it to the callbacks, the node is always consumed */
+static int
+json_clb_node(struct json_clb *jc, struct lyd_node *node)
+{
+    /* LYD_OPT_TRUSTED is used just so that the order of elements is not checked */
+    if (lyv_data_context(node, jc->options | LYD_OPT_TRUSTED, &jc->unres)
+            || lyv_data_content(node, jc->options, &jc->unres)) {
+        lyd_free(node);
+        return -1;
+    }
+
+    jc->act_notif = NULL;
+    return lyp_data_clb_node(jc->clb, node, &jc->unres);
+}
+
+/* parses a leaf, a leaf-list instance, an anydata or an anyxml value and reports it */
+static unsigned int
+json_clb_value(struct json_clb *jc, const char *data, struct lys_node *schema)
+{
+    unsigned int len;
+    struct lyd_node *node;
+
+    node = json_clb_new(jc, schema);
+    if (!node) {
+        return 0;
+    }
+
+    if (schema->nodetype & (LYS_LEAF | LYS_LEAFLIST)) {
+        len = json_get_leaf_value((struct lyd_node_leaf_list *)node, data);
+    } else {
+        len = json_get_anydata((struct lyd_node_anydata *)node, data);
+    }
+    if (!len) {
+        lyd_free(node);
+        return 0;
+    }
+
+    if (json_clb_node(jc, node)) {
+        return 0;
+    }
+    return len;
+}
+
+/* parses all the leaf-list instances and reports them one by one */
+static unsigned int
+json_clb_leaflist(struct json_clb *jc, const char *data, struct lys_node *schema)
+{
+    unsigned int len = 0, r;
+
+    if (data[len] != '[') {
+        LOGVAL(jc->ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "JSON data (expected begin-array)");
+        return 0;
+    }
+
+    do {
+        len++;
+        len += skip_ws(&data[len]);
+
+        r = json_clb_value(jc, &data[len], schema);
+        if (!r) {
+            return 0;
+        }
+        len += r;
+        len += skip_ws(&data[len]);
+    } while (data[len] == ',');
+
+    if (data[len] != ']') {
+        LOGVAL(jc->ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "JSON data (expecting value-separator or end-array)");
+        return 0;
+    }
+    len++;
+
+    return len;
+}
+
+/* parses the content of an inner node into a data subtree, the same way as json_parse_data() */
+static unsigned int
+json_clb_subtree(struct json_clb *jc, const char *data, struct lyd_node *node)
+{
+    unsigned int len = 0, r;
+    struct lyd_node *diter = NULL;
+    struct attr_cont *attrs = NULL;
+
+    if (data[len] != '{') {
+        LOGVAL(jc->ctx, LYE_XML_INVAL, LY_VLOG_LYD, node, "JSON data (missing begin-object)");
+        return 0;
+    }
+    len++;
+    len += skip_ws(&data[len]);
+
+    if (data[len] != '}') {
+        /* non-empty container */
+        len--;
+        do {
+            len++;
+            len += skip_ws(&data[len]);
+
+            r = json_parse_data(jc->ctx, &data[len], &node, node->child, diter, &attrs, jc->options, &jc->unres,
+                                &jc->act_notif, NULL);
+            if (!r) {
+                return 0;
+            }
+            len += r;
+
+            if (node->child) {
+                diter = node->child->prev;
+            }
+        } while (data[len] == ',');
+
+        /* store attributes */
+        if (store_attrs(jc->ctx, attrs, node->child, jc->options)) {
+            return 0;
+        }
+    }
+
+    if (data[len] != '}') {
+        LOGVAL(jc->ctx, LYE_XML_INVAL, LY_VLOG_LYD, node, "JSON data (missing end-object)");
+        return 0;
+    }
+    len++;
+    len += skip_ws(&data[len]);
+
+#ifdef LY_ENABLED_CACHE
+    lyd_hash(node);
+#endif
+
+    /* if we have empty non-presence container, mark it as default */
+    if ((node->schema->nodetype == LYS_CONTAINER) && !node->child && !node->attr
+            && !((struct lys_node_container *)node->schema)->presence) {
+        node->dflt = 1;
+    }
+
+    return len;
+}
+
+/* processes a single instance of an inner node as decided by the node_open callback */
+static unsigned int
+json_clb_inner(struct json_clb *jc, const char *data, struct lys_node *schema)
+{
+    unsigned int len = 0;
+    struct lyd_node *node;
+    int r;
+
+    r = jc->clb->node_open ? jc->clb->node_open(schema, jc->clb->data) : LYD_PARSE_CLB_CONTINUE;
+    if (r < 0) {
+        return 0;
+    } else if (r == LYD_PARSE_CLB_SKIP) {
+        if (json_skip_unknown(jc->ctx, NULL, data, &len)) {
+            return 0;
+        }
+        return len;
+    } else if (r == LYD_PARSE_CLB_SUBTREE) {
+        node = json_clb_new(jc, schema);
+        if (!node) {
+            return 0;
+        }
+        len = json_clb_subtree(jc, data, node);
+        if (!len) {
+            lyd_free(node);
+            return 0;
+        }
+        if (json_clb_node(jc, node)) {
+            return 0;
+        }
+        return len;
+    }
+
+    len = json_clb_object(jc, data, schema);
+    if (!len) {
+        return 0;
+    }
+    if (jc->clb->node_close && (jc->clb->node_close(schema, jc->clb->data) < 0)) {
+        return 0;
+    }
+    return len;
+}
+
+/* processes an object member, \p sparent is NULL for top-level members */
+static unsigned int
+json_clb_member(struct json_clb *jc, const char *data, const struct lys_node *sparent)
+{
+    unsigned int len, r;
+    char *str, *prefix, *name;
+    const struct lys_module *module;
+    struct lys_node *schema = NULL;
+
+    len = json_get_name(jc->ctx, data, NULL, &str, &prefix, &name);
+    if (!len) {
+        goto error;
+    }
+
+    if (!sparent && (jc->options & LYD_OPT_RPC) && prefix && !strcmp(prefix, "yang") && !strcmp(name, "action")) {
+        /* action wrapper, its content is top-level */
+        r = json_clb_object(jc, &data[len], NULL);
+        if (!r) {
+            goto error;
+        }
+        len += r;
+        free(str);
+        return len;
+    }
+
+    if (str[0] != '@') {
+        /* metadata are not reported */
+        schema = json_get_schema(jc->ctx, prefix, name, sparent, jc->options, NULL);
+        module = lys_node_module(schema);
+        if (!module || !module->implemented || module->disabled) {
+            if (jc->options & LYD_OPT_STRICT) {
+                LOGVAL(jc->ctx, LYE_INELEM, LY_VLOG_NONE, NULL, name);
+                goto error;
+            }
+            schema = NULL;
+        }
+    }
+
+    if (!schema) {
+        if (json_skip_unknown(jc->ctx, NULL, data, &len)) {
+            goto error;
+        }
+        free(str);
+        return len;
+    }
+
+    switch (schema->nodetype) {
+    case LYS_LEAF:
+    case LYS_ANYDATA:
+    case LYS_ANYXML:
+        r = json_clb_value(jc, &data[len], schema);
+        if (!r) {
+            goto error;
+        }
+        len += r;
+        break;
+    case LYS_LEAFLIST:
+        r = json_clb_leaflist(jc, &data[len], schema);
+        if (!r) {
+            goto error;
+        }
+        len += r;
+        break;
+    case LYS_LIST:
+        if (data[len] != '[') {
+            LOGVAL(jc->ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "JSON data (missing begin-array)");
+            goto error;
+        }
+        do {
+            len++;
+            len += skip_ws(&data[len]);
+
+            r = json_clb_inner(jc, &data[len], schema);
+            if (!r) {
+                goto error;
+            }
+            len += r;
+        } while (data[len] == ',');
+
+        if (data[len] != ']') {
+            LOGVAL(jc->ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "JSON data (missing end-array)");
+            goto error;
+        }
+        len++;
+        break;
+    default:
+        r = json_clb_inner(jc, &data[len], schema);
+        if (!r) {
+            goto error;
+        }
+        len += r;
+        break;
+    }
+    len += skip_ws(&data[len]);
+
+    free(str);
+    return len;
+
+error:
+    free(str);
+    return 0;
+}
+
+/* processes all the members of an object */
+static unsigned int
+json_clb_object(struct json_clb *jc, const char *data, const struct lys_node *sparent)
+{
+    unsigned int len = 0, r;
+
+    if (data[len] != '{') {
+        LOGVAL(jc->ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "JSON data (missing begin-object)");
+        return 0;
+    }
+    len++;
+    len += skip_ws(&data[len]);
+
+    if (data[len] != '}') {
+        len--;
+        do {
+            len++;
+            len += skip_ws(&data[len]);
+
+            r = json_clb_member(jc, &data[len], sparent);
+            if (!r) {
+                return 0;
+            }
+            len += r;
+        } while (data[len] == ',');
+    }
+
+    if (data[len] != '}') {
+        LOGVAL(jc->ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "JSON data (missing end-object)");
+        return 0;
+    }
+    len++;
+    len += skip_ws(&data[len]);
+
+    return len;
+}
+
+int
+lyd_parse_json_clb(struct ly_ctx *ctx, const char *data, int options, const struct lyd_parse_clb *clb)
+{
+    struct json_clb jc;
+    unsigned int len;
+
+    memset(&jc, 0, sizeof jc);
+    jc.ctx = ctx;
+    jc.options = options;
+    jc.clb = clb;
+
+    /* skip leading whitespaces */
+    len = skip_ws(data);
+
+    len = json_clb_object(&jc, &data[len], NULL);
+
+    free(jc.unres.node);
+    free(jc.unres.type);
+    return len ? EXIT_SUCCESS : EXIT_FAILURE;
+}
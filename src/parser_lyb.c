@@ -281,7 +281,7 @@ error:
 }
 
 static struct lyd_node *
-lyb_new_node(const struct lys_node *schema, int options)
+lyb_new_node(const struct lys_node *schema, int options, struct lyd_arena *arena)
 {
     struct lyd_node *node;
 
@@ -291,15 +291,15 @@ lyb_new_node(const struct lys_node *schema, int options)
     case LYS_NOTIF:
     case LYS_RPC:
     case LYS_ACTION:
-        node = calloc(sizeof(struct lyd_node), 1);
+        node = lyd_node_calloc(arena, sizeof(struct lyd_node));
         break;
     case LYS_LEAF:
     case LYS_LEAFLIST:
-        node = calloc(sizeof(struct lyd_node_leaf_list), 1);
+        node = lyd_node_calloc(arena, sizeof(struct lyd_node_leaf_list));
         break;
     case LYS_ANYDATA:
     case LYS_ANYXML:
-        node = calloc(sizeof(struct lyd_node_anydata), 1);
+        node = lyd_node_calloc(arena, sizeof(struct lyd_node_anydata));
         break;
     default:
         return NULL;
@@ -837,12 +837,12 @@ lyb_parse_attributes(struct lyd_node *node, const char *data, int options, struc
         if (!attr) {
             assert(!node->attr);
 
-            attr = calloc(1, sizeof *attr);
+            attr = lyd_attr_calloc(node);
             LY_CHECK_ERR_GOTO(!attr, LOGMEM(lybs->ctx), error);
 
             node->attr = attr;
         } else {
-            attr->next = calloc(1, sizeof *attr);
+            attr->next = lyd_attr_calloc(node);
             LY_CHECK_ERR_GOTO(!attr->next, LOGMEM(lybs->ctx), error);
 
             attr = attr->next;
@@ -892,6 +892,25 @@ lyb_is_schema_hash_match(struct lys_node *sibling, LYB_HASH *hash, uint8_t hash_
     return 1;
 }
 
+/**
+ * @brief Data of lyb_schema_hash_match_clb().
+ */
+struct lyb_hash_match {
+    LYB_HASH *hash;
+    uint8_t hash_count;
+    struct lyb_state *lybs;
+};
+
+static int
+lyb_schema_hash_match_clb(const struct lys_node *sibling, void *data)
+{
+    struct lyb_hash_match *match = data;
+
+    /* skip schema nodes from models not present during printing */
+    return lyb_has_schema_model((struct lys_node *)sibling, match->lybs->models, match->lybs->mod_count)
+            && lyb_is_schema_hash_match((struct lys_node *)sibling, match->hash, match->hash_count);
+}
+
 static int
 lyb_parse_schema_hash(const struct lys_node *sparent, const struct lys_module *mod, const char *data, const char *yang_data_name,
                       int options, struct lys_node **snode, struct lyb_state *lybs)
@@ -900,6 +919,7 @@ lyb_parse_schema_hash(const struct lys_node *sparent, const struct lys_module *m
     uint8_t i, j;
     struct lys_node *sibling;
     LYB_HASH hash[LYB_HASH_BITS - 1];
+    struct lyb_hash_match match;
 
     assert((sparent || mod) && (!sparent || !mod));
 
@@ -958,14 +978,10 @@ lyb_parse_schema_hash(const struct lys_node *sparent, const struct lys_module *m
     }
 
     /* find our node with matching hashes */
-    sibling = NULL;
-    while ((sibling = (struct lys_node *)lys_getnext(sibling, sparent, mod, 0))) {
-        /* skip schema nodes from models not present during printing */
-        if (lyb_has_schema_model(sibling, lybs->models, lybs->mod_count) && lyb_is_schema_hash_match(sibling, hash, i + 1)) {
-            /* match found */
-            break;
-        }
-    }
+    match.hash = hash;
+    match.hash_count = i + 1;
+    match.lybs = lybs;
+    sibling = (struct lys_node *)lys_child_find_lyb(sparent, mod, hash[0], lyb_schema_hash_match_clb, &match, 0);
 
 finish:
     *snode = sibling;
@@ -1045,7 +1061,7 @@ lyb_parse_subtree(const char *data, struct lyd_node *parent, struct lyd_node **f
     /*
      * read the node
      */
-    node = lyb_new_node(snode, options);
+    node = lyb_new_node(snode, options, unres->arena);
     if (!node) {
         goto error;
     }
@@ -1231,6 +1247,10 @@ lyd_parse_lyb(struct ly_ctx *ctx, const char *data, int options, const struct ly
 
     unres = calloc(1, sizeof *unres);
     LY_CHECK_ERR_GOTO(!unres, LOGMEM(ctx), finish);
+    if (options & LYD_OPT_ARENA) {
+        unres->arena = lyd_arena_new();
+        LY_CHECK_ERR_GOTO(!unres->arena, LOGMEM(ctx), finish);
+    }
 
     /* read magic number */
     ret += (r = lyb_parse_magic_number(data, &lybs));
@@ -1293,6 +1313,7 @@ finish:
     if (unres) {
         free(unres->node);
         free(unres->type);
+        lyd_arena_release(unres->arena);
         free(unres);
     }
 
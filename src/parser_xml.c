@@ -73,6 +73,35 @@ xml_data_search_schemanode(struct lyxml_elem *xml, struct lys_node *start, int o
     return NULL;
 }
 
+/* finds the schema node of an element among the children of \p sparent (NULL for top-level elements of \p mod),
+ * the same nodes as xml_data_search_schemanode() but using the schema child index */
+static struct lys_node *
+xml_data_find_child(struct lyxml_elem *xml, const struct lys_node *sparent, const struct lys_module *mod, int options)
+{
+    const struct lys_node *inout, *result;
+
+    if (sparent && (sparent->nodetype & (LYS_RPC | LYS_ACTION))) {
+        /* go into input and output following the options */
+        LY_TREE_FOR(sparent->child, inout) {
+            if (((inout->nodetype == LYS_OUTPUT) && (options & LYD_OPT_RPC))
+                    || ((inout->nodetype == LYS_INPUT) && (options & LYD_OPT_RPCREPLY))) {
+                continue;
+            }
+            if (inout->nodetype & (LYS_INPUT | LYS_OUTPUT)) {
+                result = lys_child_find(inout, NULL, NULL, xml->ns->value, xml->name, strlen(xml->name),
+                                        LYS_GETNEXT_NOSTATECHECK);
+                if (result) {
+                    return (struct lys_node *)result;
+                }
+            }
+        }
+        return NULL;
+    }
+
+    return (struct lys_node *)lys_child_find(sparent, mod, NULL, xml->ns->value, xml->name, strlen(xml->name),
+                                             LYS_GETNEXT_NOSTATECHECK);
+}
+
 /* logs directly */
 static int
 xml_get_value(struct lyd_node *node, struct lyxml_elem *xml, int editbits)
@@ -99,38 +128,20 @@ xml_get_value(struct lyd_node *node, struct lyxml_elem *xml, int editbits)
     return EXIT_SUCCESS;
 }
 
-/* logs directly */
+/* logs directly, \p schema_p is NULL if the element is not supposed to be parsed, \p sparent is the schema node
+ * of the parent element (NULL for top-level elements) even if there is no data \p parent */
 static int
-xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *parent, struct lyd_node *first_sibling,
-               struct lyd_node *prev, int options, struct unres_data *unres, struct lyd_node **result,
-               struct lyd_node **act_notif, const char *yang_data_name)
+xml_data_find_schemanode(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *parent,
+                         const struct lys_node *sparent, int options, const char *yang_data_name,
+                         struct lys_node **schema_p)
 {
     const struct lys_module *mod = NULL;
-    struct lyd_node *diter, *dlast;
     struct lys_node *schema = NULL, *target;
     const struct lys_node *ext_node;
     struct lys_node_augment *aug;
-    struct lyd_attr *dattr, *dattr_iter;
-    struct lyxml_attr *attr;
-    struct lyxml_elem *child, *next;
-    int i, j, havechildren, r, editbits = 0, filterflag = 0, found;
-    uint8_t pos;
-    int ret = 0;
-    const char *str = NULL;
-    char *msg;
+    int j;
 
-    assert(xml);
-    assert(result);
-    *result = NULL;
-
-    if (xml->flags & LYXML_ELEM_MIXED) {
-        if (options & LYD_OPT_STRICT) {
-            LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_XML, xml, "XML element with mixed content");
-            return -1;
-        } else {
-            return 0;
-        }
-    }
+    *schema_p = NULL;
 
     if (!xml->ns || !xml->ns->value) {
         if (options & LYD_OPT_STRICT) {
@@ -142,7 +153,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
     }
 
     /* find schema node */
-    if (!parent) {
+    if (!sparent) {
         mod = ly_ctx_get_module_by_ns(ctx, xml->ns->value, NULL, 0);
         if (ctx->data_clb) {
             if (!mod) {
@@ -163,7 +174,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
                     }
                 }
             } else {
-                schema = xml_data_search_schemanode(xml, mod->data, options);
+                schema = xml_data_find_child(xml, NULL, mod, options);
                 if (!schema) {
                     /* it still can be the specific case of this module containing an augment of another module
                     * top-level choice or top-level choice's case, bleh */
@@ -195,7 +206,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
         }
     } else {
         /* parsing some internal node, we start with parent's schema pointer */
-        schema = xml_data_search_schemanode(xml, parent->schema->child, options);
+        schema = xml_data_find_child(xml, sparent, NULL, options);
 
         if (ctx->data_clb) {
             if (schema && !lys_node_module(schema)->implemented) {
@@ -204,7 +215,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
             } else if (!schema) {
                 if (ctx->data_clb(ctx, NULL, xml->ns->value, 0, ctx->data_clb_data)) {
                     /* context was updated, so try to find the schema node again */
-                    schema = xml_data_search_schemanode(xml, parent->schema->child, options);
+                    schema = xml_data_find_child(xml, sparent, NULL, options);
                 }
             }
         }
@@ -213,13 +224,39 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
     mod = lys_node_module(schema);
     if (!mod || !mod->implemented || mod->disabled) {
         if (options & LYD_OPT_STRICT) {
-            LOGVAL(ctx, LYE_INELEM, (parent ? LY_VLOG_LYD : LY_VLOG_STR), (parent ? (void *)parent : (void *)"/") , xml->name);
+            if (parent) {
+                LOGVAL(ctx, LYE_INELEM, LY_VLOG_LYD, parent, xml->name);
+            } else {
+                LOGVAL(ctx, LYE_INELEM, (sparent ? LY_VLOG_XML : LY_VLOG_STR), (sparent ? (void *)xml : (void *)"/"),
+                       xml->name);
+            }
             return -1;
         } else {
             return 0;
         }
     }
 
+    *schema_p = schema;
+    return 0;
+}
+
+/* logs directly, creates the data node from the XML element without its children,
+ * on error the node is freed */
+static int
+xml_parse_data_node(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lys_node *schema, struct lyd_node *parent,
+                    struct lyd_node *first_sibling, struct lyd_node *prev, int options, struct unres_data *unres,
+                    struct lyd_node **result, struct lyd_node **act_notif)
+{
+    struct lyd_node *diter;
+    struct lyd_attr *dattr, *dattr_iter;
+    struct lyxml_attr *attr;
+    struct lyxml_elem *child, *next;
+    int i, r, editbits = 0, filterflag = 0, found;
+    uint8_t pos;
+    const char *str = NULL;
+
+    *result = NULL;
+
     /* create the element structure */
     switch (schema->nodetype) {
     case LYS_CONTAINER:
@@ -227,28 +264,15 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
     case LYS_NOTIF:
     case LYS_RPC:
     case LYS_ACTION:
-        for (i = 0; xml->content && xml->content[i]; ++i) {
-            if (!is_xmlws(xml->content[i])) {
-                msg = malloc(22 + strlen(xml->content) + 1);
-                LY_CHECK_ERR_RETURN(!msg, LOGMEM(ctx), -1);
-                sprintf(msg, "node with text data \"%s\"", xml->content);
-                LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_XML, xml, msg);
-                free(msg);
-                return -1;
-            }
-        }
-        *result = calloc(1, sizeof **result);
-        havechildren = 1;
+        *result = lyd_node_calloc(unres->arena, sizeof **result);
         break;
     case LYS_LEAF:
     case LYS_LEAFLIST:
-        *result = calloc(1, sizeof(struct lyd_node_leaf_list));
-        havechildren = 0;
+        *result = lyd_node_calloc(unres->arena, sizeof(struct lyd_node_leaf_list));
         break;
     case LYS_ANYXML:
     case LYS_ANYDATA:
-        *result = calloc(1, sizeof(struct lyd_node_anydata));
-        havechildren = 0;
+        *result = lyd_node_calloc(unres->arena, sizeof(struct lyd_node_anydata));
         break;
     default:
         LOGINT(ctx);
@@ -260,9 +284,8 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
     (*result)->schema = schema;
     (*result)->parent = parent;
     diter = NULL;
-    if (schema->nodetype == LYS_LEAF && lys_is_key((struct lys_node_leaf *)schema, &pos)) {
-        /* it is key and we need to insert it into a correct place (a key must have a parent list) */
-        assert(parent);
+    if (parent && (schema->nodetype == LYS_LEAF) && lys_is_key((struct lys_node_leaf *)schema, &pos)) {
+        /* it is key and we need to insert it into a correct place (unless it is parsed alone) */
         for (i = 0, diter = parent->child;
                 diter && i < pos && diter->schema->nodetype == LYS_LEAF && lys_is_key((struct lys_node_leaf *)diter->schema, NULL);
                 i++, diter = diter->next);
@@ -272,7 +295,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
                 LOGVAL(ctx, LYE_INORDER, LY_VLOG_LYD, *result, schema->name, diter->schema->name);
                 LOGVAL(ctx, LYE_SPEC, LY_VLOG_PREV, NULL, "Invalid position of the key \"%s\" in a list \"%s\".",
                        schema->name, parent->schema->name);
-                free(*result);
+                lyd_node_mem_free(*result);
                 *result = NULL;
                 return -1;
             } else {
@@ -508,12 +531,107 @@ attr_error:
         goto error;
     }
 
+    return 0;
+
+unlink_node_error:
+    lyd_unlink_internal(*result, 2);
+error:
+    /* cleanup */
+    for (i = unres->count - 1; i >= 0; i--) {
+        /* remove unres items connected with the node being removed */
+        if (unres->node[i] == *result) {
+            unres_data_del(unres, i);
+        }
+    }
+    lyd_free(*result);
+    *result = NULL;
+    return -1;
+}
+
+/* logs directly, finishes the data node once all its children were parsed, does not free the node on error */
+static int
+xml_parse_data_finish(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *node, struct lyd_node *first_sibling,
+                      int options, struct unres_data *unres)
+{
+    int i;
+    char *msg;
+
+    if (node->schema->nodetype & (LYS_CONTAINER | LYS_LIST | LYS_NOTIF | LYS_RPC | LYS_ACTION)) {
+        for (i = 0; xml->content && xml->content[i]; ++i) {
+            if (!is_xmlws(xml->content[i])) {
+                msg = malloc(22 + strlen(xml->content) + 1);
+                LY_CHECK_ERR_RETURN(!msg, LOGMEM(ctx), -1);
+                sprintf(msg, "node with text data \"%s\"", xml->content);
+                LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_XML, xml, msg);
+                free(msg);
+                return -1;
+            }
+        }
+    }
+
+    /* if we have empty non-presence container, we keep it, but mark it as default */
+    if (node->schema->nodetype == LYS_CONTAINER && !node->child &&
+            !node->attr && !((struct lys_node_container *)node->schema)->presence) {
+        node->dflt = 1;
+    }
+
+    /* rest of validation checks */
+    if (lyv_data_content(node, options, unres) ||
+            lyv_multicases(node, NULL, first_sibling ? &first_sibling : NULL, 0, NULL)) {
+        return -1;
+    }
+
+    /* validation successful */
+    if (node->schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) {
+        /* postpone checking when there will be all list/leaflist instances */
+        node->validity |= LYD_VAL_DUP;
+    }
+
+    return 0;
+}
+
+/* logs directly */
+static int
+xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *parent, struct lyd_node *first_sibling,
+               struct lyd_node *prev, int options, struct unres_data *unres, struct lyd_node **result,
+               struct lyd_node **act_notif, const char *yang_data_name)
+{
+    struct lyd_node *diter, *dlast;
+    struct lys_node *schema;
+    struct lyxml_elem *child, *next;
+    int i;
+
+    assert(xml);
+    assert(result);
+    *result = NULL;
+
+    if (xml->flags & LYXML_ELEM_MIXED) {
+        if (options & LYD_OPT_STRICT) {
+            LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_XML, xml, "XML element with mixed content");
+            return -1;
+        } else {
+            return 0;
+        }
+    }
+
+    /* find schema node */
+    if (xml_data_find_schemanode(ctx, xml, parent, parent ? parent->schema : NULL, options, yang_data_name, &schema)) {
+        return -1;
+    } else if (!schema) {
+        return 0;
+    }
+
+    /* create the node */
+    if (xml_parse_data_node(ctx, xml, schema, parent, first_sibling, prev, options, unres, result, act_notif)) {
+        return -1;
+    }
+
     /* process children */
-    if (havechildren && xml->child) {
+    if ((schema->nodetype & (LYS_CONTAINER | LYS_LIST | LYS_NOTIF | LYS_RPC | LYS_ACTION)) && xml->child) {
         diter = dlast = NULL;
         LY_TREE_FOR_SAFE(xml->child, next, child) {
-            r = xml_parse_data(ctx, child, *result, (*result)->child, dlast, options, unres, &diter, act_notif, yang_data_name);
-            if (r) {
+            if (xml_parse_data(ctx, child, *result, (*result)->child, dlast, options, unres, &diter, act_notif,
+                               yang_data_name)) {
                 goto error;
             } else if (options & LYD_OPT_DESTRUCT) {
                 lyxml_free(ctx, child);
@@ -526,28 +644,12 @@ attr_error:
         }
     }
 
-    /* if we have empty non-presence container, we keep it, but mark it as default */
-    if (schema->nodetype == LYS_CONTAINER && !(*result)->child &&
-            !(*result)->attr && !((struct lys_node_container *)schema)->presence) {
-        (*result)->dflt = 1;
-    }
-
-    /* rest of validation checks */
-    if (lyv_data_content(*result, options, unres) ||
-            lyv_multicases(*result, NULL, prev ? &first_sibling : NULL, 0, NULL)) {
+    if (xml_parse_data_finish(ctx, xml, *result, prev ? first_sibling : NULL, options, unres)) {
         goto error;
     }
 
-    /* validation successful */
-    if ((*result)->schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) {
-        /* postpone checking when there will be all list/leaflist instances */
-        (*result)->validity |= LYD_VAL_DUP;
-    }
+    return 0;
 
-    return ret;
-
-unlink_node_error:
-    lyd_unlink_internal(*result, 2);
 error:
     /* cleanup */
     for (i = unres->count - 1; i >= 0; i--) {
@@ -561,52 +663,320 @@ error:
     return -1;
 }
 
-API struct lyd_node *
-lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
+/**
+ * @brief Types of the XML elements being parsed by the streaming data parser.
+ */
+enum xml_stream_level_type {
+    XML_STREAM_NODE = 0,        /**< inner data node created on the start tag */
+    XML_STREAM_VALUE,           /**< terminal data node created on the end tag (its XML content is needed) */
+    XML_STREAM_SKIP,            /**< element not parsed into data, freed on the end tag */
+    XML_STREAM_KEEP,            /**< element not parsed into data, but it is a part of a terminal node's content */
+    XML_STREAM_WRAPPER,         /**< YANG action wrapper element */
+    XML_STREAM_EVENTS           /**< inner node reported by the data parser callbacks, there is no data node */
+};
+
+/**
+ * @brief Information about an open XML element of the streaming data parser.
+ */
+struct xml_stream_level {
+    enum xml_stream_level_type type;
+    struct lys_node *schema;    /**< schema node of the element data node, the schema parent of the children */
+    struct lyd_node *node;      /**< created data node, the parent of the child data nodes */
+    struct lyd_node *last;      /**< last parsed child data node */
+};
+
+/**
+ * @brief Context of the streaming data parser creating data nodes directly while the XML is being parsed,
+ * without building the whole XML tree first.
+ */
+struct xml_stream {
+    struct ly_ctx *ctx;
+    int options;
+    struct unres_data *unres;
+    const char *yang_data_name;
+    struct lyd_node *first;     /**< first top-level data node */
+    struct lyd_node *act_notif;
+    uint32_t roots;             /**< number of top-level XML elements */
+    int done;                   /**< no more top-level elements are parsed */
+
+    const struct lyd_parse_clb *clb; /**< data parser callbacks, the data nodes are passed to them instead of being
+                                          connected into a data tree */
+    uint32_t subtree;           /**< level of the root of the subtree being parsed for the callbacks, 0 if none */
+
+    struct xml_stream_level *levels; /**< stack of the open XML elements, the first item is the (reply) parent */
+    uint32_t count;
+    uint32_t size;
+};
+
+/* get the level of the data parent of the element on level \p idx, skip action wrapper */
+static struct xml_stream_level *
+xml_stream_parent(struct xml_stream *stream, uint32_t idx)
 {
-    FUN_IN;
+    if (stream->levels[idx - 1].type == XML_STREAM_WRAPPER) {
+        return &stream->levels[0];
+    }
+    return &stream->levels[idx - 1];
+}
 
-    va_list ap;
-    int r;
-    struct unres_data *unres = NULL;
-    const struct lyd_node *rpc_act = NULL, *data_tree = NULL;
-    struct lyd_node *result = NULL, *iter, *last, *reply_parent = NULL, *reply_top = NULL, *act_notif = NULL;
-    struct lyxml_elem *xmlstart, *xmlelem, *xmlaux, *xmlfree = NULL;
-    const char *yang_data_name = NULL;
+static void
+xml_stream_add(struct xml_stream *stream, struct xml_stream_level *parent, struct lyd_node *node)
+{
+    if (!node->next) {
+        /* the node can be inserted out of order (not as the last one) in case it is a list's key */
+        parent->last = node;
+    }
+    if (!stream->first && !node->parent) {
+        stream->first = node;
+    }
 
-    if (!ctx || !root) {
-        LOGARG;
-        return NULL;
+    if ((parent == &stream->levels[0]) && (stream->options & LYD_OPT_DATA_ADD_YANGLIB)
+            && (node->schema->module == stream->ctx->models.list[stream->ctx->internal_module_count - 1])) {
+        /* ietf-yang-library data present, so ignore the option to add them */
+        stream->options &= ~LYD_OPT_DATA_ADD_YANGLIB;
     }
+}
 
-    if (lyp_data_check_options(ctx, options, __func__)) {
-        return NULL;
+/* logs directly */
+static int
+xml_stream_elem_start(struct lyxml_elem *xml, void *clb_data)
+{
+    struct xml_stream *stream = clb_data;
+    struct xml_stream_level *parent, *level;
+    struct lys_node *schema;
+    void *r;
+    int ret;
+
+    if (stream->count == stream->size) {
+        stream->size *= 2;
+        r = realloc(stream->levels, stream->size * sizeof *stream->levels);
+        LY_CHECK_ERR_RETURN(!r, LOGMEM(stream->ctx), -1);
+        stream->levels = r;
+    }
+    parent = &stream->levels[stream->count - 1];
+    level = &stream->levels[stream->count++];
+    memset(level, 0, sizeof *level);
+
+    if ((parent->type == XML_STREAM_VALUE) || (parent->type == XML_STREAM_KEEP)) {
+        /* part of a terminal node content */
+        level->type = XML_STREAM_KEEP;
+        return 0;
+    } else if (parent->type == XML_STREAM_SKIP) {
+        level->type = XML_STREAM_SKIP;
+        return 0;
     }
 
-    if (!(*root) && !(options & LYD_OPT_RPCREPLY)) {
-        /* empty tree */
-        if (options & (LYD_OPT_RPC | LYD_OPT_NOTIF)) {
-            /* error, top level node identify RPC and Notification */
-            LOGERR(ctx, LY_EINVAL, "%s: *root identifies RPC/Notification so it cannot be NULL.", __func__);
-            return NULL;
-        } else if (!(options & LYD_OPT_RPCREPLY)) {
-            /* others - no work is needed, just check for missing mandatory nodes */
-            lyd_validate(&result, options, ctx);
-            return result;
+    if (stream->count == 2) {
+        /* top-level element */
+        if (stream->done) {
+            level->type = XML_STREAM_SKIP;
+            return 0;
         }
-        /* continue with empty RPC reply, for which we need RPC */
+        if (!stream->roots++ && (stream->options & LYD_OPT_RPC) && !strcmp(xml->name, "action")
+                && xml->ns && !strcmp(xml->ns->value, LY_NSYANG)) {
+            /* it's an action, not a simple RPC */
+            level->type = XML_STREAM_WRAPPER;
+            return 0;
+        }
+    }
+    parent = xml_stream_parent(stream, stream->count - 1);
+    if (stream->done) {
+        /* only the first child of the action wrapper is parsed */
+        level->type = XML_STREAM_SKIP;
+        return 0;
+    }
+
+    if (xml_data_find_schemanode(stream->ctx, xml, parent->node, parent->schema, stream->options,
+                                 stream->yang_data_name, &schema)) {
+        return -1;
+    } else if (!schema) {
+        level->type = XML_STREAM_SKIP;
+        return 0;
+    }
+
+    if (schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) {
+        /* the node is created once its value is known */
+        level->type = XML_STREAM_VALUE;
+        level->schema = schema;
+        return 0;
+    }
+
+    level->schema = schema;
+    if (stream->clb && !stream->subtree) {
+        ret = stream->clb->node_open ? stream->clb->node_open(schema, stream->clb->data) : LYD_PARSE_CLB_CONTINUE;
+        if (ret < 0) {
+            return -1;
+        } else if (ret == LYD_PARSE_CLB_SKIP) {
+            level->type = XML_STREAM_SKIP;
+            return 0;
+        } else if (ret != LYD_PARSE_CLB_SUBTREE) {
+            level->type = XML_STREAM_EVENTS;
+            return 0;
+        }
+
+        /* root of a subtree passed to the callback as a whole */
+        level->type = XML_STREAM_NODE;
+        stream->subtree = stream->count - 1;
+        return xml_parse_data_node(stream->ctx, xml, schema, NULL, NULL, NULL, stream->options, stream->unres,
+                                   &level->node, &stream->act_notif);
+    }
+
+    /* create the inner node now so that its children can be connected to it */
+    level->type = XML_STREAM_NODE;
+    if (xml_parse_data_node(stream->ctx, xml, schema, parent->node, parent->node ? parent->node->child : stream->first,
+                            parent->last, stream->options, stream->unres, &level->node, &stream->act_notif)) {
+        return -1;
+    }
+    xml_stream_add(stream, parent, level->node);
+
+    return 0;
+}
+
+/* remove all unres items connected with the subtree being removed */
+static void
+xml_stream_unres_del(struct unres_data *unres, struct lyd_node *node)
+{
+    struct lyd_node *iter;
+    int i;
+
+    for (i = unres->count - 1; i >= 0; i--) {
+        for (iter = unres->node[i]; iter && (iter != node); iter = iter->parent);
+        if (iter) {
+            unres_data_del(unres, i);
+        }
+    }
+}
+
+/* logs directly */
+static int
+xml_stream_elem_end(struct lyxml_elem *xml, void *clb_data)
+{
+    struct xml_stream *stream = clb_data;
+    struct xml_stream_level *parent, *level;
+    struct lyd_node *node, *first;
+
+    level = &stream->levels[--stream->count];
+    parent = xml_stream_parent(stream, stream->count);
+
+    switch (level->type) {
+    case XML_STREAM_KEEP:
+        /* freed together with the terminal node element */
+        return 0;
+    case XML_STREAM_SKIP:
+        break;
+    case XML_STREAM_WRAPPER:
+        stream->done = 1;
+        break;
+    case XML_STREAM_EVENTS:
+        if ((xml->flags & LYXML_ELEM_MIXED) && (stream->options & LYD_OPT_STRICT)) {
+            LOGVAL(stream->ctx, LYE_XML_INVAL, LY_VLOG_XML, xml, "XML element with mixed content");
+            return -1;
+        }
+        if (stream->clb->node_close && (stream->clb->node_close(level->schema, stream->clb->data) < 0)) {
+            return -1;
+        }
+        break;
+    case XML_STREAM_VALUE:
+    case XML_STREAM_NODE:
+        if (xml->flags & LYXML_ELEM_MIXED) {
+            if (stream->options & LYD_OPT_STRICT) {
+                LOGVAL(stream->ctx, LYE_XML_INVAL, LY_VLOG_XML, xml, "XML element with mixed content");
+                return -1;
+            }
+
+            if ((node = level->node)) {
+                /* the node is ignored, remove it with its whole subtree, it is always the last child */
+                if (parent->last == node) {
+                    parent->last = (node->prev != node) ? node->prev : NULL;
+                }
+                if (stream->first == node) {
+                    stream->first = NULL;
+                }
+                if (stream->subtree == stream->count) {
+                    stream->subtree = 0;
+                }
+                for (first = stream->act_notif; first && (first != node); first = first->parent);
+                if (first) {
+                    stream->act_notif = NULL;
+                }
+                xml_stream_unres_del(stream->unres, node);
+                lyd_free(node);
+            }
+            break;
+        }
+
+        if ((level->type == XML_STREAM_VALUE) && stream->clb && !stream->subtree) {
+            /* terminal node passed to the callbacks alone */
+            if (xml_parse_data_node(stream->ctx, xml, level->schema, NULL, NULL, NULL, stream->options, stream->unres,
+                                    &node, &stream->act_notif)) {
+                return -1;
+            }
+            if (xml_parse_data_finish(stream->ctx, xml, node, NULL, stream->options, stream->unres)) {
+                lyd_free(node);
+                return -1;
+            }
+            if (lyp_data_clb_node(stream->clb, node, stream->unres)) {
+                return -1;
+            }
+            break;
+        } else if (level->type == XML_STREAM_VALUE) {
+            if (xml_parse_data_node(stream->ctx, xml, level->schema, parent->node,
+                                    parent->node ? parent->node->child : stream->first, parent->last, stream->options,
+                                    stream->unres, &level->node, &stream->act_notif)) {
+                return -1;
+            }
+            xml_stream_add(stream, parent, level->node);
+        }
+
+        node = level->node;
+        if (stream->subtree == stream->count) {
+            /* the whole subtree was parsed */
+            if (xml_parse_data_finish(stream->ctx, xml, node, NULL, stream->options, stream->unres)) {
+                return -1;
+            }
+            stream->subtree = 0;
+            stream->act_notif = NULL;
+            if (lyp_data_clb_node(stream->clb, node, stream->unres)) {
+                return -1;
+            }
+            break;
+        }
+        first = parent->node ? parent->node->child : stream->first;
+        if (xml_parse_data_finish(stream->ctx, xml, node, (first != node) ? first : NULL, stream->options, stream->unres)) {
+            return -1;
+        }
+        break;
+    }
+
+    if ((parent == &stream->levels[0]) && (stream->options & LYD_OPT_NOSIBLINGS)) {
+        /* stop after the first processed root */
+        stream->done = 1;
     }
 
+    lyxml_free(stream->ctx, xml);
+    return 0;
+}
+
+/* logs directly, parses either the XML tree in \p root or the XML string in \p data */
+static struct lyd_node *
+xml_parse_data_trees(struct ly_ctx *ctx, struct lyxml_elem **root, const char *data, int options,
+                     const struct lyd_node *rpc_act, const struct lyd_node *data_tree, const char *yang_data_name)
+{
+    int r;
+    struct unres_data *unres = NULL;
+    struct lyd_node *result = NULL, *iter, *last, *reply_parent = NULL, *reply_top = NULL, *act_notif = NULL;
+    struct lyxml_elem *xmlstart, *xmlelem, *xmlaux, *xmlfree = NULL;
+    struct xml_stream stream;
+    struct lyxml_parse_clb clb;
+
     unres = calloc(1, sizeof *unres);
     LY_CHECK_ERR_RETURN(!unres, LOGMEM(ctx), NULL);
 
-    va_start(ap, options);
+    if (options & LYD_OPT_ARENA) {
+        unres->arena = lyd_arena_new();
+        LY_CHECK_ERR_RETURN(!unres->arena, LOGMEM(ctx); free(unres), NULL);
+    }
+
     if (options & LYD_OPT_RPCREPLY) {
-        rpc_act = va_arg(ap, const struct lyd_node *);
-        if (!rpc_act || rpc_act->parent || !(rpc_act->schema->nodetype & (LYS_RPC | LYS_LIST | LYS_CONTAINER))) {
-            LOGERR(ctx, LY_EINVAL, "%s: invalid variable parameter (const struct lyd_node *rpc_act).", __func__);
-            goto error;
-        }
         if (rpc_act->schema->nodetype == LYS_RPC) {
             /* RPC request */
             reply_top = reply_parent = _lyd_new(NULL, rpc_act->schema, 0);
@@ -627,35 +997,52 @@ lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
             lyd_free_withsiblings(reply_parent->child);
         }
     }
-    if (options & (LYD_OPT_RPC | LYD_OPT_NOTIF | LYD_OPT_RPCREPLY)) {
-        data_tree = va_arg(ap, const struct lyd_node *);
-        if (data_tree) {
-            if (options & LYD_OPT_NOEXTDEPS) {
-                LOGERR(ctx, LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree and LYD_OPT_NOEXTDEPS set).",
-                       __func__);
-                goto error;
-            }
 
-            LY_TREE_FOR((struct lyd_node *)data_tree, iter) {
-                if (iter->parent) {
-                    /* a sibling is not top-level */
-                    LOGERR(ctx, LY_EINVAL, "%s: invalid variable parameter (const struct lyd_node *data_tree).", __func__);
-                    goto error;
-                }
-            }
-
-            /* move it to the beginning */
-            for (; data_tree->prev->next; data_tree = data_tree->prev);
-
-            /* LYD_OPT_NOSIBLINGS cannot be set in this case */
-            if (options & LYD_OPT_NOSIBLINGS) {
-                LOGERR(ctx, LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree with LYD_OPT_NOSIBLINGS).", __func__);
-                goto error;
+    if (!root) {
+        /* parse the data directly from the XML parser callbacks */
+        memset(&stream, 0, sizeof stream);
+        stream.ctx = ctx;
+        stream.options = options;
+        stream.unres = unres;
+        stream.yang_data_name = yang_data_name;
+        stream.size = 16;
+        stream.levels = malloc(stream.size * sizeof *stream.levels);
+        LY_CHECK_ERR_GOTO(!stream.levels, LOGMEM(ctx); result = reply_top, error);
+        memset(&stream.levels[0], 0, sizeof *stream.levels);
+        stream.levels[0].node = reply_parent;
+        stream.levels[0].schema = reply_parent ? reply_parent->schema : NULL;
+        stream.count = 1;
+
+        clb.elem_start = xml_stream_elem_start;
+        clb.elem_end = xml_stream_elem_end;
+        clb.data = &stream;
+
+        r = lyxml_parse_mem_clb(ctx, data, NULL, (options & LYD_OPT_NOSIBLINGS) ? 0 : LYXML_PARSE_MULTIROOT, &clb,
+                                &xmlelem);
+        free(stream.levels);
+        result = reply_top ? reply_top : stream.first;
+        if (r) {
+            goto error;
+        }
+        act_notif = stream.act_notif;
+        options = stream.options;
+
+        if (!stream.roots && !(options & LYD_OPT_RPCREPLY)) {
+            /* empty tree */
+            free(unres->node);
+            free(unres->type);
+            lyd_arena_release(unres->arena);
+            free(unres);
+            if (options & (LYD_OPT_RPC | LYD_OPT_NOTIF)) {
+                /* error, top level node identify RPC and Notification */
+                LOGERR(ctx, LY_EINVAL, "Empty data cannot identify an RPC/Notification.");
+                return NULL;
             }
+            /* others - no work is needed, just check for missing mandatory nodes */
+            lyd_validate(&result, options, ctx);
+            return result;
         }
-    }
-    if (options & LYD_OPT_DATA_TEMPLATE) {
-        yang_data_name = va_arg(ap, const char *);
+        goto validate;
     }
 
     if ((*root) && !(options & LYD_OPT_NOSIBLINGS)) {
@@ -716,6 +1103,7 @@ lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
         result = reply_top;
     }
 
+validate:
     if ((options & LYD_OPT_RPCREPLY) && (rpc_act->schema->nodetype != LYS_RPC)) {
         /* action reply */
         act_notif = reply_parent;
@@ -760,8 +1148,8 @@ lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
     }
     free(unres->node);
     free(unres->type);
+    lyd_arena_release(unres->arena);
     free(unres);
-    va_end(ap);
     return result;
 
 error:
@@ -771,7 +1159,169 @@ error:
     }
     free(unres->node);
     free(unres->type);
+    lyd_arena_release(unres->arena);
     free(unres);
-    va_end(ap);
     return NULL;
 }
+
+API struct lyd_node *
+lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
+{
+    FUN_IN;
+
+    va_list ap;
+    const struct lyd_node *rpc_act = NULL, *data_tree = NULL, *iter;
+    struct lyd_node *result = NULL;
+    const char *yang_data_name = NULL;
+
+    if (!ctx || !root) {
+        LOGARG;
+        return NULL;
+    }
+
+    if (lyp_data_check_options(ctx, options, __func__)) {
+        return NULL;
+    }
+
+    if (!(*root) && !(options & LYD_OPT_RPCREPLY)) {
+        /* empty tree */
+        if (options & (LYD_OPT_RPC | LYD_OPT_NOTIF)) {
+            /* error, top level node identify RPC and Notification */
+            LOGERR(ctx, LY_EINVAL, "%s: *root identifies RPC/Notification so it cannot be NULL.", __func__);
+            return NULL;
+        } else if (!(options & LYD_OPT_RPCREPLY)) {
+            /* others - no work is needed, just check for missing mandatory nodes */
+            lyd_validate(&result, options, ctx);
+            return result;
+        }
+        /* continue with empty RPC reply, for which we need RPC */
+    }
+
+    va_start(ap, options);
+    if (options & LYD_OPT_RPCREPLY) {
+        rpc_act = va_arg(ap, const struct lyd_node *);
+        if (!rpc_act || rpc_act->parent || !(rpc_act->schema->nodetype & (LYS_RPC | LYS_LIST | LYS_CONTAINER))) {
+            LOGERR(ctx, LY_EINVAL, "%s: invalid variable parameter (const struct lyd_node *rpc_act).", __func__);
+            goto error;
+        }
+    }
+    if (options & (LYD_OPT_RPC | LYD_OPT_NOTIF | LYD_OPT_RPCREPLY)) {
+        data_tree = va_arg(ap, const struct lyd_node *);
+        if (data_tree) {
+            if (options & LYD_OPT_NOEXTDEPS) {
+                LOGERR(ctx, LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree and LYD_OPT_NOEXTDEPS set).",
+                       __func__);
+                goto error;
+            }
+
+            LY_TREE_FOR(data_tree, iter) {
+                if (iter->parent) {
+                    /* a sibling is not top-level */
+                    LOGERR(ctx, LY_EINVAL, "%s: invalid variable parameter (const struct lyd_node *data_tree).", __func__);
+                    goto error;
+                }
+            }
+
+            /* move it to the beginning */
+            for (; data_tree->prev->next; data_tree = data_tree->prev);
+
+            /* LYD_OPT_NOSIBLINGS cannot be set in this case */
+            if (options & LYD_OPT_NOSIBLINGS) {
+                LOGERR(ctx, LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree with LYD_OPT_NOSIBLINGS).", __func__);
+                goto error;
+            }
+        }
+    }
+    if (options & LYD_OPT_DATA_TEMPLATE) {
+        yang_data_name = va_arg(ap, const char *);
+    }
+
+    result = xml_parse_data_trees(ctx, root, NULL, options, rpc_act, data_tree, yang_data_name);
+#ifdef LY_ENABLED_CACHE
+    lyd_pos_idx_tree(result);
+#endif
+
+error:
+    va_end(ap);
+    return result;
+}
+
+struct lyd_node *
+xml_read_data(struct ly_ctx *ctx, const char *data, int options, const struct lyd_node *rpc_act,
+              const struct lyd_node *data_tree, const char *yang_data_name)
+{
+    return xml_parse_data_trees(ctx, NULL, data, options, rpc_act, data_tree, yang_data_name);
+}
+
+int
+xml_read_data_clb(struct ly_ctx *ctx, const char *data, int options, const struct lyd_parse_clb *clb)
+{
+    int r;
+    struct unres_data unres;
+    struct xml_stream stream;
+    struct lyxml_parse_clb xml_clb;
+    struct lyxml_elem *xmlelem;
+
+    memset(&unres, 0, sizeof unres);
+    memset(&stream, 0, sizeof stream);
+    stream.ctx = ctx;
+    stream.options = options;
+    stream.unres = &unres;
+    stream.clb = clb;
+    stream.size = 16;
+    stream.levels = malloc(stream.size * sizeof *stream.levels);
+    LY_CHECK_ERR_RETURN(!stream.levels, LOGMEM(ctx), EXIT_FAILURE);
+    memset(&stream.levels[0], 0, sizeof *stream.levels);
+    stream.count = 1;
+
+    xml_clb.elem_start = xml_stream_elem_start;
+    xml_clb.elem_end = xml_stream_elem_end;
+    xml_clb.data = &stream;
+
+    r = lyxml_parse_mem_clb(ctx, data, NULL, (options & LYD_OPT_NOSIBLINGS) ? 0 : LYXML_PARSE_MULTIROOT, &xml_clb, &xmlelem);
+    if (r && stream.subtree) {
+        /* parsing stopped inside a subtree */
+        lyd_free(stream.levels[stream.subtree].node);
+    }
+
+    free(stream.levels);
+    free(unres.node);
+    free(unres.type);
+    return r ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int
+xml_read_data_part(struct ly_ctx *ctx, const char *data, const char *end, int options, struct unres_data *unres,
+                   struct lyd_node **result)
+{
+    int r;
+    struct xml_stream stream;
+    struct lyxml_parse_clb clb;
+    struct lyxml_elem *xmlelem;
+
+    *result = NULL;
+
+    memset(&stream, 0, sizeof stream);
+    stream.ctx = ctx;
+    stream.options = options;
+    stream.unres = unres;
+    stream.size = 16;
+    stream.levels = malloc(stream.size * sizeof *stream.levels);
+    LY_CHECK_ERR_RETURN(!stream.levels, LOGMEM(ctx), EXIT_FAILURE);
+    memset(&stream.levels[0], 0, sizeof *stream.levels);
+    stream.count = 1;
+
+    clb.elem_start = xml_stream_elem_start;
+    clb.elem_end = xml_stream_elem_end;
+    clb.data = &stream;
+
+    r = lyxml_parse_mem_clb(ctx, data, end, LYXML_PARSE_MULTIROOT, &clb, &xmlelem);
+    free(stream.levels);
+    if (r) {
+        lyd_free_withsiblings(stream.first);
+        return EXIT_FAILURE;
+    }
+
+    *result = stream.first;
+    return EXIT_SUCCESS;
+}
@@ -2879,6 +2879,9 @@ fill_yin_deviation(struct lys_module *module, struct lyxml_elem *yin, struct lys
                                 (*trg_must)[i].ref = (*trg_must)[*trg_must_size].ref;
                                 (*trg_must)[i].eapptag = (*trg_must)[*trg_must_size].eapptag;
                                 (*trg_must)[i].emsg = (*trg_must)[*trg_must_size].emsg;
+#ifdef LY_ENABLED_CACHE
+                                (*trg_must)[i].compiled = (*trg_must)[*trg_must_size].compiled;
+#endif
                             }
                             if (!(*trg_must_size)) {
                                 free(*trg_must);
@@ -2889,6 +2892,9 @@ fill_yin_deviation(struct lys_module *module, struct lyxml_elem *yin, struct lys
                                 (*trg_must)[*trg_must_size].ref = NULL;
                                 (*trg_must)[*trg_must_size].eapptag = NULL;
                                 (*trg_must)[*trg_must_size].emsg = NULL;
+#ifdef LY_ENABLED_CACHE
+                                (*trg_must)[*trg_must_size].compiled = NULL;
+#endif
                             }
 
                             i = -1; /* set match flag */
@@ -12,7 +12,7 @@
  *     https://opensource.org/licenses/BSD-3-Clause
  */
 
-#define _GNU_SOURCE /* vasprintf(), vdprintf() */
+#define _GNU_SOURCE
 #define _POSIX_C_SOURCE 200809L
 
 #include <sys/types.h>
@@ -77,75 +77,191 @@ nscmp(const struct lyd_node *node1, const struct lyd_node *node2)
     }
 }
 
+/**
+ * @brief Make sure there is space for \p count more bytes in a buffer, it is enlarged geometrically
+ * so that the buffer is copied only a logarithmic number of times.
+ *
+ * @param[in,out] buf Buffer to enlarge, freed on error.
+ * @param[in,out] size Allocated size of \p buf.
+ * @param[in] len Used size of \p buf.
+ * @param[in] count Number of bytes to be added.
+ * @return 0 on success, -1 on error.
+ */
+static int
+ly_print_reserve(char **buf, size_t *size, size_t len, size_t count)
+{
+    size_t new_size;
+
+    if (len + count <= *size) {
+        return 0;
+    }
+
+    new_size = *size ? *size : 128;
+    while (new_size < len + count) {
+        new_size *= 2;
+    }
+
+    *buf = ly_realloc(*buf, new_size);
+    if (!*buf) {
+        *size = 0;
+        LOGMEM(NULL);
+        return -1;
+    }
+    *size = new_size;
+    return 0;
+}
+
+/**
+ * @brief Write data into LYOUT_FD or LYOUT_CALLBACK, until all of it is written or an error occurs.
+ *
+ * @param[in] out Output structure.
+ * @param[in] buf Data to write.
+ * @param[in] count Number of bytes in \p buf.
+ * @return Number of bytes written, -1 on error (errno set).
+ */
+static ssize_t
+ly_write_all(struct lyout *out, const char *buf, size_t count)
+{
+    size_t written = 0;
+    ssize_t r;
+    int errsv = errno;
+
+    while (written < count) {
+        if (out->type == LYOUT_FD) {
+            r = write(out->method.fd, buf + written, count - written);
+        } else {
+            r = out->method.clb.f(out->method.clb.arg, buf + written, count - written);
+        }
+        if ((r < 0) && (errno == EINTR)) {
+            continue;
+        } else if (r < 0) {
+            return -1;
+        } else if (!r) {
+            /* no progress, the rest of the data would be lost */
+            errno = EIO;
+            return -1;
+        }
+        written += r;
+    }
+
+    if (out->type == LYOUT_CALLBACK) {
+        /*
+         * Depending on what the callback function does, errno might
+         * contain non-zero values that are not real "errors" (EAGAIN or
+         * EINTR). Reset errno if the callback succeeded.
+         */
+        errno = 0;
+    } else {
+        /* forget any interrupted writes */
+        errno = errsv;
+    }
+    return written;
+}
+
+/**
+ * @brief Write all the data collected in the output buffer of LYOUT_FD or LYOUT_CALLBACK.
+ *
+ * @param[in] out Output structure.
+ * @return Number of bytes written, -1 on error (errno set).
+ */
+static ssize_t
+ly_write_wbuf(struct lyout *out)
+{
+    ssize_t r;
+
+    r = ly_write_all(out, out->wbuf, out->wbuf_len);
+    out->wbuf_len = 0;
+
+    return r;
+}
+
 int
 ly_print(struct lyout *out, const char *format, ...)
 {
-    int count = 0;
-    char *msg = NULL, *aux;
+    int count;
+    char **buf;
+    size_t *len, *size;
     va_list ap;
 
-    va_start(ap, format);
-
     switch (out->type) {
-    case LYOUT_FD:
-        count = vdprintf(out->method.fd, format, ap);
-        break;
     case LYOUT_STREAM:
+        va_start(ap, format);
         count = vfprintf(out->method.f, format, ap);
-        break;
+        va_end(ap);
+        return count;
     case LYOUT_MEMORY:
-        count = vasprintf(&msg, format, ap);
-        if (out->method.mem.len + count + 1 > out->method.mem.size) {
-            aux = ly_realloc(out->method.mem.buf, out->method.mem.len + count + 1);
-            if (!aux) {
-                out->method.mem.buf = NULL;
-                out->method.mem.len = 0;
-                out->method.mem.size = 0;
-                LOGMEM(NULL);
-                va_end(ap);
-                return -1;
-            }
-            out->method.mem.buf = aux;
-            out->method.mem.size = out->method.mem.len + count + 1;
-        }
-        memcpy(&out->method.mem.buf[out->method.mem.len], msg, count);
-        out->method.mem.len += count;
-        out->method.mem.buf[out->method.mem.len] = '\0';
-        free(msg);
+        buf = &out->method.mem.buf;
+        len = &out->method.mem.len;
+        size = &out->method.mem.size;
         break;
+    case LYOUT_FD:
     case LYOUT_CALLBACK:
-        count = vasprintf(&msg, format, ap);
-        count = out->method.clb.f(out->method.clb.arg, msg, count);
+        buf = &out->wbuf;
+        len = &out->wbuf_len;
+        size = &out->wbuf_size;
+        break;
+    default:
+        LOGINT(NULL);
+        return -1;
+    }
+
+    /* print directly into the buffer and only if it does not fit, enlarge it and print again */
+    va_start(ap, format);
+    count = vsnprintf(*buf ? *buf + *len : NULL, *size - *len, format, ap);
+    va_end(ap);
+    if (count < 0) {
+        return count;
+    }
+    if ((size_t)count + 1 > *size - *len) {
+        if (ly_print_reserve(buf, size, *len, count + 1)) {
+            *len = 0;
+            return -1;
+        }
+        va_start(ap, format);
+        vsnprintf(*buf + *len, *size - *len, format, ap);
+        va_end(ap);
+    }
+    *len += count;
+
+    if (out->type == LYOUT_CALLBACK && !count && !out->wbuf_len) {
+        /* pass even the empty output to the callback so that it learns about it */
+        count = out->method.clb.f(out->method.clb.arg, "", 0);
         if (count >= 0) {
-            /*
-             * Depending on what the callback function does, errno might
-             * contain non-zero values that are not real "errors" (EAGAIN or
-             * EINTR). Reset errno if the callback returns a zero or positive
-             * value.
-             */
             errno = 0;
         }
-        free(msg);
-        break;
+    } else if ((out->type != LYOUT_MEMORY) && (out->wbuf_len >= LYOUT_WBUF_SIZE) && (ly_write_wbuf(out) < 0)) {
+        return -1;
     }
 
-    va_end(ap);
     return count;
 }
 
-void
+int
 ly_print_flush(struct lyout *out)
 {
+    int ret = 0;
+
     switch (out->type) {
     case LYOUT_STREAM:
-        fflush(out->method.f);
+        if (fflush(out->method.f)) {
+            ret = -1;
+        }
         break;
     case LYOUT_FD:
-    case LYOUT_MEMORY:
     case LYOUT_CALLBACK:
+        if (ly_write_wbuf(out) < 0) {
+            ret = -1;
+        }
+        free(out->wbuf);
+        out->wbuf = NULL;
+        out->wbuf_size = 0;
+        break;
+    case LYOUT_MEMORY:
         /* nothing to do */
         break;
     }
+
+    return ret;
 }
 
 int
@@ -153,15 +269,9 @@ ly_write(struct lyout *out, const char *buf, size_t count)
 {
     if (out->hole_count) {
         /* we are buffering data after a hole */
-        if (out->buf_len + count > out->buf_size) {
-            out->buffered = ly_realloc(out->buffered, out->buf_len + count);
-            if (!out->buffered) {
-                out->buf_len = 0;
-                out->buf_size = 0;
-                LOGMEM(NULL);
-                return -1;
-            }
-            out->buf_size = out->buf_len + count;
+        if (ly_print_reserve(&out->buffered, &out->buf_size, out->buf_len, count)) {
+            out->buf_len = 0;
+            return -1;
         }
 
         memcpy(&out->buffered[out->buf_len], buf, count);
@@ -171,26 +281,35 @@ ly_write(struct lyout *out, const char *buf, size_t count)
 
     switch (out->type) {
     case LYOUT_MEMORY:
-        if (out->method.mem.len + count + 1 > out->method.mem.size) {
-            out->method.mem.buf = ly_realloc(out->method.mem.buf, out->method.mem.len + count + 1);
-            if (!out->method.mem.buf) {
-                out->method.mem.len = 0;
-                out->method.mem.size = 0;
-                LOGMEM(NULL);
-                return -1;
-            }
-            out->method.mem.size = out->method.mem.len + count + 1;
+        if (ly_print_reserve(&out->method.mem.buf, &out->method.mem.size, out->method.mem.len, count + 1)) {
+            out->method.mem.len = 0;
+            return -1;
         }
         memcpy(&out->method.mem.buf[out->method.mem.len], buf, count);
         out->method.mem.len += count;
         out->method.mem.buf[out->method.mem.len] = '\0';
         return count;
     case LYOUT_FD:
-        return write(out->method.fd, buf, count);
+    case LYOUT_CALLBACK:
+        if (out->wbuf_len + count > LYOUT_WBUF_SIZE) {
+            /* write the collected data first */
+            if (ly_write_wbuf(out) < 0) {
+                return -1;
+            }
+        }
+        if (count >= LYOUT_WBUF_SIZE) {
+            /* too large to be collected, write it directly */
+            return ly_write_all(out, buf, count);
+        }
+        if (ly_print_reserve(&out->wbuf, &out->wbuf_size, out->wbuf_len, count)) {
+            out->wbuf_len = 0;
+            return -1;
+        }
+        memcpy(&out->wbuf[out->wbuf_len], buf, count);
+        out->wbuf_len += count;
+        return count;
     case LYOUT_STREAM:
         return fwrite(buf, sizeof *buf, count, out->method.f);
-    case LYOUT_CALLBACK:
-        return out->method.clb.f(out->method.clb.arg, buf, count);
     }
 
     return 0;
@@ -201,15 +320,9 @@ ly_write_skip(struct lyout *out, size_t count, size_t *position)
 {
     switch (out->type) {
     case LYOUT_MEMORY:
-        if (out->method.mem.len + count > out->method.mem.size) {
-            out->method.mem.buf = ly_realloc(out->method.mem.buf, out->method.mem.len + count);
-            if (!out->method.mem.buf) {
-                out->method.mem.len = 0;
-                out->method.mem.size = 0;
-                LOGMEM(NULL);
-                return -1;
-            }
-            out->method.mem.size = out->method.mem.len + count;
+        if (ly_print_reserve(&out->method.mem.buf, &out->method.mem.size, out->method.mem.len, count)) {
+            out->method.mem.len = 0;
+            return -1;
         }
 
         /* save the current position */
@@ -222,15 +335,9 @@ ly_write_skip(struct lyout *out, size_t count, size_t *position)
     case LYOUT_STREAM:
     case LYOUT_CALLBACK:
         /* buffer the hole */
-        if (out->buf_len + count > out->buf_size) {
-            out->buffered = ly_realloc(out->buffered, out->buf_len + count);
-            if (!out->buffered) {
-                out->buf_len = 0;
-                out->buf_size = 0;
-                LOGMEM(NULL);
-                return -1;
-            }
-            out->buf_size = out->buf_len + count;
+        if (ly_print_reserve(&out->buffered, &out->buf_size, out->buf_len, count)) {
+            out->buf_len = 0;
+            return -1;
         }
 
         /* save the current position */
@@ -379,6 +486,11 @@ lys_print_(struct lyout *out, const struct lys_module *module, LYS_OUTFORMAT for
         break;
     }
 
+    /* write any data still buffered */
+    if (ly_print_flush(out) && !ret) {
+        LOGERR(module->ctx, LY_ESYS, "Print error (%s).", strerror(errno));
+        ret = EXIT_FAILURE;
+    }
     return ret;
 }
 
@@ -704,17 +816,30 @@ lys_print_target(struct lyout *out, const struct lys_module *module, const char
 static int
 lyd_print_(struct lyout *out, const struct lyd_node *root, LYD_FORMAT format, int options)
 {
+    int ret;
+
     switch (format) {
     case LYD_XML:
-        return xml_print_data(out, root, options);
+        ret = xml_print_data(out, root, options);
+        break;
     case LYD_JSON:
-        return json_print_data(out, root, options);
+        ret = json_print_data(out, root, options);
+        break;
     case LYD_LYB:
-        return lyb_print_data(out, root, options);
+        ret = lyb_print_data(out, root, options);
+        break;
     default:
         LOGERR(root->schema->module->ctx, LY_EINVAL, "Unknown output format.");
-        return EXIT_FAILURE;
+        ret = EXIT_FAILURE;
+        break;
     }
+
+    /* write any data still buffered */
+    if (ly_print_flush(out) && !ret) {
+        LOGERR(root->schema->module->ctx, LY_ESYS, "Print error (%s).", strerror(errno));
+        ret = EXIT_FAILURE;
+    }
+    return ret;
 }
 
 API int
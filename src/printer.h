@@ -49,8 +49,16 @@ struct lyout {
 
     /* hole counter */
     size_t hole_count;
+
+    /* buffer collecting the output for LYOUT_FD and LYOUT_CALLBACK, written once full or on flush */
+    char *wbuf;
+    size_t wbuf_len;
+    size_t wbuf_size;
 };
 
+/** amount of data collected for LYOUT_FD and LYOUT_CALLBACK before they are written */
+#define LYOUT_WBUF_SIZE 4096
+
 struct ext_substmt_info_s {
     const char *name;
     const char *arg;
@@ -71,7 +79,7 @@ extern struct ext_substmt_info_s ext_substmt_info[];
  * @brief Generic printer, replacement for printf() / write() / etc
  */
 int ly_print(struct lyout *out, const char *format, ...);
-void ly_print_flush(struct lyout *out);
+int ly_print_flush(struct lyout *out);
 int ly_write(struct lyout *out, const char *buf, size_t count);
 int ly_write_skip(struct lyout *out, size_t count, size_t *position);
 int ly_write_skipped(struct lyout *out, size_t position, const char *buf, size_t count);
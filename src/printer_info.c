@@ -1044,7 +1044,6 @@ info_print_model(struct lyout *out, const struct lys_module *module, const char
                               info_print_input,
                               info_print_output);
     }
-    ly_print_flush(out);
 
     return rc;
 }
@@ -1312,7 +1312,6 @@ jsons_print_model(struct lyout *out, const struct lys_module *module, const char
                               jsons_print_output);
         ly_print(out, "}");
     }
-    ly_print_flush(out);
 
     return rc;
 }
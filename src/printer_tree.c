@@ -1019,7 +1019,5 @@ tree_print_model(struct lyout *out, const struct lys_module *module, const char
         }
     }
 
-    ly_print_flush(out);
-
     return EXIT_SUCCESS;
 }
@@ -1800,7 +1800,6 @@ yang_print_model_(struct lyout *out, int level, const struct lys_module *module)
 
     level--;
     ly_print(out, "%*s}\n", LEVEL, INDENT);
-    ly_print_flush(out);
 
     return EXIT_SUCCESS;
 }
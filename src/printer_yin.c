@@ -1805,7 +1805,6 @@ yin_print_model_(struct lyout *out, int level, const struct lys_module *module)
     } else {
         ly_print(out, "%*s</module>\n", LEVEL, INDENT);
     }
-    ly_print_flush(out);
 
     return EXIT_SUCCESS;
 }
@@ -2248,13 +2248,31 @@ resolve_json_schema_list_predicate(const char *predicate, const struct lys_node_
     return 0;
 }
 
+/* whether a schema node is in an RPC/action input when looking for \p output nodes or vice versa */
+static int
+resolve_json_nodeid_inout_skip(const struct lys_node *node, int output)
+{
+    const struct lys_node *parent;
+
+    for (parent = lys_parent(node); parent && !(parent->nodetype & (LYS_INPUT | LYS_OUTPUT)); parent = lys_parent(parent));
+    if (parent) {
+        if (output && (parent->nodetype == LYS_INPUT)) {
+            return 1;
+        } else if (!output && (parent->nodetype == LYS_OUTPUT)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 /* cannot return LYS_GROUPING, LYS_AUGMENT, LYS_USES, logs directly */
 const struct lys_node *
 resolve_json_nodeid(const char *nodeid, const struct ly_ctx *ctx, const struct lys_node *start, int output)
 {
     char *str;
     const char *name, *mod_name, *id, *backup_mod_name = NULL, *yang_data_name = NULL;
-    const struct lys_node *sibling, *start_parent, *parent;
+    const struct lys_node *sibling, *start_parent;
     int r, nam_len, mod_name_len, is_relative = -1, has_predicate;
     int yang_data_name_len, backup_mod_name_len;
     /* resolved import module from the start module, it must match the next node-name-match sibling */
@@ -2341,72 +2359,38 @@ resolve_json_nodeid(const char *nodeid, const struct ly_ctx *ctx, const struct l
     prev_mod = module;
 
     while (1) {
-        sibling = NULL;
-        while ((sibling = lys_getnext(sibling, start_parent, module, 0))) {
-            /* name match */
-            if (sibling->name && !strncmp(name, sibling->name, nam_len) && !sibling->name[nam_len]) {
-                /* output check */
-                for (parent = lys_parent(sibling); parent && !(parent->nodetype & (LYS_INPUT | LYS_OUTPUT)); parent = lys_parent(parent));
-                if (parent) {
-                    if (output && (parent->nodetype == LYS_INPUT)) {
-                        continue;
-                    } else if (!output && (parent->nodetype == LYS_OUTPUT)) {
-                        continue;
-                    }
-                }
+        /* will also find an augment module */
+        prefix_mod = mod_name ? ly_ctx_nget_module(ctx, mod_name, mod_name_len, NULL, 1) : prev_mod;
 
-                /* module check */
-                if (mod_name) {
-                    /* will also find an augment module */
-                    prefix_mod = ly_ctx_nget_module(ctx, mod_name, mod_name_len, NULL, 1);
-
-                    if (!prefix_mod) {
-                        str = strndup(nodeid, (mod_name + mod_name_len) - nodeid);
-                        LOGVAL(ctx, LYE_PATH_INMOD, LY_VLOG_STR, str);
-                        free(str);
-                        return NULL;
-                    }
-                } else {
-                    prefix_mod = prev_mod;
-                }
-                if (prefix_mod != lys_node_module(sibling)) {
+        sibling = NULL;
+        if (prefix_mod && (!start_parent || !(start_parent->nodetype & (LYS_RPC | LYS_ACTION)))) {
+            /* there can be only a single sibling with the name and module */
+            sibling = lys_child_find(start_parent, module, prefix_mod->name, NULL, name, nam_len, 0);
+            if (sibling && resolve_json_nodeid_inout_skip(sibling, output)) {
+                sibling = NULL;
+            }
+        } else {
+            while ((sibling = lys_getnext(sibling, start_parent, module, 0))) {
+                /* name match */
+                if (!sibling->name || strncmp(name, sibling->name, nam_len) || sibling->name[nam_len]) {
                     continue;
                 }
 
-                /* do we have some predicates on it? */
-                if (has_predicate) {
-                    r = 0;
-                    if (sibling->nodetype & (LYS_LEAF | LYS_LEAFLIST)) {
-                        if ((r = parse_schema_json_predicate(id, NULL, NULL, NULL, NULL, NULL, NULL, &has_predicate)) < 1) {
-                            LOGVAL(ctx, LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, id[-r], &id[-r]);
-                            return NULL;
-                        }
-                    } else if (sibling->nodetype == LYS_LIST) {
-                        if (resolve_json_schema_list_predicate(id, (const struct lys_node_list *)sibling, &r)) {
-                            return NULL;
-                        }
-                    } else {
-                        LOGVAL(ctx, LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, id[0], id);
-                        return NULL;
-                    }
-                    id += r;
-                }
-
-                /* the result node? */
-                if (!id[0]) {
-                    return sibling;
+                /* output check */
+                if (resolve_json_nodeid_inout_skip(sibling, output)) {
+                    continue;
                 }
 
-                /* move down the tree, if possible */
-                if (sibling->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) {
-                    LOGVAL(ctx, LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, id[0], id);
+                /* module check */
+                if (!prefix_mod) {
+                    str = strndup(nodeid, (mod_name + mod_name_len) - nodeid);
+                    LOGVAL(ctx, LYE_PATH_INMOD, LY_VLOG_STR, str);
+                    free(str);
                     return NULL;
                 }
-                start_parent = sibling;
-
-                /* update prev mod */
-                prev_mod = (start_parent->child ? lys_node_module(start_parent->child) : module);
-                break;
+                if (prefix_mod == lys_node_module(sibling)) {
+                    break;
+                }
             }
         }
 
@@ -2418,6 +2402,40 @@ resolve_json_nodeid(const char *nodeid, const struct ly_ctx *ctx, const struct l
             return NULL;
         }
 
+        /* do we have some predicates on it? */
+        if (has_predicate) {
+            r = 0;
+            if (sibling->nodetype & (LYS_LEAF | LYS_LEAFLIST)) {
+                if ((r = parse_schema_json_predicate(id, NULL, NULL, NULL, NULL, NULL, NULL, &has_predicate)) < 1) {
+                    LOGVAL(ctx, LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, id[-r], &id[-r]);
+                    return NULL;
+                }
+            } else if (sibling->nodetype == LYS_LIST) {
+                if (resolve_json_schema_list_predicate(id, (const struct lys_node_list *)sibling, &r)) {
+                    return NULL;
+                }
+            } else {
+                LOGVAL(ctx, LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, id[0], id);
+                return NULL;
+            }
+            id += r;
+        }
+
+        /* the result node? */
+        if (!id[0]) {
+            return sibling;
+        }
+
+        /* move down the tree, if possible */
+        if (sibling->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) {
+            LOGVAL(ctx, LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, id[0], id);
+            return NULL;
+        }
+        start_parent = sibling;
+
+        /* update prev mod */
+        prev_mod = (start_parent->child ? lys_node_module(start_parent->child) : module);
+
         if ((r = parse_schema_nodeid(id, &mod_name, &mod_name_len, &name, &nam_len, &is_relative, &has_predicate, NULL, 0)) < 1) {
             LOGVAL(ctx, LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, id[-r], &id[-r]);
             return NULL;
@@ -2671,6 +2689,9 @@ resolve_partial_json_data_nodeid(const char *nodeid, const char *llist_value, st
         if (((pp.schema->nodetype != LYS_LIST) || (((struct lys_node_list *)pp.schema)->keys_size && !isdigit(pp.pred[0].name[0])))
                 && ((pp.schema->nodetype != LYS_LEAFLIST) || (pp.schema->flags & LYS_CONFIG_W))) {
             sibling = resolve_json_data_node_hash(start, pp);
+        } else if ((ssibling->nodetype == LYS_LIST) && isdigit(pp.pred[0].name[0])) {
+            /* list instance position */
+            sibling = lyd_list_nth(start, ssibling, atoi(pp.pred[0].name));
         } else {
             list_instance_position = 0;
             LY_TREE_FOR(start, sibling) {
@@ -5386,6 +5407,9 @@ resolve_uses(struct lys_node_uses *uses, struct unres_schema *unres)
                 must[j].eapptag = lydict_insert(ctx, rfn->must[k].eapptag, 0);
                 must[j].emsg = lydict_insert(ctx, rfn->must[k].emsg, 0);
                 must[j].flags = rfn->must[k].flags;
+#ifdef LY_ENABLED_CACHE
+                must[j].compiled = NULL;
+#endif
             }
 
             *old_must = must;
@@ -6272,7 +6296,8 @@ resolve_must(struct lyd_node *node, int inout_parent, int ignore_fail)
     }
 
     for (i = 0; i < must_size; ++i) {
-        if (lyxp_eval(must[i].expr, node, LYXP_NODE_ELEM, lyd_node_module(node), &set, LYXP_MUST)) {
+        if (lyxp_eval_cached(must[i].expr, LYXP_COMPILED(&must[i]), node, LYXP_NODE_ELEM, lyd_node_module(node), &set,
+                             LYXP_MUST)) {
             return -1;
         }
 
@@ -6681,8 +6706,8 @@ resolve_when(struct lyd_node *node, int ignore_fail, struct lys_when **failed_wh
     if (!(node->schema->nodetype & (LYS_NOTIF | LYS_RPC | LYS_ACTION)) && snode_get_when(node->schema)) {
         /* make the node dummy for the evaluation */
         node->validity |= LYD_VAL_INUSE;
-        rc = lyxp_eval(snode_get_when(node->schema)->cond, node, LYXP_NODE_ELEM, lyd_node_module(node),
-                       &set, LYXP_WHEN);
+        rc = lyxp_eval_cached(snode_get_when(node->schema)->cond, LYXP_COMPILED(snode_get_when(node->schema)), node,
+                              LYXP_NODE_ELEM, lyd_node_module(node), &set, LYXP_WHEN);
         node->validity &= ~LYD_VAL_INUSE;
         if (rc) {
             if (rc == 1) {
@@ -6733,8 +6758,8 @@ resolve_when(struct lyd_node *node, int ignore_fail, struct lys_when **failed_wh
                 goto cleanup;
             }
 
-            rc = lyxp_eval(snode_get_when(sparent)->cond, ctx_node, ctx_node_type, lys_node_module(sparent),
-                           &set, LYXP_WHEN);
+            rc = lyxp_eval_cached(snode_get_when(sparent)->cond, LYXP_COMPILED(snode_get_when(sparent)), ctx_node,
+                                  ctx_node_type, lys_node_module(sparent), &set, LYXP_WHEN);
 
             if (unlinked_nodes && ctx_node) {
                 if (resolve_when_relink_nodes(ctx_node, unlinked_nodes, ctx_node_type)) {
@@ -6786,8 +6811,8 @@ check_augment:
                 goto cleanup;
             }
 
-            rc = lyxp_eval(snode_get_when(sparent->parent)->cond, ctx_node, ctx_node_type,
-                           lys_node_module(sparent->parent), &set, LYXP_WHEN);
+            rc = lyxp_eval_cached(snode_get_when(sparent->parent)->cond, LYXP_COMPILED(snode_get_when(sparent->parent)),
+                                  ctx_node, ctx_node_type, lys_node_module(sparent->parent), &set, LYXP_WHEN);
 
             /* reconnect nodes, if ctx_node is NULL then all the nodes were unlinked, but linked together,
              * so the tree did not actually change and there is nothing for us to do
@@ -7964,17 +7989,195 @@ error:
     return -1;
 }
 
+/**
+ * @brief Leafref target index of a single target schema node.
+ */
+struct lref_index {
+    const struct lys_node *target; /* leafref target schema node */
+    struct hash_table *ht;         /* data instances of the target hashed by their (canonical) value */
+};
+
+static int
+resolve_lref_index_equal(void *val1_p, void *val2_p, int UNUSED(mod), void *UNUSED(cb_data))
+{
+    struct lref_index *idx1, *idx2;
+
+    idx1 = (struct lref_index *)val1_p;
+    idx2 = (struct lref_index *)val2_p;
+
+    return idx1->target == idx2->target;
+}
+
+static int
+resolve_lref_value_equal(void *val1_p, void *val2_p, int UNUSED(mod), void *UNUSED(cb_data))
+{
+    struct lyd_node_leaf_list *leaf1, *leaf2;
+
+    leaf1 = *((struct lyd_node_leaf_list **)val1_p);
+    leaf2 = *((struct lyd_node_leaf_list **)val2_p);
+
+    /* values are in the dictionary */
+    return leaf1->value_str == leaf2->value_str;
+}
+
+static uint32_t
+resolve_lref_ptr_hash(const void *ptr)
+{
+    uint32_t hash;
+
+    hash = dict_hash_multi(0, (const char *)&ptr, sizeof ptr);
+    return dict_hash_multi(hash, NULL, 0);
+}
+
+/**
+ * @brief Add all the data instances of a schema node into a leafref target index.
+ *
+ * @param[in] ht Hash table of the index.
+ * @param[in] first First sibling to search.
+ * @param[in] snodes Data schema nodes from the target (index 0) to the top-level one.
+ * @param[in] depth Index into \p snodes of the schema node of \p first and its siblings.
+ * @return 0 on success, -1 on error.
+ */
+static int
+resolve_lref_index_fill(struct hash_table *ht, struct lyd_node *first, const struct lys_node **snodes, int depth)
+{
+    struct lyd_node *node;
+
+    LY_TREE_FOR(first, node) {
+        if ((node->schema != snodes[depth]) || (node->validity & LYD_VAL_INUSE)) {
+            /* dummy nodes are skipped by XPath as well */
+            continue;
+        }
+
+        if (!depth) {
+            /* keep the first instance in the document order, the same one XPath would return */
+            if (lyht_insert(ht, &node, resolve_lref_ptr_hash(((struct lyd_node_leaf_list *)node)->value_str), NULL) == -1) {
+                return -1;
+            }
+        } else if (resolve_lref_index_fill(ht, node->child, snodes, depth - 1)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Find the leafref target instance using the index, create the target index if needed.
+ * Usable only for absolute leafref paths without predicates, which always select all the
+ * target instances in the data tree.
+ *
+ * @param[in] leaf Leafref data node.
+ * @param[in] type Leafref type of \p leaf.
+ * @param[in,out] lref_idx Leafref target index of the whole data tree of \p leaf.
+ * @param[out] ret Resolved target node or NULL.
+ * @return 0 on success (even if unresolved and \p ret is NULL), -1 on error.
+ */
+static int
+resolve_leafref_index(struct lyd_node_leaf_list *leaf, struct lys_type *type, struct hash_table **lref_idx,
+                      struct lyd_node **ret)
+{
+    struct ly_ctx *ctx = leaf->schema->module->ctx;
+    struct lref_index idx, *match;
+    const struct lys_node *snode, **snodes = NULL;
+    struct lyd_node *root, **found;
+    uint32_t hash;
+    int count, r;
+
+    if (!*lref_idx) {
+        *lref_idx = lyht_new(8, sizeof idx, resolve_lref_index_equal, NULL, 1);
+        LY_CHECK_ERR_RETURN(!*lref_idx, LOGMEM(ctx), -1);
+    }
+
+    idx.target = (struct lys_node *)type->info.lref.target;
+    idx.ht = NULL;
+    hash = resolve_lref_ptr_hash(idx.target);
+    if (lyht_find(*lref_idx, &idx, hash, (void **)&match)) {
+        /* create the index of this target, get all the data schema parents first */
+        count = 0;
+        for (snode = idx.target; snode; snode = lys_parent(snode)) {
+            if (snode->nodetype & (LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST | LYS_RPC | LYS_ACTION | LYS_NOTIF)) {
+                ++count;
+            }
+        }
+        snodes = malloc(count * sizeof *snodes);
+        LY_CHECK_ERR_RETURN(!snodes, LOGMEM(ctx), -1);
+        count = 0;
+        for (snode = idx.target; snode; snode = lys_parent(snode)) {
+            if (snode->nodetype & (LYS_CONTAINER | LYS_LIST | LYS_LEAF | LYS_LEAFLIST | LYS_RPC | LYS_ACTION | LYS_NOTIF)) {
+                snodes[count++] = snode;
+            }
+        }
+
+        idx.ht = lyht_new(8, sizeof(struct lyd_node *), resolve_lref_value_equal, NULL, 1);
+        LY_CHECK_ERR_GOTO(!idx.ht, LOGMEM(ctx), error);
+
+        /* the same root as of the XPath evaluation */
+        for (root = (struct lyd_node *)leaf; root->parent; root = root->parent);
+        for (; root->prev->next; root = root->prev);
+        if (resolve_lref_index_fill(idx.ht, root, snodes, count - 1)) {
+            goto error;
+        }
+
+        r = lyht_insert(*lref_idx, &idx, hash, (void **)&match);
+        LY_CHECK_ERR_GOTO(r, LOGINT(ctx), error);
+        free(snodes);
+    }
+
+    if (lyht_find(match->ht, &leaf, resolve_lref_ptr_hash(leaf->value_str), (void **)&found)) {
+        *ret = NULL;
+    } else {
+        *ret = *found;
+    }
+    return 0;
+
+error:
+    lyht_free(idx.ht);
+    free(snodes);
+    return -1;
+}
+
+static void
+resolve_leafref_index_free(struct hash_table *lref_idx)
+{
+    struct ht_rec *rec;
+    uint32_t i;
+
+    if (!lref_idx) {
+        return;
+    }
+
+    for (i = 0; i < lref_idx->size; ++i) {
+        rec = lyht_get_rec(lref_idx->recs, lref_idx->rec_size, i);
+        if (rec->hits > 0) {
+            lyht_free(((struct lref_index *)rec->val)->ht);
+        }
+    }
+    lyht_free(lref_idx);
+}
+
 int
-resolve_leafref(struct lyd_node_leaf_list *leaf, const char *path, int req_inst, struct lyd_node **ret)
+resolve_leafref(struct lyd_node_leaf_list *leaf, struct lys_type *type, int req_inst, struct hash_table **lref_idx,
+                struct lyd_node **ret)
 {
     struct lyxp_set xp_set;
+    const char *path = type->info.lref.path;
     uint32_t i;
 
     memset(&xp_set, 0, sizeof xp_set);
     *ret = NULL;
 
+    if (lref_idx && (path[0] == '/') && !strchr(path, '[') && type->info.lref.target) {
+        /* the path selects all the target instances, just look for the value */
+        if (resolve_leafref_index(leaf, type, lref_idx, ret)) {
+            return -1;
+        }
+        goto check;
+    }
+
     /* syntax was already checked, so just evaluate the path using standard XPath */
-    if (lyxp_eval(path, (struct lyd_node *)leaf, LYXP_NODE_ELEM, lyd_node_module((struct lyd_node *)leaf), &xp_set, 0) != EXIT_SUCCESS) {
+    if (lyxp_eval_cached(path, LYXP_COMPILED(&type->info.lref), (struct lyd_node *)leaf, LYXP_NODE_ELEM,
+                         lyd_node_module((struct lyd_node *)leaf), &xp_set, 0) != EXIT_SUCCESS) {
         return -1;
     }
 
@@ -7996,6 +8199,7 @@ resolve_leafref(struct lyd_node_leaf_list *leaf, const char *path, int req_inst,
 
     lyxp_set_cast(&xp_set, LYXP_SET_EMPTY, (struct lyd_node *)leaf, NULL, 0);
 
+check:
     if (!*ret) {
         /* reference not found */
         if (req_inst > -1) {
@@ -8050,7 +8254,7 @@ resolve_union(struct lyd_node_leaf_list *leaf, struct lys_type *type, int store,
                 req_inst = t->info.lref.req;
             }
 
-            if (!resolve_leafref(leaf, t->info.lref.path, req_inst, &ret)) {
+            if (!resolve_leafref(leaf, t, req_inst, NULL, &ret)) {
                 if (store) {
                     if (ret && !(leaf->schema->flags & LYS_LEAFREF_DEP)) {
                         /* valid resolved */
@@ -8158,11 +8362,14 @@ resolve_union(struct lyd_node_leaf_list *leaf, struct lys_type *type, int store,
  * @param[in] node Data node to resolve.
  * @param[in] type Type of the unresolved item.
  * @param[in] ignore_fail 0 - no, 1 - yes, 2 - yes, but only for external dependencies.
+ * @param[in,out] lref_idx Optional leafref target index, usable only while the data tree is not modified.
+ * @param[out] failed_when Optional failed when condition.
  *
  * @return EXIT_SUCCESS on success, EXIT_FAILURE on forward reference, -1 on error.
  */
 int
-resolve_unres_data_item(struct lyd_node *node, enum UNRES_ITEM type, int ignore_fail, struct lys_when **failed_when)
+resolve_unres_data_item(struct lyd_node *node, enum UNRES_ITEM type, int ignore_fail, struct hash_table **lref_idx,
+                        struct lys_when **failed_when)
 {
     int rc, req_inst, ext_dep;
     struct lyd_node_leaf_list *leaf;
@@ -8185,7 +8392,7 @@ resolve_unres_data_item(struct lyd_node *node, enum UNRES_ITEM type, int ignore_
             rc = 0;
             ret = NULL;
         } else {
-            rc = resolve_leafref(leaf, sleaf->type.info.lref.path, req_inst, &ret);
+            rc = resolve_leafref(leaf, &sleaf->type, req_inst, lref_idx, &ret);
         }
         if (!rc) {
             if (ret && !(leaf->schema->flags & LYS_LEAFREF_DEP)) {
@@ -8389,6 +8596,7 @@ resolve_unres_data(struct ly_ctx *ctx, struct unres_data *unres, struct lyd_node
     LY_ERR prev_ly_errno = ly_errno;
     struct lyd_node *parent;
     struct lys_when *when;
+    struct hash_table *lref_idx = NULL;
 
     assert(root);
     assert(unres);
@@ -8451,7 +8659,7 @@ resolve_unres_data(struct ly_ctx *ctx, struct unres_data *unres, struct lyd_node
             }
 
             prev_when_status = unres->node[i]->when_status;
-            rc = resolve_unres_data_item(unres->node[i], unres->type[i], ignore_fail, &when);
+            rc = resolve_unres_data_item(unres->node[i], unres->type[i], ignore_fail, NULL, &when);
             if (!rc) {
                 /* finish with error/delete the node only if when was changed from true to false, an external
                  * dependency was not required, or it was not provided (the flag would not be passed down otherwise,
@@ -8522,6 +8730,10 @@ resolve_unres_data(struct ly_ctx *ctx, struct unres_data *unres, struct lyd_node
         first = 0;
     } while (progress && resolved < stmt_count);
 
+    /* the tree may be modified from now on */
+    resolve_leafref_index_free(lref_idx);
+    lref_idx = NULL;
+
     /* do we have some unresolved when-stmt? */
     if (stmt_count > resolved) {
         goto error;
@@ -8573,7 +8785,7 @@ resolve_unres_data(struct ly_ctx *ctx, struct unres_data *unres, struct lyd_node
                 stmt_count++;
             }
 
-            rc = resolve_unres_data_item(unres->node[i], unres->type[i], ignore_fail, NULL);
+            rc = resolve_unres_data_item(unres->node[i], unres->type[i], ignore_fail, &lref_idx, NULL);
             if (!rc) {
                 unres->type[i] = UNRES_RESOLVED;
                 if (!ignore_fail) {
@@ -8588,6 +8800,10 @@ resolve_unres_data(struct ly_ctx *ctx, struct unres_data *unres, struct lyd_node
         first = 0;
     } while (progress && resolved < stmt_count);
 
+    /* the tree may be modified from now on */
+    resolve_leafref_index_free(lref_idx);
+    lref_idx = NULL;
+
     /* do we have some unresolved leafrefs? */
     if (stmt_count > resolved) {
         goto error;
@@ -8608,7 +8824,7 @@ resolve_unres_data(struct ly_ctx *ctx, struct unres_data *unres, struct lyd_node
         }
         assert(!(options & LYD_OPT_TRUSTED) || ((unres->type[i] != UNRES_MUST) && (unres->type[i] != UNRES_MUST_INOUT)));
 
-        rc = resolve_unres_data_item(unres->node[i], unres->type[i], ignore_fail, NULL);
+        rc = resolve_unres_data_item(unres->node[i], unres->type[i], ignore_fail, NULL, NULL);
         if (rc) {
             /* since when was already resolved, a forward reference is an error */
             return -1;
@@ -8622,6 +8838,7 @@ resolve_unres_data(struct ly_ctx *ctx, struct unres_data *unres, struct lyd_node
     return EXIT_SUCCESS;
 
 error:
+    resolve_leafref_index_free(lref_idx);
     if (!ignore_fail) {
         /* print all the new errors */
         ly_ilo_restore(ctx, prev_ilo, prev_eitem, 1);
@@ -18,6 +18,8 @@
 #include "libyang.h"
 #include "extensions.h"
 
+struct hash_table;
+
 /**
  * @brief Type of an unresolved item (in either SCHEMA or DATA)
  */
@@ -98,6 +100,8 @@ struct unres_data {
     struct lyd_difflist *diff;
     unsigned int diff_size;
     unsigned int diff_idx;
+
+    struct lyd_arena *arena;    /* arena of the parsed data nodes (LYD_OPT_ARENA) */
 };
 
 /**
@@ -244,12 +248,26 @@ void unres_schema_free(struct lys_module *module, struct unres_schema **unres, i
  */
 int resolve_instid(struct lyd_node *data, const char *path, int req_inst, struct lyd_node **ret);
 
-int resolve_leafref(struct lyd_node_leaf_list *leaf, const char *path, int req_inst, struct lyd_node **ret);
+/**
+ * @brief Resolve leafref in data. Logs directly.
+ *
+ * @param[in] leaf Leafref data node.
+ * @param[in] type Leafref type of \p leaf, its compiled path is reused if possible.
+ * @param[in] req_inst Whether the target instance is required (> -1) or not.
+ * @param[in,out] lref_idx Optional leafref target index used instead of XPath evaluation for absolute paths
+ * without predicates, created on first use. Valid only while the data tree is not modified.
+ * @param[out] ret Resolved target node or NULL.
+ *
+ * @return 0 on success (even if unresolved and \p ret is NULL), 1 if required instance is missing, -1 on error.
+ */
+int resolve_leafref(struct lyd_node_leaf_list *leaf, struct lys_type *type, int req_inst, struct hash_table **lref_idx,
+                    struct lyd_node **ret);
 
 int resolve_union(struct lyd_node_leaf_list *leaf, struct lys_type *type, int store, int ignore_fail,
                   struct lys_type **resolved_type);
 
-int resolve_unres_data_item(struct lyd_node *dnode, enum UNRES_ITEM type, int ignore_fail, struct lys_when **failed_when);
+int resolve_unres_data_item(struct lyd_node *dnode, enum UNRES_ITEM type, int ignore_fail, struct hash_table **lref_idx,
+                            struct lys_when **failed_when);
 
 int unres_data_addonly(struct unres_data *unres, struct lyd_node *node, enum UNRES_ITEM type);
 int unres_data_add(struct unres_data *unres, struct lyd_node *node, enum UNRES_ITEM type);
@@ -0,0 +1,1650 @@
+/**
+ * @file snapshot.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief Binary snapshot of all the schemas in a context
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "context.h"
+#include "hash_table.h"
+#include "parser.h"
+#include "resolve.h"
+#include "tree_internal.h"
+#include "tree_schema.h"
+
+/*
+ * The snapshot is a relocatable image of all the allocated schema structures of a context. Every
+ * structure (or array of structures) allocated on its own is stored as an object and every pointer
+ * inside the objects is replaced by a relocation record. Loading the snapshot means allocating the
+ * objects, copying their content and applying the relocations, no parsing nor resolving is needed.
+ *
+ * Layout (all the sections are aligned to 8 bytes, numbers in the native byte order):
+ *
+ * struct lysnap_hdr (context.h)
+ * uint32_t obj_sizes[obj_count]
+ * uint32_t rels[rel_count][5]       - object, offset, kind, target, target offset
+ * uint32_t mods[mod_count]          - objects of the modules in the context's list
+ * uint32_t str_refs[str_count]      - number of references of every string
+ * uint32_t str_lens[str_count]      - length of every string
+ * char strs[]                       - all the strings, each terminated by 0
+ * objects data, each aligned to 8 bytes
+ */
+
+#define LYSNAP_MAGIC "LYSNAP"
+#define LYSNAP_VERSION 1
+#define LYSNAP_BYTE_ORDER 0x01020304
+
+/**
+ * @brief Relocation kinds.
+ */
+enum lysnap_rel_kind {
+    LYSNAP_REL_OBJ = 0,     /**< pointer to (into) an object */
+    LYSNAP_REL_STR,         /**< dictionary string */
+    LYSNAP_REL_CTX,         /**< the context */
+    LYSNAP_REL_BUILTIN,     /**< built-in typedef from ly_types[] */
+    LYSNAP_REL_PLUGIN,      /**< plugin of the extension definition (found again when loading) */
+    LYSNAP_REL_SUBSTMT,     /**< substatements of the complex extension instance (taken from its plugin) */
+
+    LYSNAP_REL_ZERO         /**< cached or private pointer, only cleared in the snapshot, never stored */
+};
+
+struct lysnap_obj {
+    const void *addr;
+    size_t size;
+};
+
+struct lysnap_rel {
+    const void *loc;        /**< address of the pointer */
+    const void *target;     /**< pointer value (#LYSNAP_REL_OBJ) */
+    uint32_t kind;
+    uint32_t aux;           /**< string index (#LYSNAP_REL_STR), type index (#LYSNAP_REL_BUILTIN) */
+};
+
+struct lysnap_addr {
+    const void *addr;
+    uint32_t idx;
+};
+
+struct lysnap_save {
+    const struct ly_ctx *ctx;
+
+    struct hash_table *obj_ht;
+    struct lysnap_obj *objs;
+    uint32_t obj_count;
+    uint32_t obj_size;
+
+    struct lysnap_rel *rels;
+    uint32_t rel_count;
+    uint32_t rel_size;
+
+    struct hash_table *str_ht;
+    const char **strs;
+    uint32_t *str_refs;
+    uint32_t str_count;
+    uint32_t str_size;
+
+    int borrow;             /**< processing shallow copies, their strings and extension instances are not owned */
+};
+
+static int snap_nodes(struct lysnap_save *s, const struct lys_node *first);
+static int snap_type(struct lysnap_save *s, const struct lys_type *type);
+static int snap_ext_array(struct lysnap_save *s, struct lys_ext_instance **const *loc, uint8_t size);
+
+static uint32_t
+snap_layout(void)
+{
+    size_t sizes[] = {
+        sizeof(void *), sizeof(struct lys_module), sizeof(struct lys_submodule), sizeof(struct lys_node_container),
+        sizeof(struct lys_node_choice), sizeof(struct lys_node_leaf), sizeof(struct lys_node_leaflist),
+        sizeof(struct lys_node_list), sizeof(struct lys_node_anydata), sizeof(struct lys_node_uses),
+        sizeof(struct lys_node_grp), sizeof(struct lys_node_case), sizeof(struct lys_node_inout),
+        sizeof(struct lys_node_notif), sizeof(struct lys_node_rpc_action), sizeof(struct lys_node_augment),
+        sizeof(struct lys_type), sizeof(struct lys_tpdf), sizeof(struct lys_restr), sizeof(struct lys_when),
+        sizeof(struct lys_iffeature), sizeof(struct lys_ident), sizeof(struct lys_feature), sizeof(struct lys_ext),
+        sizeof(struct lys_ext_instance), sizeof(struct lys_ext_instance_complex), sizeof(struct lys_refine),
+        sizeof(struct lys_deviation), sizeof(struct lys_deviate), sizeof(struct lys_import),
+        sizeof(struct lys_include), sizeof(struct lys_revision), sizeof(struct lys_unique), sizeof(struct ly_set),
+        offsetof(struct lys_ext, plugin), offsetof(struct lys_ext_instance_complex, substmt)
+    };
+    uint32_t hash;
+
+    hash = dict_hash_multi(0, (const char *)sizes, sizeof sizes);
+    return dict_hash_multi(hash, NULL, 0);
+}
+
+static int
+snap_addr_equal(void *val1_p, void *val2_p, int UNUSED(mod), void *UNUSED(cb_data))
+{
+    return ((struct lysnap_addr *)val1_p)->addr == ((struct lysnap_addr *)val2_p)->addr;
+}
+
+static uint32_t
+snap_addr_hash(const void *addr)
+{
+    uint32_t hash;
+
+    hash = dict_hash_multi(0, (const char *)&addr, sizeof addr);
+    return dict_hash_multi(hash, NULL, 0);
+}
+
+/**
+ * @brief Store an allocated object.
+ *
+ * @return 1 if the object is new and its content is supposed to be processed, 0 if already stored, -1 on error.
+ */
+static int
+snap_obj(struct lysnap_save *s, const void *addr, size_t size)
+{
+    struct lysnap_addr rec, *match;
+    struct lysnap_obj *objs;
+
+    if (!addr) {
+        return 0;
+    }
+
+    rec.addr = addr;
+    rec.idx = s->obj_count;
+    if (!lyht_find(s->obj_ht, &rec, snap_addr_hash(addr), (void **)&match)) {
+        if (s->objs[match->idx].size < size) {
+            s->objs[match->idx].size = size;
+        }
+        return 0;
+    }
+
+    if (s->obj_count == s->obj_size) {
+        objs = realloc(s->objs, (s->obj_size ? s->obj_size * 2 : 512) * sizeof *objs);
+        LY_CHECK_ERR_RETURN(!objs, LOGMEM(s->ctx), -1);
+        s->objs = objs;
+        s->obj_size = s->obj_size ? s->obj_size * 2 : 512;
+    }
+    s->objs[s->obj_count].addr = addr;
+    s->objs[s->obj_count].size = size;
+    ++s->obj_count;
+
+    if (lyht_insert(s->obj_ht, &rec, snap_addr_hash(addr), NULL)) {
+        LOGINT(s->ctx);
+        return -1;
+    }
+    return 1;
+}
+
+static int
+snap_rel(struct lysnap_save *s, const void *loc, uint32_t kind, const void *target, uint32_t aux)
+{
+    struct lysnap_rel *rels;
+
+    if (s->rel_count == s->rel_size) {
+        rels = realloc(s->rels, (s->rel_size ? s->rel_size * 2 : 1024) * sizeof *rels);
+        LY_CHECK_ERR_RETURN(!rels, LOGMEM(s->ctx), -1);
+        s->rels = rels;
+        s->rel_size = s->rel_size ? s->rel_size * 2 : 1024;
+    }
+    s->rels[s->rel_count].loc = loc;
+    s->rels[s->rel_count].target = target;
+    s->rels[s->rel_count].kind = kind;
+    s->rels[s->rel_count].aux = aux;
+    ++s->rel_count;
+
+    return 0;
+}
+
+/**
+ * @brief Store a pointer to another object, the object itself must be stored separately.
+ */
+static int
+snap_ptr(struct lysnap_save *s, const void *loc)
+{
+    const void *target = *(void * const *)loc;
+
+    if (!target) {
+        return 0;
+    }
+    return snap_rel(s, loc, LYSNAP_REL_OBJ, target, 0);
+}
+
+/**
+ * @brief Clear a pointer that is not to be stored (private data, caches built on demand).
+ */
+static int
+snap_zero(struct lysnap_save *s, const void *loc)
+{
+    if (!*(void * const *)loc) {
+        return 0;
+    }
+    return snap_rel(s, loc, LYSNAP_REL_ZERO, NULL, 0);
+}
+
+/**
+ * @brief Clear a compiled expression cache, these members exist only with the data cache enabled.
+ */
+#ifdef LY_ENABLED_CACHE
+#   define snap_zero_compiled(s, loc) snap_zero(s, loc)
+#else
+#   define snap_zero_compiled(s, loc) 0
+#endif
+
+static int
+snap_str(struct lysnap_save *s, const void *loc)
+{
+    const char *str = *(const char * const *)loc, **strs;
+    struct lysnap_addr rec, *match;
+    uint32_t *refs;
+
+    if (!str) {
+        return 0;
+    }
+
+    rec.addr = str;
+    rec.idx = s->str_count;
+    if (!lyht_find(s->str_ht, &rec, snap_addr_hash(str), (void **)&match)) {
+        if (!s->borrow) {
+            ++s->str_refs[match->idx];
+        }
+        return snap_rel(s, loc, LYSNAP_REL_STR, NULL, match->idx);
+    }
+
+    if (s->str_count == s->str_size) {
+        strs = realloc(s->strs, (s->str_size ? s->str_size * 2 : 512) * sizeof *strs);
+        LY_CHECK_ERR_RETURN(!strs, LOGMEM(s->ctx), -1);
+        s->strs = strs;
+        refs = realloc(s->str_refs, (s->str_size ? s->str_size * 2 : 512) * sizeof *refs);
+        LY_CHECK_ERR_RETURN(!refs, LOGMEM(s->ctx), -1);
+        s->str_refs = refs;
+        s->str_size = s->str_size ? s->str_size * 2 : 512;
+    }
+    s->strs[s->str_count] = str;
+    s->str_refs[s->str_count] = s->borrow ? 0 : 1;
+    ++s->str_count;
+
+    if (lyht_insert(s->str_ht, &rec, snap_addr_hash(str), NULL)) {
+        LOGINT(s->ctx);
+        return -1;
+    }
+    return snap_rel(s, loc, LYSNAP_REL_STR, NULL, rec.idx);
+}
+
+static int
+snap_str_array(struct lysnap_save *s, const char **const *loc, unsigned int size)
+{
+    unsigned int i;
+
+    if (snap_obj(s, *loc, size * sizeof **loc) == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; *loc && (i < size); ++i) {
+        if (snap_str(s, &(*loc)[i])) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Store a pointer to an array of pointers to other objects.
+ */
+static int
+snap_ptr_array(struct lysnap_save *s, const void *loc, unsigned int size)
+{
+    void * const *array = *(void * const * const *)loc;
+    unsigned int i;
+
+    if (snap_obj(s, array, size * sizeof *array) == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; array && (i < size); ++i) {
+        if (snap_ptr(s, &array[i])) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_set(struct lysnap_save *s, struct ly_set *const *loc)
+{
+    struct ly_set *set = *loc;
+    unsigned int i;
+
+    if (!set) {
+        return 0;
+    }
+    if ((snap_obj(s, set, sizeof *set) == -1) || snap_ptr(s, loc)
+            || (snap_obj(s, set->set.g, set->size * sizeof *set->set.g) == -1) || snap_ptr(s, &set->set.g)) {
+        return -1;
+    }
+    /* the array may be larger than the number of items, the rest is cleared */
+    for (i = 0; i < set->size; ++i) {
+        if ((i < set->number) ? snap_ptr(s, &set->set.g[i]) : snap_zero(s, &set->set.g[i])) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_restr_array(struct lysnap_save *s, struct lys_restr *const *loc, unsigned int size)
+{
+    struct lys_restr *restr = *loc;
+    unsigned int i;
+    int r;
+
+    r = snap_obj(s, restr, size * sizeof *restr);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; r && (i < size); ++i) {
+        if (snap_str(s, &restr[i].expr) || snap_str(s, &restr[i].dsc) || snap_str(s, &restr[i].ref)
+                || snap_str(s, &restr[i].eapptag) || snap_str(s, &restr[i].emsg)
+                || snap_ext_array(s, &restr[i].ext, restr[i].ext_size) || snap_zero_compiled(s, &restr[i].compiled)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_when(struct lysnap_save *s, struct lys_when *const *loc)
+{
+    struct lys_when *when = *loc;
+    int r;
+
+    r = snap_obj(s, when, sizeof *when);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    if (r && (snap_str(s, &when->cond) || snap_str(s, &when->dsc) || snap_str(s, &when->ref)
+            || snap_ext_array(s, &when->ext, when->ext_size) || snap_zero_compiled(s, &when->compiled))) {
+        return -1;
+    }
+    return 0;
+}
+
+static int
+snap_iffeature_array(struct lysnap_save *s, struct lys_iffeature *const *loc, unsigned int size)
+{
+    struct lys_iffeature *iff = *loc;
+    unsigned int i, expr_size, feat_size;
+    int r;
+
+    r = snap_obj(s, iff, size * sizeof *iff);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; r && (i < size); ++i) {
+        resolve_iffeature_getsizes(&iff[i], &expr_size, &feat_size);
+        if ((snap_obj(s, iff[i].expr, (expr_size / 4) + ((expr_size % 4) ? 1 : 0)) == -1)
+                || snap_ptr(s, &iff[i].expr) || snap_ptr_array(s, &iff[i].features, feat_size)
+                || snap_ext_array(s, &iff[i].ext, iff[i].ext_size)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_unique_array(struct lysnap_save *s, struct lys_unique *const *loc, unsigned int size)
+{
+    struct lys_unique *unique = *loc;
+    unsigned int i;
+    int r;
+
+    r = snap_obj(s, unique, size * sizeof *unique);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; r && (i < size); ++i) {
+        if (snap_str_array(s, &unique[i].expr, unique[i].expr_size)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_tpdf_array(struct lysnap_save *s, struct lys_tpdf *const *loc, unsigned int size)
+{
+    struct lys_tpdf *tpdf = *loc;
+    unsigned int i;
+    int r;
+
+    r = snap_obj(s, tpdf, size * sizeof *tpdf);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; r && (i < size); ++i) {
+        if (snap_str(s, &tpdf[i].name) || snap_str(s, &tpdf[i].dsc) || snap_str(s, &tpdf[i].ref)
+                || snap_ext_array(s, &tpdf[i].ext, tpdf[i].ext_size) || snap_str(s, &tpdf[i].units)
+                || snap_ptr(s, &tpdf[i].module) || snap_type(s, &tpdf[i].type) || snap_str(s, &tpdf[i].dflt)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_revision_array(struct lysnap_save *s, struct lys_revision *const *loc, unsigned int size)
+{
+    struct lys_revision *rev = *loc;
+    unsigned int i;
+    int r;
+
+    r = snap_obj(s, rev, size * sizeof *rev);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; r && (i < size); ++i) {
+        if (snap_ext_array(s, &rev[i].ext, rev[i].ext_size) || snap_str(s, &rev[i].dsc) || snap_str(s, &rev[i].ref)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_type(struct lysnap_save *s, const struct lys_type *type)
+{
+    unsigned int i;
+    int r;
+
+    if (snap_ext_array(s, &type->ext, type->ext_size) || snap_ptr(s, &type->parent)) {
+        return -1;
+    }
+    if (type->der) {
+        for (i = 0; (i < LY_DATA_TYPE_COUNT) && (type->der != ly_types[i]); ++i);
+        if (i < LY_DATA_TYPE_COUNT) {
+            r = snap_rel(s, &type->der, LYSNAP_REL_BUILTIN, NULL, i);
+        } else {
+            r = snap_ptr(s, &type->der);
+        }
+        if (r) {
+            return -1;
+        }
+    }
+
+    switch (type->base) {
+    case LY_TYPE_BINARY:
+        return snap_restr_array(s, &type->info.binary.length, 1);
+    case LY_TYPE_BITS:
+        r = snap_obj(s, type->info.bits.bit, type->info.bits.count * sizeof *type->info.bits.bit);
+        if (r == -1 || snap_ptr(s, &type->info.bits.bit)) {
+            return -1;
+        }
+        for (i = 0; r && (i < type->info.bits.count); ++i) {
+            if (snap_str(s, &type->info.bits.bit[i].name) || snap_str(s, &type->info.bits.bit[i].dsc)
+                    || snap_str(s, &type->info.bits.bit[i].ref)
+                    || snap_ext_array(s, &type->info.bits.bit[i].ext, type->info.bits.bit[i].ext_size)
+                    || snap_iffeature_array(s, &type->info.bits.bit[i].iffeature, type->info.bits.bit[i].iffeature_size)) {
+                return -1;
+            }
+        }
+        return 0;
+    case LY_TYPE_DEC64:
+        return snap_restr_array(s, &type->info.dec64.range, 1);
+    case LY_TYPE_ENUM:
+        r = snap_obj(s, type->info.enums.enm, type->info.enums.count * sizeof *type->info.enums.enm);
+        if (r == -1 || snap_ptr(s, &type->info.enums.enm)) {
+            return -1;
+        }
+        for (i = 0; r && (i < type->info.enums.count); ++i) {
+            if (snap_str(s, &type->info.enums.enm[i].name) || snap_str(s, &type->info.enums.enm[i].dsc)
+                    || snap_str(s, &type->info.enums.enm[i].ref)
+                    || snap_ext_array(s, &type->info.enums.enm[i].ext, type->info.enums.enm[i].ext_size)
+                    || snap_iffeature_array(s, &type->info.enums.enm[i].iffeature, type->info.enums.enm[i].iffeature_size)) {
+                return -1;
+            }
+        }
+        return 0;
+    case LY_TYPE_IDENT:
+        return snap_ptr_array(s, &type->info.ident.ref, type->info.ident.count);
+    case LY_TYPE_LEAFREF:
+        return snap_str(s, &type->info.lref.path) || snap_ptr(s, &type->info.lref.target)
+                || snap_zero_compiled(s, &type->info.lref.compiled) ? -1 : 0;
+    case LY_TYPE_STRING:
+#ifdef LY_ENABLED_CACHE
+        /* compiled patterns are not stored, they are compiled again on their first use */
+        if (snap_zero(s, &type->info.str.patterns_pcre)) {
+            return -1;
+        }
+#endif
+        return snap_restr_array(s, &type->info.str.length, 1)
+                || snap_restr_array(s, &type->info.str.patterns, type->info.str.pat_count) ? -1 : 0;
+    case LY_TYPE_UNION:
+        r = snap_obj(s, type->info.uni.types, type->info.uni.count * sizeof *type->info.uni.types);
+        if (r == -1 || snap_ptr(s, &type->info.uni.types)) {
+            return -1;
+        }
+        for (i = 0; r && (i < type->info.uni.count); ++i) {
+            if (snap_type(s, &type->info.uni.types[i])) {
+                return -1;
+            }
+        }
+        return 0;
+    case LY_TYPE_INT8:
+    case LY_TYPE_UINT8:
+    case LY_TYPE_INT16:
+    case LY_TYPE_UINT16:
+    case LY_TYPE_INT32:
+    case LY_TYPE_UINT32:
+    case LY_TYPE_INT64:
+    case LY_TYPE_UINT64:
+        return snap_restr_array(s, &type->info.num.range, 1);
+    case LY_TYPE_BOOL:
+    case LY_TYPE_EMPTY:
+    case LY_TYPE_INST:
+        return 0;
+    default:
+        /* not resolved */
+        LOGERR(s->ctx, LY_EINVAL, "Unable to store unresolved type into a snapshot.");
+        return -1;
+    }
+}
+
+/**
+ * @brief Store a single item or a NULL-terminated array of items of a complex extension instance substatement.
+ */
+static int
+snap_extcomplex_items(struct lysnap_save *s, void *const *loc, LY_STMT_CARD card, size_t item_size,
+                      int (*item_clb)(struct lysnap_save *s, void *item))
+{
+    void **array;
+    unsigned int i, count;
+    int r;
+
+    if (!*loc) {
+        return 0;
+    }
+
+    if (card >= LY_STMT_CARD_SOME) {
+        array = *loc;
+        for (count = 0; array[count]; ++count);
+        if ((snap_obj(s, array, (count + 1) * sizeof *array) == -1) || snap_ptr(s, loc)) {
+            return -1;
+        }
+    } else {
+        array = (void **)loc;
+        count = 1;
+    }
+
+    for (i = 0; i < count; ++i) {
+        r = snap_obj(s, array[i], item_size);
+        if (r == -1 || snap_ptr(s, &array[i]) || (r && item_clb && item_clb(s, array[i]))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_extcomplex_type(struct lysnap_save *s, void *item)
+{
+    return snap_type(s, item);
+}
+
+static int
+snap_extcomplex_tpdf(struct lysnap_save *s, void *item)
+{
+    struct lys_tpdf *tpdf = item;
+
+    return snap_str(s, &tpdf->name) || snap_str(s, &tpdf->dsc) || snap_str(s, &tpdf->ref)
+            || snap_ext_array(s, &tpdf->ext, tpdf->ext_size) || snap_str(s, &tpdf->units)
+            || snap_ptr(s, &tpdf->module) || snap_type(s, &tpdf->type) || snap_str(s, &tpdf->dflt) ? -1 : 0;
+}
+
+static int
+snap_extcomplex_iffeature(struct lysnap_save *s, void *item)
+{
+    struct lys_iffeature *iff = item;
+    unsigned int expr_size, feat_size;
+
+    resolve_iffeature_getsizes(iff, &expr_size, &feat_size);
+    return (snap_obj(s, iff->expr, (expr_size / 4) + ((expr_size % 4) ? 1 : 0)) == -1)
+            || snap_ptr(s, &iff->expr) || snap_ptr_array(s, &iff->features, feat_size)
+            || snap_ext_array(s, &iff->ext, iff->ext_size) ? -1 : 0;
+}
+
+static int
+snap_extcomplex_restr(struct lysnap_save *s, void *item)
+{
+    struct lys_restr *restr = item;
+
+    return snap_str(s, &restr->expr) || snap_str(s, &restr->dsc) || snap_str(s, &restr->ref)
+            || snap_str(s, &restr->eapptag) || snap_str(s, &restr->emsg)
+            || snap_ext_array(s, &restr->ext, restr->ext_size) || snap_zero_compiled(s, &restr->compiled) ? -1 : 0;
+}
+
+static int
+snap_extcomplex_when(struct lysnap_save *s, void *item)
+{
+    struct lys_when *when = item;
+
+    return snap_str(s, &when->cond) || snap_str(s, &when->dsc) || snap_str(s, &when->ref)
+            || snap_ext_array(s, &when->ext, when->ext_size) || snap_zero_compiled(s, &when->compiled) ? -1 : 0;
+}
+
+static int
+snap_extcomplex_unique(struct lysnap_save *s, void *item)
+{
+    struct lys_unique *unique = item;
+
+    return snap_str_array(s, &unique->expr, unique->expr_size);
+}
+
+static int
+snap_extcomplex_revision(struct lysnap_save *s, void *item)
+{
+    struct lys_revision *rev = item;
+
+    return snap_ext_array(s, &rev->ext, rev->ext_size) || snap_str(s, &rev->dsc) || snap_str(s, &rev->ref) ? -1 : 0;
+}
+
+static int
+snap_extcomplex(struct lysnap_save *s, struct lys_ext_instance_complex *ext)
+{
+    struct lyext_substmt *substmt = ext->substmt;
+    void **loc;
+    const char **str;
+    unsigned int i, j;
+    int nodes = 0, r = 0;
+
+    for (i = 0; substmt && substmt[i].stmt; ++i) {
+        loc = (void **)&ext->content[substmt[i].offset];
+
+        switch (substmt[i].stmt) {
+        case LY_STMT_ARGUMENT:
+        case LY_STMT_BELONGSTO:
+            if (substmt[i].cardinality >= LY_STMT_CARD_SOME) {
+                if (*loc) {
+                    LOGERR(s->ctx, LY_EINVAL, "Unable to store extension instance \"%s\" into a snapshot.", ext->def->name);
+                    return -1;
+                }
+                break;
+            }
+            if (snap_str(s, loc) || ((substmt[i].stmt == LY_STMT_BELONGSTO) && snap_str(s, &loc[1]))) {
+                return -1;
+            }
+            break;
+        case LY_STMT_BASE:
+        case LY_STMT_CONTACT:
+        case LY_STMT_DEFAULT:
+        case LY_STMT_DESCRIPTION:
+        case LY_STMT_ERRTAG:
+        case LY_STMT_ERRMSG:
+        case LY_STMT_KEY:
+        case LY_STMT_NAMESPACE:
+        case LY_STMT_ORGANIZATION:
+        case LY_STMT_PATH:
+        case LY_STMT_PREFIX:
+        case LY_STMT_PRESENCE:
+        case LY_STMT_REFERENCE:
+        case LY_STMT_REVISIONDATE:
+        case LY_STMT_UNITS:
+            if (substmt[i].cardinality < LY_STMT_CARD_SOME) {
+                r = snap_str(s, loc);
+            } else if (*loc) {
+                for (str = *loc, j = 0; str[j]; ++j);
+                r = snap_str_array(s, (const char ***)loc, j + 1);
+            } else {
+                r = 0;
+            }
+            if (r) {
+                return -1;
+            }
+            break;
+        case LY_STMT_TYPE:
+            r = snap_extcomplex_items(s, loc, substmt[i].cardinality, sizeof(struct lys_type), snap_extcomplex_type);
+            break;
+        case LY_STMT_TYPEDEF:
+            r = snap_extcomplex_items(s, loc, substmt[i].cardinality, sizeof(struct lys_tpdf), snap_extcomplex_tpdf);
+            break;
+        case LY_STMT_IFFEATURE:
+            r = snap_extcomplex_items(s, loc, substmt[i].cardinality, sizeof(struct lys_iffeature),
+                                      snap_extcomplex_iffeature);
+            break;
+        case LY_STMT_LENGTH:
+        case LY_STMT_MUST:
+        case LY_STMT_PATTERN:
+        case LY_STMT_RANGE:
+            r = snap_extcomplex_items(s, loc, substmt[i].cardinality, sizeof(struct lys_restr), snap_extcomplex_restr);
+            break;
+        case LY_STMT_WHEN:
+            r = snap_extcomplex_items(s, loc, substmt[i].cardinality, sizeof(struct lys_when), snap_extcomplex_when);
+            break;
+        case LY_STMT_UNIQUE:
+            r = snap_extcomplex_items(s, loc, substmt[i].cardinality, sizeof(struct lys_unique),
+                                      snap_extcomplex_unique);
+            break;
+        case LY_STMT_REVISION:
+            r = snap_extcomplex_items(s, loc, substmt[i].cardinality, sizeof(struct lys_revision),
+                                      snap_extcomplex_revision);
+            break;
+        case LY_STMT_MAX:
+        case LY_STMT_MIN:
+        case LY_STMT_POSITION:
+        case LY_STMT_VALUE:
+            r = snap_extcomplex_items(s, loc, substmt[i].cardinality, sizeof(uint32_t), NULL);
+            break;
+        case LY_STMT_DIGITS:
+            if ((substmt[i].cardinality >= LY_STMT_CARD_SOME) && *loc) {
+                LOGERR(s->ctx, LY_EINVAL, "Unable to store extension instance \"%s\" into a snapshot.", ext->def->name);
+                return -1;
+            }
+            r = 0;
+            break;
+        case LY_STMT_MODULE:
+            if (substmt[i].cardinality >= LY_STMT_CARD_SOME) {
+                for (j = 0; *loc && ((void **)*loc)[j]; ++j);
+                r = snap_ptr_array(s, loc, *loc ? j + 1 : 0);
+            } else {
+                r = snap_ptr(s, loc);
+            }
+            break;
+        case LY_STMT_ACTION:
+        case LY_STMT_ANYDATA:
+        case LY_STMT_ANYXML:
+        case LY_STMT_CASE:
+        case LY_STMT_CHOICE:
+        case LY_STMT_CONTAINER:
+        case LY_STMT_GROUPING:
+        case LY_STMT_INPUT:
+        case LY_STMT_LEAF:
+        case LY_STMT_LEAFLIST:
+        case LY_STMT_LIST:
+        case LY_STMT_NOTIFICATION:
+        case LY_STMT_OUTPUT:
+        case LY_STMT_RPC:
+        case LY_STMT_USES:
+            /* all the data nodes share a single sibling list */
+            if (nodes) {
+                r = 0;
+                break;
+            }
+            nodes = 1;
+            r = snap_ptr(s, loc) || snap_nodes(s, *loc) ? -1 : 0;
+            break;
+        default:
+            /* stored directly in the content */
+            r = 0;
+            break;
+        }
+        if (r) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int
+snap_ext_array(struct lysnap_save *s, struct lys_ext_instance **const *loc, uint8_t size)
+{
+    struct lys_ext_instance **ext = *loc;
+    size_t ext_size;
+    unsigned int i;
+    int r;
+
+    if (s->borrow) {
+        /* the array is owned and stored by the original structure */
+        return snap_ptr(s, loc);
+    }
+
+    r = snap_obj(s, ext, size * sizeof *ext);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    } else if (!r) {
+        return 0;
+    }
+
+    for (i = 0; i < size; ++i) {
+        if (!ext[i] || (ext[i]->flags & LYEXT_OPT_YANG) || !ext[i]->def) {
+            LOGERR(s->ctx, LY_EINVAL, "Unable to store unresolved extension instance into a snapshot.");
+            return -1;
+        }
+
+        if ((ext[i]->ext_type == LYEXT_COMPLEX) && !(ext[i]->flags & LYEXT_OPT_INHERIT)) {
+            /* inherited instances are always just copies of the generic part */
+            if (!ext[i]->def->plugin || (ext[i]->def->plugin->type != LYEXT_COMPLEX)) {
+                LOGINT(s->ctx);
+                return -1;
+            }
+            ext_size = ((struct lyext_plugin_complex *)ext[i]->def->plugin)->instance_size;
+        } else {
+            ext_size = sizeof **ext;
+        }
+
+        r = snap_obj(s, ext[i], ext_size);
+        if (r == -1 || snap_ptr(s, &ext[i])) {
+            return -1;
+        } else if (!r) {
+            /* shared instance */
+            continue;
+        }
+
+        if (snap_ptr(s, &ext[i]->def) || snap_ptr(s, &ext[i]->parent) || snap_str(s, &ext[i]->arg_value)
+                || snap_ext_array(s, &ext[i]->ext, ext[i]->ext_size) || snap_zero(s, &ext[i]->priv)
+                || snap_ptr(s, &ext[i]->module)) {
+            return -1;
+        }
+        if ((ext_size > sizeof **ext)
+                && (snap_rel(s, &((struct lys_ext_instance_complex *)ext[i])->substmt, LYSNAP_REL_SUBSTMT, NULL, 0)
+                || snap_extcomplex(s, (struct lys_ext_instance_complex *)ext[i]))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_augment_array(struct lysnap_save *s, struct lys_node_augment *const *loc, unsigned int size)
+{
+    struct lys_node_augment *aug = *loc;
+    unsigned int i;
+    int r;
+
+    r = snap_obj(s, aug, size * sizeof *aug);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; r && (i < size); ++i) {
+        if (snap_str(s, &aug[i].target_name) || snap_str(s, &aug[i].dsc) || snap_str(s, &aug[i].ref)
+                || snap_ext_array(s, &aug[i].ext, aug[i].ext_size)
+                || snap_iffeature_array(s, &aug[i].iffeature, aug[i].iffeature_size) || snap_ptr(s, &aug[i].module)
+                || snap_ptr(s, &aug[i].parent) || snap_ptr(s, &aug[i].child) || snap_when(s, &aug[i].when)
+                || snap_ptr(s, &aug[i].target) || snap_zero(s, &aug[i].priv) || snap_nodes(s, aug[i].child)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_refine_array(struct lysnap_save *s, struct lys_refine *const *loc, unsigned int size)
+{
+    struct lys_refine *rfn = *loc;
+    unsigned int i;
+    int r;
+
+    r = snap_obj(s, rfn, size * sizeof *rfn);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; r && (i < size); ++i) {
+        if (snap_str(s, &rfn[i].target_name) || snap_str(s, &rfn[i].dsc) || snap_str(s, &rfn[i].ref)
+                || snap_ext_array(s, &rfn[i].ext, rfn[i].ext_size)
+                || snap_iffeature_array(s, &rfn[i].iffeature, rfn[i].iffeature_size) || snap_ptr(s, &rfn[i].module)
+                || snap_restr_array(s, &rfn[i].must, rfn[i].must_size) || snap_str_array(s, &rfn[i].dflt, rfn[i].dflt_size)
+                || ((rfn[i].target_type & LYS_CONTAINER) && snap_str(s, &rfn[i].mod.presence))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static size_t
+snap_node_size(const struct lys_node *node)
+{
+    switch (node->nodetype) {
+    case LYS_CONTAINER:
+        return sizeof(struct lys_node_container);
+    case LYS_CHOICE:
+        return sizeof(struct lys_node_choice);
+    case LYS_LEAF:
+        return sizeof(struct lys_node_leaf);
+    case LYS_LEAFLIST:
+        return sizeof(struct lys_node_leaflist);
+    case LYS_LIST:
+        return sizeof(struct lys_node_list);
+    case LYS_ANYXML:
+    case LYS_ANYDATA:
+        return sizeof(struct lys_node_anydata);
+    case LYS_CASE:
+        return sizeof(struct lys_node_case);
+    case LYS_USES:
+        return sizeof(struct lys_node_uses);
+    case LYS_GROUPING:
+        return sizeof(struct lys_node_grp);
+    case LYS_INPUT:
+    case LYS_OUTPUT:
+        return sizeof(struct lys_node_inout);
+    case LYS_NOTIF:
+        return sizeof(struct lys_node_notif);
+    case LYS_RPC:
+    case LYS_ACTION:
+        return sizeof(struct lys_node_rpc_action);
+    default:
+        return 0;
+    }
+}
+
+static int
+snap_node(struct lysnap_save *s, const struct lys_node *node)
+{
+    struct lys_node_container *cont;
+    struct lys_node_leaf *leaf;
+    struct lys_node_leaflist *llist;
+    struct lys_node_list *list;
+    struct lys_node_anydata *any;
+    struct lys_node_uses *uses;
+    struct lys_node_inout *inout;
+    struct lys_node_notif *notif;
+    size_t size;
+    int r;
+
+    size = snap_node_size(node);
+    if (!size) {
+        LOGINT(s->ctx);
+        return -1;
+    }
+    r = snap_obj(s, node, size);
+    if (r < 1) {
+        return r;
+    }
+
+    /* common part */
+    if (snap_str(s, &node->name) || snap_ext_array(s, &node->ext, node->ext_size) || snap_ptr(s, &node->module)
+            || snap_ptr(s, &node->parent) || snap_ptr(s, &node->next) || snap_ptr(s, &node->prev)
+            || snap_zero(s, &node->priv)) {
+        return -1;
+    }
+    if (!(node->nodetype & (LYS_INPUT | LYS_OUTPUT | LYS_GROUPING))) {
+        if (snap_str(s, &node->dsc) || snap_str(s, &node->ref)
+                || snap_iffeature_array(s, &node->iffeature, node->iffeature_size)) {
+            return -1;
+        }
+    } else if (node->nodetype == LYS_GROUPING) {
+        if (snap_str(s, &node->dsc) || snap_str(s, &node->ref)) {
+            return -1;
+        }
+    }
+    if (!(node->nodetype & (LYS_LEAF | LYS_LEAFLIST))) {
+        if (snap_ptr(s, &node->child) || snap_nodes(s, node->child)) {
+            return -1;
+        }
+    }
+    /* specific part */
+    switch (node->nodetype) {
+    case LYS_CONTAINER:
+        cont = (struct lys_node_container *)node;
+        r = snap_when(s, &cont->when) || snap_restr_array(s, &cont->must, cont->must_size)
+                || snap_tpdf_array(s, &cont->tpdf, cont->tpdf_size) || snap_str(s, &cont->presence);
+        break;
+    case LYS_CHOICE:
+        r = snap_when(s, &((struct lys_node_choice *)node)->when) || snap_ptr(s, &((struct lys_node_choice *)node)->dflt);
+        break;
+    case LYS_LEAF:
+        leaf = (struct lys_node_leaf *)node;
+        r = snap_zero(s, &leaf->child) || snap_when(s, &leaf->when)
+                || snap_restr_array(s, &leaf->must, leaf->must_size) || snap_type(s, &leaf->type)
+                || snap_str(s, &leaf->units) || snap_str(s, &leaf->dflt);
+        break;
+    case LYS_LEAFLIST:
+        llist = (struct lys_node_leaflist *)node;
+        r = snap_set(s, &llist->backlinks) || snap_when(s, &llist->when)
+                || snap_restr_array(s, &llist->must, llist->must_size) || snap_type(s, &llist->type)
+                || snap_str(s, &llist->units) || snap_str_array(s, &llist->dflt, llist->dflt_size);
+        break;
+    case LYS_LIST:
+        list = (struct lys_node_list *)node;
+        r = snap_when(s, &list->when) || snap_restr_array(s, &list->must, list->must_size)
+                || snap_tpdf_array(s, &list->tpdf, list->tpdf_size) || snap_ptr_array(s, &list->keys, list->keys_size)
+                || snap_unique_array(s, &list->unique, list->unique_size) || snap_str(s, &list->keys_str);
+        break;
+    case LYS_ANYXML:
+    case LYS_ANYDATA:
+        any = (struct lys_node_anydata *)node;
+        r = snap_when(s, &any->when) || snap_restr_array(s, &any->must, any->must_size);
+        break;
+    case LYS_CASE:
+        r = snap_when(s, &((struct lys_node_case *)node)->when);
+        break;
+    case LYS_USES:
+        uses = (struct lys_node_uses *)node;
+        r = snap_when(s, &uses->when) || snap_refine_array(s, &uses->refine, uses->refine_size)
+                || snap_augment_array(s, &uses->augment, uses->augment_size) || snap_ptr(s, &uses->grp);
+        break;
+    case LYS_GROUPING:
+        r = snap_tpdf_array(s, &((struct lys_node_grp *)node)->tpdf, ((struct lys_node_grp *)node)->tpdf_size);
+        break;
+    case LYS_INPUT:
+    case LYS_OUTPUT:
+        inout = (struct lys_node_inout *)node;
+        r = snap_tpdf_array(s, &inout->tpdf, inout->tpdf_size) || snap_restr_array(s, &inout->must, inout->must_size);
+        break;
+    case LYS_NOTIF:
+        notif = (struct lys_node_notif *)node;
+        r = snap_tpdf_array(s, &notif->tpdf, notif->tpdf_size) || snap_restr_array(s, &notif->must, notif->must_size);
+        break;
+    case LYS_RPC:
+    case LYS_ACTION:
+        r = snap_tpdf_array(s, &((struct lys_node_rpc_action *)node)->tpdf,
+                            ((struct lys_node_rpc_action *)node)->tpdf_size);
+        break;
+    default:
+        r = 0;
+        break;
+    }
+
+    return r ? -1 : 0;
+}
+
+static int
+snap_nodes(struct lysnap_save *s, const struct lys_node *first)
+{
+    const struct lys_node *node;
+
+    /* the sibling list may be entered in the middle (augment, uses), always follow it to its end */
+    for (node = first; node; node = node->next) {
+        if (snap_node(s, node)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+snap_deviation_array(struct lysnap_save *s, struct lys_deviation *const *loc, unsigned int size)
+{
+    struct lys_deviation *dev = *loc;
+    struct lys_deviate *d;
+    unsigned int i, j;
+    int r, rc;
+
+    r = snap_obj(s, dev, size * sizeof *dev);
+    if (r == -1 || snap_ptr(s, loc)) {
+        return -1;
+    }
+    for (i = 0; r && (i < size); ++i) {
+        if (snap_str(s, &dev[i].target_name) || snap_str(s, &dev[i].dsc) || snap_str(s, &dev[i].ref)
+                || snap_ptr(s, &dev[i].orig_node) || (dev[i].orig_node && snap_nodes(s, dev[i].orig_node))
+                || snap_ext_array(s, &dev[i].ext, dev[i].ext_size)) {
+            return -1;
+        }
+
+        d = dev[i].deviate;
+        if ((snap_obj(s, d, dev[i].deviate_size * sizeof *d) == -1) || snap_ptr(s, &dev[i].deviate)) {
+            return -1;
+        }
+        for (j = 0; d && (j < dev[i].deviate_size); ++j) {
+            /* added musts are shallow copies of the ones in the target node */
+            s->borrow = (d[j].mod == LY_DEVIATE_ADD);
+            rc = snap_restr_array(s, &d[j].must, d[j].must_size);
+            s->borrow = 0;
+
+            /* added uniques are stored directly in the target list, the type is always the one of the target */
+            if (rc || ((d[j].mod == LY_DEVIATE_ADD) ? snap_ptr(s, &d[j].unique)
+                        : snap_unique_array(s, &d[j].unique, d[j].unique_size))
+                    || snap_ptr(s, &d[j].type) || snap_str(s, &d[j].units)
+                    || snap_str_array(s, &d[j].dflt, d[j].dflt_size) || snap_ext_array(s, &d[j].ext, d[j].ext_size)) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int
+snap_module(struct lysnap_save *s, const struct lys_module *mod)
+{
+    const struct lys_submodule *submod = (const struct lys_submodule *)mod;
+    struct lys_import *imp;
+    struct lys_include *inc;
+    struct lys_ident *ident;
+    struct lys_feature *feat;
+    struct lys_ext *extdef;
+    unsigned int i;
+    int r;
+
+    r = snap_obj(s, mod, mod->type ? sizeof *submod : sizeof *mod);
+    if (r < 1) {
+        return r;
+    }
+
+    if (snap_rel(s, &mod->ctx, LYSNAP_REL_CTX, NULL, 0) || snap_str(s, &mod->name) || snap_str(s, &mod->prefix)
+            || snap_str(s, &mod->dsc) || snap_str(s, &mod->ref) || snap_str(s, &mod->org)
+            || snap_str(s, &mod->contact) || snap_str(s, &mod->filepath)
+            || snap_revision_array(s, &mod->rev, mod->rev_size)) {
+        return -1;
+    }
+
+    /* imports */
+    imp = mod->imp;
+    r = snap_obj(s, imp, mod->imp_size * sizeof *imp);
+    if (r == -1 || snap_ptr(s, &mod->imp)) {
+        return -1;
+    }
+    for (i = 0; r && (i < mod->imp_size); ++i) {
+        if (snap_ptr(s, &imp[i].module) || snap_str(s, &imp[i].prefix) || snap_ext_array(s, &imp[i].ext, imp[i].ext_size)
+                || snap_str(s, &imp[i].dsc) || snap_str(s, &imp[i].ref)) {
+            return -1;
+        }
+    }
+
+    /* includes */
+    inc = mod->inc;
+    r = snap_obj(s, inc, mod->inc_size * sizeof *inc);
+    if (r == -1 || snap_ptr(s, &mod->inc)) {
+        return -1;
+    }
+    for (i = 0; r && (i < mod->inc_size); ++i) {
+        if (snap_ptr(s, &inc[i].submodule) || snap_module(s, (struct lys_module *)inc[i].submodule)
+                || snap_ext_array(s, &inc[i].ext, inc[i].ext_size) || snap_str(s, &inc[i].dsc)
+                || snap_str(s, &inc[i].ref)) {
+            return -1;
+        }
+    }
+
+    if (snap_tpdf_array(s, &mod->tpdf, mod->tpdf_size)) {
+        return -1;
+    }
+
+    /* identities */
+    ident = mod->ident;
+    r = snap_obj(s, ident, mod->ident_size * sizeof *ident);
+    if (r == -1 || snap_ptr(s, &mod->ident)) {
+        return -1;
+    }
+    for (i = 0; r && (i < mod->ident_size); ++i) {
+        if (snap_str(s, &ident[i].name) || snap_str(s, &ident[i].dsc) || snap_str(s, &ident[i].ref)
+                || snap_ext_array(s, &ident[i].ext, ident[i].ext_size)
+                || snap_iffeature_array(s, &ident[i].iffeature, ident[i].iffeature_size)
+                || snap_ptr(s, &ident[i].module) || snap_ptr_array(s, &ident[i].base, ident[i].base_size)
+                || snap_set(s, &ident[i].der)) {
+            return -1;
+        }
+    }
+
+    /* features */
+    feat = mod->features;
+    r = snap_obj(s, feat, mod->features_size * sizeof *feat);
+    if (r == -1 || snap_ptr(s, &mod->features)) {
+        return -1;
+    }
+    for (i = 0; r && (i < mod->features_size); ++i) {
+        if (snap_str(s, &feat[i].name) || snap_str(s, &feat[i].dsc) || snap_str(s, &feat[i].ref)
+                || snap_ext_array(s, &feat[i].ext, feat[i].ext_size)
+                || snap_iffeature_array(s, &feat[i].iffeature, feat[i].iffeature_size) || snap_ptr(s, &feat[i].module)
+                || snap_set(s, &feat[i].depfeatures)) {
+            return -1;
+        }
+    }
+
+    if (snap_augment_array(s, &mod->augment, mod->augment_size)
+            || snap_deviation_array(s, &mod->deviation, mod->deviation_size)) {
+        return -1;
+    }
+
+    /* extension definitions */
+    extdef = mod->extensions;
+    r = snap_obj(s, extdef, mod->extensions_size * sizeof *extdef);
+    if (r == -1 || snap_ptr(s, &mod->extensions)) {
+        return -1;
+    }
+    for (i = 0; r && (i < mod->extensions_size); ++i) {
+        if (snap_str(s, &extdef[i].name) || snap_str(s, &extdef[i].dsc) || snap_str(s, &extdef[i].ref)
+                || snap_ext_array(s, &extdef[i].ext, extdef[i].ext_size) || snap_str(s, &extdef[i].argument)
+                || snap_ptr(s, &extdef[i].module)
+                || (extdef[i].plugin && snap_rel(s, &extdef[i].plugin, LYSNAP_REL_PLUGIN, NULL, 0))) {
+            return -1;
+        }
+    }
+
+    if (snap_ext_array(s, &mod->ext, mod->ext_size)) {
+        return -1;
+    }
+
+    if (mod->type) {
+        return snap_ptr(s, &submod->belongsto);
+    }
+    return snap_ptr(s, &mod->data) || snap_nodes(s, mod->data) || snap_str(s, &mod->ns) ? -1 : 0;
+}
+
+static int
+snap_obj_cmp(const void *ptr1, const void *ptr2)
+{
+    const struct lysnap_obj *obj1 = *(const struct lysnap_obj **)ptr1, *obj2 = *(const struct lysnap_obj **)ptr2;
+
+    if ((uintptr_t)obj1->addr < (uintptr_t)obj2->addr) {
+        return -1;
+    }
+    return (uintptr_t)obj1->addr > (uintptr_t)obj2->addr;
+}
+
+static int
+snap_rel_cmp(const void *ptr1, const void *ptr2)
+{
+    const struct lysnap_rel *rel1 = ptr1, *rel2 = ptr2;
+
+    /* the plugins of extension definitions must be known before the substatements of their instances */
+    if (rel1->kind != rel2->kind) {
+        return rel1->kind < rel2->kind ? -1 : 1;
+    }
+    if ((uintptr_t)rel1->loc != (uintptr_t)rel2->loc) {
+        return (uintptr_t)rel1->loc < (uintptr_t)rel2->loc ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Find the object containing an address.
+ */
+static int
+snap_find(struct lysnap_save *s, struct lysnap_obj **sorted, const void *addr, uint32_t *idx, uint32_t *offset)
+{
+    struct lysnap_addr rec, *match;
+    uint32_t lo, hi, mid;
+
+    /* the exact object, may also be empty */
+    rec.addr = addr;
+    if (!lyht_find(s->obj_ht, &rec, snap_addr_hash(addr), (void **)&match)) {
+        *idx = match->idx;
+        *offset = 0;
+        return 0;
+    }
+
+    /* inside an object */
+    lo = 0;
+    hi = s->obj_count;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if ((uintptr_t)sorted[mid]->addr <= (uintptr_t)addr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo && ((uintptr_t)addr < (uintptr_t)sorted[lo - 1]->addr + sorted[lo - 1]->size)) {
+        *idx = sorted[lo - 1] - s->objs;
+        *offset = (uintptr_t)addr - (uintptr_t)sorted[lo - 1]->addr;
+        return 0;
+    }
+
+    return 1;
+}
+
+static void
+snap_save_clean(struct lysnap_save *s)
+{
+    lyht_free(s->obj_ht);
+    lyht_free(s->str_ht);
+    free(s->objs);
+    free(s->rels);
+    free(s->strs);
+    free(s->str_refs);
+}
+
+int
+ctx_snapshot_print(const struct ly_ctx *ctx, char **data, size_t *len)
+{
+    struct lysnap_save s;
+    struct lysnap_hdr *hdr;
+    struct lysnap_obj **sorted = NULL;
+    struct lysnap_addr rec, *match;
+    uint64_t *offsets = NULL, obj_size;
+    uint32_t *sizes, *rels, *mods, *str_refs, *str_lens, i, rel_count, idx, offset;
+    size_t size, str_size, pos;
+    char *buf = NULL, *strs, *objs, *loc;
+    int ret = -1;
+
+    memset(&s, 0, sizeof s);
+    s.ctx = ctx;
+    s.obj_ht = lyht_new(1024, sizeof(struct lysnap_addr), snap_addr_equal, NULL, 1);
+    s.str_ht = lyht_new(1024, sizeof(struct lysnap_addr), snap_addr_equal, NULL, 1);
+    LY_CHECK_ERR_GOTO(!s.obj_ht || !s.str_ht, LOGMEM(ctx), cleanup);
+
+    /* collect all the objects, pointers and strings */
+    for (i = 0; i < (unsigned)ctx->models.used; ++i) {
+        if (snap_module(&s, ctx->models.list[i])) {
+            goto cleanup;
+        }
+    }
+
+    /* objects by their address to find the pointers inside them */
+    sorted = malloc(s.obj_count * sizeof *sorted);
+    offsets = malloc(s.obj_count * sizeof *offsets);
+    LY_CHECK_ERR_GOTO(s.obj_count && (!sorted || !offsets), LOGMEM(ctx), cleanup);
+    for (i = 0; i < s.obj_count; ++i) {
+        sorted[i] = &s.objs[i];
+    }
+    qsort(sorted, s.obj_count, sizeof *sorted, snap_obj_cmp);
+    for (i = 0; i + 1 < s.obj_count; ++i) {
+        if ((uintptr_t)sorted[i]->addr + sorted[i]->size > (uintptr_t)sorted[i + 1]->addr) {
+            LOGINT(ctx);
+            goto cleanup;
+        }
+    }
+
+    obj_size = 0;
+    for (i = 0; i < s.obj_count; ++i) {
+        if (s.objs[i].size > UINT32_MAX) {
+            LOGERR(ctx, LY_EINVAL, "Schema structure too large to be stored into a snapshot.");
+            goto cleanup;
+        }
+        offsets[i] = obj_size;
+        obj_size += LYSNAP_ALIGN(s.objs[i].size);
+    }
+
+    /* relocations applied in the order of their kind, the ones only clearing pointers are at the end */
+    qsort(s.rels, s.rel_count, sizeof *s.rels, snap_rel_cmp);
+    for (rel_count = 0; (rel_count < s.rel_count) && (s.rels[rel_count].kind != LYSNAP_REL_ZERO); ++rel_count);
+
+    str_size = 0;
+    for (i = 0; i < s.str_count; ++i) {
+        str_size += strlen(s.strs[i]) + 1;
+    }
+
+    /* allocate the whole snapshot */
+    size = LYSNAP_ALIGN(sizeof *hdr) + LYSNAP_ALIGN(s.obj_count * sizeof *sizes)
+            + LYSNAP_ALIGN(rel_count * 5 * sizeof *rels) + LYSNAP_ALIGN(ctx->models.used * sizeof *mods)
+            + 2 * LYSNAP_ALIGN(s.str_count * sizeof *str_refs) + LYSNAP_ALIGN(str_size) + obj_size;
+    buf = calloc(1, size);
+    LY_CHECK_ERR_GOTO(!buf, LOGMEM(ctx), cleanup);
+
+    pos = LYSNAP_ALIGN(sizeof *hdr);
+    hdr = (struct lysnap_hdr *)buf;
+    sizes = (uint32_t *)(buf + pos);
+    pos += LYSNAP_ALIGN(s.obj_count * sizeof *sizes);
+    rels = (uint32_t *)(buf + pos);
+    pos += LYSNAP_ALIGN(rel_count * 5 * sizeof *rels);
+    mods = (uint32_t *)(buf + pos);
+    pos += LYSNAP_ALIGN(ctx->models.used * sizeof *mods);
+    str_refs = (uint32_t *)(buf + pos);
+    pos += LYSNAP_ALIGN(s.str_count * sizeof *str_refs);
+    str_lens = (uint32_t *)(buf + pos);
+    pos += LYSNAP_ALIGN(s.str_count * sizeof *str_lens);
+    strs = buf + pos;
+    pos += LYSNAP_ALIGN(str_size);
+    objs = buf + pos;
+
+    /* header */
+    memcpy(hdr->magic, LYSNAP_MAGIC, strlen(LYSNAP_MAGIC));
+    hdr->version = LYSNAP_VERSION;
+    hdr->byte_order = LYSNAP_BYTE_ORDER;
+    hdr->layout = snap_layout();
+    hdr->obj_count = s.obj_count;
+    hdr->rel_count = rel_count;
+    hdr->mod_count = ctx->models.used;
+    hdr->str_count = s.str_count;
+    hdr->str_size = str_size;
+    hdr->module_set_id = ctx->models.module_set_id;
+    hdr->internal_module_count = ctx->internal_module_count;
+    hdr->obj_size = obj_size;
+
+    /* objects */
+    for (i = 0; i < s.obj_count; ++i) {
+        sizes[i] = s.objs[i].size;
+        memcpy(objs + offsets[i], s.objs[i].addr, s.objs[i].size);
+    }
+
+    /* relocations, the pointers themselves are cleared */
+    for (i = 0; i < s.rel_count; ++i) {
+        if (snap_find(&s, sorted, s.rels[i].loc, &idx, &offset) || (offset + sizeof(void *) > sizes[idx])) {
+            LOGINT(ctx);
+            goto cleanup;
+        }
+        loc = objs + offsets[idx] + offset;
+        memset(loc, 0, sizeof(void *));
+        if (i >= rel_count) {
+            continue;
+        }
+
+        rels[i * 5] = idx;
+        rels[i * 5 + 1] = offset;
+        rels[i * 5 + 2] = s.rels[i].kind;
+        if (s.rels[i].kind == LYSNAP_REL_OBJ) {
+            if (snap_find(&s, sorted, s.rels[i].target, &idx, &offset)) {
+                LOGERR(ctx, LY_EINVAL, "Schema pointer outside of the structures stored into a snapshot.");
+                goto cleanup;
+            }
+            rels[i * 5 + 3] = idx;
+            rels[i * 5 + 4] = offset;
+        } else {
+            rels[i * 5 + 3] = s.rels[i].aux;
+        }
+    }
+
+    /* modules */
+    for (i = 0; i < (unsigned)ctx->models.used; ++i) {
+        rec.addr = ctx->models.list[i];
+        if (lyht_find(s.obj_ht, &rec, snap_addr_hash(rec.addr), (void **)&match)) {
+            LOGINT(ctx);
+            goto cleanup;
+        }
+        mods[i] = match->idx;
+    }
+
+    /* strings */
+    pos = 0;
+    for (i = 0; i < s.str_count; ++i) {
+        str_refs[i] = s.str_refs[i];
+        str_lens[i] = strlen(s.strs[i]);
+        memcpy(strs + pos, s.strs[i], str_lens[i] + 1);
+        pos += str_lens[i] + 1;
+    }
+
+    *data = buf;
+    *len = size;
+    buf = NULL;
+    ret = 0;
+
+cleanup:
+    free(buf);
+    free(sorted);
+    free(offsets);
+    snap_save_clean(&s);
+    return ret;
+}
+
+/**
+ * @brief Get the next section of a snapshot.
+ *
+ * @return Start of the section, NULL if it does not fit into the snapshot.
+ */
+static const char *
+snap_section(const char *data, size_t len, size_t *pos, uint64_t size)
+{
+    const char *section;
+
+    if ((size > len) || (*pos > len - size)) {
+        return NULL;
+    }
+    section = data + *pos;
+    *pos += LYSNAP_ALIGN(size);
+    return section;
+}
+
+int
+ctx_snapshot_load(struct ly_ctx *ctx, const char *data, size_t len)
+{
+    const struct lysnap_hdr *hdr = (const struct lysnap_hdr *)data;
+    const uint32_t *sizes, *rels, *mods, *str_refs, *str_lens;
+    const char *strs, *objs, **dict = NULL;
+    const struct lyext_plugin_complex *plugin;
+    struct lys_ext *extdef;
+    struct lys_ext_instance_complex *ext;
+    struct lys_module **list;
+    void **obj = NULL, **loc;
+    uint64_t obj_size;
+    uint32_t i, j, str_count = 0;
+    size_t pos;
+    int size;
+
+    assert(!ctx->models.used);
+
+    /* header */
+    if ((len < sizeof *hdr) || memcmp(hdr->magic, LYSNAP_MAGIC, strlen(LYSNAP_MAGIC)) || (hdr->version != LYSNAP_VERSION)) {
+        LOGERR(ctx, LY_EINVAL, "Invalid schema snapshot.");
+        return -1;
+    }
+    if ((hdr->byte_order != LYSNAP_BYTE_ORDER) || (hdr->layout != snap_layout())) {
+        LOGERR(ctx, LY_EINVAL, "Schema snapshot created by an incompatible libyang build.");
+        return -1;
+    }
+
+    /* sections */
+    pos = LYSNAP_ALIGN(sizeof *hdr);
+    sizes = (const uint32_t *)snap_section(data, len, &pos, (uint64_t)hdr->obj_count * sizeof *sizes);
+    rels = (const uint32_t *)snap_section(data, len, &pos, (uint64_t)hdr->rel_count * 5 * sizeof *rels);
+    mods = (const uint32_t *)snap_section(data, len, &pos, (uint64_t)hdr->mod_count * sizeof *mods);
+    str_refs = (const uint32_t *)snap_section(data, len, &pos, (uint64_t)hdr->str_count * sizeof *str_refs);
+    str_lens = (const uint32_t *)snap_section(data, len, &pos, (uint64_t)hdr->str_count * sizeof *str_lens);
+    strs = snap_section(data, len, &pos, hdr->str_size);
+    objs = snap_section(data, len, &pos, hdr->obj_size);
+    if (!sizes || !rels || !mods || !str_refs || !str_lens || !strs || !objs) {
+        goto invalid;
+    }
+
+    /* objects */
+    obj = calloc(hdr->obj_count ? hdr->obj_count : 1, sizeof *obj);
+    LY_CHECK_ERR_GOTO(!obj, LOGMEM(ctx), error);
+    obj_size = 0;
+    for (i = 0; i < hdr->obj_count; ++i) {
+        if ((obj_size > hdr->obj_size) || (hdr->obj_size - obj_size < sizes[i])) {
+            goto invalid;
+        }
+        obj[i] = malloc(sizes[i] ? sizes[i] : 1);
+        LY_CHECK_ERR_GOTO(!obj[i], LOGMEM(ctx), error);
+        memcpy(obj[i], objs + obj_size, sizes[i]);
+        obj_size += LYSNAP_ALIGN(sizes[i]);
+    }
+
+    /* strings */
+    dict = malloc((hdr->str_count ? hdr->str_count : 1) * sizeof *dict);
+    LY_CHECK_ERR_GOTO(!dict, LOGMEM(ctx), error);
+    pos = 0;
+    for (str_count = 0; str_count < hdr->str_count; ++str_count) {
+        if (!str_refs[str_count] || (str_lens[str_count] >= hdr->str_size - pos) || strs[pos + str_lens[str_count]]) {
+            goto invalid;
+        }
+        dict[str_count] = lydict_insert_refs(ctx, strs + pos, str_lens[str_count], str_refs[str_count]);
+        LY_CHECK_ERR_GOTO(!dict[str_count], LOGMEM(ctx), error);
+        pos += str_lens[str_count] + 1;
+    }
+
+    /* relocations */
+    for (i = 0; i < hdr->rel_count; ++i) {
+        j = rels[i * 5];
+        if ((j >= hdr->obj_count) || (sizes[j] < sizeof *loc) || (rels[i * 5 + 1] > sizes[j] - sizeof *loc)) {
+            goto invalid;
+        }
+        loc = (void **)((char *)obj[j] + rels[i * 5 + 1]);
+
+        switch (rels[i * 5 + 2]) {
+        case LYSNAP_REL_OBJ:
+            j = rels[i * 5 + 3];
+            if ((j >= hdr->obj_count) || (rels[i * 5 + 4] && (rels[i * 5 + 4] >= sizes[j]))) {
+                goto invalid;
+            }
+            *loc = (char *)obj[j] + rels[i * 5 + 4];
+            break;
+        case LYSNAP_REL_STR:
+            if (rels[i * 5 + 3] >= hdr->str_count) {
+                goto invalid;
+            }
+            *loc = (void *)dict[rels[i * 5 + 3]];
+            break;
+        case LYSNAP_REL_CTX:
+            *loc = ctx;
+            break;
+        case LYSNAP_REL_BUILTIN:
+            if (rels[i * 5 + 3] >= LY_DATA_TYPE_COUNT) {
+                goto invalid;
+            }
+            *loc = ly_types[rels[i * 5 + 3]];
+            break;
+        case LYSNAP_REL_PLUGIN:
+            if (rels[i * 5 + 1] < offsetof(struct lys_ext, plugin)) {
+                goto invalid;
+            }
+            extdef = (struct lys_ext *)((char *)loc - offsetof(struct lys_ext, plugin));
+            if (!extdef->name || !extdef->module || !extdef->module->name) {
+                goto invalid;
+            }
+            /* missing plugin is fine, the extension is just not processed, as if loaded from the source */
+            *loc = ext_get_plugin(extdef->name, extdef->module->name,
+                                  extdef->module->rev_size ? extdef->module->rev[0].date : NULL);
+            break;
+        case LYSNAP_REL_SUBSTMT:
+            if (rels[i * 5 + 1] != offsetof(struct lys_ext_instance_complex, substmt)) {
+                goto invalid;
+            }
+            ext = (struct lys_ext_instance_complex *)obj[rels[i * 5]];
+            plugin = ext->def ? (struct lyext_plugin_complex *)ext->def->plugin : NULL;
+            if (!plugin || (plugin->type != LYEXT_COMPLEX) || (plugin->instance_size != sizes[rels[i * 5]])) {
+                LOGERR(ctx, LY_EINVAL, "Plugin of the extension \"%s\" stored in the schema snapshot not available.",
+                       ext->def && ext->def->name ? ext->def->name : "<unknown>");
+                goto error;
+            }
+            *loc = plugin->substmt;
+            break;
+        default:
+            goto invalid;
+        }
+    }
+
+    /* modules */
+    size = ctx->models.size;
+    while (size < (signed)hdr->mod_count) {
+        size *= 2;
+    }
+    if (size > ctx->models.size) {
+        list = realloc(ctx->models.list, size * sizeof *list);
+        LY_CHECK_ERR_GOTO(!list, LOGMEM(ctx), error);
+        ctx->models.list = list;
+        ctx->models.size = size;
+    }
+    for (i = 0; i < hdr->mod_count; ++i) {
+        if ((mods[i] >= hdr->obj_count) || (sizes[mods[i]] != sizeof(struct lys_module))) {
+            goto invalid;
+        }
+        ctx->models.list[i] = obj[mods[i]];
+        if (!ctx->models.list[i]->name || !ctx->models.list[i]->ns) {
+            goto invalid;
+        }
+    }
+    for (i = 0; i < hdr->mod_count; ++i) {
+        if (ctx_modules_index_add(ctx->models.list[i])) {
+            while (i--) {
+                ctx_modules_index_remove(ctx->models.list[i]);
+            }
+            LOGMEM(ctx);
+            goto error;
+        }
+    }
+    ctx->models.used = hdr->mod_count;
+    ctx->models.module_set_id = hdr->module_set_id;
+    ctx->internal_module_count = hdr->internal_module_count;
+
+    free(obj);
+    free(dict);
+    return 0;
+
+invalid:
+    LOGERR(ctx, LY_EINVAL, "Invalid schema snapshot.");
+error:
+    for (i = 0; obj && (i < hdr->obj_count); ++i) {
+        free(obj[i]);
+    }
+    free(obj);
+    for (i = 0; i < str_count; ++i) {
+        for (j = 0; j < str_refs[i]; ++j) {
+            lydict_remove(ctx, dict[i]);
+        }
+    }
+    free(dict);
+    return -1;
+}
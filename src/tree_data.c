@@ -19,6 +19,7 @@
 #include <limits.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -375,6 +376,141 @@ lyd_hash(struct lyd_node *node)
     return 1;
 }
 
+#endif
+
+/**
+ * @brief Data node lookup by its schema node and optionally the values of its keys or its leaf-list value.
+ */
+struct lyd_node_lookup {
+    const struct lys_node *schema;
+    uint8_t val_count;                      /* number of values, 0 to match all the instances */
+    const char *vals[LYD_LOOKUP_MAX_VALS];  /* canonical key values in the schema order, or the leaf-list value */
+};
+
+/**
+ * @brief Callback for matching data nodes to a lookup, always called with the lookup as the first value.
+ */
+static int
+lyd_node_lookup_equal(void *val1_p, void *val2_p, int UNUSED(mod), void *UNUSED(cb_data))
+{
+    struct lyd_node_lookup *lookup = val1_p;
+    struct lyd_node *node = *(struct lyd_node **)val2_p, *key;
+    uint8_t i;
+
+    if (node->schema != lookup->schema) {
+        return 0;
+    }
+
+    if (lookup->schema->nodetype == LYS_LEAFLIST) {
+        if (lookup->val_count && strcmp(((struct lyd_node_leaf_list *)node)->value_str, lookup->vals[0])) {
+            return 0;
+        }
+    } else if (lookup->schema->nodetype == LYS_LIST) {
+        for (i = 0, key = node->child; i < lookup->val_count; ++i, key = key->next) {
+            if (!key || (key->schema != (struct lys_node *)((struct lys_node_list *)lookup->schema)->keys[i])
+                    || strcmp(((struct lyd_node_leaf_list *)key)->value_str, lookup->vals[i])) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Get the hash of a schema node used as the start of the hashes of all its data instances.
+ *
+ * @param[in] schema Schema node.
+ * @return Unfinished hash.
+ */
+static uint32_t
+lyd_node_lookup_hash(const struct lys_node *schema)
+{
+    const char *mod_name;
+    uint32_t hash;
+
+    /* the same start as in lyd_hash() */
+    mod_name = lys_node_module(schema)->name;
+    hash = dict_hash_multi(0, mod_name, strlen(mod_name));
+    return dict_hash_multi(hash, schema->name, strlen(schema->name));
+}
+
+/**
+ * @brief Find a data node instance matching a lookup, in the sibling hash table if there is one.
+ *
+ * If there can be more matching instances (state lists and leaf-lists), any of them is returned.
+ *
+ * @param[in] siblings First sibling of the instances, can be NULL.
+ * @param[in] lookup Lookup to use.
+ * @param[in] hash Hash of the lookup schema node from lyd_node_lookup_hash().
+ * @return Found instance, NULL if there is none.
+ */
+static struct lyd_node *
+lyd_node_lookup_first(struct lyd_node *siblings, struct lyd_node_lookup *lookup, uint32_t hash)
+{
+    struct lyd_node *iter;
+
+#ifdef LY_ENABLED_CACHE
+    struct lyd_node **match_p;
+    uint8_t i;
+
+    if (siblings && siblings->parent && siblings->parent->ht) {
+        for (i = 0; i < lookup->val_count; ++i) {
+            hash = dict_hash_multi(hash, lookup->vals[i], strlen(lookup->vals[i]));
+        }
+        hash = dict_hash_multi(hash, NULL, 0);
+
+        if (lyht_find_with_val_cb(siblings->parent->ht, lookup, hash, lyd_node_lookup_equal, (void **)&match_p)) {
+            return NULL;
+        }
+        return *match_p;
+    }
+#else
+    (void)hash;
+#endif
+
+    LY_TREE_FOR(siblings, iter) {
+        if (lyd_node_lookup_equal(lookup, &iter, 0, NULL)) {
+            return iter;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Find all the data node instances matching a lookup.
+ *
+ * @param[in] siblings First sibling of the instances, can be NULL.
+ * @param[in] lookup Lookup to use.
+ * @param[in] single Whether there can be at most one matching instance so that the sibling hash table can be used.
+ * @param[in] set Set to add the matching instances to.
+ * @return 0 on success, -1 on error.
+ */
+static int
+lyd_node_lookup_find(struct lyd_node *siblings, struct lyd_node_lookup *lookup, int single, struct ly_set *set)
+{
+    struct lyd_node *iter;
+
+    if (single) {
+        iter = lyd_node_lookup_first(siblings, lookup, lyd_node_lookup_hash(lookup->schema));
+        if (iter && (ly_set_add(set, iter, LY_SET_OPT_USEASLIST) == -1)) {
+            return -1;
+        }
+        return 0;
+    }
+
+    LY_TREE_FOR(siblings, iter) {
+        if (lyd_node_lookup_equal(lookup, &iter, 0, NULL) && (ly_set_add(set, iter, LY_SET_OPT_USEASLIST) == -1)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+#ifdef LY_ENABLED_CACHE
+
 static void
 lyd_keyless_list_hash_change(struct lyd_node *parent)
 {
@@ -414,6 +550,8 @@ _lyd_insert_hash(struct lyd_node *node, int keyless_list_check)
     int i;
 
     if (node->parent) {
+        lyd_content_hash_invalidate(node->parent);
+
         if ((node->schema->nodetype != LYS_LIST) || lyd_list_has_keys(node)) {
             if ((node->schema->nodetype == LYS_LEAF) && lys_is_key((struct lys_node_leaf *)node->schema, NULL)) {
                 /* we are adding a key which means that it may be the last missing key for our parent's hash */
@@ -481,6 +619,10 @@ _lyd_unlink_hash(struct lyd_node *node, struct lyd_node *orig_parent, int keyles
     }
 #endif
 
+    if (orig_parent) {
+        lyd_content_hash_invalidate(orig_parent);
+    }
+
     if (orig_parent && node->hash && ((node->schema->nodetype != LYS_LIST) || lyd_list_has_keys(node))) {
         if (orig_parent->ht) {
             if (lyht_remove(orig_parent->ht, &node, node->hash)) {
@@ -514,6 +656,21 @@ lyd_unlink_hash(struct lyd_node *node, struct lyd_node *orig_parent)
     _lyd_unlink_hash(node, orig_parent, 1);
 }
 
+void
+lyd_content_hash_invalidate(struct lyd_node *node)
+{
+    if (node && (node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA))) {
+        /* only the hashes of inner nodes are cached */
+        node = node->parent;
+    }
+
+    /* a node with a cached hash has the hashes of all its descendants cached, too,
+     * so there is nothing more to invalidate once a node without a hash is reached */
+    for (; node && node->content_hash; node = node->parent) {
+        node->content_hash = 0;
+    }
+}
+
 #endif
 
 /**
@@ -931,37 +1088,18 @@ static struct lyd_node *
 lyd_parse_(struct ly_ctx *ctx, const struct lyd_node *rpc_act, const char *data, LYD_FORMAT format, int options,
            const struct lyd_node *data_tree, const char *yang_data_name)
 {
-    struct lyxml_elem *xml;
     struct lyd_node *result = NULL;
-    int xmlopt = LYXML_PARSE_MULTIROOT;
 
     if (!ctx || !data) {
         LOGARG;
         return NULL;
     }
 
-    if (options & LYD_OPT_NOSIBLINGS) {
-        xmlopt = 0;
-    }
-
     /* we must free all the errors, otherwise we are unable to properly check returned ly_errno :-/ */
     ly_errno = LY_SUCCESS;
     switch (format) {
     case LYD_XML:
-        xml = lyxml_parse_mem(ctx, data, xmlopt);
-        if (ly_errno) {
-            break;
-        }
-        if (options & LYD_OPT_RPCREPLY) {
-            result = lyd_parse_xml(ctx, &xml, options, rpc_act, data_tree);
-        } else if (options & (LYD_OPT_RPC | LYD_OPT_NOTIF)) {
-            result = lyd_parse_xml(ctx, &xml, options, data_tree);
-        } else if (options & LYD_OPT_DATA_TEMPLATE) {
-            result = lyd_parse_xml(ctx, &xml, options, yang_data_name);
-        } else {
-            result = lyd_parse_xml(ctx, &xml, options);
-        }
-        lyxml_free_withsiblings(ctx, xml);
+        result = xml_read_data(ctx, data, options, rpc_act, data_tree, yang_data_name);
         break;
     case LYD_JSON:
         result = lyd_parse_json(ctx, data, options, rpc_act, data_tree, yang_data_name);
@@ -985,6 +1123,10 @@ lyd_parse_(struct ly_ctx *ctx, const struct lyd_node *rpc_act, const char *data,
         return NULL;
     }
 
+#ifdef LY_ENABLED_CACHE
+    lyd_pos_idx_tree(result);
+#endif
+
     return result;
 }
 
@@ -1124,108 +1266,482 @@ lyd_parse_path(struct ly_ctx *ctx, const char *path, LYD_FORMAT format, int opti
     return ret;
 }
 
-static struct lys_node *
-lyd_new_find_schema(struct lyd_node *parent, const struct lys_module *module, int rpc_output)
+/* minimal size of a data part parsed by a single thread */
+#define LYD_PARSE_PART_MIN 65536
+
+/* number of data parts per thread so that the threads are evenly loaded */
+#define LYD_PARSE_PARTS_PER_THREAD 4
+
+/**
+ * @brief Part of the data parsed by a single thread of lyd_parse_mem_parallel().
+ */
+struct lyd_parse_part {
+    const char *start;          /**< start of the part (top-level boundary) */
+    const char *end;            /**< end of the part, NULL for the last one */
+    struct lyd_node *first;     /**< parsed top-level nodes */
+    struct unres_data unres;    /**< unresolved items of the parsed nodes */
+    struct ly_err_item *eitem;  /**< messages logged while parsing the part */
+    LY_ERR no;                  /**< error code, LY_SUCCESS if the part was parsed */
+};
+
+/**
+ * @brief Work shared by the threads of lyd_parse_mem_parallel().
+ */
+struct lyd_parse_pool {
+    struct ly_ctx *ctx;
+    LYD_FORMAT format;
+    int options;
+    enum int_log_opts ilo;      /**< internal logging options of the calling thread */
+    struct lyd_parse_part *parts;
+    uint32_t count;
+    uint32_t next;              /**< index of the next part to parse */
+    int failed;                 /**< some part failed to be parsed, stop */
+};
+
+static void *
+lyd_parse_worker(void *arg)
 {
-    struct lys_node *siblings;
+    struct lyd_parse_pool *pool = arg;
+    struct lyd_parse_part *part;
+    uint32_t idx;
+    int r;
 
-    if (!parent) {
-        siblings = module->data;
-    } else {
-        if (!parent->schema) {
-            return NULL;
+    log_opt = pool->ilo;
+    while (!__sync_fetch_and_add(&pool->failed, 0) && ((idx = __sync_fetch_and_add(&pool->next, 1)) < pool->count)) {
+        part = &pool->parts[idx];
+        ly_errno = LY_SUCCESS;
+
+        if (pool->options & LYD_OPT_ARENA) {
+            part->unres.arena = lyd_arena_new();
         }
-        siblings = parent->schema->child;
-        if (siblings && (siblings->nodetype == (rpc_output ? LYS_INPUT : LYS_OUTPUT))) {
-            siblings = siblings->next;
+        if ((pool->options & LYD_OPT_ARENA) && !part->unres.arena) {
+            LOGMEM(pool->ctx);
+            r = EXIT_FAILURE;
+        } else if (pool->format == LYD_XML) {
+            r = xml_read_data_part(pool->ctx, part->start, part->end, pool->options, &part->unres, &part->first);
+        } else {
+            r = lyd_parse_json_part(pool->ctx, part->start, part->end, pool->options, &part->unres, &part->first);
         }
-        if (siblings && (siblings->nodetype == (rpc_output ? LYS_OUTPUT : LYS_INPUT))) {
-            siblings = siblings->child;
+        if (r) {
+            part->no = ly_errno ? ly_errno : LY_EINT;
+            __sync_fetch_and_or(&pool->failed, 1);
         }
+
+        /* the messages are passed to the calling thread */
+        part->eitem = ly_err_detach(pool->ctx);
     }
 
-    return siblings;
+    return NULL;
 }
 
-struct lyd_node *
-_lyd_new(struct lyd_node *parent, const struct lys_node *schema, int dflt)
+/* logs directly, splits the data into parts at top-level boundaries and parses them in parallel */
+static struct lyd_node *
+lyd_parse_parallel_(struct ly_ctx *ctx, const char *data, LYD_FORMAT format, int options, int threads)
 {
-    struct lyd_node *ret;
+    struct lyd_parse_pool pool;
+    struct lyd_parse_part *parts;
+    struct unres_data *unres = NULL;
+    struct lyd_node *result = NULL, *iter, *last;
+    const struct lys_node *parent;
+    struct ly_err_item *eitem;
+    const char *start, *next, *min;
+    pthread_t *tids = NULL;
+    size_t part_size;
+    uint32_t count, i, started = 0;
+    void *r;
+
+    if (format == LYD_XML) {
+        start = data;
+    } else {
+        start = data + strspn(data, " \t\n\r");
+        if ((*start != '{') || !lyjson_attrs_adjacent(start)) {
+            /* invalid or with metadata that could be split from their nodes, let the standard parser handle it */
+            return lyd_parse_(ctx, NULL, data, format, options, NULL, NULL);
+        }
+    }
 
-    ret = calloc(1, sizeof *ret);
-    LY_CHECK_ERR_RETURN(!ret, LOGMEM(schema->module->ctx), NULL);
+    /* split the data */
+    count = threads * LYD_PARSE_PARTS_PER_THREAD;
+    part_size = strlen(start) / count;
+    if (part_size < LYD_PARSE_PART_MIN) {
+        part_size = LYD_PARSE_PART_MIN;
+    }
+    parts = calloc(count, sizeof *parts);
+    LY_CHECK_ERR_RETURN(!parts, LOGMEM(ctx), NULL);
+    parts[0].start = start;
+    for (i = 1, next = start; i < count; ++i) {
+        min = start + i * part_size;
+        if (min <= next) {
+            min = next + 1;
+        }
+        next = (format == LYD_XML) ? lyxml_next_root(next, min) : lyjson_next_member(next, min);
+        if (!next) {
+            break;
+        }
+        parts[i - 1].end = next;
+        parts[i].start = next;
+    }
+    count = i;
+    if (count < 2) {
+        /* not worth it */
+        free(parts);
+        return lyd_parse_(ctx, NULL, data, format, options, NULL, NULL);
+    }
+
+    /* parse the parts, the calling thread is one of the workers */
+    memset(&pool, 0, sizeof pool);
+    pool.ctx = ctx;
+    pool.format = format;
+    pool.options = options;
+    pool.ilo = log_opt;
+    pool.parts = parts;
+    pool.count = count;
+
+    eitem = ly_err_detach(ctx);
+    if ((uint32_t)threads > count) {
+        threads = count;
+    }
+    tids = malloc((threads - 1) * sizeof *tids);
+    if (tids) {
+        for (started = 0; (int)started < threads - 1; ++started) {
+            if (pthread_create(&tids[started], NULL, lyd_parse_worker, &pool)) {
+                /* continue with fewer threads */
+                break;
+            }
+        }
+    }
+    lyd_parse_worker(&pool);
+    for (i = 0; i < started; ++i) {
+        pthread_join(tids[i], &r);
+    }
+    free(tids);
 
-    ret->schema = (struct lys_node *)schema;
-    ret->validity = ly_new_node_validity(schema);
-    if (resolve_applies_when(schema, 0, NULL)) {
-        ret->when_status = LYD_WHEN;
+    /* restore the messages in the order of the data */
+    ly_err_attach(ctx, eitem);
+    ly_errno = LY_SUCCESS;
+    for (i = 0; i < count; ++i) {
+        ly_err_attach(ctx, parts[i].eitem);
+        if (parts[i].no && !ly_errno) {
+            ly_errno = parts[i].no;
+        }
+    }
+
+    /* connect all the parsed nodes and merge the unres, all the parts are freed on error */
+    i = 0;
+    unres = calloc(1, sizeof *unres);
+    LY_CHECK_ERR_GOTO(!unres && !ly_errno, LOGMEM(ctx), error);
+    for (i = 0; i < count; ++i) {
+        if (parts[i].first) {
+            if (!result) {
+                result = parts[i].first;
+            } else {
+                last = result->prev;
+                result->prev = parts[i].first->prev;
+                last->next = parts[i].first;
+                parts[i].first->prev = last;
+            }
+            parts[i].first = NULL;
+        }
+
+        if (unres && !ly_errno && parts[i].unres.count) {
+            r = realloc(unres->node, (unres->count + parts[i].unres.count) * sizeof *unres->node);
+            LY_CHECK_ERR_GOTO(!r, LOGMEM(ctx), error);
+            unres->node = r;
+            r = realloc(unres->type, (unres->count + parts[i].unres.count) * sizeof *unres->type);
+            LY_CHECK_ERR_GOTO(!r, LOGMEM(ctx), error);
+            unres->type = r;
+            memcpy(&unres->node[unres->count], parts[i].unres.node, parts[i].unres.count * sizeof *unres->node);
+            memcpy(&unres->type[unres->count], parts[i].unres.type, parts[i].unres.count * sizeof *unres->type);
+            unres->count += parts[i].unres.count;
+        }
+        free(parts[i].unres.node);
+        free(parts[i].unres.type);
+        parts[i].unres.node = NULL;
+        parts[i].unres.type = NULL;
+        lyd_arena_release(parts[i].unres.arena);
+        parts[i].unres.arena = NULL;
+    }
+    if (ly_errno) {
+        goto error;
+    }
+
+    /* the top-level nodes were checked only against the nodes from the same part */
+    LY_TREE_FOR(result, iter) {
+        if (!(options & LYD_OPT_TRUSTED) && (iter->schema->nodetype & (LYS_CONTAINER | LYS_LEAF | LYS_ANYDATA))) {
+            for (last = iter->next; last && (last->schema != iter->schema); last = last->next);
+            if (last) {
+                parent = lys_parent(iter->schema);
+                LOGVAL(ctx, LYE_TOOMANY, LY_VLOG_LYD, last, iter->schema->name,
+                       parent ? (parent->nodetype == LYS_EXT) ? ((struct lys_ext_instance *)parent)->arg_value : parent->name : "data tree");
+                goto error;
+            }
+        }
+        if (lyv_multicases(iter, NULL, &result, 0, NULL)) {
+            goto error;
+        }
+    }
+
+    /* add missing ietf-yang-library if requested */
+    if (options & LYD_OPT_DATA_ADD_YANGLIB) {
+        LY_TREE_FOR(result, iter) {
+            if (iter->schema->module == ctx->models.list[ctx->internal_module_count - 1]) {
+                /* ietf-yang-library data present, so ignore the option to add them */
+                options &= ~LYD_OPT_DATA_ADD_YANGLIB;
+                break;
+            }
+        }
+    }
+    if (options & LYD_OPT_DATA_ADD_YANGLIB) {
+        if (!result) {
+            result = ly_ctx_info(ctx);
+        } else if (lyd_merge(result, ly_ctx_info(ctx), LYD_OPT_DESTRUCT | LYD_OPT_EXPLICIT)) {
+            LOGERR(ctx, LY_EINT, "Adding ietf-yang-library data failed.");
+            goto error;
+        }
+    }
+
+    /* check for uniqueness of top-level lists/leaflists because
+     * only the inner instances were tested in lyv_data_content() */
+    LY_TREE_FOR(result, iter) {
+        if (!(iter->schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) || !(iter->validity & LYD_VAL_DUP)) {
+            continue;
+        }
+
+        if (lyv_data_dup(iter, result)) {
+            goto error;
+        }
     }
-    ret->prev = ret;
-    ret->dflt = dflt;
 
+    /* add default values, resolve unres and check for mandatory nodes in final tree */
+    if (lyd_defaults_add_unres(&result, options, ctx, NULL, 0, NULL, NULL, unres, 1)) {
+        goto error;
+    }
+    if (!(options & LYD_OPT_TRUSTED) && lyd_check_mandatory_tree(result, ctx, NULL, 0, options)) {
+        goto error;
+    }
 #ifdef LY_ENABLED_CACHE
-    lyd_hash(ret);
+    lyd_pos_idx_tree(result);
 #endif
 
-    if (parent) {
-        if (lyd_insert(parent, ret)) {
-            lyd_free(ret);
-            return NULL;
-        }
+    free(unres->node);
+    free(unres->type);
+    free(unres);
+    free(parts);
+    return result;
+
+error:
+    lyd_free_withsiblings(result);
+    if (unres) {
+        free(unres->node);
+        free(unres->type);
+        free(unres);
     }
-    return ret;
+    for (; i < count; ++i) {
+        lyd_free_withsiblings(parts[i].first);
+        free(parts[i].unres.node);
+        free(parts[i].unres.type);
+        lyd_arena_release(parts[i].unres.arena);
+    }
+    free(parts);
+    return NULL;
 }
 
 API struct lyd_node *
-lyd_new(struct lyd_node *parent, const struct lys_module *module, const char *name)
+lyd_parse_mem_parallel(struct ly_ctx *ctx, const char *data, LYD_FORMAT format, int options, int threads)
 {
     FUN_IN;
 
-    const struct lys_node *snode = NULL, *siblings;
-
-    if ((!parent && !module) || !name) {
+    if (!ctx || !data || (threads < 1)) {
         LOGARG;
         return NULL;
     }
 
-    siblings = lyd_new_find_schema(parent, module, 0);
-    if (!siblings) {
-        LOGARG;
+    if (lyp_data_check_options(ctx, options, __func__)) {
         return NULL;
     }
-
-    if (lys_getnext_data(module, lys_parent(siblings), name, strlen(name), LYS_CONTAINER | LYS_LIST | LYS_NOTIF
-                         | LYS_RPC | LYS_ACTION, 0, &snode) || !snode) {
-        LOGERR(siblings->module->ctx, LY_EINVAL, "Failed to find \"%s\" as a sibling to \"%s:%s\".",
-               name, lys_node_module(siblings)->name, siblings->name);
+    if (options & (LYD_OPT_RPC | LYD_OPT_RPCREPLY | LYD_OPT_NOTIF | LYD_OPT_NOTIF_FILTER | LYD_OPT_DATA_TEMPLATE
+            | LYD_OPT_DESTRUCT | LYD_OPT_NOSIBLINGS | LYD_OPT_VAL_DIFF)) {
+        LOGERR(ctx, LY_EINVAL, "%s: Invalid options 0x%x (not supported when parsing in parallel).", __func__, options);
         return NULL;
     }
 
-    return _lyd_new(parent, snode, 0);
+    if ((threads == 1) || ((format != LYD_XML) && (format != LYD_JSON))) {
+        return lyd_parse_(ctx, NULL, data, format, options, NULL, NULL);
+    }
+
+    ly_errno = LY_SUCCESS;
+    return lyd_parse_parallel_(ctx, data, format, options, threads);
 }
 
-static struct lyd_node *
-lyd_create_leaf(const struct lys_node *schema, const char *val_str, int dflt, int edit_leaf)
+static int
+lyd_parse_clb_(struct ly_ctx *ctx, const char *data, LYD_FORMAT format, int options, const struct lyd_parse_clb *clb,
+               const char *func)
 {
-    struct lyd_node_leaf_list *ret;
-
-    ret = calloc(1, sizeof *ret);
-    LY_CHECK_ERR_RETURN(!ret, LOGMEM(schema->module->ctx), NULL);
-
-    ret->schema = (struct lys_node *)schema;
-    ret->validity = ly_new_node_validity(schema);
-    if (resolve_applies_when(schema, 0, NULL)) {
-        ret->when_status = LYD_WHEN;
+    if (lyp_data_check_options(ctx, options, func)) {
+        return EXIT_FAILURE;
+    }
+    if (options & (LYD_OPT_RPCREPLY | LYD_OPT_DATA_TEMPLATE | LYD_OPT_DATA_ADD_YANGLIB | LYD_OPT_DESTRUCT
+            | LYD_OPT_VAL_DIFF | LYD_OPT_ARENA)) {
+        LOGERR(ctx, LY_EINVAL, "%s: Invalid options 0x%x (not supported when parsing data for callbacks).", func, options);
+        return EXIT_FAILURE;
     }
-    ret->prev = (struct lyd_node *)ret;
-    ret->value_type = ((struct lys_node_leaf *)schema)->type.base;
-    ret->value_str = lydict_insert(schema->module->ctx, val_str ? val_str : "", 0);
-    ret->dflt = dflt;
 
-    if (edit_leaf && !ret->value_str[0]) {
-        /* empty edit leaf, it is fine */
-        ((struct lyd_node_leaf_list *)ret)->value_type = LY_TYPE_UNKNOWN;
-    } else if (!lyp_parse_value(&((struct lys_node_leaf *)schema)->type, &ret->value_str, NULL, ret, NULL, NULL, 1, dflt)) {
+    ly_errno = LY_SUCCESS;
+    switch (format) {
+    case LYD_XML:
+        return xml_read_data_clb(ctx, data, options, clb);
+    case LYD_JSON:
+        return lyd_parse_json_clb(ctx, data, options, clb);
+    default:
+        LOGERR(ctx, LY_EINVAL, "%s: Unsupported data format.", func);
+        return EXIT_FAILURE;
+    }
+}
+
+API int
+lyd_parse_mem_clb(struct ly_ctx *ctx, const char *data, LYD_FORMAT format, int options, const struct lyd_parse_clb *clb)
+{
+    FUN_IN;
+
+    if (!ctx || !data || !clb) {
+        LOGARG;
+        return EXIT_FAILURE;
+    }
+
+    return lyd_parse_clb_(ctx, data, format, options, clb, __func__);
+}
+
+API int
+lyd_parse_fd_clb(struct ly_ctx *ctx, int fd, LYD_FORMAT format, int options, const struct lyd_parse_clb *clb)
+{
+    FUN_IN;
+
+    int ret;
+    size_t length;
+    char *data;
+
+    if (!ctx || (fd == -1) || !clb) {
+        LOGARG;
+        return EXIT_FAILURE;
+    }
+
+    if (lyp_mmap(ctx, fd, 0, &length, (void **)&data)) {
+        LOGERR(ctx, LY_ESYS, "Mapping file descriptor into memory failed (%s()).", __func__);
+        return EXIT_FAILURE;
+    } else if (!data) {
+        /* empty file */
+        return EXIT_SUCCESS;
+    }
+
+    ret = lyd_parse_clb_(ctx, data, format, options, clb, __func__);
+
+    lyp_munmap(data, length);
+
+    return ret;
+}
+
+static struct lys_node *
+lyd_new_find_schema(struct lyd_node *parent, const struct lys_module *module, int rpc_output)
+{
+    struct lys_node *siblings;
+
+    if (!parent) {
+        siblings = module->data;
+    } else {
+        if (!parent->schema) {
+            return NULL;
+        }
+        siblings = parent->schema->child;
+        if (siblings && (siblings->nodetype == (rpc_output ? LYS_INPUT : LYS_OUTPUT))) {
+            siblings = siblings->next;
+        }
+        if (siblings && (siblings->nodetype == (rpc_output ? LYS_OUTPUT : LYS_INPUT))) {
+            siblings = siblings->child;
+        }
+    }
+
+    return siblings;
+}
+
+struct lyd_node *
+_lyd_new(struct lyd_node *parent, const struct lys_node *schema, int dflt)
+{
+    struct lyd_node *ret;
+
+    ret = calloc(1, sizeof *ret);
+    LY_CHECK_ERR_RETURN(!ret, LOGMEM(schema->module->ctx), NULL);
+
+    ret->schema = (struct lys_node *)schema;
+    ret->validity = ly_new_node_validity(schema);
+    if (resolve_applies_when(schema, 0, NULL)) {
+        ret->when_status = LYD_WHEN;
+    }
+    ret->prev = ret;
+    ret->dflt = dflt;
+
+#ifdef LY_ENABLED_CACHE
+    lyd_hash(ret);
+#endif
+
+    if (parent) {
+        if (lyd_insert(parent, ret)) {
+            lyd_free(ret);
+            return NULL;
+        }
+    }
+    return ret;
+}
+
+API struct lyd_node *
+lyd_new(struct lyd_node *parent, const struct lys_module *module, const char *name)
+{
+    FUN_IN;
+
+    const struct lys_node *snode = NULL, *siblings;
+
+    if ((!parent && !module) || !name) {
+        LOGARG;
+        return NULL;
+    }
+
+    siblings = lyd_new_find_schema(parent, module, 0);
+    if (!siblings) {
+        LOGARG;
+        return NULL;
+    }
+
+    if (lys_getnext_data(module, lys_parent(siblings), name, strlen(name), LYS_CONTAINER | LYS_LIST | LYS_NOTIF
+                         | LYS_RPC | LYS_ACTION, 0, &snode) || !snode) {
+        LOGERR(siblings->module->ctx, LY_EINVAL, "Failed to find \"%s\" as a sibling to \"%s:%s\".",
+               name, lys_node_module(siblings)->name, siblings->name);
+        return NULL;
+    }
+
+    return _lyd_new(parent, snode, 0);
+}
+
+static struct lyd_node *
+lyd_create_leaf(const struct lys_node *schema, const char *val_str, int dflt, int edit_leaf)
+{
+    struct lyd_node_leaf_list *ret;
+
+    ret = calloc(1, sizeof *ret);
+    LY_CHECK_ERR_RETURN(!ret, LOGMEM(schema->module->ctx), NULL);
+
+    ret->schema = (struct lys_node *)schema;
+    ret->validity = ly_new_node_validity(schema);
+    if (resolve_applies_when(schema, 0, NULL)) {
+        ret->when_status = LYD_WHEN;
+    }
+    ret->prev = (struct lyd_node *)ret;
+    ret->value_type = ((struct lys_node_leaf *)schema)->type.base;
+    ret->value_str = lydict_insert(schema->module->ctx, val_str ? val_str : "", 0);
+    ret->dflt = dflt;
+
+    if (edit_leaf && !ret->value_str[0]) {
+        /* empty edit leaf, it is fine */
+        ((struct lyd_node_leaf_list *)ret)->value_type = LY_TYPE_UNKNOWN;
+    } else if (!lyp_parse_value(&((struct lys_node_leaf *)schema)->type, &ret->value_str, NULL, ret, NULL, NULL, 1, dflt)) {
         lyd_free((struct lyd_node *)ret);
         return NULL;
     }
@@ -1321,6 +1837,9 @@ lyd_wd_update_parents(struct lyd_node *node)
             /* all siblings are implicit default nodes, propagate it to the parent */
             node = node->parent;
             node->dflt = 1;
+#ifdef LY_ENABLED_CACHE
+            lyd_content_hash_invalidate(node);
+#endif
             continue;
         } else {
             /* stop the loop */
@@ -1343,6 +1862,9 @@ lyd_change_leaf(struct lyd_node_leaf_list *leaf, const char *val_str)
         return -1;
     }
 
+    /* the value is stored into the leaf while being parsed */
+    lyd_journal_change((struct lyd_node *)leaf);
+
     backup = leaf->value_str;
     new_val = lydict_insert(leaf->schema->module->ctx, val_str ? val_str : "", 0);
 
@@ -1397,6 +1919,12 @@ lyd_change_leaf(struct lyd_node_leaf_list *leaf, const char *val_str)
 #endif
     }
 
+#ifdef LY_ENABLED_CACHE
+    if (val_change || dflt_change) {
+        lyd_content_hash_invalidate((struct lyd_node *)leaf);
+    }
+#endif
+
     return (val_change || dflt_change ? 0 : 1);
 }
 
@@ -1741,6 +2269,9 @@ lyd_new_path_update(struct lyd_node *node, void *value, LYD_ANYDATA_VALUETYPE va
         if (dflt) {
             /* maybe the value is the same, but the node is default now */
             node->dflt = 1;
+#ifdef LY_ENABLED_CACHE
+            lyd_content_hash_invalidate(node);
+#endif
             return node;
         }
 
@@ -1767,6 +2298,11 @@ lyd_new_path_update(struct lyd_node *node, void *value, LYD_ANYDATA_VALUETYPE va
             }
         }
 
+#ifdef LY_ENABLED_CACHE
+        lyd_content_hash_invalidate(node);
+#endif
+        lyd_journal_change(node);
+
         /* values are not the same - 1) remove the old one ... */
         switch (any->value_type) {
         case LYD_ANYDATA_CONSTSTRING:
@@ -2196,271 +2732,1230 @@ lyd_new_path(struct lyd_node *data_tree, const struct ly_ctx *ctx, const char *p
     return NULL;
 }
 
-API unsigned int
-lyd_list_pos(const struct lyd_node *node)
+/**
+ * @brief Parse a data path template predicate. It is a key-with-value predicate of parse_schema_json_predicate()
+ * without a module name and the value can also be the placeholder '?'.
+ *
+ * @param[in] id Predicate to parse.
+ * @param[out] name Points to the list key name or '.'.
+ * @param[out] nam_len Length of \p name.
+ * @param[out] value Points to the value, NULL for a placeholder.
+ * @param[out] val_len Length of \p value.
+ * @param[out] has_predicate Flag to mark whether there is another predicate specified.
+ * @return Number of characters successfully parsed, non-positive on error (negative index of the invalid character).
+ */
+static int
+lyd_path_tmpl_predicate(const char *id, const char **name, int *nam_len, const char **value, int *val_len,
+                        int *has_predicate)
 {
-    FUN_IN;
-
-    unsigned int pos;
-    struct lys_node *schema;
+    const char *ptr = id, *end;
 
-    if (!node || ((node->schema->nodetype != LYS_LIST) && (node->schema->nodetype != LYS_LEAFLIST))) {
+    if (ptr[0] != '[') {
         return 0;
     }
+    ++ptr;
+    while (isspace(ptr[0])) {
+        ++ptr;
+    }
 
-    schema = node->schema;
-    pos = 0;
-    do {
-        if (node->schema == schema) {
-            ++pos;
+    /* "." or key name */
+    *name = ptr;
+    if (ptr[0] == '.') {
+        *nam_len = 1;
+    } else if (!(*nam_len = parse_identifier(ptr))) {
+        return -(ptr - id);
+    }
+    ptr += *nam_len;
+    while (isspace(ptr[0])) {
+        ++ptr;
+    }
+
+    if (ptr[0] != '=') {
+        return -(ptr - id);
+    }
+    ++ptr;
+    while (isspace(ptr[0])) {
+        ++ptr;
+    }
+
+    /* placeholder or quoted value */
+    if (ptr[0] == '?') {
+        *value = NULL;
+        *val_len = 0;
+        ++ptr;
+    } else if ((ptr[0] == '\'') || (ptr[0] == '\"')) {
+        if (!(end = strchr(ptr + 1, ptr[0]))) {
+            return -(ptr - id);
+        }
+        *value = ptr + 1;
+        *val_len = end - *value;
+        ptr = end + 1;
+    } else {
+        return -(ptr - id);
+    }
+    while (isspace(ptr[0])) {
+        ++ptr;
+    }
+
+    if (ptr[0] != ']') {
+        return -(ptr - id);
+    }
+    ++ptr;
+
+    *has_predicate = (ptr[0] == '[');
+    return ptr - id;
+}
+
+/**
+ * @brief Learn whether the values of a leaf or leaf-list may not be in the canonical form.
+ */
+static int
+lyd_path_tmpl_need_canon(const struct lys_node *schema)
+{
+    const struct lys_type *type;
+
+    for (type = &((struct lys_node_leaf *)schema)->type; type->base == LY_TYPE_LEAFREF; type = &type->info.lref.target->type) {
+        if (!type->info.lref.target) {
+            return 1;
         }
-        node = node->prev;
-    } while (node->next);
+    }
 
-    return pos;
+    return (type->base != LY_TYPE_STRING);
 }
 
-static struct lyd_node *
-lyd_new_dummy(struct lyd_node *root, struct lyd_node *parent, const struct lys_node *schema, const char *value, int dflt)
+API struct lyd_path_tmpl *
+lyd_path_tmpl_compile(struct ly_ctx *ctx, const char *path, int options)
 {
-    unsigned int index;
-    struct ly_set *spath;
-    const struct lys_node *siter;
-    struct lyd_node *iter, *dummy = NULL;
+    FUN_IN;
 
-    assert(schema);
-    assert(schema->nodetype & (LYS_CONTAINER | LYS_LEAF | LYS_LIST | LYS_LEAFLIST | LYS_ANYDATA | LYS_NOTIF |
-                               LYS_RPC | LYS_ACTION));
+    struct lyd_path_tmpl *tmpl;
+    struct lyd_path_tmpl_step *step;
+    const struct lys_node *schild, *sparent = NULL, *tmp, *key;
+    const struct lys_node_list *slist;
+    const struct lys_module *prev_mod = NULL;
+    const char *id, *mod_name, *name, *value;
+    char *str;
+    void *mem;
+    int r, mod_name_len, nam_len, val_len, is_relative = -1, has_predicate;
+    uint8_t k;
 
-    spath = ly_set_new();
-    if (!spath) {
-        LOGMEM(schema->module->ctx);
+    if (!ctx || !path || (path[0] != '/')) {
+        LOGARG;
         return NULL;
     }
 
-    if (!parent && root) {
-        /* find data root */
-        for (; root->parent; root = root->parent);   /* vertical move (up) */
-        for (; root->prev->next; root = root->prev); /* horizontal move (left) */
-    }
+    tmpl = calloc(1, sizeof *tmpl);
+    LY_CHECK_ERR_RETURN(!tmpl, LOGMEM(ctx), NULL);
+    tmpl->ctx = ctx;
+    tmpl->path = lydict_insert(ctx, path, 0);
 
-    /* build schema path */
-    for (siter = schema; siter; siter = lys_parent(siter)) {
-        /* stop if we know some of the parents */
-        if (parent && parent->schema == siter) {
-            break;
+    id = path;
+    do {
+        if ((r = parse_schema_nodeid(id, &mod_name, &mod_name_len, &name, &nam_len, &is_relative, &has_predicate, NULL, 0)) < 1) {
+            LOGVAL(ctx, LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, id[-r], &id[-r]);
+            goto error;
         }
+        id += r;
 
-        if (siter->nodetype & (LYS_CONTAINER | LYS_LEAF | LYS_LIST | LYS_LEAFLIST | LYS_ANYDATA | LYS_NOTIF |
-                               LYS_RPC | LYS_ACTION)) {
-            /* we have a node that can appear in data tree */
-            ly_set_add(spath, (void*)siter, LY_SET_OPT_USEASLIST);
-        } /* else skip the rest node types */
-    }
-
-    assert(spath->number > 0);
-    index = spath->number;
-    if (!parent && !(spath->set.s[index - 1]->nodetype & LYS_LEAFLIST)) {
-        /* start by searching for the top-level parent */
-        LY_TREE_FOR(root, iter) {
-            if (iter->schema == spath->set.s[index - 1]) {
-                parent = iter;
-                index--;
-                break;
+        if (mod_name) {
+            prev_mod = ly_ctx_nget_module(ctx, mod_name, mod_name_len, NULL, 1);
+            if (!prev_mod) {
+                str = strndup(path, (mod_name + mod_name_len) - path);
+                LOGVAL(ctx, LYE_PATH_INMOD, LY_VLOG_STR, str);
+                free(str);
+                goto error;
             }
+        } else if (!prev_mod) {
+            str = strndup(path, (name + nam_len) - path);
+            LOGVAL(ctx, LYE_PATH_MISSMOD, LY_VLOG_STR, str);
+            free(str);
+            goto error;
         }
-    }
 
-    iter = parent;
-    while (iter && index && !(spath->set.s[index - 1]->nodetype & LYS_LEAFLIST)) {
-        /* search for closer parent on the path */
-        LY_TREE_FOR(parent->child, iter) {
-            if (iter->schema == spath->set.s[index - 1]) {
-                index--;
-                parent = iter;
-                break;
+        /* find the schema node */
+        schild = NULL;
+        while ((schild = lys_getnext(schild, sparent, prev_mod, 0))) {
+            if (!(schild->nodetype & (LYS_CONTAINER | LYS_LEAF | LYS_LEAFLIST | LYS_LIST | LYS_NOTIF | LYS_RPC | LYS_ACTION))
+                    || (lys_node_module(schild) != prev_mod) || strncmp(schild->name, name, nam_len) || schild->name[nam_len]) {
+                continue;
+            }
+
+            /* RPC/action in/out check */
+            for (tmp = lys_parent(schild); tmp && (tmp->nodetype == LYS_USES); tmp = lys_parent(tmp));
+            if (tmp && (tmp->nodetype == ((options & LYD_PATH_OPT_OUTPUT) ? LYS_INPUT : LYS_OUTPUT))) {
+                continue;
             }
-        }
-    }
-    while (index) {
-        /* create the missing part of the path */
-        switch (spath->set.s[index - 1]->nodetype) {
-        case LYS_LEAF:
-        case LYS_LEAFLIST:
-            iter = _lyd_new_leaf(parent, spath->set.s[index - 1], value, dflt, 1);
-            break;
-        case LYS_CONTAINER:
-        case LYS_LIST:
-            iter = _lyd_new(parent, spath->set.s[index - 1], dflt);
-            break;
-        case LYS_ANYXML:
-        case LYS_ANYDATA:
-            iter = lyd_create_anydata(parent, spath->set.s[index - 1], "", LYD_ANYDATA_CONSTSTRING);
             break;
-        default:
+        }
+        if (!schild) {
+            str = strndup(path, (name + nam_len) - path);
+            LOGVAL(ctx, LYE_PATH_INNODE, LY_VLOG_STR, str);
+            free(str);
             goto error;
         }
-        if (!iter) {
-            LOGINT(schema->module->ctx);
+        slist = (const struct lys_node_list *)schild;
+        if ((schild->nodetype == LYS_LIST) && (slist->keys_size > LYD_LOOKUP_MAX_VALS)) {
+            LOGERR(ctx, LY_EINVAL, "%s: list \"%s\" has more than %d keys.", __func__, schild->name, LYD_LOOKUP_MAX_VALS);
             goto error;
         }
 
-        /* we say it is valid and it is dummy */
-        iter->validity = LYD_VAL_INUSE;
-
-        if (!dummy) {
-            dummy = iter;
+        /* add a new step */
+        mem = realloc(tmpl->steps, (tmpl->step_count + 1) * sizeof *tmpl->steps);
+        LY_CHECK_ERR_GOTO(!mem, LOGMEM(ctx), error);
+        tmpl->steps = mem;
+        step = &tmpl->steps[tmpl->step_count++];
+        memset(step, 0, sizeof *step);
+        step->schema = schild;
+        step->hash = lyd_node_lookup_hash(schild);
+        if (schild->nodetype == LYS_LIST) {
+            for (k = 0; k < slist->keys_size; ++k) {
+                if (lyd_path_tmpl_need_canon((struct lys_node *)slist->keys[k])) {
+                    step->canonize |= 1 << k;
+                }
+            }
+        } else if ((schild->nodetype & (LYS_LEAF | LYS_LEAFLIST)) && lyd_path_tmpl_need_canon(schild)) {
+            step->canonize = 1;
         }
 
-        /* continue */
-        parent = iter;
-        index--;
-    }
+        /* predicates, list keys must be in the schema order */
+        while (has_predicate) {
+            if ((r = lyd_path_tmpl_predicate(id, &name, &nam_len, &value, &val_len, &has_predicate)) < 1) {
+                LOGVAL(ctx, LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, id[-r], &id[-r]);
+                goto error;
+            }
+            id += r;
 
-    ly_set_free(spath);
+            k = step->val_count;
+            if ((schild->nodetype & (LYS_LEAF | LYS_LEAFLIST)) && !k && (name[0] == '.')) {
+                key = schild;
+            } else if ((schild->nodetype == LYS_LIST) && (k < slist->keys_size)
+                    && !strncmp(slist->keys[k]->name, name, nam_len) && !slist->keys[k]->name[nam_len]) {
+                key = (struct lys_node *)slist->keys[k];
+            } else {
+                LOGVAL(ctx, LYE_PATH_INKEY, LY_VLOG_NONE, NULL, name);
+                goto error;
+            }
 
-    return dummy;
+            if (value) {
+                /* the value is resolved right away */
+                str = lyd_make_canonical(key, value, val_len);
+                if (!str) {
+                    goto error;
+                }
+                step->vals[k] = lydict_insert_zc(ctx, str);
+            } else {
+                ++tmpl->placeholder_count;
+            }
+            ++step->val_count;
+        }
+        if ((schild->nodetype == LYS_LIST) && (step->val_count < slist->keys_size)) {
+            LOGVAL(ctx, LYE_PATH_MISSKEY, LY_VLOG_NONE, NULL, slist->keys[step->val_count]->name);
+            goto error;
+        }
+
+        sparent = schild;
+        prev_mod = lys_node_module(schild);
+    } while (id[0]);
+
+    return tmpl;
 
 error:
-    ly_set_free(spath);
-    lyd_free(dummy);
+    lyd_path_tmpl_free(tmpl);
     return NULL;
 }
 
-static struct lys_node *
-lys_get_schema_inctx(struct lys_node *schema, struct ly_ctx *ctx)
+API unsigned int
+lyd_path_tmpl_placeholder_count(const struct lyd_path_tmpl *tmpl)
 {
-    const struct lys_module *mod, *trg_mod = NULL;
-    struct lys_node *parent, *first_sibling = NULL, *iter = NULL;
-    struct ly_set *parents;
-    unsigned int index;
-    uint32_t idx;
-    void **ptr;
+    FUN_IN;
 
-    if (!ctx || schema->module->ctx == ctx) {
-        /* we have the same context */
-        return schema;
+    if (!tmpl) {
+        LOGARG;
+        return 0;
     }
 
-    /* store the parents chain */
-    parents = ly_set_new();
-    for (parent = schema; parent; parent = lys_parent(parent)) {
-        /* note - augments are skipped so we will work only with the implemented modules
-         * (where the augments are applied) */
-        if (parent->nodetype != LYS_USES) {
-            ly_set_add(parents, parent, LY_SET_OPT_USEASLIST);
-        }
-    }
-    assert(parents->number);
-    index = parents->number - 1;
+    return tmpl->placeholder_count;
+}
 
-    /* process the parents from the top level */
-    /* for the top-level node, we have to locate the module first */
-    parent = parents->set.s[index];
-    if (parent->nodetype == LYS_EXT) {
-        ptr = lys_ext_complex_get_substmt(LY_STMT_NODE, (struct lys_ext_instance_complex *)parent, NULL);
-        if (!ptr) {
-            ly_set_free(parents);
-            return NULL;
-        }
-        first_sibling = *(struct lys_node **)ptr;
-        parent = parents->set.s[--index];
+/**
+ * @brief Get a canonical value for a data path template step.
+ *
+ * @param[in] schema Leaf or leaf-list with the value.
+ * @param[in] value Value to use.
+ * @param[in] canonize Whether \p value may not be canonical.
+ * @param[out] dyn Set to the canonical value if it was created.
+ * @return Canonical value, NULL on error.
+ */
+static const char *
+lyd_path_tmpl_value(const struct lys_node *schema, const char *value, int canonize, char **dyn)
+{
+    if (!value) {
+        LOGARG;
+        return NULL;
     }
-    idx = 0;
-    while ((mod = ly_ctx_get_module_iter(ctx, &idx))) {
-        trg_mod = lys_node_module(parent);
-        /* check module name */
-        if (strcmp(mod->name, trg_mod->name)) {
-            continue;
-        }
 
-        /* check revision */
-        if ((!mod->rev_size && !trg_mod->rev_size) ||
-                (mod->rev_size && trg_mod->rev_size && !strcmp(mod->rev[0].date, trg_mod->rev[0].date))) {
-            /* we have match */
-            break;
-        }
-    }
-    /* try data callback */
-    if (!mod && trg_mod && ctx->data_clb) {
-        LOGDBG(LY_LDGYANG, "Attempting to load '%s' into context using callback ...", trg_mod->name);
-        mod = ctx->data_clb(ctx, trg_mod->name, NULL, 0, ctx->data_clb_data);
+    if (canonize) {
+        *dyn = lyd_make_canonical(schema, value, strlen(value));
+        return *dyn;
     }
-    if (!mod) {
-        ly_set_free(parents);
+    return value;
+}
+
+API struct lyd_node *
+lyd_path_tmpl_new(struct lyd_node *data_tree, const struct lyd_path_tmpl *tmpl, const char **values, const char *value,
+                  int options)
+{
+    FUN_IN;
+
+    const struct lyd_path_tmpl_step *step;
+    const struct lys_node *sparent, *key;
+    struct lyd_node *ret = NULL, *node = NULL, *parent = NULL, *siblings = NULL;
+    struct lyd_node_lookup lookup;
+    char *dyn[LYD_LOOKUP_MAX_VALS];
+    const char *val;
+    int dflt = (options & LYD_PATH_OPT_DFLT) ? 1 : 0;
+    uint16_t i, p = 0;
+    uint8_t k;
+
+    if (!tmpl || (tmpl->placeholder_count && !values) || (data_tree && (lyd_node_module(data_tree)->ctx != tmpl->ctx))) {
+        LOGARG;
         return NULL;
     }
-    if (!first_sibling) {
-        first_sibling = mod->data;
+    memset(dyn, 0, sizeof dyn);
+
+    if (data_tree) {
+        for (; data_tree->parent; data_tree = data_tree->parent);
+        siblings = lyd_first_sibling(data_tree);
     }
 
-    /* now search in the schema tree for the matching node */
-    while (1) {
-        lys_get_sibling(first_sibling, trg_mod->name, 0, parent->name, 0, parent->nodetype,
-                        (const struct lys_node **)&iter);
-        if (!iter) {
-            /* not found, iter will be used as NULL result */
-            break;
+    for (i = 0; i < tmpl->step_count; ++i) {
+        step = &tmpl->steps[i];
+
+        /* fill the values */
+        lookup.schema = step->schema;
+        lookup.val_count = step->val_count;
+        for (k = 0; k < step->val_count; ++k) {
+            if (step->vals[k]) {
+                lookup.vals[k] = step->vals[k];
+                continue;
+            }
+
+            key = (step->schema->nodetype == LYS_LIST) ? (struct lys_node *)((struct lys_node_list *)step->schema)->keys[k]
+                    : step->schema;
+            lookup.vals[k] = lyd_path_tmpl_value(key, values[p++], step->canonize & (1 << k), &dyn[k]);
+            if (!lookup.vals[k]) {
+                goto error;
+            }
+        }
+        if ((step->schema->nodetype == LYS_LEAFLIST) && !step->val_count) {
+            /* the value is the same as in a predicate */
+            lookup.vals[0] = lyd_path_tmpl_value(step->schema, value ? value : "", step->canonize, &dyn[0]);
+            if (!lookup.vals[0]) {
+                goto error;
+            }
+            lookup.val_count = 1;
+        }
+        val = lookup.val_count ? lookup.vals[0] : value;
+        if (step->schema->nodetype == LYS_LEAF) {
+            /* leaf values are not used for matching */
+            lookup.val_count = 0;
         }
 
-        if (index == 0) {
-            /* we are done, iter is the result */
+        /* existing node, there cannot be any once a node was created, the same instances as in lyd_new_path() */
+        node = NULL;
+        if (!ret && ((step->schema->nodetype != LYS_LIST) || ((struct lys_node_list *)step->schema)->keys_size)
+                && ((step->schema->nodetype != LYS_LEAFLIST) || (step->schema->flags & LYS_CONFIG_W))) {
+            node = lyd_node_lookup_first(siblings, &lookup, step->hash);
+        }
+
+        if (node && (i == tmpl->step_count - 1)) {
+            /* the node exists, are we supposed to update it or is it default? */
+            if (!(options & LYD_PATH_OPT_UPDATE) && (!node->dflt || (options & LYD_PATH_OPT_DFLT))) {
+                LOGVAL(tmpl->ctx, LYE_PATH_EXISTS, LY_VLOG_STR, tmpl->path);
+                goto error;
+            }
+
+            /* no change, the default node already exists */
+            if (node->dflt && (options & LYD_PATH_OPT_DFLT)) {
+                node = NULL;
+            } else {
+                node = lyd_new_path_update(node, (void *)val, LYD_ANYDATA_CONSTSTRING, dflt);
+            }
+            ret = node;
             break;
-        } else {
-            /* we are going to continue, so update variables for the next loop */
-            first_sibling = iter->child;
-            parent = parents->set.s[--index];
-            iter = NULL;
+        } else if (!node) {
+            /* create the node */
+            switch (step->schema->nodetype) {
+            case LYS_LEAF:
+            case LYS_LEAFLIST:
+                node = _lyd_new_leaf(parent, step->schema, val, dflt, options & LYD_PATH_OPT_EDIT);
+                break;
+            default:
+                if (options & LYD_PATH_OPT_NOPARENT) {
+                    /* these were supposed to exist */
+                    LOGVAL(tmpl->ctx, LYE_PATH_MISSPAR, LY_VLOG_STR, tmpl->path);
+                    goto error;
+                }
+                node = _lyd_new(parent, step->schema, dflt);
+                break;
+            }
+            if (!node) {
+                LOGVAL(tmpl->ctx, LYE_SPEC, LY_VLOG_STR, tmpl->path, "Failed to create node \"%s\".", step->schema->name);
+                goto error;
+            }
+
+            if (!ret) {
+                /* special case when we are creating a sibling of a top-level data node */
+                if (!parent && data_tree) {
+                    for (; data_tree->next; data_tree = data_tree->next);
+                    if (lyd_insert_after(data_tree, node)) {
+                        lyd_free(node);
+                        goto error;
+                    }
+                }
+
+                /* sort if needed, but only when inserted somewhere */
+                for (sparent = lys_parent(node->schema);
+                        sparent && !(sparent->nodetype & (LYS_INPUT | LYS_OUTPUT));
+                        sparent = lys_parent(sparent));
+                if (sparent && lyd_schema_sort(node, 0)) {
+                    lyd_free(node);
+                    goto error;
+                }
+
+                /* first created node */
+                ret = node;
+            }
+
+            if (step->schema->nodetype == LYS_LIST) {
+                for (k = 0; k < step->val_count; ++k) {
+                    if (!_lyd_new_leaf(node, (struct lys_node *)((struct lys_node_list *)step->schema)->keys[k],
+                                       lookup.vals[k], 0, 0)) {
+                        goto error;
+                    }
+                }
+            }
         }
-    }
 
-    ly_set_free(parents);
-    return iter;
-}
+        for (k = 0; k < LYD_LOOKUP_MAX_VALS; ++k) {
+            free(dyn[k]);
+            dyn[k] = NULL;
+        }
+        parent = node;
+        siblings = node->child;
+    }
 
-static struct lys_node *
-lyd_get_schema_inctx(const struct lyd_node *node, struct ly_ctx *ctx)
-{
-    assert(node);
+    for (k = 0; k < LYD_LOOKUP_MAX_VALS; ++k) {
+        free(dyn[k]);
+    }
+    if (ret && (options & LYD_PATH_OPT_NOPARENTRET)) {
+        /* last created node */
+        return node;
+    }
+    return ret;
 
-    return lys_get_schema_inctx(node->schema, ctx);
+error:
+    for (k = 0; k < LYD_LOOKUP_MAX_VALS; ++k) {
+        free(dyn[k]);
+    }
+    lyd_free(ret);
+    return NULL;
 }
 
-/* both target and source were validated */
-static void
-lyd_merge_node_update(struct lyd_node *target, struct lyd_node *source, int options)
+API void
+lyd_path_tmpl_free(struct lyd_path_tmpl *tmpl)
 {
-    struct ly_ctx *ctx;
-    struct lyd_node_leaf_list *trg_leaf, *src_leaf;
-    struct lyd_node_anydata *trg_any, *src_any;
-    int len;
+    FUN_IN;
 
-    assert(target->schema->nodetype & (LYS_LEAF | LYS_ANYDATA));
-    ctx = target->schema->module->ctx;
+    uint16_t i;
+    uint8_t k;
 
-    if (source->dflt && (options & LYD_OPT_EXPLICIT)) {
-        /* keep the target node whatever it is */
+    if (!tmpl) {
         return;
     }
 
-    if (ctx == source->schema->module->ctx) {
-        /* source and targets are in the same context */
-        if (target->schema->nodetype == LYS_LEAF) {
-            trg_leaf = (struct lyd_node_leaf_list *)target;
-            src_leaf = (struct lyd_node_leaf_list *)source;
+    for (i = 0; i < tmpl->step_count; ++i) {
+        for (k = 0; k < tmpl->steps[i].val_count; ++k) {
+            lydict_remove(tmpl->ctx, tmpl->steps[i].vals[k]);
+        }
+    }
+    free(tmpl->steps);
+    lydict_remove(tmpl->ctx, tmpl->path);
+    free(tmpl);
+}
 
-            lydict_remove(ctx, trg_leaf->value_str);
-            trg_leaf->value_str = lydict_insert(ctx, src_leaf->value_str, 0);
-            trg_leaf->value_type = src_leaf->value_type;
-            if (trg_leaf->value_type == LY_TYPE_LEAFREF) {
-                lyp_parse_value(&((struct lys_node_leaf *)trg_leaf->schema)->type, &trg_leaf->value_str,
-                                NULL, trg_leaf, NULL, NULL, 1, src_leaf->dflt);
-            } else {
-                lyd_free_value(trg_leaf->value, trg_leaf->value_type, trg_leaf->value_flags,
-                               &((struct lys_node_leaf *)trg_leaf->schema)->type, trg_leaf->value_str, NULL, NULL, NULL);
-                trg_leaf->value = src_leaf->value;
-                /* so that it is not freed */
-                src_leaf->value.uint64 = 0;
+#ifdef LY_ENABLED_CACHE
+
+/**
+ * @brief Record of an instance in a position index.
+ */
+struct lyd_pos_rec {
+    struct lyd_node *node;
+    struct lyd_pos_block *block;
+};
+
+static int
+lyd_pos_rec_equal(void *val1_p, void *val2_p, int UNUSED(mod), void *UNUSED(cb_data))
+{
+    return ((struct lyd_pos_rec *)val1_p)->node == ((struct lyd_pos_rec *)val2_p)->node;
+}
+
+static uint32_t
+lyd_pos_hash(const struct lyd_node *node)
+{
+    uint32_t hash;
+
+    hash = dict_hash_multi(0, (const char *)&node, sizeof node);
+    return dict_hash_multi(hash, NULL, sizeof node);
+}
+
+/**
+ * @brief Get the next instance of a schema node.
+ */
+static struct lyd_node *
+lyd_pos_next(struct lyd_node *node, const struct lys_node *schema)
+{
+    for (node = node->next; node && (node->schema != schema); node = node->next);
+    return node;
+}
+
+/**
+ * @brief Add a difference to the instance count of a block in the Fenwick tree.
+ */
+static void
+lyd_pos_tree_add(struct lyd_pos_idx *idx, uint32_t i, int32_t diff)
+{
+    for (++i; i <= idx->count; i += i & -i) {
+        idx->tree[i - 1] += diff;
+    }
+}
+
+/**
+ * @brief Get the number of instances in all the blocks before a block.
+ */
+static uint32_t
+lyd_pos_tree_prefix(const struct lyd_pos_idx *idx, uint32_t i)
+{
+    uint32_t sum = 0;
+
+    for (; i; i -= i & -i) {
+        sum += idx->tree[i - 1];
+    }
+    return sum;
+}
+
+/**
+ * @brief Renumber the blocks and rebuild the Fenwick tree after blocks were added or removed.
+ */
+static void
+lyd_pos_tree_build(struct lyd_pos_idx *idx)
+{
+    uint32_t i, j;
+
+    for (i = 0; i < idx->count; ++i) {
+        idx->blocks[i]->idx = i;
+        idx->tree[i] = idx->blocks[i]->count;
+    }
+    for (i = 1; i <= idx->count; ++i) {
+        j = i + (i & -i);
+        if (j <= idx->count) {
+            idx->tree[j - 1] += idx->tree[i - 1];
+        }
+    }
+}
+
+/**
+ * @brief Find the block with an instance on a position.
+ *
+ * @param[in] idx Position index.
+ * @param[in,out] pos Position of the instance, set to the position in the returned block.
+ * @return Block with the instance, NULL if there are less instances.
+ */
+static struct lyd_pos_block *
+lyd_pos_tree_search(const struct lyd_pos_idx *idx, uint32_t *pos)
+{
+    uint32_t i = 0, step;
+
+    for (step = 1; step <= idx->count / 2; step <<= 1);
+    for (; step; step >>= 1) {
+        if ((i + step <= idx->count) && (idx->tree[i + step - 1] < *pos)) {
+            i += step;
+            *pos -= idx->tree[i - 1];
+        }
+    }
+
+    return (i < idx->count) ? idx->blocks[i] : NULL;
+}
+
+static struct lyd_pos_idx *
+lyd_pos_idx_get(const struct lyd_node *parent, const struct lys_node *schema)
+{
+    struct lyd_pos_idx *idx;
+
+    for (idx = parent->pos_idx; idx && (idx->schema != schema); idx = idx->next);
+    return idx;
+}
+
+static struct lyd_pos_block *
+lyd_pos_idx_block(const struct lyd_pos_idx *idx, const struct lyd_node *node)
+{
+    struct lyd_pos_rec rec, *match;
+
+    rec.node = (struct lyd_node *)node;
+    if (lyht_find(idx->ht, &rec, lyd_pos_hash(node), (void **)&match)) {
+        return NULL;
+    }
+    return match->block;
+}
+
+/**
+ * @brief Make room for another block in a position index.
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int
+lyd_pos_idx_grow(struct lyd_pos_idx *idx)
+{
+    struct lyd_pos_block **blocks;
+    uint32_t *tree, size;
+
+    if (idx->count < idx->size) {
+        return 0;
+    }
+
+    size = idx->size ? idx->size * 2 : 8;
+    blocks = realloc(idx->blocks, size * sizeof *blocks);
+    if (!blocks) {
+        return -1;
+    }
+    idx->blocks = blocks;
+    tree = realloc(idx->tree, size * sizeof *tree);
+    if (!tree) {
+        return -1;
+    }
+    idx->tree = tree;
+    idx->size = size;
+
+    return 0;
+}
+
+/**
+ * @brief Free position indexes of a parent.
+ *
+ * @param[in] parent Parent with the indexes.
+ * @param[in] schema List or leaf-list of the index to free, NULL to free all the indexes.
+ */
+static void
+lyd_pos_idx_free(struct lyd_node *parent, const struct lys_node *schema)
+{
+    struct lyd_pos_idx *idx, **idx_p;
+    uint32_t i;
+
+    for (idx_p = &parent->pos_idx; *idx_p; ) {
+        idx = *idx_p;
+        if (schema && (idx->schema != schema)) {
+            idx_p = &idx->next;
+            continue;
+        }
+
+        *idx_p = idx->next;
+        for (i = 0; i < idx->count; ++i) {
+            free(idx->blocks[i]);
+        }
+        free(idx->blocks);
+        free(idx->tree);
+        lyht_free(idx->ht);
+        free(idx);
+    }
+}
+
+/**
+ * @brief Create a position index of all the instances of a list or leaf-list of a parent.
+ *
+ * @param[in] parent Parent of the instances.
+ * @param[in] schema List or leaf-list of the instances.
+ * @return Created index, NULL on error.
+ */
+static struct lyd_pos_idx *
+lyd_pos_idx_new(struct lyd_node *parent, const struct lys_node *schema)
+{
+    struct lyd_pos_idx *idx;
+    struct lyd_pos_block *block = NULL;
+    struct lyd_pos_rec rec;
+    struct lyd_node *iter;
+    uint32_t count = 0, size;
+
+    LY_TREE_FOR(parent->child, iter) {
+        if (iter->schema == schema) {
+            ++count;
+        }
+    }
+    if (!count) {
+        return NULL;
+    }
+
+    idx = calloc(1, sizeof *idx);
+    LY_CHECK_ERR_RETURN(!idx, LOGMEM(schema->module->ctx), NULL);
+    idx->schema = schema;
+    idx->next = parent->pos_idx;
+    parent->pos_idx = idx;
+
+    for (size = LYD_POS_IDX_MIN; size < count * 2; size <<= 1);
+    idx->ht = lyht_new(size, sizeof rec, lyd_pos_rec_equal, NULL, 1);
+    LY_CHECK_ERR_GOTO(!idx->ht, LOGMEM(schema->module->ctx), error);
+
+    LY_TREE_FOR(parent->child, iter) {
+        if (iter->schema != schema) {
+            continue;
+        }
+
+        if (!block || (block->count == LYD_POS_BLOCK_SIZE)) {
+            /* next block */
+            LY_CHECK_ERR_GOTO(lyd_pos_idx_grow(idx), LOGMEM(schema->module->ctx), error);
+            block = calloc(1, sizeof *block);
+            LY_CHECK_ERR_GOTO(!block, LOGMEM(schema->module->ctx), error);
+            block->first = iter;
+            idx->blocks[idx->count++] = block;
+        }
+
+        rec.node = iter;
+        rec.block = block;
+        LY_CHECK_ERR_GOTO(lyht_insert(idx->ht, &rec, lyd_pos_hash(iter), NULL) == -1, LOGMEM(schema->module->ctx), error);
+        ++block->count;
+    }
+    lyd_pos_tree_build(idx);
+
+    return idx;
+
+error:
+    lyd_pos_idx_free(parent, schema);
+    return NULL;
+}
+
+/**
+ * @brief Split a block of a position index into two.
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int
+lyd_pos_idx_split(struct lyd_pos_idx *idx, struct lyd_pos_block *block)
+{
+    struct lyd_pos_block *new;
+    struct lyd_pos_rec rec, *match;
+    struct lyd_node *iter;
+    uint32_t i;
+
+    if (lyd_pos_idx_grow(idx)) {
+        return -1;
+    }
+    new = calloc(1, sizeof *new);
+    if (!new) {
+        return -1;
+    }
+
+    /* the second half of the instances moves into the new block */
+    iter = block->first;
+    for (i = 0; i < block->count / 2; ++i) {
+        iter = lyd_pos_next(iter, idx->schema);
+    }
+    new->first = iter;
+    new->count = block->count - i;
+    block->count = i;
+    for (i = 0; i < new->count; ++i) {
+        rec.node = iter;
+        lyht_find(idx->ht, &rec, lyd_pos_hash(iter), (void **)&match);
+        match->block = new;
+        iter = lyd_pos_next(iter, idx->schema);
+    }
+
+    memmove(&idx->blocks[block->idx + 2], &idx->blocks[block->idx + 1],
+            (idx->count - block->idx - 1) * sizeof *idx->blocks);
+    idx->blocks[block->idx + 1] = new;
+    ++idx->count;
+    lyd_pos_tree_build(idx);
+
+    return 0;
+}
+
+/**
+ * @brief Add a newly linked node into the position index of its parent, if any.
+ *
+ * @param[in] node Inserted node.
+ */
+static void
+lyd_pos_idx_insert(struct lyd_node *node)
+{
+    struct lyd_pos_idx *idx;
+    struct lyd_pos_block *block;
+    struct lyd_pos_rec rec;
+    struct lyd_node *iter;
+
+    if (!node->parent || !(idx = lyd_pos_idx_get(node->parent, node->schema))) {
+        return;
+    }
+
+    /* find the previous instance, the last sibling cannot be one */
+    for (iter = node->prev; iter->next && (iter->schema != node->schema); iter = iter->prev);
+    if (iter->next) {
+        block = lyd_pos_idx_block(idx, iter);
+        assert(block);
+    } else {
+        /* the new first instance */
+        block = idx->blocks[0];
+        block->first = node;
+    }
+
+    rec.node = node;
+    rec.block = block;
+    if (lyht_insert(idx->ht, &rec, lyd_pos_hash(node), NULL) == -1) {
+        goto error;
+    }
+    ++block->count;
+    lyd_pos_tree_add(idx, block->idx, 1);
+
+    if ((block->count > 2 * LYD_POS_BLOCK_SIZE) && lyd_pos_idx_split(idx, block)) {
+        goto error;
+    }
+    return;
+
+error:
+    /* the index is only an optimization, drop it */
+    lyd_pos_idx_free(node->parent, node->schema);
+}
+
+/**
+ * @brief Remove a node from the position index of its parent, if any. Must be called
+ * while the node is still linked to its siblings.
+ *
+ * @param[in] node Node being unlinked.
+ */
+static void
+lyd_pos_idx_unlink(struct lyd_node *node)
+{
+    struct lyd_pos_idx *idx;
+    struct lyd_pos_block *block;
+    struct lyd_pos_rec rec;
+
+    if (!node->parent || !(idx = lyd_pos_idx_get(node->parent, node->schema))) {
+        return;
+    }
+
+    block = lyd_pos_idx_block(idx, node);
+    assert(block);
+    if ((block->count == 1) && (idx->count == 1)) {
+        /* the last instance */
+        lyd_pos_idx_free(node->parent, node->schema);
+        return;
+    }
+
+    rec.node = node;
+    lyht_remove(idx->ht, &rec, lyd_pos_hash(node));
+
+    if (block->count == 1) {
+        /* remove the empty block */
+        memmove(&idx->blocks[block->idx], &idx->blocks[block->idx + 1],
+                (idx->count - block->idx - 1) * sizeof *idx->blocks);
+        --idx->count;
+        free(block);
+        lyd_pos_tree_build(idx);
+        return;
+    }
+
+    if (block->first == node) {
+        block->first = lyd_pos_next(node, idx->schema);
+    }
+    --block->count;
+    lyd_pos_tree_add(idx, block->idx, -1);
+}
+
+/**
+ * @brief Create the position index of the instances of an inserted list or leaf-list instance, if there are
+ * many of them next to it. Only functions modifying the siblings create the indexes so that the queries
+ * never modify the tree.
+ *
+ * @param[in] node Inserted node.
+ */
+static void
+lyd_pos_idx_add(struct lyd_node *node)
+{
+    struct lyd_node *iter;
+    uint32_t count = 1;
+
+    if (!node->parent || !(node->schema->nodetype & (LYS_LIST | LYS_LEAFLIST))
+            || lyd_pos_idx_get(node->parent, node->schema)) {
+        return;
+    }
+
+    /* the instances are consecutive, count only the few adjacent ones */
+    for (iter = node->prev; iter->next && (iter->schema == node->schema) && (count < LYD_POS_IDX_MIN); iter = iter->prev) {
+        ++count;
+    }
+    for (iter = node->next; iter && (iter->schema == node->schema) && (count < LYD_POS_IDX_MIN); iter = iter->next) {
+        ++count;
+    }
+
+    if (count == LYD_POS_IDX_MIN) {
+        lyd_pos_idx_new(node->parent, node->schema);
+    }
+}
+
+void
+lyd_pos_idx_tree(struct lyd_node *root)
+{
+    struct lyd_node *top, *next, *elem, *iter;
+    uint32_t count;
+
+    LY_TREE_FOR(root, top) {
+        LY_TREE_DFS_BEGIN(top, next, elem) {
+            /* count the instances from the first one of every run */
+            if (elem->parent && (elem->schema->nodetype & (LYS_LIST | LYS_LEAFLIST))
+                    && (!elem->prev->next || (elem->prev->schema != elem->schema))) {
+                for (count = 1, iter = elem->next; iter && (iter->schema == elem->schema) && (count < LYD_POS_IDX_MIN);
+                        iter = iter->next) {
+                    ++count;
+                }
+                if ((count == LYD_POS_IDX_MIN) && !lyd_pos_idx_get(elem->parent, elem->schema)) {
+                    lyd_pos_idx_new(elem->parent, elem->schema);
+                }
+            }
+            LY_TREE_DFS_END(top, next, elem);
+        }
+    }
+}
+
+#endif
+
+API unsigned int
+lyd_list_pos(const struct lyd_node *node)
+{
+    FUN_IN;
+
+    unsigned int pos;
+    struct lys_node *schema;
+    const struct lyd_node *iter;
+#ifdef LY_ENABLED_CACHE
+    struct lyd_pos_idx *idx;
+    struct lyd_pos_block *block;
+#endif
+
+    if (!node || ((node->schema->nodetype != LYS_LIST) && (node->schema->nodetype != LYS_LEAFLIST))) {
+        return 0;
+    }
+
+#ifdef LY_ENABLED_CACHE
+    if (node->parent && (idx = lyd_pos_idx_get(node->parent, node->schema))) {
+        block = lyd_pos_idx_block(idx, node);
+        assert(block);
+        pos = lyd_pos_tree_prefix(idx, block->idx) + 1;
+        for (iter = block->first; iter != node; iter = lyd_pos_next((struct lyd_node *)iter, node->schema)) {
+            ++pos;
+        }
+        return pos;
+    }
+#endif
+
+    schema = node->schema;
+    pos = 0;
+    iter = node;
+    do {
+        if (iter->schema == schema) {
+            ++pos;
+        }
+        iter = iter->prev;
+    } while (iter->next);
+
+    return pos;
+}
+
+API struct lyd_node *
+lyd_list_nth(const struct lyd_node *siblings, const struct lys_node *schema, unsigned int pos)
+{
+    FUN_IN;
+
+    struct lyd_node *iter;
+    unsigned int i;
+#ifdef LY_ENABLED_CACHE
+    struct lyd_pos_idx *idx;
+    struct lyd_pos_block *block;
+    uint32_t block_pos;
+#endif
+
+    if (!schema || !(schema->nodetype & (LYS_LIST | LYS_LEAFLIST))) {
+        LOGARG;
+        return NULL;
+    }
+    if (!siblings || !pos) {
+        return NULL;
+    }
+
+#ifdef LY_ENABLED_CACHE
+    if (siblings->parent && (idx = lyd_pos_idx_get(siblings->parent, schema))) {
+        block_pos = pos;
+        block = lyd_pos_tree_search(idx, &block_pos);
+        if (!block) {
+            return NULL;
+        }
+        for (iter = block->first; --block_pos; iter = lyd_pos_next(iter, schema));
+        return iter;
+    }
+#endif
+
+    i = 0;
+    for (iter = lyd_first_sibling((struct lyd_node *)siblings); iter; iter = iter->next) {
+        if ((iter->schema == schema) && (++i == pos)) {
+            break;
+        }
+    }
+
+    return iter;
+}
+
+static struct lyd_node *
+lyd_new_dummy(struct lyd_node *root, struct lyd_node *parent, const struct lys_node *schema, const char *value, int dflt)
+{
+    unsigned int index;
+    struct ly_set *spath;
+    const struct lys_node *siter;
+    struct lyd_node *iter, *dummy = NULL;
+
+    assert(schema);
+    assert(schema->nodetype & (LYS_CONTAINER | LYS_LEAF | LYS_LIST | LYS_LEAFLIST | LYS_ANYDATA | LYS_NOTIF |
+                               LYS_RPC | LYS_ACTION));
+
+    spath = ly_set_new();
+    if (!spath) {
+        LOGMEM(schema->module->ctx);
+        return NULL;
+    }
+
+    if (!parent && root) {
+        /* find data root */
+        for (; root->parent; root = root->parent);   /* vertical move (up) */
+        for (; root->prev->next; root = root->prev); /* horizontal move (left) */
+    }
+
+    /* build schema path */
+    for (siter = schema; siter; siter = lys_parent(siter)) {
+        /* stop if we know some of the parents */
+        if (parent && parent->schema == siter) {
+            break;
+        }
+
+        if (siter->nodetype & (LYS_CONTAINER | LYS_LEAF | LYS_LIST | LYS_LEAFLIST | LYS_ANYDATA | LYS_NOTIF |
+                               LYS_RPC | LYS_ACTION)) {
+            /* we have a node that can appear in data tree */
+            ly_set_add(spath, (void*)siter, LY_SET_OPT_USEASLIST);
+        } /* else skip the rest node types */
+    }
+
+    assert(spath->number > 0);
+    index = spath->number;
+    if (!parent && !(spath->set.s[index - 1]->nodetype & LYS_LEAFLIST)) {
+        /* start by searching for the top-level parent */
+        LY_TREE_FOR(root, iter) {
+            if (iter->schema == spath->set.s[index - 1]) {
+                parent = iter;
+                index--;
+                break;
+            }
+        }
+    }
+
+    iter = parent;
+    while (iter && index && !(spath->set.s[index - 1]->nodetype & LYS_LEAFLIST)) {
+        /* search for closer parent on the path */
+        LY_TREE_FOR(parent->child, iter) {
+            if (iter->schema == spath->set.s[index - 1]) {
+                index--;
+                parent = iter;
+                break;
+            }
+        }
+    }
+    while (index) {
+        /* create the missing part of the path */
+        switch (spath->set.s[index - 1]->nodetype) {
+        case LYS_LEAF:
+        case LYS_LEAFLIST:
+            iter = _lyd_new_leaf(parent, spath->set.s[index - 1], value, dflt, 1);
+            break;
+        case LYS_CONTAINER:
+        case LYS_LIST:
+            iter = _lyd_new(parent, spath->set.s[index - 1], dflt);
+            break;
+        case LYS_ANYXML:
+        case LYS_ANYDATA:
+            iter = lyd_create_anydata(parent, spath->set.s[index - 1], "", LYD_ANYDATA_CONSTSTRING);
+            break;
+        default:
+            goto error;
+        }
+        if (!iter) {
+            LOGINT(schema->module->ctx);
+            goto error;
+        }
+
+        /* we say it is valid and it is dummy */
+        iter->validity = LYD_VAL_INUSE;
+
+        if (!dummy) {
+            dummy = iter;
+        }
+
+        /* continue */
+        parent = iter;
+        index--;
+    }
+
+    ly_set_free(spath);
+
+    return dummy;
+
+error:
+    ly_set_free(spath);
+    lyd_free(dummy);
+    return NULL;
+}
+
+static struct lys_node *
+lys_get_schema_inctx(struct lys_node *schema, struct ly_ctx *ctx)
+{
+    const struct lys_module *mod, *trg_mod = NULL;
+    struct lys_node *parent, *first_sibling = NULL, *iter = NULL;
+    struct ly_set *parents;
+    unsigned int index;
+    uint32_t idx;
+    void **ptr;
+
+    if (!ctx || schema->module->ctx == ctx) {
+        /* we have the same context */
+        return schema;
+    }
+
+    /* store the parents chain */
+    parents = ly_set_new();
+    for (parent = schema; parent; parent = lys_parent(parent)) {
+        /* note - augments are skipped so we will work only with the implemented modules
+         * (where the augments are applied) */
+        if (parent->nodetype != LYS_USES) {
+            ly_set_add(parents, parent, LY_SET_OPT_USEASLIST);
+        }
+    }
+    assert(parents->number);
+    index = parents->number - 1;
+
+    /* process the parents from the top level */
+    /* for the top-level node, we have to locate the module first */
+    parent = parents->set.s[index];
+    if (parent->nodetype == LYS_EXT) {
+        ptr = lys_ext_complex_get_substmt(LY_STMT_NODE, (struct lys_ext_instance_complex *)parent, NULL);
+        if (!ptr) {
+            ly_set_free(parents);
+            return NULL;
+        }
+        first_sibling = *(struct lys_node **)ptr;
+        parent = parents->set.s[--index];
+    }
+    idx = 0;
+    while ((mod = ly_ctx_get_module_iter(ctx, &idx))) {
+        trg_mod = lys_node_module(parent);
+        /* check module name */
+        if (strcmp(mod->name, trg_mod->name)) {
+            continue;
+        }
+
+        /* check revision */
+        if ((!mod->rev_size && !trg_mod->rev_size) ||
+                (mod->rev_size && trg_mod->rev_size && !strcmp(mod->rev[0].date, trg_mod->rev[0].date))) {
+            /* we have match */
+            break;
+        }
+    }
+    /* try data callback */
+    if (!mod && trg_mod && ctx->data_clb) {
+        LOGDBG(LY_LDGYANG, "Attempting to load '%s' into context using callback ...", trg_mod->name);
+        mod = ctx->data_clb(ctx, trg_mod->name, NULL, 0, ctx->data_clb_data);
+    }
+    if (!mod) {
+        ly_set_free(parents);
+        return NULL;
+    }
+    if (!first_sibling) {
+        first_sibling = mod->data;
+    }
+
+    /* now search in the schema tree for the matching node */
+    while (1) {
+        lys_get_sibling(first_sibling, trg_mod->name, 0, parent->name, 0, parent->nodetype,
+                        (const struct lys_node **)&iter);
+        if (!iter) {
+            /* not found, iter will be used as NULL result */
+            break;
+        }
+
+        if (index == 0) {
+            /* we are done, iter is the result */
+            break;
+        } else {
+            /* we are going to continue, so update variables for the next loop */
+            first_sibling = iter->child;
+            parent = parents->set.s[--index];
+            iter = NULL;
+        }
+    }
+
+    ly_set_free(parents);
+    return iter;
+}
+
+static struct lys_node *
+lyd_get_schema_inctx(const struct lyd_node *node, struct ly_ctx *ctx)
+{
+    assert(node);
+
+    return lys_get_schema_inctx(node->schema, ctx);
+}
+
+/* both target and source were validated */
+static void
+lyd_merge_node_update(struct lyd_node *target, struct lyd_node *source, int options)
+{
+    struct ly_ctx *ctx;
+    struct lyd_node_leaf_list *trg_leaf, *src_leaf;
+    struct lyd_node_anydata *trg_any, *src_any;
+    int len;
+
+    assert(target->schema->nodetype & (LYS_LEAF | LYS_ANYDATA));
+    ctx = target->schema->module->ctx;
+
+    if (source->dflt && (options & LYD_OPT_EXPLICIT)) {
+        /* keep the target node whatever it is */
+        return;
+    }
+
+#ifdef LY_ENABLED_CACHE
+    lyd_content_hash_invalidate(target);
+#endif
+    lyd_journal_change(target);
+
+    if (ctx == source->schema->module->ctx) {
+        /* source and targets are in the same context */
+        if (target->schema->nodetype == LYS_LEAF) {
+            trg_leaf = (struct lyd_node_leaf_list *)target;
+            src_leaf = (struct lyd_node_leaf_list *)source;
+
+            lydict_remove(ctx, trg_leaf->value_str);
+            trg_leaf->value_str = lydict_insert(ctx, src_leaf->value_str, 0);
+            trg_leaf->value_type = src_leaf->value_type;
+            if (trg_leaf->value_type == LY_TYPE_LEAFREF) {
+                lyp_parse_value(&((struct lys_node_leaf *)trg_leaf->schema)->type, &trg_leaf->value_str,
+                                NULL, trg_leaf, NULL, NULL, 1, src_leaf->dflt);
+            } else {
+                lyd_free_value(trg_leaf->value, trg_leaf->value_type, trg_leaf->value_flags,
+                               &((struct lys_node_leaf *)trg_leaf->schema)->type, trg_leaf->value_str, NULL, NULL, NULL);
+                trg_leaf->value = src_leaf->value;
+                /* so that it is not freed */
+                src_leaf->value.uint64 = 0;
             }
             trg_leaf->dflt = src_leaf->dflt;
         } else { /* ANYDATA */
@@ -2634,9 +4129,64 @@ lyd_merge_node_schema_equal(struct lyd_node *node1, struct lyd_node *node2)
     return 1;
 }
 
-/* return: 0 (not equal), 1 (equal), 2 (equal and state leaf-/list marked), -1 (error) */
 static int
-lyd_merge_node_equal(struct lyd_node *node1, struct lyd_node *node2)
+lyd_node_ptr_equal(void *val1_p, void *val2_p, int UNUSED(mod), void *UNUSED(cb_data))
+{
+    return *((struct lyd_node **)val1_p) == *((struct lyd_node **)val2_p);
+}
+
+static uint32_t
+lyd_node_ptr_hash(const struct lyd_node *node)
+{
+    uint32_t hash;
+
+    hash = dict_hash_multi(0, (const char *)&node, sizeof node);
+    return dict_hash_multi(hash, NULL, 0);
+}
+
+/**
+ * @brief Mark a data node as matched by the current operation. The marks are kept aside
+ * so that the data trees are never modified by read-only operations (and can be shared by threads).
+ *
+ * @param[in,out] marks Set of marked nodes, created on the first mark.
+ * @param[in] node Node to mark.
+ * @return 0 on success, -1 on error.
+ */
+static int
+lyd_mark_node(struct hash_table **marks, struct lyd_node *node)
+{
+    if (!*marks) {
+        *marks = lyht_new(8, sizeof node, lyd_node_ptr_equal, NULL, 1);
+        LY_CHECK_ERR_RETURN(!*marks, LOGMEM(node->schema->module->ctx), -1);
+    }
+
+    if (lyht_insert(*marks, &node, lyd_node_ptr_hash(node), NULL) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+static int
+lyd_node_is_marked(struct hash_table *marks, struct lyd_node *node)
+{
+    if (!marks) {
+        return 0;
+    }
+
+    return !lyht_find(marks, &node, lyd_node_ptr_hash(node), NULL);
+}
+
+static void
+lyd_unmark_node(struct hash_table *marks, struct lyd_node *node)
+{
+    if (marks) {
+        lyht_remove(marks, &node, lyd_node_ptr_hash(node));
+    }
+}
+
+/* return: 0 (not equal), 1 (equal), -1 (error) */
+static int
+lyd_merge_node_equal(struct lyd_node *node1, struct lyd_node *node2, struct hash_table **marks)
 {
     int ret;
 
@@ -2650,7 +4200,7 @@ lyd_merge_node_equal(struct lyd_node *node1, struct lyd_node *node2)
     case LYS_NOTIF:
         return 1;
     case LYS_LEAFLIST:
-        if (node1->validity & LYD_VAL_INUSE) {
+        if (lyd_node_is_marked(*marks, node1)) {
             /* this instance was already matched, we want to find another so that the number of the istances matches */
             assert(node1->schema->flags & LYS_CONFIG_R);
             return 0;
@@ -2659,12 +4209,13 @@ lyd_merge_node_equal(struct lyd_node *node1, struct lyd_node *node2)
         ret = lyd_list_equal(node1, node2, 1);
         if ((ret == 1) && (node1->schema->flags & LYS_CONFIG_R)) {
             /* mark it as matched */
-            node1->validity |= LYD_VAL_INUSE;
-            ret = 2;
+            if (lyd_mark_node(marks, node1)) {
+                return -1;
+            }
         }
         return ret;
     case LYS_LIST:
-        if (node1->validity & LYD_VAL_INUSE) {
+        if (lyd_node_is_marked(*marks, node1)) {
             /* this instance was already matched, we want to find another so that the number of the istances matches */
             assert(!((struct lys_node_list *)node1->schema)->keys_size);
             return 0;
@@ -2673,8 +4224,9 @@ lyd_merge_node_equal(struct lyd_node *node1, struct lyd_node *node2)
         ret = lyd_list_equal(node1, node2, 1);
         if ((ret == 1) && !((struct lys_node_list *)node1->schema)->keys_size) {
             /* mark it as matched */
-            node1->validity |= LYD_VAL_INUSE;
-            ret = 2;
+            if (lyd_mark_node(marks, node1)) {
+                return -1;
+            }
         }
         return ret;
     default:
@@ -2685,12 +4237,69 @@ lyd_merge_node_equal(struct lyd_node *node1, struct lyd_node *node2)
     return -1;
 }
 
+#ifdef LY_ENABLED_CACHE
+
+/**
+ * @brief Find the target sibling matching a source node in the hash table of the target siblings.
+ *
+ * @param[in] ht Hash table of the target siblings.
+ * @param[in] src Source node from the same context.
+ * @param[in,out] marks Set of already matched keyless state list and state leaf-list instances.
+ * @param[out] match Matching target sibling.
+ * @return 0 (not found), 1 (found), -1 (error)
+ */
+static int
+lyd_merge_node_find_hash(struct hash_table *ht, struct lyd_node *src, struct hash_table **marks, struct lyd_node **match)
+{
+    struct lyd_node *trg, **trg_p;
+
+    /* trees are supposed to be validated so all nodes must have their hash, but lets not be that strict */
+    if (!src->hash) {
+        lyd_hash(src);
+    }
+
+    *match = NULL;
+    if (lyht_find(ht, &src, src->hash, (void **)&trg_p)) {
+        return 0;
+    }
+    trg = *trg_p;
+
+    /* it is a bit more difficult with keyless state lists and leaf-lists */
+    if (((trg->schema->nodetype == LYS_LIST) && !((struct lys_node_list *)trg->schema)->keys_size)
+            || ((trg->schema->nodetype == LYS_LEAFLIST) && (trg->schema->flags & LYS_CONFIG_R))) {
+        assert(trg->schema->flags & LYS_CONFIG_R);
+
+        while (trg && lyd_node_is_marked(*marks, trg)) {
+            /* state lists, find one not-already-found */
+            if (lyht_find_next(ht, &trg, trg->hash, (void **)&trg_p)) {
+                trg = NULL;
+            } else {
+                trg = *trg_p;
+            }
+        }
+        if (!trg) {
+            /* actually, it was matched already and no other instance found, so now not a match */
+            return 0;
+        }
+
+        /* mark it as matched */
+        if (lyd_mark_node(marks, trg)) {
+            return -1;
+        }
+    }
+
+    *match = trg;
+    return 1;
+}
+
+#endif
+
 /* spends source */
 static int
-lyd_merge_parent_children(struct lyd_node *target, struct lyd_node *source, int options)
+lyd_merge_parent_children(struct lyd_node *target, struct lyd_node *source, int options, struct hash_table **marks)
 {
     struct lyd_node *trg_parent, *src, *src_backup, *src_elem, *src_elem_backup, *src_next, *trg_child, *trg_parent_backup;
-    int ret, clear_flag = 0;
+    int ret;
     struct ly_ctx *ctx = target->schema->module->ctx; /* shortcut */
 
     LY_TREE_FOR_SAFE(source, src_backup, src) {
@@ -2701,42 +4310,9 @@ lyd_merge_parent_children(struct lyd_node *target, struct lyd_node *source, int
             ret = 0;
 
 #ifdef LY_ENABLED_CACHE
-            struct lyd_node **trg_child_p;
-
-            /* trees are supposed to be validated so all nodes must have their hash, but lets not be that strict */
-            if (!src_elem->hash) {
-                lyd_hash(src_elem);
-            }
-
-            if (trg_parent->ht) {
-                trg_child = NULL;
-                if (!lyht_find(trg_parent->ht, &src_elem, src_elem->hash, (void **)&trg_child_p)) {
-                    trg_child = *trg_child_p;
-                    ret = 1;
-
-                    /* it is a bit more difficult with keyless state lists and leaf-lists */
-                    if (((trg_child->schema->nodetype == LYS_LIST) && !((struct lys_node_list *)trg_child->schema)->keys_size)
-                            || ((trg_child->schema->nodetype == LYS_LEAFLIST) && (trg_child->schema->flags & LYS_CONFIG_R))) {
-                        assert(trg_child->schema->flags & LYS_CONFIG_R);
-
-                        while (trg_child && (trg_child->validity & LYD_VAL_INUSE)) {
-                            /* state lists, find one not-already-found */
-                            if (lyht_find_next(trg_parent->ht, &trg_child, trg_child->hash, (void **)&trg_child_p)) {
-                                trg_child = NULL;
-                            } else {
-                                trg_child = *trg_child_p;
-                            }
-                        }
-                        if (trg_child) {
-                            /* mark it as matched */
-                            trg_child->validity |= LYD_VAL_INUSE;
-                            ret = 2;
-                        } else {
-                            /* actually, it was matched already and no other instance found, so now not a match */
-                            ret = 0;
-                        }
-                    }
-                }
+            /* the hash table compares schema nodes so it can be used only in the same context */
+            if (trg_parent->ht && (src_elem->schema->module->ctx == ctx)) {
+                ret = lyd_merge_node_find_hash(trg_parent->ht, src_elem, marks, &trg_child);
             } else
 #endif
             {
@@ -2744,7 +4320,7 @@ lyd_merge_parent_children(struct lyd_node *target, struct lyd_node *source, int
                     /* schema match, data match? */
                     ret = lyd_merge_node_schema_equal(trg_child, src_elem);
                     if (ret == 1) {
-                        ret = lyd_merge_node_equal(trg_child, src_elem);
+                        ret = lyd_merge_node_equal(trg_child, src_elem, marks);
                     }
                     if (ret != 0) {
                         /* even data match */
@@ -2756,8 +4332,6 @@ lyd_merge_parent_children(struct lyd_node *target, struct lyd_node *source, int
             if (ret > 0) {
                 if (trg_child->schema->nodetype & (LYS_LEAF | LYS_ANYDATA)) {
                     lyd_merge_node_update(trg_child, src_elem, options);
-                } else if (ret == 2) {
-                    clear_flag = 1;
                 }
             } else if (ret == -1) {
                 /* error */
@@ -2834,73 +4408,149 @@ src_insert:
     }
 
     lyd_free_withsiblings(source);
-    if (clear_flag) {
-        return 2;
+    return 0;
+}
+
+#ifdef LY_ENABLED_CACHE
+
+/**
+ * @brief Learn whether a top-level node can be stored in the hash table of its siblings.
+ */
+static int
+lyd_merge_node_hashable(struct lyd_node *node)
+{
+    if (node->schema->nodetype & (LYS_RPC | LYS_ACTION | LYS_NOTIF)) {
+        return 0;
+    }
+
+    /* lists without keys are not hashed */
+    return (node->schema->nodetype != LYS_LIST) || lyd_list_has_keys(node);
+}
+
+/**
+ * @brief Create a hash table of top-level siblings, the same one a parent has for its children.
+ *
+ * @param[in] first First sibling.
+ * @param[out] ht Created hash table, NULL if there are too few siblings.
+ * @return 0 on success, -1 on error.
+ */
+static int
+lyd_merge_siblings_hash(struct lyd_node *first, struct hash_table **ht)
+{
+    struct lyd_node *iter;
+    uint32_t count = 0, size;
+
+    *ht = NULL;
+    LY_TREE_FOR(first, iter) {
+        ++count;
+    }
+    if (count < LY_CACHE_HT_MIN_CHILDREN) {
+        return 0;
+    }
+
+    for (size = LY_CACHE_HT_MIN_CHILDREN; size < count; size <<= 1);
+    *ht = lyht_new(size, sizeof(struct lyd_node *), lyd_hash_table_val_equal, NULL, 1);
+    LY_CHECK_ERR_RETURN(!*ht, LOGMEM(first->schema->module->ctx), -1);
+
+    LY_TREE_FOR(first, iter) {
+        if (!lyd_merge_node_hashable(iter)) {
+            continue;
+        }
+
+        if (!iter->hash) {
+            lyd_hash(iter);
+        }
+        if (lyht_insert(*ht, &iter, iter->hash, NULL) == -1) {
+            lyht_free(*ht);
+            *ht = NULL;
+            return -1;
+        }
     }
+
     return 0;
 }
 
+#endif
+
 /* spends source */
 static int
-lyd_merge_siblings(struct lyd_node *target, struct lyd_node *source, int options)
+lyd_merge_siblings(struct lyd_node *target, struct lyd_node *source, int options, struct hash_table **marks)
 {
-    struct lyd_node *trg, *src, *src_backup, *ins;
-    int ret, clear_flag = 0;
+    struct lyd_node *trg, *src, *src_backup, *ins, *pending = NULL;
+    struct hash_table *ht = NULL;
+    int ret = 0;
     struct ly_ctx *ctx = target->schema->module->ctx; /* shortcut */
 
     while (target->prev->next) {
         target = target->prev;
     }
 
+#ifdef LY_ENABLED_CACHE
+    /* top-level siblings have no parent with their hash table, so create one for the merge */
+    if (lyd_merge_siblings_hash(target, &ht)) {
+        goto error;
+    }
+#endif
+
     LY_TREE_FOR_SAFE(source, src_backup, src) {
-        LY_TREE_FOR(target, trg) {
-            /* sibling found, merge it */
-            ret = lyd_merge_node_schema_equal(trg, src);
-            if (ret == 1) {
-                ret = lyd_merge_node_equal(trg, src);
-            }
-            if (ret > 0) {
-                if (ret == 2) {
-                    clear_flag = 1;
+#ifdef LY_ENABLED_CACHE
+        /* the hash table compares schema nodes so it can be used only in the same context */
+        if (ht && (src->schema->module->ctx == ctx) && lyd_merge_node_hashable(src)) {
+            ret = lyd_merge_node_find_hash(ht, src, marks, &trg);
+        } else
+#endif
+        {
+            LY_TREE_FOR(target, trg) {
+                ret = lyd_merge_node_schema_equal(trg, src);
+                if (ret == 1) {
+                    ret = lyd_merge_node_equal(trg, src, marks);
                 }
-
-                switch (trg->schema->nodetype) {
-                case LYS_LEAF:
-                case LYS_ANYXML:
-                case LYS_ANYDATA:
-                    lyd_merge_node_update(trg, src, options);
-                    break;
-                case LYS_LEAFLIST:
-                    /* it's already there, nothing to do */
+                if (ret != 0) {
                     break;
-                case LYS_LIST:
-                case LYS_CONTAINER:
-                case LYS_NOTIF:
-                case LYS_RPC:
-                case LYS_INPUT:
-                case LYS_OUTPUT:
-                    ret = lyd_merge_parent_children(trg, src->child, options);
-                    if (ret == 2) {
-                        clear_flag = 1;
-                    } else if (ret) {
-                        lyd_free_withsiblings(source);
-                        return 1;
+                }
+            }
+            if (!trg && !ret) {
+                LY_TREE_FOR(pending, trg) {
+                    ret = lyd_merge_node_schema_equal(trg, src);
+                    if (ret == 1) {
+                        ret = lyd_merge_node_equal(trg, src, marks);
+                    }
+                    if (ret != 0) {
+                        break;
                     }
-                    break;
-                default:
-                    LOGINT(ctx);
-                    lyd_free_withsiblings(source);
-                    return 1;
                 }
-                break;
-            } else if (ret == -1) {
-                lyd_free_withsiblings(source);
-                return 1;
-            } /* else not equal, nothing to do */
+            }
         }
 
-        /* sibling not found, insert it */
-        if (!trg) {
+        if (ret == -1) {
+            goto error;
+        } else if (ret > 0) {
+            /* sibling found, merge it */
+            switch (trg->schema->nodetype) {
+            case LYS_LEAF:
+            case LYS_ANYXML:
+            case LYS_ANYDATA:
+                lyd_merge_node_update(trg, src, options);
+                break;
+            case LYS_LEAFLIST:
+                /* it's already there, nothing to do */
+                break;
+            case LYS_LIST:
+            case LYS_CONTAINER:
+            case LYS_NOTIF:
+            case LYS_RPC:
+            case LYS_INPUT:
+            case LYS_OUTPUT:
+                if (lyd_merge_parent_children(trg, src->child, options, marks)) {
+                    goto error;
+                }
+                break;
+            default:
+                LOGINT(ctx);
+                goto error;
+            }
+        } else {
+            /* sibling not found, insert it */
             if (ctx != src->schema->module->ctx) {
                 ins = lyd_dup_to_ctx(src, 1, ctx);
             } else {
@@ -2911,15 +4561,44 @@ lyd_merge_siblings(struct lyd_node *target, struct lyd_node *source, int options
                 }
                 ins = src;
             }
-            lyd_insert_after(target->prev, ins);
+            if (!ins) {
+                goto error;
+            }
+
+            /* all the new siblings are inserted at once, finding the last sibling each time is not for free */
+            if (!pending) {
+                pending = ins;
+            } else {
+                ins->prev = pending->prev;
+                pending->prev->next = ins;
+                pending->prev = ins;
+            }
+
+#ifdef LY_ENABLED_CACHE
+            if (ht && lyd_merge_node_hashable(ins)) {
+                if (!ins->hash) {
+                    lyd_hash(ins);
+                }
+                if (lyht_insert(ht, &ins, ins->hash, NULL) == -1) {
+                    goto error;
+                }
+            }
+#endif
         }
     }
 
-    lyd_free_withsiblings(source);
-    if (clear_flag) {
-        return 2;
+    if (pending) {
+        lyd_insert_after(target->prev, pending);
     }
+    lyht_free(ht);
+    lyd_free_withsiblings(source);
     return 0;
+
+error:
+    lyd_free_withsiblings(pending);
+    lyht_free(ht);
+    lyd_free_withsiblings(source);
+    return 1;
 }
 
 API int
@@ -2932,6 +4611,7 @@ lyd_merge_to_ctx(struct lyd_node **trg, const struct lyd_node *src, int options,
     struct lys_node *src_snode, *sch = NULL;
     int i, src_depth, depth, first_iter, ret, dflt = 1;
     const struct lys_node *parent = NULL;
+    struct hash_table *marks = NULL;
 
     if (!trg || !(*trg) || !src) {
         LOGARG;
@@ -2966,9 +4646,10 @@ lyd_merge_to_ctx(struct lyd_node **trg, const struct lyd_node *src, int options,
                 goto error;
             }
             if (node) {
-                if (lyd_insert_after(node->prev, node2)) {
-                    goto error;
-                }
+                /* just append the duplicate, inserting it after the last sibling would look for the first one */
+                node2->prev = node->prev;
+                node->prev->next = node2;
+                node->prev = node2;
             } else {
                 node = node2;
             }
@@ -3109,10 +4790,10 @@ lyd_merge_to_ctx(struct lyd_node **trg, const struct lyd_node *src, int options,
                 goto error;
             }
             if (node) {
-                if (lyd_insert_after(node->prev, node2)) {
-                    lyd_free_withsiblings(node);
-                    goto error;
-                }
+                /* just append the duplicate, the same as above */
+                node2->prev = node->prev;
+                node->prev->next = node2;
+                node->prev = node2;
             } else {
                 node = node2;
             }
@@ -3138,21 +4819,17 @@ lyd_merge_to_ctx(struct lyd_node **trg, const struct lyd_node *src, int options,
 
     if (!first_iter) {
         /* !! src_merge start is a child(ren) of trg_merge_start */
-        ret = lyd_merge_parent_children(trg_merge_start, src_merge_start, options);
+        ret = lyd_merge_parent_children(trg_merge_start, src_merge_start, options, &marks);
     } else {
         /* !! src_merge start is a (top-level) sibling(s) of trg_merge_start */
-        ret = lyd_merge_siblings(trg_merge_start, src_merge_start, options);
+        ret = lyd_merge_siblings(trg_merge_start, src_merge_start, options, &marks);
     }
     /* it was freed whatever the return value */
     src_merge_start = NULL;
-    if (ret == 2) {
-        /* clear remporary LYD_VAL_INUSE validation flags */
-        LY_TREE_DFS_BEGIN(target, node2, node) {
-            node->validity &= ~LYD_VAL_INUSE;
-            LY_TREE_DFS_END(target, node2, node);
-        }
-        ret = 0;
-    } else if (ret) {
+    /* matched state leaf-/list instances */
+    lyht_free(marks);
+    marks = NULL;
+    if (ret) {
         goto error;
     }
 
@@ -3190,6 +4867,263 @@ lyd_merge(struct lyd_node *target, const struct lyd_node *source, int options)
     return lyd_merge_to_ctx(&target, source, options, target->schema->module->ctx);
 }
 
+/* FNV-1a */
+#define LYD_CONTENT_HASH_INIT 0xcbf29ce484222325ULL
+#define LYD_CONTENT_HASH_PRIME 0x100000001b3ULL
+
+static uint64_t
+lyd_content_hash_add(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *ptr = data;
+    size_t i;
+
+    for (i = 0; i < len; ++i) {
+        hash ^= ptr[i];
+        hash *= LYD_CONTENT_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+static uint64_t
+lyd_content_hash_child(uint64_t hash, uint64_t child_hash)
+{
+    int i;
+
+    for (i = 0; i < 8; ++i) {
+        hash ^= (child_hash >> (i * 8)) & 0xff;
+        hash *= LYD_CONTENT_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+static uint64_t
+lyd_content_hash(struct lyd_node *node)
+{
+    struct lyd_node_anydata *any;
+    struct lyd_node *iter;
+    const char *str;
+    char *mem = NULL;
+    uint64_t hash;
+    uint8_t dflt;
+    int len;
+
+#ifdef LY_ENABLED_CACHE
+    if (!(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) && node->content_hash) {
+        return node->content_hash;
+    }
+#endif
+
+    str = lyd_node_module(node)->name;
+    hash = lyd_content_hash_add(LYD_CONTENT_HASH_INIT, str, strlen(str) + 1);
+    hash = lyd_content_hash_add(hash, node->schema->name, strlen(node->schema->name) + 1);
+    dflt = node->dflt;
+    hash = lyd_content_hash_add(hash, &dflt, 1);
+
+    switch (node->schema->nodetype) {
+    case LYS_LEAF:
+    case LYS_LEAFLIST:
+        str = ((struct lyd_node_leaf_list *)node)->value_str;
+        if (str) {
+            hash = lyd_content_hash_add(hash, str, strlen(str));
+        }
+        break;
+    case LYS_ANYXML:
+    case LYS_ANYDATA:
+        any = (struct lyd_node_anydata *)node;
+        if (!any->value.str) {
+            break;
+        }
+        switch (any->value_type) {
+        case LYD_ANYDATA_CONSTSTRING:
+        case LYD_ANYDATA_SXML:
+        case LYD_ANYDATA_JSON:
+            hash = lyd_content_hash_add(hash, any->value.str, strlen(any->value.str));
+            break;
+        case LYD_ANYDATA_XML:
+            lyxml_print_mem(&mem, any->value.xml, LYXML_PRINT_SIBLINGS);
+            if (mem) {
+                hash = lyd_content_hash_add(hash, mem, strlen(mem));
+                free(mem);
+            }
+            break;
+        case LYD_ANYDATA_DATATREE:
+            LY_TREE_FOR(any->value.tree, iter) {
+                hash = lyd_content_hash_child(hash, lyd_content_hash(iter));
+            }
+            break;
+        case LYD_ANYDATA_LYB:
+            len = lyd_lyb_data_length(any->value.mem);
+            if (len > 0) {
+                hash = lyd_content_hash_add(hash, any->value.mem, len);
+            }
+            break;
+        case LYD_ANYDATA_STRING:
+        case LYD_ANYDATA_SXMLD:
+        case LYD_ANYDATA_JSOND:
+        case LYD_ANYDATA_LYBD:
+            /* dynamic strings are used only as input parameters */
+            assert(0);
+            break;
+        }
+        break;
+    default:
+        LY_TREE_FOR(node->child, iter) {
+            hash = lyd_content_hash_child(hash, lyd_content_hash(iter));
+        }
+        if (!hash) {
+            /* 0 means unknown hash */
+            hash = 1;
+        }
+#ifdef LY_ENABLED_CACHE
+        node->content_hash = hash;
+#endif
+        break;
+    }
+
+    return hash ? hash : 1;
+}
+
+static int lyd_content_equal_siblings(const struct lyd_node *first1, const struct lyd_node *first2);
+
+/**
+ * @brief Compare the serialized values of two anydata nodes, as they are hashed by lyd_content_hash().
+ *
+ * @param[in] any1 First anydata node.
+ * @param[in] any2 Second anydata node.
+ * @return 1 if the values are equal, 0 if not.
+ */
+static int
+lyd_content_equal_anydata(const struct lyd_node_anydata *any1, const struct lyd_node_anydata *any2)
+{
+    char *mem1 = NULL, *mem2 = NULL;
+    int len, ret;
+
+    if (!any1->value.str || !any2->value.str) {
+        return (!any1->value.str && !any2->value.str);
+    }
+
+    switch (any1->value_type) {
+    case LYD_ANYDATA_CONSTSTRING:
+    case LYD_ANYDATA_SXML:
+    case LYD_ANYDATA_JSON:
+        if ((any2->value_type != LYD_ANYDATA_CONSTSTRING) && (any2->value_type != LYD_ANYDATA_SXML)
+                && (any2->value_type != LYD_ANYDATA_JSON)) {
+            return 0;
+        }
+        return ly_strequal(any1->value.str, any2->value.str, 0);
+    case LYD_ANYDATA_XML:
+        if (any2->value_type != LYD_ANYDATA_XML) {
+            return 0;
+        }
+        lyxml_print_mem(&mem1, any1->value.xml, LYXML_PRINT_SIBLINGS);
+        lyxml_print_mem(&mem2, any2->value.xml, LYXML_PRINT_SIBLINGS);
+        ret = (mem1 && mem2) ? !strcmp(mem1, mem2) : (!mem1 && !mem2);
+        free(mem1);
+        free(mem2);
+        return ret;
+    case LYD_ANYDATA_DATATREE:
+        if (any2->value_type != LYD_ANYDATA_DATATREE) {
+            return 0;
+        }
+        return lyd_content_equal_siblings(any1->value.tree, any2->value.tree);
+    case LYD_ANYDATA_LYB:
+        if (any2->value_type != LYD_ANYDATA_LYB) {
+            return 0;
+        }
+        len = lyd_lyb_data_length(any1->value.mem);
+        return ((len == lyd_lyb_data_length(any2->value.mem)) && ((len < 1) || !memcmp(any1->value.mem, any2->value.mem, len)));
+    case LYD_ANYDATA_STRING:
+    case LYD_ANYDATA_SXMLD:
+    case LYD_ANYDATA_JSOND:
+    case LYD_ANYDATA_LYBD:
+        /* dynamic strings are used only as input parameters */
+        assert(0);
+        break;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Compare the content of two data subtrees, exactly what lyd_content_hash() covers. Used to confirm
+ * the equality of subtrees with the same hashes, the hashes may collide.
+ *
+ * @param[in] node1 Root of the first subtree.
+ * @param[in] node2 Root of the second subtree.
+ * @return 1 if the subtrees are equal, 0 if not.
+ */
+static int
+lyd_content_equal(const struct lyd_node *node1, const struct lyd_node *node2)
+{
+    const char *str1, *str2;
+
+    if (node1 == node2) {
+        return 1;
+    }
+
+    if ((node1->dflt != node2->dflt) || !ly_strequal(node1->schema->name, node2->schema->name, 0)
+            || !ly_strequal(lyd_node_module(node1)->name, lyd_node_module(node2)->name, 0)) {
+        return 0;
+    }
+
+    switch (node1->schema->nodetype) {
+    case LYS_LEAF:
+    case LYS_LEAFLIST:
+        str1 = ((struct lyd_node_leaf_list *)node1)->value_str;
+        str2 = ((struct lyd_node_leaf_list *)node2)->value_str;
+        /* no value is hashed the same as an empty value */
+        return ly_strequal(str1 ? str1 : "", str2 ? str2 : "", 0);
+    case LYS_ANYXML:
+    case LYS_ANYDATA:
+        return lyd_content_equal_anydata((struct lyd_node_anydata *)node1, (struct lyd_node_anydata *)node2);
+    default:
+        return lyd_content_equal_siblings(node1->child, node2->child);
+    }
+}
+
+static int
+lyd_content_equal_siblings(const struct lyd_node *first1, const struct lyd_node *first2)
+{
+    for (; first1 && first2; first1 = first1->next, first2 = first2->next) {
+        if (!lyd_content_equal(first1, first2)) {
+            return 0;
+        }
+    }
+
+    return (!first1 && !first2);
+}
+
+API uint64_t
+lyd_subtree_hash(const struct lyd_node *node)
+{
+    FUN_IN;
+
+    if (!node) {
+        return 0;
+    }
+
+    return lyd_content_hash((struct lyd_node *)node);
+}
+
+API int
+lyd_subtree_equal(const struct lyd_node *node1, const struct lyd_node *node2)
+{
+    FUN_IN;
+
+    if (!node1 || !node2) {
+        return (node1 == node2);
+    }
+
+    /* different hashes mean different subtrees, only the same hashes need to be confirmed */
+    if (lyd_content_hash((struct lyd_node *)node1) != lyd_content_hash((struct lyd_node *)node2)) {
+        return 0;
+    }
+
+    return lyd_content_equal(node1, node2);
+}
+
 API void
 lyd_free_diff(struct lyd_difflist *diff)
 {
@@ -3246,22 +5180,17 @@ lyd_difflist_add(struct lyd_difflist *diff, unsigned int *size, unsigned int ind
     return EXIT_SUCCESS;
 }
 
-struct diff_ordered_dist {
-    struct diff_ordered_dist *next;
-    int dist;
-};
 struct diff_ordered_item {
     struct lyd_node *first;
     struct lyd_node *second;
-    struct diff_ordered_dist *dist;
+    unsigned int pos;                /* position of first among the matched instances in the first tree */
+    int keep;                        /* whether the item is part of the longest kept (not moved) sequence */
 };
 struct diff_ordered {
     struct lys_node *schema;
     struct lyd_node *parent;
     unsigned int count;
-    struct diff_ordered_item *items; /* array */
-    struct diff_ordered_dist *dist;  /* linked list (1-way, ring) */
-    struct diff_ordered_dist *dist_last;  /* aux pointer for faster insertion sort */
+    struct diff_ordered_item *items; /* array, in the order of the second tree */
 };
 
 static int
@@ -3293,7 +5222,7 @@ diff_ordset_insert(struct lyd_node *node, struct ly_set *ordset)
 static void
 diff_ordset_free(struct ly_set *set)
 {
-    unsigned int i, j;
+    unsigned int i;
     struct diff_ordered *ord;
 
     if (!set) {
@@ -3302,9 +5231,6 @@ diff_ordset_free(struct ly_set *set)
 
     for (i = 0; i < set->number; i++) {
         ord = (struct diff_ordered *)set->set.g[i];
-        for (j = 0; j < ord->count; j++) {
-            free(ord->items[j].dist);
-        }
         free(ord->items);
         free(ord);
     }
@@ -3318,7 +5244,7 @@ diff_ordset_free(struct ly_set *set)
  *  1 - first and second not the same
  */
 static int
-lyd_diff_compare(struct lyd_node *first, struct lyd_node *second, int options)
+lyd_diff_compare(struct lyd_node *first, struct lyd_node *second, int options, struct hash_table *marks)
 {
     int rc;
 
@@ -3329,7 +5255,7 @@ lyd_diff_compare(struct lyd_node *first, struct lyd_node *second, int options)
     }
 
     if (first->schema->nodetype & (LYS_LEAFLIST | LYS_LIST)) {
-        if (first->validity & LYD_VAL_INUSE) {
+        if (lyd_node_is_marked(marks, first)) {
             /* this node was already matched, it cannot be matched twice (except for state leaf-/lists,
              * which we want to keep the count on this way) */
             return 1;
@@ -3354,7 +5280,7 @@ lyd_diff_compare(struct lyd_node *first, struct lyd_node *second, int options)
  */
 static int
 lyd_diff_match(struct lyd_node *first, struct lyd_node *second, struct lyd_difflist *diff, unsigned int *size,
-               unsigned int *i, struct ly_set *matchset, struct ly_set *ordset, int options)
+               unsigned int *i, struct ly_set *matchset, struct ly_set *ordset, int options, struct hash_table **marks)
 {
     switch (first->schema->nodetype) {
     case LYS_LEAFLIST:
@@ -3369,8 +5295,10 @@ lyd_diff_match(struct lyd_node *first, struct lyd_node *second, struct lyd_diffl
     case LYS_RPC:
     case LYS_ACTION:
     case LYS_NOTIF:
-        assert(!(second->validity & LYD_VAL_INUSE));
-        second->validity |= LYD_VAL_INUSE;
+        assert(!lyd_node_is_marked(*marks, second));
+        if (lyd_mark_node(marks, second)) {
+            return -1;
+        }
         /* remember the matching node in first for keeping correct pointer in first
          * for comparing when passing through the second tree in lyd_diff().
          * Duplicities are not allowed actually, but they cannot happen since single
@@ -3398,8 +5326,10 @@ lyd_diff_match(struct lyd_node *first, struct lyd_node *second, struct lyd_diffl
     }
 
     /* mark both that they have matching instance in the other tree */
-    assert(!(first->validity & LYD_VAL_INUSE));
-    first->validity |= LYD_VAL_INUSE;
+    assert(!lyd_node_is_marked(*marks, first));
+    if (lyd_mark_node(marks, first)) {
+        return -1;
+    }
 
     return 0;
 }
@@ -3442,84 +5372,149 @@ lyd_diff_equivnode(struct lyd_node *first, struct lyd_node *second)
     return 1;
 }
 
-static int
+static void
 lyd_diff_move_preprocess(struct diff_ordered *ordered, struct lyd_node *first, struct lyd_node *second)
 {
-    struct ly_ctx *ctx = first->schema->module->ctx;
-    struct lyd_node *iter;
-    unsigned int pos = 0;
-    int abs_dist;
-    struct diff_ordered_dist *dist_aux;
-    struct diff_ordered_dist *dist_iter, *dist_last;
-    char *str = NULL;
-
     /* ordered->count was zeroed and now it is incremented with each added
      * item's information, so it is actually position of the second node
      */
+    ordered->items[ordered->count].first = first;
+    ordered->items[ordered->count].second = second;
+    ordered->count++;
+}
+
+static int
+lyd_diff_ordered_item_equal(void *val1_p, void *val2_p, int UNUSED(mod), void *UNUSED(cb_data))
+{
+    return (*((struct diff_ordered_item **)val1_p))->first == (*((struct diff_ordered_item **)val2_p))->first;
+}
 
-    /* get the position of the first node */
-    for (iter = first->prev; iter->next; iter = iter->prev) {
-        if (!(iter->validity & LYD_VAL_INUSE)) {
-            /* skip deleted nodes */
+/**
+ * @brief Learn positions of the first tree instances of a user-ordered (leaf-)list. All the siblings are
+ * traversed just once, the matched instances are recognized using a temporary hash table.
+ *
+ * @param[in] ordered User-ordered instances with all the items preprocessed.
+ * @return 0 on success, -1 on error.
+ */
+static int
+lyd_diff_move_positions(struct diff_ordered *ordered)
+{
+    struct ly_ctx *ctx = ordered->schema->module->ctx;
+    struct hash_table *ht;
+    struct diff_ordered_item *item, key, **match_p;
+    struct lyd_node *iter;
+    unsigned int i, pos = 0;
+
+    ht = lyht_new(8, sizeof item, lyd_diff_ordered_item_equal, NULL, 1);
+    LY_CHECK_ERR_RETURN(!ht, LOGMEM(ctx), -1);
+
+    for (i = 0; i < ordered->count; i++) {
+        item = &ordered->items[i];
+        if (lyht_insert(ht, &item, lyd_node_ptr_hash(item->first), NULL) == -1) {
+            lyht_free(ht);
+            return -1;
+        }
+    }
+
+    item = &key;
+    for (iter = lyd_first_sibling(ordered->items[0].first); iter; iter = iter->next) {
+        if (iter->schema != ordered->schema) {
             continue;
         }
-        if (iter->schema == first->schema) {
-            pos++;
+
+        key.first = iter;
+        if (!lyht_find(ht, &item, lyd_node_ptr_hash(iter), (void **)&match_p)) {
+            (*match_p)->pos = pos++;
         }
     }
+    lyht_free(ht);
+
     if (pos != ordered->count) {
-        LOGDBG(LY_LDGDIFF, "detected moved element \"%s\" from %d to %d (distance %d)",
-               str = lyd_path(first), pos, ordered->count, ordered->count - pos);
-        free(str);
+        LOGINT(ctx);
+        return -1;
     }
+    return 0;
+}
 
-    /* store information, count distance */
-    ordered->items[pos].dist = dist_aux = calloc(1, sizeof *dist_aux);
-    LY_CHECK_ERR_RETURN(!dist_aux, LOGMEM(ctx), EXIT_FAILURE);
-    ordered->items[pos].dist->dist = ordered->count - pos;
-    abs_dist = abs(ordered->items[pos].dist->dist);
-    ordered->items[pos].first = first;
-    ordered->items[pos].second = second;
-    ordered->count++;
+/**
+ * @brief Get the moves of user-ordered (leaf-)list instances present in both trees.
+ *
+ * The longest sequence of instances with the same relative order in both trees is found (patience sorting,
+ * O(n log n)) and only all the other instances are moved, which is the minimal number of moves. The sequence
+ * starting in the second tree as early as possible is preferred. The moves are generated in the order
+ * of the second tree, so every instance is moved right after its (already correctly placed) predecessor.
+ *
+ * @param[in] ordered User-ordered instances with all the items preprocessed.
+ * @param[in] diff Diff to add the moves into.
+ * @param[in,out] size Allocated size of \p diff.
+ * @param[in,out] index Index of the next item in \p diff.
+ * @return 0 on success, -1 on error.
+ */
+static int
+lyd_diff_move_ordered(struct diff_ordered *ordered, struct lyd_difflist *diff, unsigned int *size, unsigned int *index)
+{
+    struct ly_ctx *ctx = ordered->schema->module->ctx;
+    struct diff_ordered_item *items = ordered->items;
+    unsigned int *tails, *prev, len = 0, lo, hi, mid, k;
+    char *str = NULL;
 
-    /* insert sort of distances, higher first */
-    for (dist_iter = ordered->dist, dist_last = NULL;
-            dist_iter;
-            dist_last = dist_iter, dist_iter = dist_iter->next) {
-        if (abs_dist >= abs(dist_iter->dist)) {
-            /* found correct place */
-            dist_aux->next = dist_iter;
-            if (dist_last) {
-                dist_last->next = dist_aux;
-            }
-            break;
-        } else if (dist_iter->next == ordered->dist) {
-            /* last item */
-            dist_aux->next = ordered->dist; /* ring list */
-            ordered->dist_last = dist_aux;
-            break;
-        }
+    if (ordered->count < 2) {
+        /* nothing to reorder */
+        return 0;
     }
-    if (dist_aux->next == ordered->dist) {
-        if (ordered->dist_last == dist_aux) {
-            /* last item */
-            if (!ordered->dist) {
-                /* the only item */
-                dist_aux->next = dist_aux;
-                ordered->dist = ordered->dist_last = dist_aux;
-            }
-        } else {
-            /* first item */
-            ordered->dist = dist_aux;
-            if (dist_aux->next) {
-                /* more than one item, update the last one's next */
-                ordered->dist_last->next = dist_aux;
+
+    if (lyd_diff_move_positions(ordered)) {
+        return -1;
+    }
+
+    tails = malloc(2 * ordered->count * sizeof *tails);
+    LY_CHECK_ERR_RETURN(!tails, LOGMEM(ctx), -1);
+    prev = tails + ordered->count;
+
+    /* longest decreasing sequence of the first tree positions when going from the end of the second tree,
+     * tails[l] is the (second tree) index of the item ending such a sequence of length l + 1 with the highest position */
+    for (k = ordered->count; k > 0; k--) {
+        lo = 0;
+        hi = len;
+        while (lo < hi) {
+            mid = (lo + hi) / 2;
+            if (items[tails[mid]].pos < items[k - 1].pos) {
+                hi = mid;
             } else {
-                /* the only item */
-                ordered->dist_last = dist_aux;
-                dist_aux->next = dist_aux; /* ring list */
+                lo = mid + 1;
             }
         }
+
+        prev[k - 1] = lo ? tails[lo - 1] : ordered->count;
+        tails[lo] = k - 1;
+        if (lo == len) {
+            ++len;
+        }
+    }
+
+    /* these items stay where they are */
+    for (k = tails[len - 1]; k < ordered->count; k = prev[k]) {
+        items[k].keep = 1;
+    }
+    free(tails);
+
+    if (len == ordered->count) {
+        /* the order has not changed */
+        return 0;
+    }
+
+    for (k = 0; k < ordered->count; k++) {
+        if (items[k].keep) {
+            continue;
+        }
+
+        LOGDBG(LY_LDGDIFF, "detected moved element \"%s\" from %u to %u", str = lyd_path(items[k].first), items[k].pos, k);
+        free(str);
+
+        /* store the transaction into the difflist */
+        if (lyd_difflist_add(diff, size, (*index)++, LYD_DIFF_MOVEDAFTER1, items[k].first, k ? items[k - 1].first : NULL)) {
+            return -1;
+        }
     }
 
     return 0;
@@ -3550,6 +5545,35 @@ lyd_diff_init_difflist(struct ly_ctx *ctx, unsigned int *size)
     return result;
 }
 
+/**
+ * @brief Check whether the children of matching inner nodes need not be compared because the subtree hashes
+ * cached in both nodes (see lyd_subtree_hash()) are the same and the subtrees really are equal. The hashes
+ * are never computed here so that the trees are not modified.
+ *
+ * @param[in] first Inner node from the first tree.
+ * @param[in] second Matching node from the second tree.
+ * @param[in,out] same Set of the first tree nodes with the same subtrees, \p first is added into it.
+ * @return 1 if the subtrees are the same, 0 if they may differ, -1 on error.
+ */
+static int
+lyd_diff_same_subtree(struct lyd_node *first, struct lyd_node *second, struct hash_table **same)
+{
+#ifdef LY_ENABLED_CACHE
+    if (first->content_hash && (first->content_hash == second->content_hash) && lyd_content_equal(first, second)) {
+        if (lyd_mark_node(same, first)) {
+            return -1;
+        }
+        return 1;
+    }
+#else
+    (void)first;
+    (void)second;
+    (void)same;
+#endif
+
+    return 0;
+}
+
 API struct lyd_difflist *
 lyd_diff(struct lyd_node *first, struct lyd_node *second, int options)
 {
@@ -3560,7 +5584,7 @@ lyd_diff(struct lyd_node *first, struct lyd_node *second, int options)
     struct lyd_node *elem1, *elem2, *iter, *aux, *parent = NULL, *next1, *next2;
     struct lyd_difflist *result, *result2 = NULL;
     void *new;
-    unsigned int size, size2, index = 0, index2 = 0, i, j, k;
+    unsigned int size, size2, index = 0, index2 = 0, i, j;
     struct matchlist_s {
         struct matchlist_s *prev;
         struct ly_set *match;
@@ -3568,8 +5592,7 @@ lyd_diff(struct lyd_node *first, struct lyd_node *second, int options)
     } *matchlist = NULL, *mlaux;
     struct ly_set *ordset = NULL;
     struct diff_ordered *ordered;
-    struct diff_ordered_dist *dist_aux, *dist_iter;
-    struct diff_ordered_item item_aux;
+    struct hash_table *marks = NULL, *same = NULL;
 
     if (!first) {
         /* all nodes in second were created,
@@ -3694,7 +5717,7 @@ lyd_diff(struct lyd_node *first, struct lyd_node *second, int options)
                      * so the nodes differs (first one is default node) */
                     iter = NULL;
                 }
-                while (iter && (iter->validity & LYD_VAL_INUSE)) {
+                while (iter && lyd_node_is_marked(marks, iter)) {
                     /* state lists, find one not-already-found */
                     assert((iter->schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) && (iter->schema->flags & LYS_CONFIG_R));
                     if (lyht_find_next(elem1->parent->ht, &iter, iter->hash, (void **)&iter_p)) {
@@ -3714,7 +5737,7 @@ lyd_diff(struct lyd_node *first, struct lyd_node *second, int options)
                 }
 
                 /* elem2 instance found */
-                rc = lyd_diff_compare(iter, elem2, options);
+                rc = lyd_diff_compare(iter, elem2, options, marks);
                 if (rc == -1) {
                     goto error;
                 } else if (rc == 0) {
@@ -3724,7 +5747,7 @@ lyd_diff(struct lyd_node *first, struct lyd_node *second, int options)
             }
         }
         /* we have a match */
-        if (iter && lyd_diff_match(iter, elem2, result, &size, &index, matchlist->match, ordset, options)) {
+        if (iter && lyd_diff_match(iter, elem2, result, &size, &index, matchlist->match, ordset, options, &marks)) {
             goto error;
         }
 
@@ -3778,7 +5801,6 @@ cmp_continue:
                 }
                 ordered->items = calloc(ordered->count, sizeof *ordered->items);
                 LY_CHECK_ERR_GOTO(!ordered->items, LOGMEM(ctx), error);
-                ordered->dist = NULL;
                 /* zero the count to be used as a node position in lyd_diff_move_preprocess() */
                 ordered->count = 0;
             }
@@ -3792,7 +5814,7 @@ cmp_continue:
 
             /* and then find the first child */
             LY_TREE_FOR(elem2, iter) {
-                if (!(iter->validity & LYD_VAL_INUSE)) {
+                if (!lyd_node_is_marked(marks, iter)) {
                     /* the iter is not present in both trees */
                     continue;
                 } else if (matchlist->i == matchlist->match->number) {
@@ -3810,7 +5832,7 @@ cmp_continue:
                     }
                 }
 
-                iter->validity &= ~LYD_VAL_INUSE;
+                lyd_unmark_node(marks, iter);
                 if ((iter->schema->nodetype & (LYS_LEAFLIST | LYS_LIST)) && (iter->schema->flags & LYS_USERORDERED)) {
                     for (j = ordset->number; j > 0; j--) {
                         ordered = (struct diff_ordered *)ordset->set.g[j - 1];
@@ -3834,6 +5856,14 @@ cmp_continue:
                         LOGINT(ctx);
                         goto error;
                     }
+                    rc = lyd_diff_same_subtree(matchlist->match->set.d[matchlist->i], iter, &same);
+                    if (rc == -1) {
+                        goto error;
+                    } else if (rc) {
+                        /* no differences in the children */
+                        matchlist->i++;
+                        continue;
+                    }
                     next1 = matchlist->match->set.d[matchlist->i]->child;
                     if (!next1) {
                         parent = matchlist->match->set.d[matchlist->i];
@@ -3872,7 +5902,7 @@ cmp_continue:
             /* try to go to a cousin - child of the next parent's sibling */
             mlaux = matchlist->prev;
             LY_TREE_FOR(elem2->parent->next, iter) {
-                if (!(iter->validity & LYD_VAL_INUSE)) {
+                if (!lyd_node_is_marked(marks, iter)) {
                     continue;
                 } else if (mlaux->i == mlaux->match->number) {
                     if (iter == elem2->parent->next) {
@@ -3889,7 +5919,7 @@ cmp_continue:
                     }
                 }
 
-                iter->validity &= ~LYD_VAL_INUSE;
+                lyd_unmark_node(marks, iter);
                 if ((iter->schema->nodetype & (LYS_LEAFLIST | LYS_LIST)) && (iter->schema->flags & LYS_USERORDERED)) {
                     for (j = ordset->number ; j > 0; j--) {
                         ordered = (struct diff_ordered *)ordset->set.g[j - 1];
@@ -3913,6 +5943,14 @@ cmp_continue:
                         LOGINT(ctx);
                         goto error;
                     }
+                    rc = lyd_diff_same_subtree(mlaux->match->set.d[mlaux->i], iter, &same);
+                    if (rc == -1) {
+                        goto error;
+                    } else if (rc) {
+                        /* no differences in the children */
+                        mlaux->i++;
+                        continue;
+                    }
                     next1 = mlaux->match->set.d[mlaux->i]->child;
                     if (!next1) {
                         parent = mlaux->match->set.d[mlaux->i];
@@ -3949,9 +5987,11 @@ cmp_continue:
     /* 2) deleted nodes */
     LY_TREE_DFS_BEGIN(first, next1, elem1) {
         /* search for elem1s deleted in the second */
-        if (elem1->validity & LYD_VAL_INUSE) {
-            /* erase temporary LYD_VAL_INUSE flag and continue into children */
-            elem1->validity &= ~LYD_VAL_INUSE;
+        if (lyd_node_is_marked(marks, elem1)) {
+            /* elem1 has a matching node in second, continue into children unless they are the same */
+            if (lyd_node_is_marked(same, elem1)) {
+                goto dfs_nextsibling;
+            }
         } else if (!elem1->dflt || (options & LYD_DIFFOPT_WITHDEFAULTS)) {
             /* elem1 has no matching node in second, add it into result */
             if (lyd_difflist_add(result, &size, index++, LYD_DIFF_DELETED, elem1, NULL)) {
@@ -3990,83 +6030,17 @@ dfs_nextsibling:
 
     /* 3) moved nodes (when user-ordered) */
     for (i = 0; i < ordset->number; i++) {
-        ordered = (struct diff_ordered *)ordset->set.g[i];
-        if (!ordered->dist->dist) {
-            /* the dist list is sorted here, but the biggest dist is 0,
-             * so nothing changed in order of these items between first
-             * and second. We can continue with another user-ordered list.
-             */
-            continue;
-        }
-
-        /* get needed movements
-         * - from the biggest distances try to apply node movements
-         * on first tree node until they will be ordered as in the
-         * second tree - i.e. until there will be no position difference
-         */
-
-        for (dist_iter = ordered->dist; ; dist_iter = dist_iter->next) {
-            /* dist list is sorted at the beginning, since applying a move causes
-             * just a small change in other distances, we assume that the biggest
-             * dist is the next one (note that dist list is implemented as ring
-             * list). This way we avoid sorting distances after each move. The loop
-             * stops when all distances are zero.
-             */
-            dist_aux = dist_iter;
-            while (!dist_iter->dist) {
-                /* no dist, so no move. Try another, but when
-                 * there is no dist at all, stop the loop
-                 */
-                dist_iter = dist_iter->next;
-                if (dist_iter == dist_aux) {
-                    /* all dist we zeroed */
-                    goto movedone;
-                }
-            }
-            /* something to move */
-
-            /* get the item to move */
-            for (k = 0; k < ordered->count; k++) {
-                if (ordered->items[k].dist == dist_iter) {
-                    break;
-                }
-            }
-
-            /* apply the move (distance) */
-            memcpy(&item_aux, &ordered->items[k], sizeof item_aux);
-            if (dist_iter->dist > 0) {
-                /* move to right (other move to left) */
-                while (dist_iter->dist) {
-                    memcpy(&ordered->items[k], &ordered->items[k + 1], sizeof *ordered->items);
-                    ordered->items[k].dist->dist++; /* update moved item distance */
-                    dist_iter->dist--;
-                    k++;
-                }
-            } else {
-                /* move to left (other move to right) */
-                while (dist_iter->dist) {
-                    memcpy(&ordered->items[k], &ordered->items[k - 1], sizeof *ordered->items);
-                    ordered->items[k].dist->dist--; /* update moved item distance */
-                    dist_iter->dist++;
-                    k--;
-                }
-            }
-            memcpy(&ordered->items[k], &item_aux, sizeof *ordered->items);
-
-            /* store the transaction into the difflist */
-            if (lyd_difflist_add(result, &size, index++, LYD_DIFF_MOVEDAFTER1, item_aux.first,
-                                 (k > 0) ? ordered->items[k - 1].first : NULL)) {
-                goto error;
-            }
-            continue;
-
-movedone:
-            break;
+        if (lyd_diff_move_ordered((struct diff_ordered *)ordset->set.g[i], result, &size, &index)) {
+            goto error;
         }
     }
 
     diff_ordset_free(ordset);
     ordset = NULL;
+    lyht_free(marks);
+    marks = NULL;
+    lyht_free(same);
+    same = NULL;
 
     if (index2) {
         /* append result2 with newly created
@@ -4105,6 +6079,8 @@ error:
 
     }
     diff_ordset_free(ordset);
+    lyht_free(marks);
+    lyht_free(same);
 
     lyd_free_diff(result);
     lyd_free_diff(result2);
@@ -4215,6 +6191,17 @@ lyd_replace(struct lyd_node *orig, struct lyd_node *repl)
         }
     }
 
+#ifdef LY_ENABLED_CACHE
+    /* the positions are not maintained for the replaced nodes */
+    if (orig->parent) {
+        lyd_pos_idx_free(orig->parent, orig->schema);
+        for (iter = repl; iter; iter = iter->next) {
+            lyd_pos_idx_free(orig->parent, iter->schema);
+        }
+        lyd_content_hash_invalidate(orig->parent);
+    }
+#endif
+
     /* parent */
     if (orig->parent && (orig->parent->child == orig)) {
         orig->parent->child = repl;
@@ -4472,11 +6459,16 @@ lyd_insert_common(struct lyd_node *parent, struct lyd_node **sibling, struct lyd
 
 #ifdef LY_ENABLED_CACHE
         lyd_insert_hash(ins);
+        lyd_pos_idx_insert(ins);
+        lyd_pos_idx_add(ins);
 #endif
 
         if (invalid) {
             lyd_insert_setinvalid(ins);
         }
+        if (invalidate) {
+            lyd_journal_insert(ins, !invalid);
+        }
     }
     ly_set_free(llists);
 
@@ -4660,1266 +6652,2157 @@ lyd_insert_nextto(struct lyd_node *sibling, struct lyd_node *node, int before, i
                 }
             }
 
-            ins->parent = sibling->parent;
-            last = ins;
-        }
-    }
+            ins->parent = sibling->parent;
+            last = ins;
+        }
+    }
+
+    /* insert the (list of) node(s) to the specified position */
+    if (before) {
+        if (sibling->prev->next) {
+            /* adding into the middle */
+            sibling->prev->next = node;
+        } else if (sibling->parent) {
+            /* at the beginning */
+            sibling->parent->child = node;
+        }
+        node->prev = sibling->prev;
+        sibling->prev = last;
+        last->next = sibling;
+    } else { /* after */
+        if (sibling->next) {
+            /* adding into the middle - fix the prev pointer of the node after inserted nodes */
+            last->next = sibling->next;
+            sibling->next->prev = last;
+        } else {
+            /* at the end - fix the prev pointer of the first node */
+            start->prev = last;
+        }
+        sibling->next = node;
+        node->prev = sibling;
+    }
+
+#ifdef LY_ENABLED_CACHE
+    /* now that all the nodes are correctly inserted, fix hashes (node was already unlinked) */
+    lyd_insert_hash(node);
+
+    /* relink all following nodes */
+    iter = node;
+    for (iter = node; iter != last; iter = iter->next) {
+        lyd_unlink_hash(iter, iter->parent);
+        lyd_insert_hash(iter);
+    }
+
+    /* add all the inserted nodes into the position index, the positions of many instances are worth indexing */
+    for (iter = node; iter; iter = (iter == last) ? NULL : iter->next) {
+        lyd_pos_idx_insert(iter);
+    }
+    lyd_pos_idx_add(node);
+#endif
+
+    if (invalidate) {
+        /* temporarily unlinked nodes linked back are not changes */
+        for (iter = node; iter; iter = (iter == last) ? NULL : iter->next) {
+            lyd_journal_insert(iter, !invalid);
+        }
+    }
+
+    return EXIT_SUCCESS;
+
+error:
+    /* insert back to the original position */
+    if (orig_prev) {
+        lyd_insert_after(orig_prev, node);
+    } else if (orig_next) {
+        lyd_insert_before(orig_next, node);
+    } else if (orig_parent) {
+        /* there were no siblings */
+        orig_parent->child = node;
+        node->parent = orig_parent;
+    }
+    return EXIT_FAILURE;
+}
+
+API int
+lyd_insert_before(struct lyd_node *sibling, struct lyd_node *node)
+{
+    FUN_IN;
+
+    if (!node || !sibling) {
+        LOGARG;
+        return EXIT_FAILURE;
+    }
+
+    return lyd_insert_nextto(sibling, node, 1, 1);
+}
+
+API int
+lyd_insert_after(struct lyd_node *sibling, struct lyd_node *node)
+{
+    FUN_IN;
+
+    if (!node || !sibling) {
+        LOGARG;
+        return EXIT_FAILURE;
+    }
+
+    return lyd_insert_nextto(sibling, node, 0, 1);
+}
+
+static uint32_t
+lys_module_pos(struct lys_module *module)
+{
+    int i;
+    uint32_t pos = 1;
+
+    for (i = 0; i < module->ctx->models.used; ++i) {
+        if (module->ctx->models.list[i] == module) {
+            return pos;
+        }
+        ++pos;
+    }
+
+    LOGINT(module->ctx);
+    return 0;
+}
+
+static int
+lys_module_node_pos_r(struct lys_node *first_sibling, struct lys_node *target, uint32_t *pos)
+{
+    const struct lys_node *next = NULL;
+
+    /* the schema nodes are actually from data, lys_getnext skips non-data schema nodes for us (we know the parent will not be uses) */
+    while ((next = lys_getnext(next, lys_parent(first_sibling), lys_node_module(first_sibling), LYS_GETNEXT_NOSTATECHECK))) {
+        ++(*pos);
+        if (target == next) {
+            return 0;
+        }
+    }
+
+    LOGINT(first_sibling->module->ctx);
+    return 1;
+}
+
+static int
+lyd_node_pos_cmp(const void *item1, const void *item2)
+{
+    uint32_t mpos1, mpos2;
+    struct lyd_node_pos *np1, *np2;
+
+    np1 = (struct lyd_node_pos *)item1;
+    np2 = (struct lyd_node_pos *)item2;
+
+    /* different modules? */
+    if (lys_node_module(np1->node->schema) != lys_node_module(np2->node->schema)) {
+        mpos1 = lys_module_pos(lys_node_module(np1->node->schema));
+        mpos2 = lys_module_pos(lys_node_module(np2->node->schema));
+        /* if lys_module_pos failed, there is nothing we can do anyway,
+         * at least internal error will be printed */
+
+        if (mpos1 > mpos2) {
+            return 1;
+        } else {
+            return -1;
+        }
+    }
+
+    if (np1->pos > np2->pos) {
+        return 1;
+    } else if (np1->pos < np2->pos) {
+        return -1;
+    }
+    return 0;
+}
+
+API int
+lyd_schema_sort(struct lyd_node *sibling, int recursive)
+{
+    FUN_IN;
+
+    uint32_t len, i;
+    struct lyd_node *node;
+    struct lys_node *first_ssibling = NULL;
+    struct lyd_node_pos *array;
+
+    if (!sibling) {
+        LOGARG;
+        return -1;
+    }
+
+    /* something actually to sort */
+    if (sibling->prev != sibling) {
+
+        /* find the beginning */
+        sibling = lyd_first_sibling(sibling);
+
+        /* count siblings */
+        len = 0;
+        for (node = sibling; node; node = node->next) {
+            ++len;
+        }
+
+        array = malloc(len * sizeof *array);
+        LY_CHECK_ERR_RETURN(!array, LOGMEM(sibling->schema->module->ctx), -1);
+
+        /* fill arrays with positions and corresponding nodes */
+        for (i = 0, node = sibling; i < len; ++i, node = node->next) {
+            array[i].pos = 0;
+
+            /* we need to repeat this for every module */
+            if (!first_ssibling || (lyd_node_module(node) != lys_node_module(first_ssibling))) {
+                /* find the data node schema parent */
+                first_ssibling = node->schema;
+                while (lys_parent(first_ssibling)
+                        && (lys_parent(first_ssibling)->nodetype & (LYS_CHOICE | LYS_CASE | LYS_USES))) {
+                    first_ssibling = lys_parent(first_ssibling);
+                }
+
+                /* find the beginning */
+                if (lys_parent(first_ssibling)) {
+                    first_ssibling = lys_parent(first_ssibling)->child;
+                } else {
+                    while (first_ssibling->prev->next) {
+                        first_ssibling = first_ssibling->prev;
+                    }
+                }
+            }
+
+            if (lys_module_node_pos_r(first_ssibling, node->schema, &array[i].pos)) {
+                free(array);
+                return -1;
+            }
+
+            array[i].node = node;
+        }
+
+        /* sort the arrays */
+        qsort(array, len, sizeof *array, lyd_node_pos_cmp);
+
+        /* adjust siblings based on the sorted array */
+        for (i = 0; i < len; ++i) {
+            /* parent child */
+            if (i == 0) {
+                /* adjust sibling so that it still points to the beginning */
+                sibling = array[i].node;
+                if (array[i].node->parent) {
+                    array[i].node->parent->child = array[i].node;
+                }
+            }
+
+            /* prev */
+            if (i > 0) {
+                array[i].node->prev = array[i - 1].node;
+            } else {
+                array[i].node->prev = array[len - 1].node;
+            }
 
-    /* insert the (list of) node(s) to the specified position */
-    if (before) {
-        if (sibling->prev->next) {
-            /* adding into the middle */
-            sibling->prev->next = node;
-        } else if (sibling->parent) {
-            /* at the beginning */
-            sibling->parent->child = node;
-        }
-        node->prev = sibling->prev;
-        sibling->prev = last;
-        last->next = sibling;
-    } else { /* after */
-        if (sibling->next) {
-            /* adding into the middle - fix the prev pointer of the node after inserted nodes */
-            last->next = sibling->next;
-            sibling->next->prev = last;
-        } else {
-            /* at the end - fix the prev pointer of the first node */
-            start->prev = last;
+            /* next */
+            if (i < len - 1) {
+                array[i].node->next = array[i + 1].node;
+            } else {
+                array[i].node->next = NULL;
+            }
         }
-        sibling->next = node;
-        node->prev = sibling;
-    }
+        free(array);
 
 #ifdef LY_ENABLED_CACHE
-    /* now that all the nodes are correctly inserted, fix hashes (node was already unlinked) */
-    lyd_insert_hash(node);
+        /* the instances may have been reordered */
+        if (sibling->parent) {
+            lyd_pos_idx_free(sibling->parent, NULL);
+            lyd_content_hash_invalidate(sibling->parent);
+        }
+#endif
+    }
 
-    /* relink all following nodes */
-    iter = node;
-    for (iter = node; iter != last; iter = iter->next) {
-        lyd_unlink_hash(iter, iter->parent);
-        lyd_insert_hash(iter);
+    /* sort all the children recursively */
+    if (recursive) {
+        LY_TREE_FOR(sibling, node) {
+            if ((node->schema->nodetype & (LYS_CONTAINER | LYS_LIST | LYS_RPC | LYS_ACTION | LYS_NOTIF))
+                    && node->child && lyd_schema_sort(node->child, recursive)) {
+                return -1;
+            }
+        }
     }
-#endif
 
     return EXIT_SUCCESS;
-
-error:
-    /* insert back to the original position */
-    if (orig_prev) {
-        lyd_insert_after(orig_prev, node);
-    } else if (orig_next) {
-        lyd_insert_before(orig_next, node);
-    } else if (orig_parent) {
-        /* there were no siblings */
-        orig_parent->child = node;
-        node->parent = orig_parent;
-    }
-    return EXIT_FAILURE;
 }
 
-API int
-lyd_insert_before(struct lyd_node *sibling, struct lyd_node *node)
+static int
+_lyd_validate(struct lyd_node **node, struct lyd_node *data_tree, struct ly_ctx *ctx, const struct lys_module **modules,
+              int mod_count, struct lyd_difflist **diff, int options)
 {
-    FUN_IN;
+    struct lyd_node *root, *next1, *next2, *iter, *act_notif = NULL;
+    int ret = EXIT_FAILURE;
+    unsigned int i;
+    struct unres_data *unres = NULL;
+    const struct lys_module *yanglib_mod;
 
-    if (!node || !sibling) {
-        LOGARG;
-        return EXIT_FAILURE;
+    unres = calloc(1, sizeof *unres);
+    LY_CHECK_ERR_RETURN(!unres, LOGMEM(NULL), EXIT_FAILURE);
+
+    if (diff) {
+        unres->store_diff = 1;
+        unres->diff = lyd_diff_init_difflist(ctx, &unres->diff_size);
     }
 
-    return lyd_insert_nextto(sibling, node, 1, 1);
-}
+    if ((options & (LYD_OPT_RPC | LYD_OPT_RPCREPLY)) && *node && ((*node)->schema->nodetype != LYS_RPC)) {
+        options |= LYD_OPT_ACT_NOTIF;
+    }
+    if ((options & (LYD_OPT_NOTIF | LYD_OPT_NOTIF_FILTER)) && *node && ((*node)->schema->nodetype != LYS_NOTIF)) {
+        options |= LYD_OPT_ACT_NOTIF;
+    }
 
-API int
-lyd_insert_after(struct lyd_node *sibling, struct lyd_node *node)
-{
-    FUN_IN;
+    LY_TREE_FOR_SAFE(*node, next1, root) {
+        if (modules) {
+            for (i = 0; i < (unsigned)mod_count; ++i) {
+                if (lyd_node_module(root) == modules[i]) {
+                    break;
+                }
+            }
+            if (i == (unsigned)mod_count) {
+                /* skip data that should not be validated */
+                continue;
+            }
+        }
 
-    if (!node || !sibling) {
-        LOGARG;
-        return EXIT_FAILURE;
-    }
+        LY_TREE_DFS_BEGIN(root, next2, iter) {
+            if (iter->parent && (iter->schema->nodetype & (LYS_ACTION | LYS_NOTIF))) {
+                if (!(options & LYD_OPT_ACT_NOTIF) || act_notif) {
+                    LOGVAL(ctx, LYE_INELEM, LY_VLOG_LYD, iter, iter->schema->name);
+                    LOGVAL(ctx, LYE_SPEC, LY_VLOG_PREV, NULL, "Unexpected %s node \"%s\".",
+                           (options & LYD_OPT_RPC ? "action" : "notification"), iter->schema->name);
+                    goto cleanup;
+                }
+                act_notif = iter;
+            }
 
-    return lyd_insert_nextto(sibling, node, 0, 1);
-}
+            if (lyv_data_context(iter, options, unres) || lyv_data_content(iter, options, unres)) {
+                goto cleanup;
+            }
 
-static uint32_t
-lys_module_pos(struct lys_module *module)
-{
-    int i;
-    uint32_t pos = 1;
+            /* empty non-default, non-presence container without attributes, make it default */
+            if (!iter->dflt && (iter->schema->nodetype == LYS_CONTAINER) && !iter->child
+                        && !((struct lys_node_container *)iter->schema)->presence && !iter->attr) {
+                iter->dflt = 1;
+#ifdef LY_ENABLED_CACHE
+                lyd_content_hash_invalidate(iter);
+#endif
+            }
 
-    for (i = 0; i < module->ctx->models.used; ++i) {
-        if (module->ctx->models.list[i] == module) {
-            return pos;
+            LY_TREE_DFS_END(root, next2, iter);
         }
-        ++pos;
+
+        if (options & LYD_OPT_NOSIBLINGS) {
+            break;
+        }
+
     }
 
-    LOGINT(module->ctx);
-    return 0;
-}
+    if (options & LYD_OPT_ACT_NOTIF) {
+        if (!act_notif) {
+            LOGVAL(ctx, LYE_MISSELEM, LY_VLOG_LYD, *node, (options & LYD_OPT_RPC ? "action" : "notification"), (*node)->schema->name);
+            goto cleanup;
+        }
+        options &= ~LYD_OPT_ACT_NOTIF;
+    }
 
-static int
-lys_module_node_pos_r(struct lys_node *first_sibling, struct lys_node *target, uint32_t *pos)
-{
-    const struct lys_node *next = NULL;
+    if (*node) {
+        /* check for uniqueness of top-level lists/leaflists because
+         * only the inner instances were tested in lyv_data_content() */
+        yanglib_mod = ly_ctx_get_module(ctx ? ctx : (*node)->schema->module->ctx, "ietf-yang-library", NULL, 1);
+        LY_TREE_FOR(*node, root) {
+            if ((options & LYD_OPT_DATA_ADD_YANGLIB) && yanglib_mod && (root->schema->module == yanglib_mod)) {
+                /* ietf-yang-library data present, so ignore the option to add them */
+                options &= ~LYD_OPT_DATA_ADD_YANGLIB;
+            }
 
-    /* the schema nodes are actually from data, lys_getnext skips non-data schema nodes for us (we know the parent will not be uses) */
-    while ((next = lys_getnext(next, lys_parent(first_sibling), lys_node_module(first_sibling), LYS_GETNEXT_NOSTATECHECK))) {
-        ++(*pos);
-        if (target == next) {
-            return 0;
+            if (!(root->schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) || !(root->validity & LYD_VAL_DUP)) {
+                continue;
+            }
+
+            if (options & LYD_OPT_TRUSTED) {
+                /* just clear the flag */
+                root->validity &= ~LYD_VAL_DUP;
+                continue;
+            }
+
+            if (lyv_data_dup(root, *node)) {
+                goto cleanup;
+            }
         }
     }
 
-    LOGINT(first_sibling->module->ctx);
-    return 1;
-}
+    /* add missing ietf-yang-library if requested */
+    if (options & LYD_OPT_DATA_ADD_YANGLIB) {
+        if (!(*node)) {
+            (*node) = ly_ctx_info(ctx);
+        } else if (lyd_merge((*node), ly_ctx_info(ctx), LYD_OPT_DESTRUCT | LYD_OPT_EXPLICIT)) {
+            LOGERR(ctx, LY_EINT, "Adding ietf-yang-library data failed.");
+            goto cleanup;
+        }
+    }
 
-static int
-lyd_node_pos_cmp(const void *item1, const void *item2)
-{
-    uint32_t mpos1, mpos2;
-    struct lyd_node_pos *np1, *np2;
+    /* add default values, resolve unres and check for mandatory nodes in final tree */
+    if (lyd_defaults_add_unres(node, options, ctx, modules, mod_count, data_tree, act_notif, unres, 1)) {
+        goto cleanup;
+    }
+    if (act_notif) {
+        if (lyd_check_mandatory_tree(act_notif, ctx, modules, mod_count, options)) {
+            goto cleanup;
+        }
+    } else {
+        if (lyd_check_mandatory_tree(*node, ctx, modules, mod_count, options)) {
+            goto cleanup;
+        }
+    }
 
-    np1 = (struct lyd_node_pos *)item1;
-    np2 = (struct lyd_node_pos *)item2;
+    if ((options & (LYD_OPT_RPC | LYD_OPT_RPCREPLY)) && *node && lyd_schema_sort(*node, 1)) {
+        /* rpc and rpc-reply must be sorted */
+        goto cleanup;
+    }
 
-    /* different modules? */
-    if (lys_node_module(np1->node->schema) != lys_node_module(np2->node->schema)) {
-        mpos1 = lys_module_pos(lys_node_module(np1->node->schema));
-        mpos2 = lys_module_pos(lys_node_module(np2->node->schema));
-        /* if lys_module_pos failed, there is nothing we can do anyway,
-         * at least internal error will be printed */
+    /* consolidate diff if created */
+    if (diff) {
+        assert(unres->store_diff);
 
-        if (mpos1 > mpos2) {
-            return 1;
-        } else {
-            return -1;
+        for (i = 0; i < unres->diff_idx; ++i) {
+            if (unres->diff->type[i] == LYD_DIFF_CREATED) {
+                if (unres->diff->second[i]->parent) {
+                    unres->diff->first[i] = (struct lyd_node *)lyd_path(unres->diff->second[i]->parent);
+                }
+                unres->diff->second[i] = lyd_dup(unres->diff->second[i], LYD_DUP_OPT_RECURSIVE);
+            }
         }
+
+        *diff = unres->diff;
+        unres->diff = 0;
+        unres->diff_idx = 0;
     }
 
-    if (np1->pos > np2->pos) {
-        return 1;
-    } else if (np1->pos < np2->pos) {
-        return -1;
+    ret = EXIT_SUCCESS;
+
+cleanup:
+    if (unres) {
+        free(unres->node);
+        free(unres->type);
+        for (i = 0; i < unres->diff_idx; ++i) {
+            if (unres->diff->type[i] == LYD_DIFF_DELETED) {
+                lyd_free_withsiblings(unres->diff->first[i]);
+                free(unres->diff->second[i]);
+            }
+        }
+        lyd_free_diff(unres->diff);
+        free(unres);
     }
-    return 0;
+
+    return ret;
 }
 
 API int
-lyd_schema_sort(struct lyd_node *sibling, int recursive)
+lyd_validate(struct lyd_node **node, int options, void *var_arg, ...)
 {
     FUN_IN;
 
-    uint32_t len, i;
-    struct lyd_node *node;
-    struct lys_node *first_ssibling = NULL;
-    struct lyd_node_pos *array;
+    struct lyd_node *iter, *data_tree = NULL;
+    struct lyd_difflist **diff = NULL;
+    struct ly_ctx *ctx = NULL;
+    va_list ap;
 
-    if (!sibling) {
+    if (!node) {
         LOGARG;
-        return -1;
+        return EXIT_FAILURE;
     }
 
-    /* something actually to sort */
-    if (sibling->prev != sibling) {
+    if (lyp_data_check_options(NULL, options, __func__)) {
+        return EXIT_FAILURE;
+    }
 
-        /* find the beginning */
-        sibling = lyd_first_sibling(sibling);
+    data_tree = *node;
 
-        /* count siblings */
-        len = 0;
-        for (node = sibling; node; node = node->next) {
-            ++len;
+    if ((!(options & LYD_OPT_TYPEMASK)
+            || (options & (LYD_OPT_CONFIG | LYD_OPT_GET | LYD_OPT_GETCONFIG | LYD_OPT_EDIT))) && !(*node)) {
+        /* get context with schemas from the var_arg */
+        ctx = (struct ly_ctx *)var_arg;
+        if (!ctx) {
+            LOGERR(NULL, LY_EINVAL, "%s: invalid variable parameter (struct ly_ctx *ctx).", __func__);
+            return EXIT_FAILURE;
         }
 
-        array = malloc(len * sizeof *array);
-        LY_CHECK_ERR_RETURN(!array, LOGMEM(sibling->schema->module->ctx), -1);
-
-        /* fill arrays with positions and corresponding nodes */
-        for (i = 0, node = sibling; i < len; ++i, node = node->next) {
-            array[i].pos = 0;
-
-            /* we need to repeat this for every module */
-            if (!first_ssibling || (lyd_node_module(node) != lys_node_module(first_ssibling))) {
-                /* find the data node schema parent */
-                first_ssibling = node->schema;
-                while (lys_parent(first_ssibling)
-                        && (lys_parent(first_ssibling)->nodetype & (LYS_CHOICE | LYS_CASE | LYS_USES))) {
-                    first_ssibling = lys_parent(first_ssibling);
-                }
-
-                /* find the beginning */
-                if (lys_parent(first_ssibling)) {
-                    first_ssibling = lys_parent(first_ssibling)->child;
-                } else {
-                    while (first_ssibling->prev->next) {
-                        first_ssibling = first_ssibling->prev;
-                    }
-                }
-            }
-
-            if (lys_module_node_pos_r(first_ssibling, node->schema, &array[i].pos)) {
-                free(array);
-                return -1;
-            }
-
-            array[i].node = node;
+        /* LYD_OPT_NOSIBLINGS has no meaning here */
+        options &= ~LYD_OPT_NOSIBLINGS;
+    } else if (options & (LYD_OPT_RPC | LYD_OPT_RPCREPLY | LYD_OPT_NOTIF)) {
+        /* LYD_OPT_NOSIBLINGS cannot be set in this case */
+        if (options & LYD_OPT_NOSIBLINGS) {
+            LOGERR(NULL, LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree with LYD_OPT_NOSIBLINGS).", __func__);
+            return EXIT_FAILURE;
+        } else if (!(*node)) {
+            LOGARG;
+            return EXIT_FAILURE;
         }
 
-        /* sort the arrays */
-        qsort(array, len, sizeof *array, lyd_node_pos_cmp);
+        /* get the additional data tree if given */
+        data_tree = (struct lyd_node *)var_arg;
+        if (data_tree) {
+            if (options & LYD_OPT_NOEXTDEPS) {
+                LOGERR(NULL, LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree and LYD_OPT_NOEXTDEPS set).",
+                       __func__);
+                return EXIT_FAILURE;
+            }
 
-        /* adjust siblings based on the sorted array */
-        for (i = 0; i < len; ++i) {
-            /* parent child */
-            if (i == 0) {
-                /* adjust sibling so that it still points to the beginning */
-                sibling = array[i].node;
-                if (array[i].node->parent) {
-                    array[i].node->parent->child = array[i].node;
+            LY_TREE_FOR(data_tree, iter) {
+                if (iter->parent) {
+                    /* a sibling is not top-level */
+                    LOGERR(NULL, LY_EINVAL, "%s: invalid variable parameter (const struct lyd_node *data_tree).", __func__);
+                    return EXIT_FAILURE;
                 }
             }
 
-            /* prev */
-            if (i > 0) {
-                array[i].node->prev = array[i - 1].node;
-            } else {
-                array[i].node->prev = array[len - 1].node;
-            }
+            /* move it to the beginning */
+            for (; data_tree->prev->next; data_tree = data_tree->prev);
+        }
+    } else if (options & LYD_OPT_DATA_TEMPLATE) {
+        /* get context with schemas from the var_arg */
+        if (*node && ((*node)->prev->next || (*node)->next)) {
+            /* not allow sibling in top-level */
+            LOGERR(NULL, LY_EINVAL, "%s: invalid variable parameter (struct lyd_node *node).", __func__);
+            return EXIT_FAILURE;
+        }
+    }
 
-            /* next */
-            if (i < len - 1) {
-                array[i].node->next = array[i + 1].node;
-            } else {
-                array[i].node->next = NULL;
-            }
+    if (options & LYD_OPT_VAL_DIFF) {
+        va_start(ap, var_arg);
+        diff = va_arg(ap, struct lyd_difflist **);
+        va_end(ap);
+        if (!diff) {
+            LOGERR(ctx, LY_EINVAL, "%s: invalid variable parameter (struct lyd_difflist **).", __func__);
+            return EXIT_FAILURE;
         }
-        free(array);
     }
 
-    /* sort all the children recursively */
-    if (recursive) {
-        LY_TREE_FOR(sibling, node) {
-            if ((node->schema->nodetype & (LYS_CONTAINER | LYS_LIST | LYS_RPC | LYS_ACTION | LYS_NOTIF))
-                    && node->child && lyd_schema_sort(node->child, recursive)) {
-                return -1;
+    if (*node) {
+        if (!ctx) {
+            ctx = (*node)->schema->module->ctx;
+        }
+        if (!(options & LYD_OPT_NOSIBLINGS)) {
+            /* check that the node is the first sibling */
+            while ((*node)->prev->next) {
+                *node = (*node)->prev;
             }
         }
     }
 
-    return EXIT_SUCCESS;
+    return _lyd_validate(node, data_tree, ctx, NULL, 0, diff, options);
 }
 
-static int
-_lyd_validate(struct lyd_node **node, struct lyd_node *data_tree, struct ly_ctx *ctx, const struct lys_module **modules,
-              int mod_count, struct lyd_difflist **diff, int options)
+API int
+lyd_validate_modules(struct lyd_node **node, const struct lys_module **modules, int mod_count, int options, ...)
 {
-    struct lyd_node *root, *next1, *next2, *iter, *act_notif = NULL;
-    int ret = EXIT_FAILURE;
-    unsigned int i;
-    struct unres_data *unres = NULL;
-    const struct lys_module *yanglib_mod;
+    FUN_IN;
 
-    unres = calloc(1, sizeof *unres);
-    LY_CHECK_ERR_RETURN(!unres, LOGMEM(NULL), EXIT_FAILURE);
+    struct ly_ctx *ctx;
+    struct lyd_difflist **diff = NULL;
+    va_list ap;
 
-    if (diff) {
-        unres->store_diff = 1;
-        unres->diff = lyd_diff_init_difflist(ctx, &unres->diff_size);
+    if (!node || !modules || !mod_count) {
+        LOGARG;
+        return EXIT_FAILURE;
     }
 
-    if ((options & (LYD_OPT_RPC | LYD_OPT_RPCREPLY)) && *node && ((*node)->schema->nodetype != LYS_RPC)) {
-        options |= LYD_OPT_ACT_NOTIF;
+    ctx = modules[0]->ctx;
+
+    if (*node && !(options & LYD_OPT_NOSIBLINGS)) {
+        /* check that the node is the first sibling */
+        while ((*node)->prev->next) {
+            *node = (*node)->prev;
+        }
     }
-    if ((options & (LYD_OPT_NOTIF | LYD_OPT_NOTIF_FILTER)) && *node && ((*node)->schema->nodetype != LYS_NOTIF)) {
-        options |= LYD_OPT_ACT_NOTIF;
+
+    if (lyp_data_check_options(ctx, options, __func__)) {
+        return EXIT_FAILURE;
     }
 
-    LY_TREE_FOR_SAFE(*node, next1, root) {
-        if (modules) {
-            for (i = 0; i < (unsigned)mod_count; ++i) {
-                if (lyd_node_module(root) == modules[i]) {
-                    break;
-                }
-            }
-            if (i == (unsigned)mod_count) {
-                /* skip data that should not be validated */
-                continue;
-            }
-        }
+    if ((options & LYD_OPT_TYPEMASK) && !(options & (LYD_OPT_CONFIG | LYD_OPT_GET | LYD_OPT_GETCONFIG | LYD_OPT_EDIT))) {
+        LOGERR(NULL, LY_EINVAL, "%s: options include a forbidden data type.", __func__);
+        return EXIT_FAILURE;
+    }
 
-        LY_TREE_DFS_BEGIN(root, next2, iter) {
-            if (iter->parent && (iter->schema->nodetype & (LYS_ACTION | LYS_NOTIF))) {
-                if (!(options & LYD_OPT_ACT_NOTIF) || act_notif) {
-                    LOGVAL(ctx, LYE_INELEM, LY_VLOG_LYD, iter, iter->schema->name);
-                    LOGVAL(ctx, LYE_SPEC, LY_VLOG_PREV, NULL, "Unexpected %s node \"%s\".",
-                           (options & LYD_OPT_RPC ? "action" : "notification"), iter->schema->name);
-                    goto cleanup;
-                }
-                act_notif = iter;
-            }
+    if (options & LYD_OPT_VAL_DIFF) {
+        va_start(ap, options);
+        diff = va_arg(ap, struct lyd_difflist **);
+        va_end(ap);
+        if (!diff) {
+            LOGERR(ctx, LY_EINVAL, "%s: invalid variable parameter (struct lyd_difflist **).", __func__);
+            return EXIT_FAILURE;
+        }
+    }
 
-            if (lyv_data_context(iter, options, unres) || lyv_data_content(iter, options, unres)) {
-                goto cleanup;
-            }
+    return _lyd_validate(node, *node, ctx, modules, mod_count, diff, options);
+}
 
-            /* empty non-default, non-presence container without attributes, make it default */
-            if (!iter->dflt && (iter->schema->nodetype == LYS_CONTAINER) && !iter->child
-                        && !((struct lys_node_container *)iter->schema)->presence && !iter->attr) {
-                iter->dflt = 1;
-            }
+API int
+lyd_validate_value(struct lys_node *node, const char *value)
+{
+    return lyd_value_type(node, value, NULL);
+}
 
-            LY_TREE_DFS_END(root, next2, iter);
-        }
+API int
+lyd_value_type(struct lys_node *node, const char *value, struct lys_type **type)
+{
+    FUN_IN;
 
-        if (options & LYD_OPT_NOSIBLINGS) {
-            break;
-        }
+    struct lyd_node_leaf_list leaf;
+    struct lys_node_leaf *sleaf = (struct lys_node_leaf*)node;
+    struct lys_type *t = NULL;
 
+    if (!node || !(node->nodetype & (LYS_LEAF | LYS_LEAFLIST))) {
+        LOGARG;
+        return EXIT_FAILURE;
     }
 
-    if (options & LYD_OPT_ACT_NOTIF) {
-        if (!act_notif) {
-            LOGVAL(ctx, LYE_MISSELEM, LY_VLOG_LYD, *node, (options & LYD_OPT_RPC ? "action" : "notification"), (*node)->schema->name);
-            goto cleanup;
-        }
-        options &= ~LYD_OPT_ACT_NOTIF;
+    if (!value) {
+        value = "";
     }
 
-    if (*node) {
-        /* check for uniqueness of top-level lists/leaflists because
-         * only the inner instances were tested in lyv_data_content() */
-        yanglib_mod = ly_ctx_get_module(ctx ? ctx : (*node)->schema->module->ctx, "ietf-yang-library", NULL, 1);
-        LY_TREE_FOR(*node, root) {
-            if ((options & LYD_OPT_DATA_ADD_YANGLIB) && yanglib_mod && (root->schema->module == yanglib_mod)) {
-                /* ietf-yang-library data present, so ignore the option to add them */
-                options &= ~LYD_OPT_DATA_ADD_YANGLIB;
-            }
-
-            if (!(root->schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) || !(root->validity & LYD_VAL_DUP)) {
-                continue;
-            }
-
-            if (options & LYD_OPT_TRUSTED) {
-                /* just clear the flag */
-                root->validity &= ~LYD_VAL_DUP;
-                continue;
-            }
+    /* dummy leaf */
+    memset(&leaf, 0, sizeof leaf);
+    leaf.value_str = lydict_insert(node->module->ctx, value, 0);
 
-            if (lyv_data_dup(root, *node)) {
-                goto cleanup;
-            }
-        }
-    }
+repeat:
+    leaf.value_type = sleaf->type.base;
+    leaf.schema = node;
 
-    /* add missing ietf-yang-library if requested */
-    if (options & LYD_OPT_DATA_ADD_YANGLIB) {
-        if (!(*node)) {
-            (*node) = ly_ctx_info(ctx);
-        } else if (lyd_merge((*node), ly_ctx_info(ctx), LYD_OPT_DESTRUCT | LYD_OPT_EXPLICIT)) {
-            LOGERR(ctx, LY_EINT, "Adding ietf-yang-library data failed.");
+    if (leaf.value_type == LY_TYPE_LEAFREF) {
+        if (!sleaf->type.info.lref.target) {
+            /* it should either be unresolved leafref (leaf.value_type are ORed flags) or it will be resolved */
+            LOGINT(node->module->ctx);
             goto cleanup;
         }
+        sleaf = sleaf->type.info.lref.target;
+        goto repeat;
+    } else {
+        t = lyp_parse_value(&sleaf->type, &leaf.value_str, NULL, &leaf, NULL, NULL, 0, 0);
     }
 
-    /* add default values, resolve unres and check for mandatory nodes in final tree */
-    if (lyd_defaults_add_unres(node, options, ctx, modules, mod_count, data_tree, act_notif, unres, 1)) {
-        goto cleanup;
+cleanup:
+    lydict_remove(node->module->ctx, leaf.value_str);
+    if (type) {
+        *type = t;
     }
-    if (act_notif) {
-        if (lyd_check_mandatory_tree(act_notif, ctx, modules, mod_count, options)) {
-            goto cleanup;
-        }
+    return t ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* create an attribute copy */
+static struct lyd_attr *
+lyd_dup_attr(struct ly_ctx *ctx, struct lyd_node *parent, struct lyd_attr *attr)
+{
+    struct lyd_attr *ret;
+
+    /* allocate new attr */
+    if (!parent->attr) {
+        parent->attr = lyd_attr_calloc(parent);
+        ret = parent->attr;
     } else {
-        if (lyd_check_mandatory_tree(*node, ctx, modules, mod_count, options)) {
-            goto cleanup;
-        }
+        for (ret = parent->attr; ret->next; ret = ret->next);
+        ret->next = lyd_attr_calloc(parent);
+        ret = ret->next;
     }
+    LY_CHECK_ERR_RETURN(!ret, LOGMEM(ctx), NULL);
 
-    if ((options & (LYD_OPT_RPC | LYD_OPT_RPCREPLY)) && *node && lyd_schema_sort(*node, 1)) {
-        /* rpc and rpc-reply must be sorted */
-        goto cleanup;
+    /* fill new attr except */
+    ret->parent = parent;
+    ret->annotation = attr->annotation;
+    ret->name = lydict_insert(ctx, attr->name, 0);
+    ret->value_str = lydict_insert(ctx, attr->value_str, 0);
+    ret->value_type = attr->value_type;
+    ret->value_flags |= attr->value_flags & ~LY_VALUE_ARENA;
+    switch (ret->value_type) {
+    case LY_TYPE_BINARY:
+    case LY_TYPE_STRING:
+        /* value_str pointer is shared in these cases */
+        ret->value.string = ret->value_str;
+        break;
+    case LY_TYPE_LEAFREF:
+        lyp_parse_value(*((struct lys_type **)lys_ext_complex_get_substmt(LY_STMT_TYPE, ret->annotation, NULL)),
+                             &ret->value_str, NULL, NULL, ret, NULL, 1, 0);
+        break;
+    case LY_TYPE_INST:
+        ret->value.instance = NULL;
+        break;
+    case LY_TYPE_UNION:
+        /* unresolved union (this must be non-validated tree), duplicate the stored string (duplicated
+         * because of possible change of the value in case of instance-identifier) */
+        ret->value.string = lydict_insert(ctx, attr->value.string, 0);
+        break;
+    case LY_TYPE_ENUM:
+    case LY_TYPE_IDENT:
+    case LY_TYPE_BITS:
+        /* in case of duplicating bits (no matter if in the same context or not) or enum and identityref into
+         * a different context, searching for the type and duplicating the data is almost as same as resolving
+         * the string value, so due to a simplicity, parse the value for the duplicated leaf */
+        lyp_parse_value(*((struct lys_type **)lys_ext_complex_get_substmt(LY_STMT_TYPE, ret->annotation, NULL)),
+                             &ret->value_str, NULL, NULL, ret, NULL, 1, 0);
+        break;
+    default:
+        ret->value = attr->value;
+        break;
     }
+    return ret;
+}
 
-    /* consolidate diff if created */
-    if (diff) {
-        assert(unres->store_diff);
+int
+lyd_unlink_internal(struct lyd_node *node, int permanent)
+{
+    struct lyd_node *iter;
 
-        for (i = 0; i < unres->diff_idx; ++i) {
-            if (unres->diff->type[i] == LYD_DIFF_CREATED) {
-                if (unres->diff->second[i]->parent) {
-                    unres->diff->first[i] = (struct lyd_node *)lyd_path(unres->diff->second[i]->parent);
-                }
-                unres->diff->second[i] = lyd_dup(unres->diff->second[i], LYD_DUP_OPT_RECURSIVE);
+    if (!node) {
+        LOGARG;
+        return EXIT_FAILURE;
+    }
+
+    if (permanent == 1) {
+        lyd_journal_unlink(node);
+    }
+
+#ifdef LY_ENABLED_CACHE
+    /* the node position is known only while it is linked */
+    lyd_pos_idx_unlink(node);
+#endif
+
+    /* unlink from siblings */
+    if (node->prev->next) {
+        node->prev->next = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    } else {
+        /* unlinking the last node */
+        if (node->parent) {
+            iter = node->parent->child;
+        } else {
+            iter = node->prev;
+            while (iter->prev != node) {
+                iter = iter->prev;
             }
         }
-
-        *diff = unres->diff;
-        unres->diff = 0;
-        unres->diff_idx = 0;
+        /* update the "last" pointer from the first node */
+        iter->prev = node->prev;
     }
 
-    ret = EXIT_SUCCESS;
+    /* unlink from parent */
+    if (node->parent) {
+        if (node->parent->child == node) {
+            /* the node is the first child */
+            node->parent->child = node->next;
+        }
 
-cleanup:
-    if (unres) {
-        free(unres->node);
-        free(unres->type);
-        for (i = 0; i < unres->diff_idx; ++i) {
-            if (unres->diff->type[i] == LYD_DIFF_DELETED) {
-                lyd_free_withsiblings(unres->diff->first[i]);
-                free(unres->diff->second[i]);
+#ifdef LY_ENABLED_CACHE
+        /* do not remove from parent hash table if freeing the whole subtree */
+        if (permanent != 2) {
+            lyd_unlink_hash(node, node->parent);
+        }
+#endif
+
+        /* a removed unique leaf can be replaced by its default value, the parent list must be revalidated */
+        if (((node->schema->nodetype == LYS_LEAF) && (node->schema->flags & LYS_UNIQUE))
+                || (node->schema->nodetype == LYS_CONTAINER)) {
+            for (iter = node->parent; iter && (iter->schema->nodetype != LYS_LIST); iter = iter->parent);
+            if (iter && ((struct lys_node_list *)iter->schema)->unique_size) {
+                iter->validity |= LYD_VAL_UNIQUE;
             }
         }
-        lyd_free_diff(unres->diff);
-        free(unres);
+
+        node->parent = NULL;
     }
 
-    return ret;
+    node->next = NULL;
+    node->prev = node;
+
+    return EXIT_SUCCESS;
 }
 
 API int
-lyd_validate(struct lyd_node **node, int options, void *var_arg, ...)
+lyd_unlink(struct lyd_node *node)
 {
     FUN_IN;
 
-    struct lyd_node *iter, *data_tree = NULL;
-    struct lyd_difflist **diff = NULL;
-    struct ly_ctx *ctx = NULL;
-    va_list ap;
+    return lyd_unlink_internal(node, 1);
+}
 
-    if (!node) {
-        LOGARG;
-        return EXIT_FAILURE;
+/*
+ * - in leaflist it must be added with value_str
+ */
+static int
+_lyd_dup_node_common(struct lyd_node *new_node, const struct lyd_node *orig, struct ly_ctx *ctx, int options)
+{
+    struct lyd_attr *attr;
+
+    new_node->attr = NULL;
+    if (!(options & LYD_DUP_OPT_NO_ATTR)) {
+        LY_TREE_FOR(orig->attr, attr) {
+            lyd_dup_attr(ctx, new_node, attr);
+        }
+    }
+    new_node->next = NULL;
+    new_node->prev = new_node;
+    new_node->parent = NULL;
+    new_node->validity = ly_new_node_validity(new_node->schema);
+    new_node->dflt = orig->dflt;
+    if (options & LYD_DUP_OPT_WITH_WHEN) {
+        new_node->when_status = orig->when_status;
+    } else {
+        new_node->when_status = orig->when_status & LYD_WHEN;
+    }
+#ifdef LY_ENABLED_CACHE
+    /* just copy the hash, it will not change */
+    if ((new_node->schema->nodetype != LYS_LIST) || lyd_list_has_keys(new_node)) {
+        new_node->hash = orig->hash;
     }
+#endif
 
-    if (lyp_data_check_options(NULL, options, __func__)) {
-        return EXIT_FAILURE;
+#ifdef LY_ENABLED_LYD_PRIV
+    if (ctx->priv_dup_clb) {
+        new_node->priv = ctx->priv_dup_clb(orig->priv);
     }
+#endif
 
-    data_tree = *node;
+    return EXIT_SUCCESS;
+}
 
-    if ((!(options & LYD_OPT_TYPEMASK)
-            || (options & (LYD_OPT_CONFIG | LYD_OPT_GET | LYD_OPT_GETCONFIG | LYD_OPT_EDIT))) && !(*node)) {
-        /* get context with schemas from the var_arg */
-        ctx = (struct ly_ctx *)var_arg;
-        if (!ctx) {
-            LOGERR(NULL, LY_EINVAL, "%s: invalid variable parameter (struct ly_ctx *ctx).", __func__);
-            return EXIT_FAILURE;
-        }
+static struct lyd_node *
+_lyd_dup_node(const struct lyd_node *node, const struct lys_node *schema, struct ly_ctx *ctx, struct lyd_arena *arena,
+              int options)
+{
+    struct lyd_node *new_node = NULL;
+    struct lys_node_leaf *sleaf;
+    struct lyd_node_leaf_list *new_leaf;
+    struct lyd_node_anydata *new_any, *old_any;
+    const struct lys_type *type;
+    int r;
 
-        /* LYD_OPT_NOSIBLINGS has no meaning here */
-        options &= ~LYD_OPT_NOSIBLINGS;
-    } else if (options & (LYD_OPT_RPC | LYD_OPT_RPCREPLY | LYD_OPT_NOTIF)) {
-        /* LYD_OPT_NOSIBLINGS cannot be set in this case */
-        if (options & LYD_OPT_NOSIBLINGS) {
-            LOGERR(NULL, LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree with LYD_OPT_NOSIBLINGS).", __func__);
-            return EXIT_FAILURE;
-        } else if (!(*node)) {
-            LOGARG;
-            return EXIT_FAILURE;
+    /* fill specific part */
+    switch (node->schema->nodetype) {
+    case LYS_LEAF:
+    case LYS_LEAFLIST:
+        new_leaf = lyd_node_calloc(arena, sizeof *new_leaf);
+        new_node = (struct lyd_node *)new_leaf;
+        LY_CHECK_ERR_GOTO(!new_node, LOGMEM(ctx), error);
+        new_node->schema = (struct lys_node *)schema;
+
+        new_leaf->value_str = lydict_insert(ctx, ((struct lyd_node_leaf_list *)node)->value_str, 0);
+        new_leaf->value_type = ((struct lyd_node_leaf_list *)node)->value_type;
+        new_leaf->value_flags = ((struct lyd_node_leaf_list *)node)->value_flags;
+        if (_lyd_dup_node_common(new_node, node, ctx, options)) {
+            goto error;
         }
 
-        /* get the additional data tree if given */
-        data_tree = (struct lyd_node *)var_arg;
-        if (data_tree) {
-            if (options & LYD_OPT_NOEXTDEPS) {
-                LOGERR(NULL, LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree and LYD_OPT_NOEXTDEPS set).",
-                       __func__);
-                return EXIT_FAILURE;
+        /* get schema from the correct context */
+        sleaf = (struct lys_node_leaf *)new_leaf->schema;
+
+        switch (new_leaf->value_type) {
+        case LY_TYPE_BINARY:
+        case LY_TYPE_STRING:
+            /* value_str pointer is shared in these cases */
+            new_leaf->value.string = new_leaf->value_str;
+            break;
+        case LY_TYPE_LEAFREF:
+            lyp_parse_value(&sleaf->type, &new_leaf->value_str, NULL, new_leaf, NULL, NULL, 1, node->dflt);
+            break;
+        case LY_TYPE_INST:
+            new_leaf->value.instance = NULL;
+            break;
+        case LY_TYPE_UNION:
+            /* unresolved union (this must be non-validated tree), duplicate the stored string (duplicated
+             * because of possible change of the value in case of instance-identifier) */
+            new_leaf->value.string = lydict_insert(ctx, ((struct lyd_node_leaf_list *)node)->value.string, 0);
+            break;
+        case LY_TYPE_ENUM:
+        case LY_TYPE_IDENT:
+        case LY_TYPE_BITS:
+            /* in case of duplicating bits (no matter if in the same context or not) or enum and identityref into
+             * a different context, searching for the type and duplicating the data is almost as same as resolving
+             * the string value, so due to a simplicity, parse the value for the duplicated leaf */
+            if (!lyp_parse_value(&sleaf->type, &new_leaf->value_str, NULL, new_leaf, NULL, NULL, 1, node->dflt)) {
+                goto error;
             }
+            break;
+        default:
+            new_leaf->value = ((struct lyd_node_leaf_list *)node)->value;
+            break;
+        }
 
-            LY_TREE_FOR(data_tree, iter) {
-                if (iter->parent) {
-                    /* a sibling is not top-level */
-                    LOGERR(NULL, LY_EINVAL, "%s: invalid variable parameter (const struct lyd_node *data_tree).", __func__);
-                    return EXIT_FAILURE;
-                }
+        if (new_leaf->value_flags & LY_VALUE_USER) {
+            /* get the real type */
+            type = lyd_leaf_type(new_leaf);
+            if (!type || !type->der || !type->der->module) {
+                LOGINT(ctx);
+                goto error;
             }
 
-            /* move it to the beginning */
-            for (; data_tree->prev->next; data_tree = data_tree->prev);
-        }
-    } else if (options & LYD_OPT_DATA_TEMPLATE) {
-        /* get context with schemas from the var_arg */
-        if (*node && ((*node)->prev->next || (*node)->next)) {
-            /* not allow sibling in top-level */
-            LOGERR(NULL, LY_EINVAL, "%s: invalid variable parameter (struct lyd_node *node).", __func__);
-            return EXIT_FAILURE;
+            r = lytype_store(type->der->module, type->der->name, &new_leaf->value_str, &new_leaf->value);
+            if (r == -1) {
+                goto error;
+            } else if (r) {
+                LOGINT(ctx);
+                goto error;
+            }
         }
-    }
+        break;
+    case LYS_ANYXML:
+    case LYS_ANYDATA:
+        old_any = (struct lyd_node_anydata *)node;
+        new_any = lyd_node_calloc(arena, sizeof *new_any);
+        new_node = (struct lyd_node *)new_any;
+        LY_CHECK_ERR_GOTO(!new_node, LOGMEM(ctx), error);
+        new_node->schema = (struct lys_node *)schema;
 
-    if (options & LYD_OPT_VAL_DIFF) {
-        va_start(ap, var_arg);
-        diff = va_arg(ap, struct lyd_difflist **);
-        va_end(ap);
-        if (!diff) {
-            LOGERR(ctx, LY_EINVAL, "%s: invalid variable parameter (struct lyd_difflist **).", __func__);
-            return EXIT_FAILURE;
+        if (_lyd_dup_node_common(new_node, node, ctx, options)) {
+            goto error;
         }
-    }
 
-    if (*node) {
-        if (!ctx) {
-            ctx = (*node)->schema->module->ctx;
+        new_any->value_type = old_any->value_type;
+        if (!(void*)old_any->value.tree) {
+            /* no value to duplicate */
+            break;
         }
-        if (!(options & LYD_OPT_NOSIBLINGS)) {
-            /* check that the node is the first sibling */
-            while ((*node)->prev->next) {
-                *node = (*node)->prev;
+        /* duplicate the value */
+        switch (old_any->value_type) {
+        case LYD_ANYDATA_CONSTSTRING:
+        case LYD_ANYDATA_SXML:
+        case LYD_ANYDATA_JSON:
+            new_any->value.str = lydict_insert(ctx, old_any->value.str, 0);
+            break;
+        case LYD_ANYDATA_DATATREE:
+            new_any->value.tree = lyd_dup_withsiblings_to_ctx(old_any->value.tree, 1, ctx);
+            break;
+        case LYD_ANYDATA_XML:
+            new_any->value.xml = lyxml_dup_elem(ctx, old_any->value.xml, NULL, 1, 1);
+            break;
+        case LYD_ANYDATA_LYB:
+            r = lyd_lyb_data_length(old_any->value.mem);
+            if (r == -1) {
+                LOGERR(ctx, LY_EINVAL, "Invalid LYB data.");
+                goto error;
             }
+            new_any->value.mem = malloc(r);
+            LY_CHECK_ERR_GOTO(!new_any->value.mem, LOGMEM(ctx), error);
+            memcpy(new_any->value.mem, old_any->value.mem, r);
+            break;
+        case LYD_ANYDATA_STRING:
+        case LYD_ANYDATA_SXMLD:
+        case LYD_ANYDATA_JSOND:
+        case LYD_ANYDATA_LYBD:
+            /* dynamic strings are used only as input parameters */
+            assert(0);
+            break;
+        }
+        break;
+    case LYS_CONTAINER:
+    case LYS_LIST:
+    case LYS_NOTIF:
+    case LYS_RPC:
+    case LYS_ACTION:
+        new_node = lyd_node_calloc(arena, sizeof *new_node);
+        LY_CHECK_ERR_GOTO(!new_node, LOGMEM(ctx), error);
+        new_node->schema = (struct lys_node *)schema;
+
+        if (_lyd_dup_node_common(new_node, node, ctx, options)) {
+            goto error;
         }
+        break;
+    default:
+        LOGINT(ctx);
+        goto error;
     }
 
-    return _lyd_validate(node, data_tree, ctx, NULL, 0, diff, options);
+    return new_node;
+
+error:
+    lyd_free(new_node);
+    return NULL;
 }
 
-API int
-lyd_validate_modules(struct lyd_node **node, const struct lys_module **modules, int mod_count, int options, ...)
+static int
+lyd_dup_keys(struct lyd_node *new_list, const struct lyd_node *old_list, struct lys_node *skip_key,
+        struct ly_ctx *log_ctx, int options)
 {
-    FUN_IN;
-
-    struct ly_ctx *ctx;
-    struct lyd_difflist **diff = NULL;
-    va_list ap;
+    struct lys_node_list *slist;
+    struct lyd_node *key, *key_dup;
+    uint16_t i;
 
-    if (!node || !modules || !mod_count) {
-        LOGARG;
-        return EXIT_FAILURE;
+    if (new_list->schema->nodetype != LYS_LIST) {
+        return 0;
     }
 
-    ctx = modules[0]->ctx;
-
-    if (*node && !(options & LYD_OPT_NOSIBLINGS)) {
-        /* check that the node is the first sibling */
-        while ((*node)->prev->next) {
-            *node = (*node)->prev;
+    slist = (struct lys_node_list *)new_list->schema;
+    for (key = old_list->child, i = 0; key && (i < slist->keys_size); ++i, key = key->next) {
+        if (key->schema != (struct lys_node *)slist->keys[i]) {
+            LOGVAL(log_ctx, LYE_PATH_INKEY, LY_VLOG_LYD, new_list, slist->keys[i]->name);
+            return -1;
+        }
+        if (key->schema == skip_key) {
+            continue;
         }
-    }
-
-    if (lyp_data_check_options(ctx, options, __func__)) {
-        return EXIT_FAILURE;
-    }
 
-    if ((options & LYD_OPT_TYPEMASK) && !(options & (LYD_OPT_CONFIG | LYD_OPT_GET | LYD_OPT_GETCONFIG | LYD_OPT_EDIT))) {
-        LOGERR(NULL, LY_EINVAL, "%s: options include a forbidden data type.", __func__);
-        return EXIT_FAILURE;
-    }
+        key_dup = lyd_dup(key, options & LYD_DUP_OPT_NO_ATTR);
+        LY_CHECK_ERR_RETURN(!key_dup, LOGMEM(log_ctx), -1);
 
-    if (options & LYD_OPT_VAL_DIFF) {
-        va_start(ap, options);
-        diff = va_arg(ap, struct lyd_difflist **);
-        va_end(ap);
-        if (!diff) {
-            LOGERR(ctx, LY_EINVAL, "%s: invalid variable parameter (struct lyd_difflist **).", __func__);
-            return EXIT_FAILURE;
+        if (lyd_insert(new_list, key_dup)) {
+            lyd_free(key_dup);
+            return -1;
         }
     }
+    if (!key && (i < slist->keys_size)) {
+        LOGVAL(log_ctx, LYE_PATH_INKEY, LY_VLOG_LYD, new_list, slist->keys[i]->name);
+        return -1;
+    }
 
-    return _lyd_validate(node, *node, ctx, modules, mod_count, diff, options);
-}
-
-API int
-lyd_validate_value(struct lys_node *node, const char *value)
-{
-    return lyd_value_type(node, value, NULL);
+    return 0;
 }
 
-API int
-lyd_value_type(struct lys_node *node, const char *value, struct lys_type **type)
+API struct lyd_node *
+lyd_dup_to_ctx(const struct lyd_node *node, int options, struct ly_ctx *ctx)
 {
     FUN_IN;
 
-    struct lyd_node_leaf_list leaf;
-    struct lys_node_leaf *sleaf = (struct lys_node_leaf*)node;
-    struct lys_type *t = NULL;
+    struct ly_ctx *log_ctx;
+    struct lys_node *schema;
+    const char *yang_data_name;
+    const struct lys_module *trg_mod;
+    const struct lyd_node *next, *elem;
+    struct lyd_node *ret, *parent, *new_node = NULL;
 
-    if (!node || !(node->nodetype & (LYS_LEAF | LYS_LEAFLIST))) {
+    if (!node) {
         LOGARG;
-        return EXIT_FAILURE;
+        return NULL;
     }
 
-    if (!value) {
-        value = "";
+    /* fix options */
+    if ((options & LYD_DUP_OPT_RECURSIVE) && (options & LYD_DUP_OPT_WITH_KEYS)) {
+        options &= ~LYD_DUP_OPT_WITH_KEYS;
     }
 
-    /* dummy leaf */
-    memset(&leaf, 0, sizeof leaf);
-    leaf.value_str = lydict_insert(node->module->ctx, value, 0);
+    log_ctx = (ctx ? ctx : node->schema->module->ctx);
+    if (ctx == node->schema->module->ctx) {
+        /* target context is actually the same as the source context,
+         * ignore the target context */
+        ctx = NULL;
+    }
 
-repeat:
-    leaf.value_type = sleaf->type.base;
-    leaf.schema = node;
+    ret = NULL;
+    parent = NULL;
 
-    if (leaf.value_type == LY_TYPE_LEAFREF) {
-        if (!sleaf->type.info.lref.target) {
-            /* it should either be unresolved leafref (leaf.value_type are ORed flags) or it will be resolved */
-            LOGINT(node->module->ctx);
-            goto cleanup;
-        }
-        sleaf = sleaf->type.info.lref.target;
-        goto repeat;
-    } else {
-        t = lyp_parse_value(&sleaf->type, &leaf.value_str, NULL, &leaf, NULL, NULL, 0, 0);
-    }
+    /* LY_TREE_DFS */
+    for (elem = next = node; elem; elem = next) {
 
-cleanup:
-    lydict_remove(node->module->ctx, leaf.value_str);
-    if (type) {
-        *type = t;
-    }
-    return t ? EXIT_SUCCESS : EXIT_FAILURE;
-}
+        /* find the correct schema */
+        if (ctx) {
+            schema = NULL;
+            if (parent) {
+                trg_mod = lyp_get_module(parent->schema->module, NULL, 0, lyd_node_module(elem)->name,
+                                         strlen(lyd_node_module(elem)->name), 1);
+                if (!trg_mod) {
+                    LOGERR(log_ctx, LY_EINVAL, "Target context does not contain model for the data node being duplicated (%s).",
+                                lyd_node_module(elem)->name);
+                    goto error;
+                }
+                /* we know its parent, so we can start with it */
+                lys_getnext_data(trg_mod, parent->schema, elem->schema->name, strlen(elem->schema->name),
+                                 elem->schema->nodetype, 0, (const struct lys_node **)&schema);
+            } else {
+                /* we have to search in complete context */
+                schema = lyd_get_schema_inctx(elem, ctx);
+            }
 
-/* create an attribute copy */
-static struct lyd_attr *
-lyd_dup_attr(struct ly_ctx *ctx, struct lyd_node *parent, struct lyd_attr *attr)
-{
-    struct lyd_attr *ret;
+            if (!schema) {
+                yang_data_name = lyp_get_yang_data_template_name(elem);
+                if (yang_data_name) {
+                    LOGERR(log_ctx, LY_EINVAL, "Target context does not contain schema node for the data node being duplicated "
+                                        "(%s:#%s/%s).", lyd_node_module(elem)->name, yang_data_name, elem->schema->name);
+                } else {
+                    LOGERR(log_ctx, LY_EINVAL, "Target context does not contain schema node for the data node being duplicated "
+                                        "(%s:%s).", lyd_node_module(elem)->name, elem->schema->name);
+                }
+                goto error;
+            }
+        } else {
+            schema = elem->schema;
+        }
 
-    /* allocate new attr */
-    if (!parent->attr) {
-        parent->attr = calloc(1, sizeof *ret);
-        ret = parent->attr;
-    } else {
-        for (ret = parent->attr; ret->next; ret = ret->next);
-        ret->next = calloc(1, sizeof *ret);
-        ret = ret->next;
-    }
-    LY_CHECK_ERR_RETURN(!ret, LOGMEM(ctx), NULL);
+        /* make node copy */
+        new_node = _lyd_dup_node(elem, schema, log_ctx, NULL, options);
+        if (!new_node) {
+            goto error;
+        }
 
-    /* fill new attr except */
-    ret->parent = parent;
-    ret->annotation = attr->annotation;
-    ret->name = lydict_insert(ctx, attr->name, 0);
-    ret->value_str = lydict_insert(ctx, attr->value_str, 0);
-    ret->value_type = attr->value_type;
-    ret->value_flags = attr->value_flags;
-    switch (ret->value_type) {
-    case LY_TYPE_BINARY:
-    case LY_TYPE_STRING:
-        /* value_str pointer is shared in these cases */
-        ret->value.string = ret->value_str;
-        break;
-    case LY_TYPE_LEAFREF:
-        lyp_parse_value(*((struct lys_type **)lys_ext_complex_get_substmt(LY_STMT_TYPE, ret->annotation, NULL)),
-                             &ret->value_str, NULL, NULL, ret, NULL, 1, 0);
-        break;
-    case LY_TYPE_INST:
-        ret->value.instance = NULL;
-        break;
-    case LY_TYPE_UNION:
-        /* unresolved union (this must be non-validated tree), duplicate the stored string (duplicated
-         * because of possible change of the value in case of instance-identifier) */
-        ret->value.string = lydict_insert(ctx, attr->value.string, 0);
-        break;
-    case LY_TYPE_ENUM:
-    case LY_TYPE_IDENT:
-    case LY_TYPE_BITS:
-        /* in case of duplicating bits (no matter if in the same context or not) or enum and identityref into
-         * a different context, searching for the type and duplicating the data is almost as same as resolving
-         * the string value, so due to a simplicity, parse the value for the duplicated leaf */
-        lyp_parse_value(*((struct lys_type **)lys_ext_complex_get_substmt(LY_STMT_TYPE, ret->annotation, NULL)),
-                             &ret->value_str, NULL, NULL, ret, NULL, 1, 0);
-        break;
-    default:
-        ret->value = attr->value;
-        break;
-    }
-    return ret;
-}
+        if (parent && lyd_insert(parent, new_node)) {
+            goto error;
+        }
 
-int
-lyd_unlink_internal(struct lyd_node *node, int permanent)
-{
-    struct lyd_node *iter;
-    (void)permanent;
+        if (!ret) {
+            ret = new_node;
+        }
 
-    if (!node) {
-        LOGARG;
-        return EXIT_FAILURE;
-    }
+        if (!(options & (LYD_DUP_OPT_RECURSIVE | LYD_DUP_OPT_WITH_KEYS))) {
+            /* no more descendants copied */
+            break;
+        }
 
-    /* unlink from siblings */
-    if (node->prev->next) {
-        node->prev->next = node->next;
-    }
-    if (node->next) {
-        node->next->prev = node->prev;
-    } else {
-        /* unlinking the last node */
-        if (node->parent) {
-            iter = node->parent->child;
+        if (options & LYD_DUP_OPT_WITH_KEYS) {
+            /* copy only descendant keys */
+            if (lyd_dup_keys(new_node, elem, NULL, log_ctx, options)) {
+                goto error;
+            }
+            break;
+        }
+
+        /* LY_TREE_DFS_END */
+        /* select element for the next run - children first,
+         * child exception for lyd_node_leaf and lyd_node_leaflist */
+        if (elem->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) {
+            next = NULL;
         } else {
-            iter = node->prev;
-            while (iter->prev != node) {
-                iter = iter->prev;
+            next = elem->child;
+        }
+        if (!next) {
+            if (elem->parent == node->parent) {
+                break;
             }
+            /* no children, so try siblings */
+            next = elem->next;
+        } else {
+            parent = new_node;
         }
-        /* update the "last" pointer from the first node */
-        iter->prev = node->prev;
-    }
+        new_node = NULL;
 
-    /* unlink from parent */
-    if (node->parent) {
-        if (node->parent->child == node) {
-            /* the node is the first child */
-            node->parent->child = node->next;
+        while (!next) {
+            /* no siblings, go back through parents */
+            elem = elem->parent;
+            if (elem->parent == node->parent) {
+                break;
+            }
+            if (!parent) {
+                LOGINT(log_ctx);
+                goto error;
+            }
+            parent = parent->parent;
+            /* parent is already processed, go to its sibling */
+            next = elem->next;
         }
+    }
 
-#ifdef LY_ENABLED_CACHE
-        /* do not remove from parent hash table if freeing the whole subtree */
-        if (permanent != 2) {
-            lyd_unlink_hash(node, node->parent);
+    /* dup all the parents */
+    if (options & LYD_DUP_OPT_WITH_PARENTS) {
+        parent = ret;
+        if (lys_is_key((struct lys_node_leaf *)ret->schema, NULL)) {
+            /* this key was being duplicated so do not add it twice */
+            schema = ret->schema;
+        } else {
+            schema = NULL;
         }
-#endif
+        for (elem = node->parent; elem; elem = elem->parent) {
+            new_node = lyd_dup(elem, options & LYD_DUP_OPT_NO_ATTR);
+            LY_CHECK_ERR_GOTO(!new_node, LOGMEM(log_ctx), error);
 
-        node->parent = NULL;
+            /* dup all list keys */
+            if (lyd_dup_keys(new_node, elem, schema, log_ctx, options)) {
+                goto error;
+            }
+
+            /* link together */
+            if (lyd_insert(new_node, parent)) {
+                ret = parent;
+                goto error;
+            }
+            parent = new_node;
+        }
     }
 
-    node->next = NULL;
-    node->prev = node;
+    return ret;
 
-    return EXIT_SUCCESS;
+error:
+    lyd_free(ret);
+    return NULL;
 }
 
-API int
-lyd_unlink(struct lyd_node *node)
+API struct lyd_node *
+lyd_dup(const struct lyd_node *node, int options)
 {
     FUN_IN;
 
-    return lyd_unlink_internal(node, 1);
+    return lyd_dup_to_ctx(node, options, NULL);
 }
 
-/*
- * - in leaflist it must be added with value_str
+#ifdef LY_ENABLED_CACHE
+
+/**
+ * @brief Create the children hash table of a duplicated node with all its children at once.
+ *
+ * @param[in] parent_dup Duplicated node with all the children.
+ * @param[in] orig_ht Children hash table of the original node, its size is used so that the table is never resized.
+ * @return 0 on success, -1 on error.
  */
 static int
-_lyd_dup_node_common(struct lyd_node *new_node, const struct lyd_node *orig, struct ly_ctx *ctx, int options)
+lyd_dup_hash_table(struct lyd_node *parent_dup, const struct hash_table *orig_ht)
 {
-    struct lyd_attr *attr;
+    struct lyd_node *iter;
 
-    new_node->attr = NULL;
-    if (!(options & LYD_DUP_OPT_NO_ATTR)) {
-        LY_TREE_FOR(orig->attr, attr) {
-            lyd_dup_attr(ctx, new_node, attr);
+    parent_dup->ht = lyht_new(orig_ht->size, sizeof iter, lyd_hash_table_val_equal, NULL, 1);
+    LY_CHECK_ERR_RETURN(!parent_dup->ht, LOGMEM(parent_dup->schema->module->ctx), -1);
+    parent_dup->ht->resize = orig_ht->resize;
+
+    LY_TREE_FOR(parent_dup->child, iter) {
+        if ((iter->schema->nodetype == LYS_LIST) && !lyd_list_has_keys(iter)) {
+            /* skip lists without keys */
+            continue;
         }
-    }
-    new_node->next = NULL;
-    new_node->prev = new_node;
-    new_node->parent = NULL;
-    new_node->validity = ly_new_node_validity(new_node->schema);
-    new_node->dflt = orig->dflt;
-    if (options & LYD_DUP_OPT_WITH_WHEN) {
-        new_node->when_status = orig->when_status;
-    } else {
-        new_node->when_status = orig->when_status & LYD_WHEN;
-    }
-#ifdef LY_ENABLED_CACHE
-    /* just copy the hash, it will not change */
-    if ((new_node->schema->nodetype != LYS_LIST) || lyd_list_has_keys(new_node)) {
-        new_node->hash = orig->hash;
-    }
-#endif
 
-#ifdef LY_ENABLED_LYD_PRIV
-    if (ctx->priv_dup_clb) {
-        new_node->priv = ctx->priv_dup_clb(orig->priv);
+        if (lyht_insert(parent_dup->ht, &iter, iter->hash, NULL)) {
+            assert(0);
+        }
     }
-#endif
 
-    return EXIT_SUCCESS;
+    return 0;
 }
 
+#endif
+
 static struct lyd_node *
-_lyd_dup_node(const struct lyd_node *node, const struct lys_node *schema, struct ly_ctx *ctx, int options)
+lyd_dup_withsiblings_r(const struct lyd_node *first, struct lyd_node *parent_dup, int options, struct lyd_arena *arena,
+                       struct ly_ctx *ctx)
 {
-    struct lyd_node *new_node = NULL;
-    struct lys_node_leaf *sleaf;
-    struct lyd_node_leaf_list *new_leaf;
-    struct lyd_node_anydata *new_any, *old_any;
-    const struct lys_type *type;
-    int r;
+    struct lyd_node *first_dup = NULL, *prev_dup = NULL, *last_dup;
+    const struct lyd_node *next;
 
-    /* fill specific part */
-    switch (node->schema->nodetype) {
-    case LYS_LEAF:
-    case LYS_LEAFLIST:
-        new_leaf = calloc(1, sizeof *new_leaf);
-        new_node = (struct lyd_node *)new_leaf;
-        LY_CHECK_ERR_GOTO(!new_node, LOGMEM(ctx), error);
-        new_node->schema = (struct lys_node *)schema;
+    assert(first);
 
-        new_leaf->value_str = lydict_insert(ctx, ((struct lyd_node_leaf_list *)node)->value_str, 0);
-        new_leaf->value_type = ((struct lyd_node_leaf_list *)node)->value_type;
-        new_leaf->value_flags = ((struct lyd_node_leaf_list *)node)->value_flags;
-        if (_lyd_dup_node_common(new_node, node, ctx, options)) {
+    /* duplicate and connect all siblings */
+    LY_TREE_FOR(first, next) {
+        last_dup = _lyd_dup_node(next, next->schema, ctx, arena, options);
+        if (!last_dup) {
             goto error;
         }
 
-        /* get schema from the correct context */
-        sleaf = (struct lys_node_leaf *)new_leaf->schema;
+        /* the whole data tree is exactly the same so we can safely copy the validation flags */
+        last_dup->validity = next->validity;
+        last_dup->when_status = next->when_status;
 
-        switch (new_leaf->value_type) {
-        case LY_TYPE_BINARY:
-        case LY_TYPE_STRING:
-            /* value_str pointer is shared in these cases */
-            new_leaf->value.string = new_leaf->value_str;
-            break;
-        case LY_TYPE_LEAFREF:
-            lyp_parse_value(&sleaf->type, &new_leaf->value_str, NULL, new_leaf, NULL, NULL, 1, node->dflt);
-            break;
-        case LY_TYPE_INST:
-            new_leaf->value.instance = NULL;
-            break;
-        case LY_TYPE_UNION:
-            /* unresolved union (this must be non-validated tree), duplicate the stored string (duplicated
-             * because of possible change of the value in case of instance-identifier) */
-            new_leaf->value.string = lydict_insert(ctx, ((struct lyd_node_leaf_list *)node)->value.string, 0);
-            break;
-        case LY_TYPE_ENUM:
-        case LY_TYPE_IDENT:
-        case LY_TYPE_BITS:
-            /* in case of duplicating bits (no matter if in the same context or not) or enum and identityref into
-             * a different context, searching for the type and duplicating the data is almost as same as resolving
-             * the string value, so due to a simplicity, parse the value for the duplicated leaf */
-            if (!lyp_parse_value(&sleaf->type, &new_leaf->value_str, NULL, new_leaf, NULL, NULL, 1, node->dflt)) {
-                goto error;
+        last_dup->parent = parent_dup;
+        /* connect to the parent or the siblings */
+        if (!first_dup) {
+            first_dup = last_dup;
+            if (parent_dup) {
+                parent_dup->child = first_dup;
             }
-            break;
-        default:
-            new_leaf->value = ((struct lyd_node_leaf_list *)node)->value;
-            break;
+        } else {
+            assert(prev_dup);
+            prev_dup->next = last_dup;
+            last_dup->prev = prev_dup;
         }
 
-        if (new_leaf->value_flags & LY_VALUE_USER) {
-            /* get the real type */
-            type = lyd_leaf_type(new_leaf);
-            if (!type || !type->der || !type->der->module) {
-                LOGINT(ctx);
-                goto error;
-            }
+#ifdef LY_ENABLED_CACHE
+        /* copy the hashes, the content is the same (attributes are not part of the content hash) */
+        last_dup->hash = next->hash;
+        if (!(next->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA))) {
+            last_dup->content_hash = next->content_hash;
+        }
+#endif
 
-            r = lytype_store(type->der->module, type->der->name, &new_leaf->value_str, &new_leaf->value);
-            if (r == -1) {
-                goto error;
-            } else if (r) {
-                LOGINT(ctx);
+        if ((next->schema->nodetype & (LYS_LIST | LYS_CONTAINER | LYS_RPC | LYS_ACTION | LYS_NOTIF)) && next->child) {
+            /* recursively duplicate all children */
+            if (!lyd_dup_withsiblings_r(next->child, last_dup, options, arena, ctx)) {
                 goto error;
             }
         }
-        break;
-    case LYS_ANYXML:
-    case LYS_ANYDATA:
-        old_any = (struct lyd_node_anydata *)node;
-        new_any = calloc(1, sizeof *new_any);
-        new_node = (struct lyd_node *)new_any;
-        LY_CHECK_ERR_GOTO(!new_node, LOGMEM(ctx), error);
-        new_node->schema = (struct lys_node *)schema;
 
-        if (_lyd_dup_node_common(new_node, node, ctx, options)) {
-            goto error;
+        prev_dup = last_dup;
+    }
+
+    /* correctly set last sibling */
+    assert(!prev_dup->next);
+    first_dup->prev = prev_dup;
+
+#ifdef LY_ENABLED_CACHE
+    /* all the children are known, create the parent hash table at once instead of growing it */
+    if (parent_dup && first->parent->ht && lyd_dup_hash_table(parent_dup, first->parent->ht)) {
+        goto error;
+    }
+#endif
+
+    return first_dup;
+
+error:
+    /* disconnect and free */
+    if (first_dup) {
+        if (parent_dup) {
+            parent_dup->child = NULL;
         }
+        first_dup->parent = NULL;
+        lyd_free_withsiblings(first_dup);
+    }
+    return NULL;
+}
 
-        new_any->value_type = old_any->value_type;
-        if (!(void*)old_any->value.tree) {
-            /* no value to duplicate */
-            break;
+static struct lyd_node *
+lyd_dup_withsiblings_to_ctx(const struct lyd_node *node, int options, struct ly_ctx *ctx)
+{
+    const struct lyd_node *iter;
+    struct lyd_node *ret, *ret_iter, *tmp;
+
+    if (!node) {
+        return NULL;
+    }
+
+    /* find first sibling */
+    while (node->prev->next) {
+        node = node->prev;
+    }
+
+    if (node->parent) {
+        ret = lyd_dup_to_ctx(node, options, ctx);
+        if (!ret) {
+            return NULL;
         }
-        /* duplicate the value */
-        switch (old_any->value_type) {
-        case LYD_ANYDATA_CONSTSTRING:
-        case LYD_ANYDATA_SXML:
-        case LYD_ANYDATA_JSON:
-            new_any->value.str = lydict_insert(ctx, old_any->value.str, 0);
-            break;
-        case LYD_ANYDATA_DATATREE:
-            new_any->value.tree = lyd_dup_withsiblings_to_ctx(old_any->value.tree, 1, ctx);
-            break;
-        case LYD_ANYDATA_XML:
-            new_any->value.xml = lyxml_dup_elem(ctx, old_any->value.xml, NULL, 1, 1);
-            break;
-        case LYD_ANYDATA_LYB:
-            r = lyd_lyb_data_length(old_any->value.mem);
-            if (r == -1) {
-                LOGERR(ctx, LY_EINVAL, "Invalid LYB data.");
-                goto error;
+
+        /* copy following siblings */
+        ret_iter = ret;
+        LY_TREE_FOR(node->next, iter) {
+            tmp = lyd_dup_to_ctx(iter, options, ctx);
+            if (!tmp) {
+                lyd_free_withsiblings(ret);
+                return NULL;
             }
-            new_any->value.mem = malloc(r);
-            LY_CHECK_ERR_GOTO(!new_any->value.mem, LOGMEM(ctx), error);
-            memcpy(new_any->value.mem, old_any->value.mem, r);
-            break;
-        case LYD_ANYDATA_STRING:
-        case LYD_ANYDATA_SXMLD:
-        case LYD_ANYDATA_JSOND:
-        case LYD_ANYDATA_LYBD:
-            /* dynamic strings are used only as input parameters */
-            assert(0);
-            break;
+
+            if (lyd_insert_after(ret_iter, tmp)) {
+                lyd_free_withsiblings(ret);
+                return NULL;
+            }
+            ret_iter = ret_iter->next;
+            assert(ret_iter == tmp);
         }
-        break;
-    case LYS_CONTAINER:
-    case LYS_LIST:
-    case LYS_NOTIF:
-    case LYS_RPC:
-    case LYS_ACTION:
-        new_node = calloc(1, sizeof *new_node);
-        LY_CHECK_ERR_GOTO(!new_node, LOGMEM(ctx), error);
-        new_node->schema = (struct lys_node *)schema;
+    } else {
+        /* duplicating top-level siblings, we can duplicate much more efficiently */
+        ret = lyd_dup_withsiblings_r(node, NULL, options, NULL, ctx);
+    }
+
+    return ret;
+}
+
+API struct lyd_node *
+lyd_dup_withsiblings(const struct lyd_node *node, int options)
+{
+    FUN_IN;
+
+    if (!node) {
+        return NULL;
+    }
+
+    return lyd_dup_withsiblings_to_ctx(node, options, lyd_node_module(node)->ctx);
+}
 
-        if (_lyd_dup_node_common(new_node, node, ctx, options)) {
-            goto error;
-        }
-        break;
-    default:
-        LOGINT(ctx);
-        goto error;
+struct lyd_snapshot {
+    struct lyd_node *data;          /* first top-level sibling of the data tree, never modified */
+    uint32_t refs;                  /* number of references */
+};
+
+API struct lyd_snapshot *
+lyd_snapshot(struct lyd_node *node)
+{
+    FUN_IN;
+
+    struct lyd_snapshot *snap;
+#ifdef LY_ENABLED_CACHE
+    struct lyd_node *iter;
+#endif
+
+    if (!node || node->parent) {
+        LOGARG;
+        return NULL;
     }
 
-    return new_node;
+    snap = malloc(sizeof *snap);
+    LY_CHECK_ERR_RETURN(!snap, LOGMEM(lyd_node_module(node)->ctx), NULL);
+    snap->data = lyd_first_sibling(node);
+    snap->refs = 1;
 
-error:
-    lyd_free(new_node);
-    return NULL;
+#ifdef LY_ENABLED_CACHE
+    /* cache all the content hashes now, the snapshot must not be modified once it can be shared */
+    LY_TREE_FOR(snap->data, iter) {
+        lyd_content_hash(iter);
+    }
+#endif
+
+    return snap;
 }
 
-static int
-lyd_dup_keys(struct lyd_node *new_list, const struct lyd_node *old_list, struct lys_node *skip_key,
-        struct ly_ctx *log_ctx, int options)
+API struct lyd_node *
+lyd_snapshot_data(const struct lyd_snapshot *snap)
 {
-    struct lys_node_list *slist;
-    struct lyd_node *key, *key_dup;
-    uint16_t i;
+    FUN_IN;
 
-    if (new_list->schema->nodetype != LYS_LIST) {
-        return 0;
+    if (!snap) {
+        LOGARG;
+        return NULL;
     }
 
-    slist = (struct lys_node_list *)new_list->schema;
-    for (key = old_list->child, i = 0; key && (i < slist->keys_size); ++i, key = key->next) {
-        if (key->schema != (struct lys_node *)slist->keys[i]) {
-            LOGVAL(log_ctx, LYE_PATH_INKEY, LY_VLOG_LYD, new_list, slist->keys[i]->name);
-            return -1;
-        }
-        if (key->schema == skip_key) {
-            continue;
-        }
+    return snap->data;
+}
 
-        key_dup = lyd_dup(key, options & LYD_DUP_OPT_NO_ATTR);
-        LY_CHECK_ERR_RETURN(!key_dup, LOGMEM(log_ctx), -1);
+API struct lyd_snapshot *
+lyd_snapshot_ref(struct lyd_snapshot *snap)
+{
+    FUN_IN;
 
-        if (lyd_insert(new_list, key_dup)) {
-            lyd_free(key_dup);
-            return -1;
-        }
+    if (!snap) {
+        LOGARG;
+        return NULL;
     }
-    if (!key && (i < slist->keys_size)) {
-        LOGVAL(log_ctx, LYE_PATH_INKEY, LY_VLOG_LYD, new_list, slist->keys[i]->name);
-        return -1;
+
+    __sync_add_and_fetch(&snap->refs, 1);
+    return snap;
+}
+
+API void
+lyd_snapshot_free(struct lyd_snapshot *snap)
+{
+    FUN_IN;
+
+    if (!snap || __sync_sub_and_fetch(&snap->refs, 1)) {
+        return;
     }
 
-    return 0;
+    lyd_free_withsiblings(snap->data);
+    free(snap);
 }
 
 API struct lyd_node *
-lyd_dup_to_ctx(const struct lyd_node *node, int options, struct ly_ctx *ctx)
+lyd_snapshot_dup(const struct lyd_snapshot *snap)
 {
     FUN_IN;
 
-    struct ly_ctx *log_ctx;
-    struct lys_node *schema;
-    const char *yang_data_name;
-    const struct lys_module *trg_mod;
-    const struct lyd_node *next, *elem;
-    struct lyd_node *ret, *parent, *new_node = NULL;
+    struct lyd_arena *arena;
+    struct lyd_node *ret;
 
-    if (!node) {
+    if (!snap) {
         LOGARG;
         return NULL;
     }
 
-    /* fix options */
-    if ((options & LYD_DUP_OPT_RECURSIVE) && (options & LYD_DUP_OPT_WITH_KEYS)) {
-        options &= ~LYD_DUP_OPT_WITH_KEYS;
+    /* the copy is freed mostly as a whole, either on a failed transaction or once replaced by a newer copy */
+    arena = lyd_arena_new();
+    LY_CHECK_ERR_RETURN(!arena, LOGMEM(lyd_node_module(snap->data)->ctx), NULL);
+
+    ret = lyd_dup_withsiblings_r(snap->data, NULL, 0, arena, lyd_node_module(snap->data)->ctx);
+    lyd_arena_release(arena);
+    return ret;
+}
+
+/* journal record types, a node can be both moved and changed */
+#define LYD_JOURNAL_CREATED 0x01
+#define LYD_JOURNAL_DELETED 0x02
+#define LYD_JOURNAL_CHANGED 0x04
+#define LYD_JOURNAL_MOVED   0x08
+
+struct lyd_journal_rec {
+    struct lyd_node *node;          /* recorded node of the data tree, NULL for deleted nodes */
+    struct lyd_node *old;           /* journal copy (with parents) of a deleted node or a changed node previous value */
+    uint8_t type;                   /* LYD_JOURNAL_* flags, 0 for a dropped record */
+};
+
+/* record index item, the first member is used by lyd_node_ptr_equal() */
+struct lyd_journal_idx {
+    struct lyd_node *node;
+    uint32_t rec;
+};
+
+/* context registry item, the first member is used by lyd_node_ptr_equal() */
+struct lyd_journal_top {
+    struct lyd_node *node;
+    struct lyd_journal *journal;
+};
+
+struct lyd_journal {
+    struct ly_ctx *ctx;
+    struct ly_set *tops;            /* top-level nodes of the data tree, all registered in the context */
+    struct lyd_journal_rec *recs;   /* records in the order they were made */
+    uint32_t count;                 /* number of records */
+    uint32_t size;                  /* allocated number of records */
+    uint32_t live;                  /* number of records of the nodes in the data tree */
+    struct hash_table *idx;         /* record index of the nodes in the data tree */
+    int err;                        /* a change could not be recorded */
+};
+
+/**
+ * @brief Learn whether there are any journals in a context, without locking. The registry is created
+ * and freed by other threads under the journal lock, which is needed to use it.
+ *
+ * @param[in] ctx Context to check.
+ * @return Whether there are any journals.
+ */
+static int
+lyd_journal_any(struct ly_ctx *ctx)
+{
+    return (__atomic_load_n(&ctx->journals, __ATOMIC_ACQUIRE) != NULL);
+}
+
+/**
+ * @brief Find the journal of a data tree.
+ *
+ * @param[in] node Any node of the data tree.
+ * @return Journal of the tree, NULL if there is none.
+ */
+static struct lyd_journal *
+lyd_journal_find(struct lyd_node *node)
+{
+    struct ly_ctx *ctx = node->schema->module->ctx;
+    struct lyd_journal_top top, *match;
+    struct lyd_journal *journal = NULL;
+
+    if (!lyd_journal_any(ctx)) {
+        /* no journals in the context, the common case */
+        return NULL;
     }
 
-    log_ctx = (ctx ? ctx : node->schema->module->ctx);
-    if (ctx == node->schema->module->ctx) {
-        /* target context is actually the same as the source context,
-         * ignore the target context */
-        ctx = NULL;
+    for (top.node = node; top.node->parent; top.node = top.node->parent);
+
+    pthread_mutex_lock(&ctx->journal_lock);
+    if (ctx->journals && !lyht_find(ctx->journals, &top, lyd_node_ptr_hash(top.node), (void **)&match)) {
+        journal = match->journal;
     }
+    pthread_mutex_unlock(&ctx->journal_lock);
 
-    ret = NULL;
-    parent = NULL;
+    return journal;
+}
 
-    /* LY_TREE_DFS */
-    for (elem = next = node; elem; elem = next) {
+static int
+lyd_journal_reg(struct lyd_journal *journal, struct lyd_node *node)
+{
+    struct ly_ctx *ctx = journal->ctx;
+    struct lyd_journal_top top;
+    int r = 0;
 
-        /* find the correct schema */
-        if (ctx) {
-            schema = NULL;
-            if (parent) {
-                trg_mod = lyp_get_module(parent->schema->module, NULL, 0, lyd_node_module(elem)->name,
-                                         strlen(lyd_node_module(elem)->name), 1);
-                if (!trg_mod) {
-                    LOGERR(log_ctx, LY_EINVAL, "Target context does not contain model for the data node being duplicated (%s).",
-                                lyd_node_module(elem)->name);
-                    goto error;
-                }
-                /* we know its parent, so we can start with it */
-                lys_getnext_data(trg_mod, parent->schema, elem->schema->name, strlen(elem->schema->name),
-                                 elem->schema->nodetype, 0, (const struct lys_node **)&schema);
-            } else {
-                /* we have to search in complete context */
-                schema = lyd_get_schema_inctx(elem, ctx);
-            }
+    top.node = node;
+    top.journal = journal;
 
-            if (!schema) {
-                yang_data_name = lyp_get_yang_data_template_name(elem);
-                if (yang_data_name) {
-                    LOGERR(log_ctx, LY_EINVAL, "Target context does not contain schema node for the data node being duplicated "
-                                        "(%s:#%s/%s).", lyd_node_module(elem)->name, yang_data_name, elem->schema->name);
-                } else {
-                    LOGERR(log_ctx, LY_EINVAL, "Target context does not contain schema node for the data node being duplicated "
-                                        "(%s:%s).", lyd_node_module(elem)->name, elem->schema->name);
-                }
-                goto error;
-            }
-        } else {
-            schema = elem->schema;
+    if (ly_set_add(journal->tops, node, LY_SET_OPT_USEASLIST) == -1) {
+        r = -1;
+    } else {
+        pthread_mutex_lock(&ctx->journal_lock);
+        if (!ctx->journals) {
+            __atomic_store_n(&ctx->journals, lyht_new(8, sizeof top, lyd_node_ptr_equal, NULL, 1), __ATOMIC_RELEASE);
         }
-
-        /* make node copy */
-        new_node = _lyd_dup_node(elem, schema, log_ctx, options);
-        if (!new_node) {
-            goto error;
+        if (!ctx->journals || (lyht_insert(ctx->journals, &top, lyd_node_ptr_hash(node), NULL) == -1)) {
+            r = -1;
         }
+        pthread_mutex_unlock(&ctx->journal_lock);
+    }
 
-        if (parent && lyd_insert(parent, new_node)) {
-            goto error;
+    if (r) {
+        LOGMEM(ctx);
+        journal->err = 1;
+    }
+    return r;
+}
+
+static void
+lyd_journal_unreg(struct lyd_journal *journal, struct lyd_node *node)
+{
+    struct ly_ctx *ctx = journal->ctx;
+    struct lyd_journal_top top;
+
+    top.node = node;
+
+    pthread_mutex_lock(&ctx->journal_lock);
+    if (ctx->journals) {
+        lyht_remove(ctx->journals, &top, lyd_node_ptr_hash(node));
+        if (!ctx->journals->used) {
+            /* the last journal is gone, keep the data modifications fast */
+            lyht_free(ctx->journals);
+            __atomic_store_n(&ctx->journals, NULL, __ATOMIC_RELEASE);
         }
+    }
+    pthread_mutex_unlock(&ctx->journal_lock);
 
-        if (!ret) {
-            ret = new_node;
+    ly_set_rm(journal->tops, node);
+}
+
+static struct lyd_journal_rec *
+lyd_journal_rec_get(struct lyd_journal *journal, struct lyd_node *node)
+{
+    struct lyd_journal_idx item, *match;
+
+    item.node = node;
+    if (!journal->live || lyht_find(journal->idx, &item, lyd_node_ptr_hash(node), (void **)&match)) {
+        return NULL;
+    }
+    return &journal->recs[match->rec];
+}
+
+static struct lyd_journal_rec *
+lyd_journal_rec_new(struct lyd_journal *journal, struct lyd_node *node, uint8_t type, struct lyd_node *old)
+{
+    struct lyd_journal_rec *new;
+    struct lyd_journal_idx item;
+
+    if (journal->count == journal->size) {
+        new = realloc(journal->recs, (journal->size ? journal->size * 2 : 16) * sizeof *journal->recs);
+        LY_CHECK_ERR_GOTO(!new, LOGMEM(journal->ctx), error);
+        journal->recs = new;
+        journal->size = journal->size ? journal->size * 2 : 16;
+    }
+
+    if (node) {
+        item.node = node;
+        item.rec = journal->count;
+        LY_CHECK_ERR_GOTO(lyht_insert(journal->idx, &item, lyd_node_ptr_hash(node), NULL) == -1, LOGMEM(journal->ctx),
+                          error);
+        ++journal->live;
+    }
+
+    new = &journal->recs[journal->count++];
+    new->node = node;
+    new->old = old;
+    new->type = type;
+    return new;
+
+error:
+    journal->err = 1;
+    return NULL;
+}
+
+static void
+lyd_journal_copy_free(struct lyd_node *copy)
+{
+    if (copy) {
+        for (; copy->parent; copy = copy->parent);
+        lyd_free(copy);
+    }
+}
+
+static void
+lyd_journal_rec_drop(struct lyd_journal *journal, struct lyd_journal_rec *rec)
+{
+    struct lyd_journal_idx item;
+
+    if (rec->node) {
+        item.node = rec->node;
+        lyht_remove(journal->idx, &item, lyd_node_ptr_hash(rec->node));
+        --journal->live;
+    }
+    lyd_journal_copy_free(rec->old);
+    rec->node = NULL;
+    rec->old = NULL;
+    rec->type = 0;
+}
+
+/**
+ * @brief Check whether a node is a part of a subtree recorded as created, whose changes are not recorded separately.
+ */
+static int
+lyd_journal_in_created(struct lyd_journal *journal, struct lyd_node *node)
+{
+    struct lyd_journal_rec *rec;
+
+    for (node = node->parent; node && journal->live; node = node->parent) {
+        if ((rec = lyd_journal_rec_get(journal, node)) && (rec->type & LYD_JOURNAL_CREATED)) {
+            return 1;
         }
+    }
+    return 0;
+}
 
-        if (!(options & (LYD_DUP_OPT_RECURSIVE | LYD_DUP_OPT_WITH_KEYS))) {
-            /* no more descendants copied */
-            break;
+void
+lyd_journal_insert(struct lyd_node *node, int moved)
+{
+    struct lyd_journal *journal;
+    struct lyd_journal_rec *rec;
+    struct lyd_node *sibling;
+
+    if (!lyd_journal_any(node->schema->module->ctx)) {
+        return;
+    }
+
+    if (!node->parent) {
+        /* a top-level node of a tree with a journal, which must be registered as well */
+        sibling = (node->prev != node) ? node->prev : node->next;
+        if (!sibling || !(journal = lyd_journal_find(sibling))) {
+            return;
         }
+        if (!moved && lyd_journal_reg(journal, node)) {
+            return;
+        }
+    } else if (!(journal = lyd_journal_find(node))) {
+        return;
+    }
 
-        if (options & LYD_DUP_OPT_WITH_KEYS) {
-            /* copy only descendant keys */
-            if (lyd_dup_keys(new_node, elem, NULL, log_ctx, options)) {
-                goto error;
-            }
-            break;
+    if (node->dflt || lyd_journal_in_created(journal, node)) {
+        /* default nodes are not recorded, the same as by lyd_diff() */
+        return;
+    }
+
+    rec = lyd_journal_rec_get(journal, node);
+    if (!moved) {
+        /* unlinking dropped any previous records of the node */
+        assert(!rec);
+        lyd_journal_rec_new(journal, node, LYD_JOURNAL_CREATED, NULL);
+    } else if (node->schema->flags & LYS_USERORDERED) {
+        if (!rec) {
+            lyd_journal_rec_new(journal, node, LYD_JOURNAL_MOVED, NULL);
+        } else if (!(rec->type & LYD_JOURNAL_CREATED)) {
+            rec->type |= LYD_JOURNAL_MOVED;
         }
+    }
+}
 
-        /* LY_TREE_DFS_END */
-        /* select element for the next run - children first,
-         * child exception for lyd_node_leaf and lyd_node_leaflist */
-        if (elem->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) {
-            next = NULL;
-        } else {
-            next = elem->child;
+void
+lyd_journal_unlink(struct lyd_node *node)
+{
+    struct lyd_journal *journal;
+    struct lyd_journal_rec *rec;
+    struct lyd_node *old = NULL, *next, *elem;
+    int created = 0;
+
+    if (!lyd_journal_any(node->schema->module->ctx) || !(journal = lyd_journal_find(node))) {
+        return;
+    }
+
+    /* the node is recorded with all its descendants as a single deleted subtree */
+    if (journal->live && (rec = lyd_journal_rec_get(journal, node))) {
+        created = rec->type & LYD_JOURNAL_CREATED;
+        if (rec->type & LYD_JOURNAL_CHANGED) {
+            /* keep the previous value */
+            old = rec->old;
+            rec->old = NULL;
         }
-        if (!next) {
-            if (elem->parent == node->parent) {
+        lyd_journal_rec_drop(journal, rec);
+    }
+    if (!(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA))) {
+        /* the same cost as copying the subtree, stop once there are no records left */
+        LY_TREE_DFS_BEGIN(node, next, elem) {
+            if (!journal->live) {
                 break;
             }
-            /* no children, so try siblings */
-            next = elem->next;
-        } else {
-            parent = new_node;
+            if ((elem != node) && (rec = lyd_journal_rec_get(journal, elem))) {
+                lyd_journal_rec_drop(journal, rec);
+            }
+            LY_TREE_DFS_END(node, next, elem);
         }
-        new_node = NULL;
+    }
 
-        while (!next) {
-            /* no siblings, go back through parents */
-            elem = elem->parent;
-            if (elem->parent == node->parent) {
-                break;
-            }
-            if (!parent) {
-                LOGINT(log_ctx);
-                goto error;
+    if (!created && !node->dflt && !lyd_journal_in_created(journal, node)) {
+        if (!old) {
+            old = lyd_dup(node, LYD_DUP_OPT_RECURSIVE | LYD_DUP_OPT_WITH_PARENTS);
+            if (!old) {
+                journal->err = 1;
             }
-            parent = parent->parent;
-            /* parent is already processed, go to its sibling */
-            next = elem->next;
         }
+        if (old && !lyd_journal_rec_new(journal, NULL, LYD_JOURNAL_DELETED, old)) {
+            lyd_journal_copy_free(old);
+        }
+    } else {
+        lyd_journal_copy_free(old);
     }
 
-    /* dup all the parents */
-    if (options & LYD_DUP_OPT_WITH_PARENTS) {
-        parent = ret;
-        if (lys_is_key((struct lys_node_leaf *)ret->schema, NULL)) {
-            /* this key was being duplicated so do not add it twice */
-            schema = ret->schema;
-        } else {
-            schema = NULL;
+    if (!node->parent) {
+        lyd_journal_unreg(journal, node);
+    }
+}
+
+void
+lyd_journal_change(struct lyd_node *node)
+{
+    struct lyd_journal *journal;
+    struct lyd_journal_rec *rec;
+    struct lyd_node *old = NULL;
+    uint8_t type;
+
+    if (!lyd_journal_any(node->schema->module->ctx) || !(journal = lyd_journal_find(node))) {
+        return;
+    }
+
+    rec = lyd_journal_rec_get(journal, node);
+    if ((rec && (rec->type & (LYD_JOURNAL_CREATED | LYD_JOURNAL_CHANGED))) || lyd_journal_in_created(journal, node)) {
+        /* the original value is already recorded or there is none */
+        return;
+    }
+
+    if (node->dflt) {
+        /* an explicit value replaces the default one, which is a creation for lyd_diff() */
+        type = LYD_JOURNAL_CREATED;
+    } else {
+        type = LYD_JOURNAL_CHANGED;
+        old = lyd_dup(node, LYD_DUP_OPT_WITH_PARENTS);
+        if (!old) {
+            journal->err = 1;
+            return;
         }
-        for (elem = node->parent; elem; elem = elem->parent) {
-            new_node = lyd_dup(elem, options & LYD_DUP_OPT_NO_ATTR);
-            LY_CHECK_ERR_GOTO(!new_node, LOGMEM(log_ctx), error);
+    }
 
-            /* dup all list keys */
-            if (lyd_dup_keys(new_node, elem, schema, log_ctx, options)) {
-                goto error;
-            }
+    if (rec) {
+        rec->type |= type;
+        rec->old = old;
+    } else if (!lyd_journal_rec_new(journal, node, type, old)) {
+        lyd_journal_copy_free(old);
+    }
+}
 
-            /* link together */
-            if (lyd_insert(new_node, parent)) {
-                ret = parent;
-                goto error;
-            }
-            parent = new_node;
+API struct lyd_journal *
+lyd_journal_new(struct lyd_node *node)
+{
+    FUN_IN;
+
+    struct lyd_journal *journal;
+    struct lyd_node *iter;
+
+    if (!node) {
+        LOGARG;
+        return NULL;
+    }
+    if (lyd_journal_find(node)) {
+        LOGERR(node->schema->module->ctx, LY_EINVAL, "%s: the data tree already has a journal.", __func__);
+        return NULL;
+    }
+
+    journal = calloc(1, sizeof *journal);
+    LY_CHECK_ERR_RETURN(!journal, LOGMEM(node->schema->module->ctx), NULL);
+    journal->ctx = node->schema->module->ctx;
+    journal->tops = ly_set_new();
+    journal->idx = lyht_new(8, sizeof(struct lyd_journal_idx), lyd_node_ptr_equal, NULL, 1);
+    LY_CHECK_ERR_GOTO(!journal->tops || !journal->idx, LOGMEM(journal->ctx), error);
+
+    for (; node->parent; node = node->parent);
+    LY_TREE_FOR(lyd_first_sibling(node), iter) {
+        if (lyd_journal_reg(journal, iter)) {
+            goto error;
         }
     }
 
-    return ret;
+    return journal;
 
 error:
-    lyd_free(ret);
+    lyd_journal_free(journal);
     return NULL;
 }
 
-API struct lyd_node *
-lyd_dup(const struct lyd_node *node, int options)
+API void
+lyd_journal_clear(struct lyd_journal *journal)
 {
     FUN_IN;
 
-    return lyd_dup_to_ctx(node, options, NULL);
+    uint32_t i;
+
+    if (!journal) {
+        return;
+    }
+
+    for (i = 0; i < journal->count; ++i) {
+        lyd_journal_rec_drop(journal, &journal->recs[i]);
+    }
+    journal->count = 0;
+    journal->err = 0;
 }
 
-static struct lyd_node *
-lyd_dup_withsiblings_r(const struct lyd_node *first, struct lyd_node *parent_dup, int options, struct ly_ctx *ctx)
+API void
+lyd_journal_free(struct lyd_journal *journal)
 {
-    struct lyd_node *first_dup = NULL, *prev_dup = NULL, *last_dup;
-    const struct lyd_node *next;
+    FUN_IN;
 
-    assert(first);
+    if (!journal) {
+        return;
+    }
 
-    /* duplicate and connect all siblings */
-    LY_TREE_FOR(first, next) {
-        last_dup = _lyd_dup_node(next, next->schema, ctx, options);
-        if (!last_dup) {
-            goto error;
+    if (journal->tops) {
+        while (journal->tops->number) {
+            lyd_journal_unreg(journal, journal->tops->set.d[journal->tops->number - 1]);
         }
+        ly_set_free(journal->tops);
+    }
+    if (journal->idx) {
+        lyd_journal_clear(journal);
+        lyht_free(journal->idx);
+    }
+    free(journal->recs);
+    free(journal);
+}
 
-        /* the whole data tree is exactly the same so we can safely copy the validation flags */
-        last_dup->validity = next->validity;
-        last_dup->when_status = next->when_status;
+/* moved and created user-ordered instance, sorted by their parents and positions */
+struct lyd_journal_ord {
+    struct lyd_node *node;
+    unsigned int pos;
+};
 
-        last_dup->parent = parent_dup;
-        /* connect to the parent or the siblings */
-        if (!first_dup) {
-            first_dup = last_dup;
-            if (parent_dup) {
-                parent_dup->child = first_dup;
-            }
-        } else {
-            assert(prev_dup);
-            prev_dup->next = last_dup;
-            last_dup->prev = prev_dup;
-        }
+static int
+lyd_journal_ord_cmp(const void *ptr1, const void *ptr2)
+{
+    const struct lyd_journal_ord *ord1 = ptr1, *ord2 = ptr2;
 
-#ifdef LY_ENABLED_CACHE
-        /* copy hash */
-        if ((last_dup->schema->nodetype != LYS_LIST) || lyd_list_has_keys(last_dup)) {
-            last_dup->hash = next->hash;
+    if (ord1->node->parent != ord2->node->parent) {
+        return ((uintptr_t)ord1->node->parent < (uintptr_t)ord2->node->parent) ? -1 : 1;
+    }
+    if (ord1->node->schema != ord2->node->schema) {
+        return ((uintptr_t)ord1->node->schema < (uintptr_t)ord2->node->schema) ? -1 : 1;
+    }
+    return (ord1->pos < ord2->pos) ? -1 : (ord1->pos > ord2->pos);
+}
+
+static struct lyd_node *
+lyd_journal_prev_instance(struct lyd_journal *journal, struct lyd_node *node, int skip_created)
+{
+    struct lyd_journal_rec *rec;
+    struct lyd_node *iter;
+
+    for (iter = node->prev; iter->next; iter = iter->prev) {
+        if ((iter->schema == node->schema)
+                && (!skip_created || !(rec = lyd_journal_rec_get(journal, iter)) || !(rec->type & LYD_JOURNAL_CREATED))) {
+            return iter;
         }
+    }
+    return NULL;
+}
 
-        /* insert into parent */
-        lyd_insert_hash(last_dup);
-#endif
+API struct lyd_difflist *
+lyd_journal_diff(struct lyd_journal *journal)
+{
+    FUN_IN;
 
-        if ((next->schema->nodetype & (LYS_LIST | LYS_CONTAINER | LYS_RPC | LYS_ACTION | LYS_NOTIF)) && next->child) {
-            /* recursively duplicate all children */
-            if (!lyd_dup_withsiblings_r(next->child, last_dup, options, ctx)) {
+    struct lyd_difflist *diff;
+    struct lyd_journal_rec *rec;
+    struct lyd_journal_ord *ord = NULL;
+    unsigned int size, index = 0, ord_count, i;
+
+    if (!journal) {
+        LOGARG;
+        return NULL;
+    }
+    if (journal->err) {
+        LOGERR(journal->ctx, LY_EINT, "%s: some data tree changes could not be recorded.", __func__);
+        return NULL;
+    }
+
+    diff = lyd_diff_init_difflist(journal->ctx, &size);
+    if (!diff) {
+        return NULL;
+    }
+    if (journal->live) {
+        ord = malloc(journal->live * sizeof *ord);
+        LY_CHECK_ERR_GOTO(!ord, LOGMEM(journal->ctx), error);
+    }
+
+    /* the same order as by lyd_diff(), changed and deleted nodes first */
+    for (i = 0; i < journal->count; ++i) {
+        rec = &journal->recs[i];
+        if ((rec->type & LYD_JOURNAL_CHANGED) && !(rec->type & LYD_JOURNAL_CREATED)) {
+            if ((rec->node->schema->nodetype == LYS_LEAF) && ly_strequal(((struct lyd_node_leaf_list *)rec->old)->value_str,
+                                                                         ((struct lyd_node_leaf_list *)rec->node)->value_str, 1)) {
+                /* changed back */
+                continue;
+            }
+            if (lyd_difflist_add(diff, &size, index++, LYD_DIFF_CHANGED, rec->old, rec->node)) {
                 goto error;
             }
         }
+    }
+    for (i = 0; i < journal->count; ++i) {
+        rec = &journal->recs[i];
+        if ((rec->type & LYD_JOURNAL_DELETED) && lyd_difflist_add(diff, &size, index++, LYD_DIFF_DELETED, rec->old, NULL)) {
+            goto error;
+        }
+    }
 
-        prev_dup = last_dup;
+    /* moved instances, each is moved after its (final) predecessor so they must follow the final order */
+    for (i = 0, ord_count = 0; i < journal->count; ++i) {
+        rec = &journal->recs[i];
+        if ((rec->type & LYD_JOURNAL_MOVED) && !(rec->type & LYD_JOURNAL_CREATED)) {
+            ord[ord_count].node = rec->node;
+            ord[ord_count++].pos = lyd_list_pos(rec->node);
+        }
+    }
+    qsort(ord, ord_count, sizeof *ord, lyd_journal_ord_cmp);
+    for (i = 0; i < ord_count; ++i) {
+        if (lyd_difflist_add(diff, &size, index++, LYD_DIFF_MOVEDAFTER1, ord[i].node,
+                             lyd_journal_prev_instance(journal, ord[i].node, 1))) {
+            goto error;
+        }
     }
 
-    /* correctly set last sibling */
-    assert(!prev_dup->next);
-    first_dup->prev = prev_dup;
+    /* created nodes, the user-ordered instances are moved to their positions in the final order as well */
+    for (i = 0, ord_count = 0; i < journal->count; ++i) {
+        rec = &journal->recs[i];
+        if (!(rec->type & LYD_JOURNAL_CREATED)) {
+            continue;
+        }
+        if (rec->node->schema->flags & LYS_USERORDERED) {
+            ord[ord_count].node = rec->node;
+            ord[ord_count++].pos = lyd_list_pos(rec->node);
+        } else if (lyd_difflist_add(diff, &size, index++, LYD_DIFF_CREATED, rec->node->parent, rec->node)) {
+            goto error;
+        }
+    }
+    qsort(ord, ord_count, sizeof *ord, lyd_journal_ord_cmp);
+    for (i = 0; i < ord_count; ++i) {
+        if (lyd_difflist_add(diff, &size, index++, LYD_DIFF_CREATED, ord[i].node->parent, ord[i].node)
+                || lyd_difflist_add(diff, &size, index++, LYD_DIFF_MOVEDAFTER2,
+                                    lyd_journal_prev_instance(journal, ord[i].node, 0), ord[i].node)) {
+            goto error;
+        }
+    }
 
-    return first_dup;
+    free(ord);
+    return diff;
 
 error:
-    /* disconnect and free */
-    if (first_dup) {
-        first_dup->parent = NULL;
-        lyd_free_withsiblings(first_dup);
-    }
+    free(ord);
+    lyd_free_diff(diff);
     return NULL;
 }
 
-static struct lyd_node *
-lyd_dup_withsiblings_to_ctx(const struct lyd_node *node, int options, struct ly_ctx *ctx)
+/**
+ * @brief Header of every arena slab, the slabs are aligned to their size so that the header
+ * of the slab an object was allocated from can be found from the object address.
+ */
+struct lyd_arena_slab {
+    struct lyd_arena *arena;
+    struct lyd_arena_slab *next;
+};
+
+struct lyd_arena {
+    struct lyd_arena_slab *slabs;   /* list of all the slabs, the first one is being allocated from */
+    size_t used;                    /* bytes used in the first slab */
+    uint32_t refs;                  /* number of objects allocated from the arena and not yet freed + its owner */
+};
+
+#define LYD_ARENA_SLAB_SIZE 65536
+#define LYD_ARENA_ALIGN 8
+#define LYD_ARENA_HDR_SIZE ((sizeof(struct lyd_arena_slab) + LYD_ARENA_ALIGN - 1) & ~(LYD_ARENA_ALIGN - 1))
+
+#define LYD_ARENA_OF(ptr) ((struct lyd_arena_slab *)((uintptr_t)(ptr) & ~((uintptr_t)LYD_ARENA_SLAB_SIZE - 1)))->arena
+
+struct lyd_arena *
+lyd_arena_new(void)
 {
-    const struct lyd_node *iter;
-    struct lyd_node *ret, *ret_iter, *tmp;
+    struct lyd_arena *arena;
 
-    if (!node) {
+    arena = calloc(1, sizeof *arena);
+    if (!arena) {
         return NULL;
     }
 
-    /* find first sibling */
-    while (node->prev->next) {
-        node = node->prev;
+    /* the first slab is allocated on the first allocation */
+    arena->used = LYD_ARENA_SLAB_SIZE;
+    arena->refs = 1;
+    return arena;
+}
+
+void
+lyd_arena_release(struct lyd_arena *arena)
+{
+    struct lyd_arena_slab *slab;
+
+    if (!arena || __sync_sub_and_fetch(&arena->refs, 1)) {
+        return;
     }
 
-    if (node->parent) {
-        ret = lyd_dup_to_ctx(node, options, ctx);
-        if (!ret) {
+    while (arena->slabs) {
+        slab = arena->slabs;
+        arena->slabs = slab->next;
+        free(slab);
+    }
+    free(arena);
+}
+
+/**
+ * @brief Allocate zeroed memory from an arena.
+ *
+ * @param[in] arena Arena to allocate from.
+ * @param[in] size Size of the memory.
+ * @return Allocated memory, NULL on error.
+ */
+static void *
+lyd_arena_calloc(struct lyd_arena *arena, size_t size)
+{
+    struct lyd_arena_slab *slab;
+    void *mem;
+
+    size = (size + LYD_ARENA_ALIGN - 1) & ~(LYD_ARENA_ALIGN - 1);
+    assert(size <= LYD_ARENA_SLAB_SIZE - LYD_ARENA_HDR_SIZE);
+
+    if (arena->used + size > LYD_ARENA_SLAB_SIZE) {
+        /* new slab */
+        if (posix_memalign((void **)&slab, LYD_ARENA_SLAB_SIZE, LYD_ARENA_SLAB_SIZE)) {
             return NULL;
         }
+        slab->arena = arena;
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+        arena->used = LYD_ARENA_HDR_SIZE;
+    }
 
-        /* copy following siblings */
-        ret_iter = ret;
-        LY_TREE_FOR(node->next, iter) {
-            tmp = lyd_dup_to_ctx(iter, options, ctx);
-            if (!tmp) {
-                lyd_free_withsiblings(ret);
-                return NULL;
-            }
+    mem = (char *)arena->slabs + arena->used;
+    arena->used += size;
+    __sync_add_and_fetch(&arena->refs, 1);
 
-            if (lyd_insert_after(ret_iter, tmp)) {
-                lyd_free_withsiblings(ret);
-                return NULL;
-            }
-            ret_iter = ret_iter->next;
-            assert(ret_iter == tmp);
-        }
-    } else {
-        /* duplicating top-level siblings, we can duplicate much more efficiently */
-        ret = lyd_dup_withsiblings_r(node, NULL, options, ctx);
+    memset(mem, 0, size);
+    return mem;
+}
+
+void *
+lyd_node_calloc(struct lyd_arena *arena, size_t size)
+{
+    struct lyd_node *node;
+
+    if (!arena) {
+        return calloc(1, size);
     }
 
-    return ret;
+    node = lyd_arena_calloc(arena, size);
+    if (node) {
+        node->arena = 1;
+    }
+    return node;
 }
 
-API struct lyd_node *
-lyd_dup_withsiblings(const struct lyd_node *node, int options)
+struct lyd_attr *
+lyd_attr_calloc(const struct lyd_node *parent)
 {
-    FUN_IN;
+    struct lyd_attr *attr;
 
-    if (!node) {
+    if (!parent || !parent->arena) {
+        return calloc(1, sizeof *attr);
+    }
+
+    attr = lyd_arena_calloc(LYD_ARENA_OF(parent), sizeof *attr);
+    if (attr) {
+        attr->value_flags = LY_VALUE_ARENA;
+    }
+    return attr;
+}
+
+struct lyd_arena *
+lyd_node_arena(const struct lyd_node *node)
+{
+    if (!node || !node->arena) {
         return NULL;
     }
+    return LYD_ARENA_OF(node);
+}
+
+void
+lyd_node_mem_free(struct lyd_node *node)
+{
+    if (node->arena) {
+        lyd_arena_release(LYD_ARENA_OF(node));
+    } else {
+        free(node);
+    }
+}
 
-    return lyd_dup_withsiblings_to_ctx(node, options, lyd_node_module(node)->ctx);
+void
+lyd_attr_mem_free(struct lyd_attr *attr)
+{
+    if (attr->value_flags & LY_VALUE_ARENA) {
+        lyd_arena_release(LYD_ARENA_OF(attr));
+    } else {
+        free(attr);
+    }
 }
 
 API void
@@ -5966,7 +8849,7 @@ lyd_free_attr(struct ly_ctx *ctx, struct lyd_node *parent, struct lyd_attr *attr
         assert(type);
         lyd_free_value(attr->value, attr->value_type, attr->value_flags, *type, attr->value_str, NULL, NULL, NULL);
         lydict_remove(ctx, attr->value_str);
-        free(attr);
+        lyd_attr_mem_free(attr);
     }
 }
 
@@ -6129,6 +9012,7 @@ _lyd_free_node(struct lyd_node *node)
 #ifdef LY_ENABLED_CACHE
         /* it should be empty because all the children are freed already (only if in debug mode) */
         lyht_free(node->ht);
+        lyd_pos_idx_free(node, NULL);
 #endif
         break;
     case LYS_ANYDATA:
@@ -6169,7 +9053,7 @@ _lyd_free_node(struct lyd_node *node)
     }
 
     lyd_free_attr(node->schema->module->ctx, node, node->attr, 1);
-    free(node);
+    lyd_node_mem_free(node);
 }
 
 static void
@@ -6185,6 +9069,11 @@ lyd_free_internal_r(struct lyd_node *node, int top)
     lyd_unlink_internal(node, (top ? 1 : 2));
 
     if (!(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA))) {
+#ifdef LY_ENABLED_CACHE
+        /* the positions of the children being freed need not be maintained */
+        lyd_pos_idx_free(node, NULL);
+#endif
+
         /* free children */
         LY_TREE_FOR_SAFE(node->child, next, iter) {
             lyd_free_internal_r(iter, 0);
@@ -6227,6 +9116,11 @@ lyd_free_withsiblings(struct lyd_node *node)
     }
 
     if (node->parent) {
+#ifdef LY_ENABLED_CACHE
+        /* all the children are freed, their positions need not be maintained */
+        lyd_pos_idx_free(node->parent, NULL);
+#endif
+
         /* optimization - avoid freeing (unlinking) the last node of the siblings list */
         /* so, first, free the node's predecessors to the beginning of the list ... */
         for(iter = node->prev; iter->next; iter = aux) {
@@ -6244,6 +9138,13 @@ lyd_free_withsiblings(struct lyd_node *node)
             node = node->prev;
         }
 
+        if (lyd_journal_any(node->schema->module->ctx)) {
+            /* but a journal must record it */
+            LY_TREE_FOR(node, iter) {
+                lyd_journal_unlink(iter);
+            }
+        }
+
         /* free it all */
         lyd_free_withsiblings_r(node);
     }
@@ -6430,6 +9331,260 @@ lyd_build_relative_data_path(const struct lys_module *module, const struct lyd_n
     return len;
 }
 
+/**
+ * @brief Get the canonical value of a path predicate the same way XPath canonizes it.
+ *
+ * @param[in] schema Leaf or leaf-list with the value.
+ * @param[in] value Predicate value.
+ * @param[in] val_len Length of \p value.
+ * @param[out] dyn Set to the canonical value if it needs to be freed.
+ * @return Canonical value, NULL if not supported.
+ */
+static const char *
+lyd_find_path_canonical(const struct lys_node *schema, const char *value, int val_len, char **dyn)
+{
+    const struct lys_type *type;
+    enum int_log_opts prev_ilo;
+    char *val_can;
+
+    *dyn = NULL;
+
+    /* the literal is transformed if it may include a module name */
+    if (strnchr(value, ':', val_len)) {
+        return NULL;
+    }
+
+    for (type = &((struct lys_node_leaf *)schema)->type; type->base == LY_TYPE_LEAFREF; type = &type->info.lref.target->type) {
+        if (!type->info.lref.target) {
+            return NULL;
+        }
+    }
+
+    switch (type->base) {
+    case LY_TYPE_IDENT:
+    case LY_TYPE_INST:
+        return NULL;
+    case LY_TYPE_STRING:
+        /* always canonical */
+        break;
+    default:
+        /* ignore errors, the value may not satisfy schema constraints and then it is used as it is */
+        ly_ilo_change(NULL, ILO_IGNORE, &prev_ilo, NULL);
+        val_can = lyd_make_canonical(schema, value, val_len);
+        ly_ilo_restore(NULL, prev_ilo, NULL, 0);
+        if (val_can) {
+            *dyn = val_can;
+            return val_can;
+        }
+        break;
+    }
+
+    *dyn = strndup(value, val_len);
+    if (!*dyn) {
+        LOGMEM(schema->module->ctx);
+    }
+    return *dyn;
+}
+
+/**
+ * @brief Find the result of a simple path (node identifiers with key or leaf-list value predicates)
+ * directly in the data tree, without evaluating it as XPath.
+ *
+ * @param[in] ctx_node Context node.
+ * @param[in] path Path to evaluate.
+ * @param[out] ret Set with the result.
+ * @return 0 on success, 1 if \p path is not simple, -1 on error.
+ */
+static int
+lyd_find_path_simple(const struct lyd_node *ctx_node, const char *path, struct ly_set **ret)
+{
+    struct ly_ctx *ctx = ctx_node->schema->module->ctx;
+    const struct lys_module *prev_mod;
+    const struct lys_node *sparent, *schema;
+    const struct lys_node_list *slist;
+    struct lyd_node_lookup lookup;
+    struct ly_set *parents = NULL, *set = NULL, *aux;
+    struct lyd_node *siblings;
+    const char *id, *mod_name, *name, *value;
+    char *dyn[LYD_LOOKUP_MAX_VALS];
+    int r, rc = 1, mod_name_len, nam_len, val_len, is_relative = -1, has_predicate, single;
+    unsigned int i, pos;
+    uint8_t k;
+
+    memset(dyn, 0, sizeof dyn);
+    prev_mod = lyd_node_module(ctx_node);
+
+    parents = ly_set_new();
+    set = ly_set_new();
+    LY_CHECK_ERR_GOTO(!parents || !set, LOGMEM(ctx); rc = -1, cleanup);
+
+    id = path;
+    r = parse_schema_nodeid(id, &mod_name, &mod_name_len, &name, &nam_len, &is_relative, &has_predicate, NULL, 0);
+    if (r < 1) {
+        goto cleanup;
+    }
+    if (is_relative) {
+        sparent = ctx_node->schema;
+        ly_set_add(set, (void *)ctx_node, LY_SET_OPT_USEASLIST);
+    } else {
+        sparent = NULL;
+        for (; ctx_node->parent; ctx_node = ctx_node->parent);
+        ly_set_add(set, NULL, LY_SET_OPT_USEASLIST);
+    }
+
+    while (1) {
+        if (sparent && (sparent->nodetype & (LYS_RPC | LYS_ACTION))) {
+            /* input and output nodes */
+            goto cleanup;
+        }
+
+        /* find the schema node */
+        if (mod_name) {
+            prev_mod = ly_ctx_nget_module(ctx, mod_name, mod_name_len, NULL, 1);
+            if (!prev_mod) {
+                goto cleanup;
+            }
+        }
+        schema = NULL;
+        while ((schema = lys_getnext(schema, sparent, prev_mod, 0))) {
+            if ((lys_node_module(schema) == prev_mod) && !strncmp(schema->name, name, nam_len) && !schema->name[nam_len]) {
+                break;
+            }
+        }
+        if (!schema) {
+            goto cleanup;
+        }
+        id += r;
+
+        /* predicates */
+        memset(&lookup, 0, sizeof lookup);
+        lookup.schema = schema;
+        slist = (struct lys_node_list *)schema;
+        pos = 0;
+        while (has_predicate) {
+            r = parse_schema_json_predicate(id, &mod_name, &mod_name_len, &name, &nam_len, &value, &val_len, &has_predicate);
+            if ((r < 1) || mod_name) {
+                goto cleanup;
+            }
+            id += r;
+
+            if (!value && isdigit(name[0]) && (schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) && !pos && !lookup.val_count) {
+                /* instance position, the only predicate */
+                pos = atoi(name);
+                continue;
+            } else if (!value || pos) {
+                goto cleanup;
+            }
+
+            if (schema->nodetype == LYS_LEAFLIST) {
+                if ((name[0] != '.') || lookup.val_count) {
+                    goto cleanup;
+                }
+                k = 0;
+            } else if ((schema->nodetype == LYS_LIST) && (slist->keys_size <= LYD_LOOKUP_MAX_VALS)) {
+                for (k = 0; k < slist->keys_size; ++k) {
+                    if (!strncmp(slist->keys[k]->name, name, nam_len) && !slist->keys[k]->name[nam_len]) {
+                        break;
+                    }
+                }
+                if ((k == slist->keys_size) || lookup.vals[k]) {
+                    goto cleanup;
+                }
+            } else {
+                goto cleanup;
+            }
+
+            lookup.vals[k] = lyd_find_path_canonical(schema->nodetype == LYS_LIST ? (struct lys_node *)slist->keys[k] : schema,
+                                                     value, val_len, &dyn[k]);
+            if (!lookup.vals[k]) {
+                rc = dyn[k] ? 1 : -1;
+                goto cleanup;
+            }
+            ++lookup.val_count;
+        }
+
+        switch (schema->nodetype) {
+        case LYS_CONTAINER:
+        case LYS_LEAF:
+        case LYS_ANYXML:
+        case LYS_ANYDATA:
+        case LYS_NOTIF:
+        case LYS_RPC:
+        case LYS_ACTION:
+            single = 1;
+            break;
+        case LYS_LEAFLIST:
+            single = lookup.val_count && (schema->flags & LYS_CONFIG_W);
+            break;
+        case LYS_LIST:
+            if (lookup.val_count && (lookup.val_count < slist->keys_size)) {
+                /* not all the keys */
+                goto cleanup;
+            }
+            single = lookup.val_count && (schema->flags & LYS_CONFIG_W);
+            break;
+        default:
+            goto cleanup;
+        }
+
+        /* find the instances in all the parents */
+        aux = parents;
+        parents = set;
+        set = aux;
+        ly_set_clean(set);
+        for (i = 0; i < parents->number; ++i) {
+            if (!parents->set.d[i]) {
+                siblings = lyd_first_sibling((struct lyd_node *)ctx_node);
+            } else if (parents->set.d[i]->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) {
+                siblings = NULL;
+            } else {
+                siblings = parents->set.d[i]->child;
+            }
+            if (pos) {
+                if (siblings && (siblings = lyd_list_nth(siblings, schema, pos))) {
+                    ly_set_add(set, siblings, LY_SET_OPT_USEASLIST);
+                }
+                continue;
+            }
+            if (lyd_node_lookup_find(siblings, &lookup, single, set)) {
+                LOGMEM(ctx);
+                rc = -1;
+                goto cleanup;
+            }
+        }
+
+        for (k = 0; k < LYD_LOOKUP_MAX_VALS; ++k) {
+            free(dyn[k]);
+            dyn[k] = NULL;
+        }
+
+        if (!id[0]) {
+            /* success */
+            break;
+        }
+
+        /* next node identifier */
+        r = parse_schema_nodeid(id, &mod_name, &mod_name_len, &name, &nam_len, &is_relative, &has_predicate, NULL, 0);
+        if (r < 1) {
+            goto cleanup;
+        }
+        sparent = schema;
+        prev_mod = lys_node_module(schema);
+    }
+
+    *ret = set;
+    set = NULL;
+    rc = 0;
+
+cleanup:
+    for (k = 0; k < LYD_LOOKUP_MAX_VALS; ++k) {
+        free(dyn[k]);
+    }
+    ly_set_free(parents);
+    ly_set_free(set);
+    return rc;
+}
+
 API struct ly_set *
 lyd_find_path(const struct lyd_node *ctx_node, const char *path)
 {
@@ -6439,7 +9594,7 @@ lyd_find_path(const struct lyd_node *ctx_node, const char *path)
     struct ly_set *set;
     char *yang_xpath;
     const char * node_mod_name, *mod_name, *name;
-    int mod_name_len, name_len, is_relative = -1;
+    int r, mod_name_len, name_len, is_relative = -1;
     uint32_t i;
 
     if (!ctx_node || !path) {
@@ -6457,6 +9612,12 @@ lyd_find_path(const struct lyd_node *ctx_node, const char *path)
         }
     }
 
+    /* simple paths are found directly */
+    r = lyd_find_path_simple(ctx_node, path, &set);
+    if (r < 1) {
+        return r ? NULL : set;
+    }
+
     /* transform JSON into YANG XPATH */
     yang_xpath = transform_json2xpath(lyd_node_module(ctx_node), path);
     if (!yang_xpath) {
@@ -6499,7 +9660,9 @@ lyd_find_instance(const struct lyd_node *data, const struct lys_node *schema)
     struct ly_set *ret, *ret_aux, *spath;
     const struct lys_node *siter;
     struct lyd_node *iter;
+    struct lyd_node_lookup lookup;
     unsigned int i, j;
+    int single;
 
     if (!data || !schema ||
             !(schema->nodetype & (LYS_CONTAINER | LYS_LEAF | LYS_LIST | LYS_LEAFLIST | LYS_ANYDATA | LYS_NOTIF | LYS_RPC | LYS_ACTION))) {
@@ -6558,11 +9721,14 @@ lyd_find_instance(const struct lyd_node *data, const struct lys_node *schema)
             LOGMEM(schema->module->ctx);
             goto error;
         }
+        memset(&lookup, 0, sizeof lookup);
+        lookup.schema = spath->set.s[i - 1];
+        single = !(lookup.schema->nodetype & (LYS_LIST | LYS_LEAFLIST));
         for (j = 0; j < ret->number; j++) {
-            LY_TREE_FOR(ret->set.d[j]->child, iter) {
-                if (iter->schema == spath->set.s[i - 1]) {
-                    ly_set_add(ret_aux, iter, LY_SET_OPT_USEASLIST);
-                }
+            if (lyd_node_lookup_find(ret->set.d[j]->child, &lookup, single, ret_aux)) {
+                LOGMEM(schema->module->ctx);
+                ly_set_free(ret_aux);
+                goto error;
             }
         }
         ly_set_free(ret);
@@ -6946,6 +10112,124 @@ lyd_first_sibling(struct lyd_node *node)
     return start;
 }
 
+/**
+ * @brief Record of the ly_set index.
+ */
+struct ly_set_rec {
+    void *item;
+    unsigned int idx;
+};
+
+/**
+ * @brief Callback for checking ly_set index records equivalence, the same object can be in the set
+ * several times so the records of particular items are equal only if their indexes are equal, too.
+ */
+static int
+ly_set_rec_equal(void *val1_p, void *val2_p, int mod, void *UNUSED(cb_data))
+{
+    struct ly_set_rec *rec1 = val1_p, *rec2 = val2_p;
+
+    if (rec1->item != rec2->item) {
+        return 0;
+    }
+    return !mod || (rec1->idx == rec2->idx);
+}
+
+static uint32_t
+ly_set_hash(void *item)
+{
+    uint32_t hash;
+
+    hash = dict_hash_multi(0, (const char *)&item, sizeof item);
+    return dict_hash_multi(hash, NULL, sizeof item);
+}
+
+/**
+ * @brief Add a record of a set item into the set index.
+ *
+ * @param[in] set Set with the index.
+ * @param[in] idx Index of the item in the set.
+ * @return 0 on success, -1 on error.
+ */
+static int
+ly_set_index_add(struct ly_set *set, unsigned int idx)
+{
+    struct ly_set_rec rec;
+
+    rec.item = set->set.g[idx];
+    rec.idx = idx;
+    if (lyht_insert(set->ht, &rec, ly_set_hash(rec.item), NULL) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Create the index of a set.
+ *
+ * @param[in] set Set to index.
+ * @return 0 on success, -1 on error.
+ */
+static int
+ly_set_index(struct ly_set *set)
+{
+    unsigned int i, size;
+
+    for (size = LY_SET_INDEX_MIN; size < set->number * 2; size <<= 1);
+    set->ht = lyht_new(size, sizeof(struct ly_set_rec), ly_set_rec_equal, NULL, 1);
+    LY_CHECK_ERR_RETURN(!set->ht, LOGMEM(NULL), -1);
+
+    for (i = 0; i < set->number; ++i) {
+        if (ly_set_index_add(set, i)) {
+            lyht_free(set->ht);
+            set->ht = NULL;
+            LOGMEM(NULL);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Find an object in a set.
+ *
+ * @param[in] set Set to search in.
+ * @param[in] node Object to find.
+ * @return Index of the first occurrence of \p node in \p set, -1 if not found.
+ */
+static int
+ly_set_find(const struct ly_set *set, void *node)
+{
+    struct ly_set_rec rec, *match;
+    unsigned int i;
+    uint32_t hash;
+
+    if (set->ht) {
+        rec.item = node;
+        hash = ly_set_hash(node);
+        if (lyht_find(set->ht, &rec, hash, (void **)&match)) {
+            return -1;
+        }
+
+        /* the object can be in a list set several times, return its first occurrence the same as the walk */
+        i = match->idx;
+        while (!lyht_find_next(set->ht, match, hash, (void **)&match)) {
+            if ((match->item == node) && (match->idx < i)) {
+                i = match->idx;
+            }
+        }
+        return i;
+    }
+
+    for (i = 0; i < set->number; i++) {
+        if (set->set.g[i] == node) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 API struct ly_set *
 ly_set_new(void)
 {
@@ -6967,6 +10251,7 @@ ly_set_free(struct ly_set *set)
         return;
     }
 
+    lyht_free(set->ht);
     free(set->set.g);
     free(set);
 }
@@ -6976,21 +10261,11 @@ ly_set_contains(const struct ly_set *set, void *node)
 {
     FUN_IN;
 
-    unsigned int i;
-
     if (!set) {
         return -1;
     }
 
-    for (i = 0; i < set->number; i++) {
-        if (set->set.g[i] == node) {
-            /* object found */
-            return i;
-        }
-    }
-
-    /* object not found */
-    return -1;
+    return ly_set_find(set, node);
 }
 
 API struct ly_set *
@@ -7012,6 +10287,9 @@ ly_set_dup(const struct ly_set *set)
     LY_CHECK_ERR_RETURN(!new->set.g, LOGMEM(NULL); free(new), NULL);
     memcpy(new->set.g, set->set.g, new->size * sizeof *(new->set.g));
 
+    /* the index is created again when needed */
+    new->ht = NULL;
+
     return new;
 }
 
@@ -7020,7 +10298,8 @@ ly_set_add(struct ly_set *set, void *node, int options)
 {
     FUN_IN;
 
-    unsigned int i;
+    int i;
+    unsigned int size;
     void **new;
 
     if (!set) {
@@ -7029,23 +10308,32 @@ ly_set_add(struct ly_set *set, void *node, int options)
     }
 
     if (!(options & LY_SET_OPT_USEASLIST)) {
+        if (!set->ht && (set->number >= LY_SET_INDEX_MIN) && ly_set_index(set)) {
+            return -1;
+        }
+
         /* search for duplication */
-        for (i = 0; i < set->number; i++) {
-            if (set->set.g[i] == node) {
-                /* already in set */
-                return i;
-            }
+        i = ly_set_find(set, node);
+        if (i > -1) {
+            /* already in set */
+            return i;
         }
     }
 
     if (set->size == set->number) {
-        new = realloc(set->set.g, (set->size + 8) * sizeof *(set->set.g));
+        size = set->size ? set->size * 2 : 8;
+        new = realloc(set->set.g, size * sizeof *(set->set.g));
         LY_CHECK_ERR_RETURN(!new, LOGMEM(NULL), -1);
-        set->size += 8;
+        set->size = size;
         set->set.g = new;
     }
 
     set->set.g[set->number++] = node;
+    if (set->ht && ly_set_index_add(set, set->number - 1)) {
+        set->number--;
+        LOGMEM(NULL);
+        return -1;
+    }
 
     return set->number - 1;
 }
@@ -7055,7 +10343,7 @@ ly_set_merge(struct ly_set *trg, struct ly_set *src, int options)
 {
     FUN_IN;
 
-    unsigned int i, ret;
+    unsigned int i, size, number;
     void **new;
 
     if (!trg) {
@@ -7067,34 +10355,26 @@ ly_set_merge(struct ly_set *trg, struct ly_set *src, int options)
         return 0;
     }
 
-    if (!(options & LY_SET_OPT_USEASLIST)) {
-        /* remove duplicates */
-        i = 0;
-        while (i < src->number) {
-            if (ly_set_contains(trg, src->set.g[i]) > -1) {
-                ly_set_rm_index(src, i);
-            } else {
-                ++i;
-            }
-        }
-    }
-
     /* allocate more memory if needed */
     if (trg->size < trg->number + src->number) {
-        new = realloc(trg->set.g, (trg->number + src->number) * sizeof *(trg->set.g));
+        for (size = trg->size ? trg->size : 8; size < trg->number + src->number; size *= 2);
+        new = realloc(trg->set.g, size * sizeof *(trg->set.g));
         LY_CHECK_ERR_RETURN(!new, LOGMEM(NULL), -1);
-        trg->size = trg->number + src->number;
+        trg->size = size;
         trg->set.g = new;
     }
 
-    /* copy contents from src into trg */
-    memcpy(trg->set.g + trg->number, src->set.g, src->number * sizeof *(src->set.g));
-    ret = src->number;
-    trg->number += ret;
+    /* add contents from src into trg */
+    number = trg->number;
+    for (i = 0; i < src->number; ++i) {
+        if (ly_set_add(trg, src->set.g[i], options) == -1) {
+            return -1;
+        }
+    }
 
     /* cleanup */
     ly_set_free(src);
-    return ret;
+    return trg->number - number;
 }
 
 API int
@@ -7102,11 +10382,19 @@ ly_set_rm_index(struct ly_set *set, unsigned int index)
 {
     FUN_IN;
 
+    struct ly_set_rec rec;
+
     if (!set || (index + 1) > set->number) {
         LOGARG;
         return EXIT_FAILURE;
     }
 
+    if (set->ht) {
+        rec.item = set->set.g[index];
+        rec.idx = index;
+        lyht_remove(set->ht, &rec, ly_set_hash(rec.item));
+    }
+
     if (index == set->number - 1) {
         /* removing last item in set */
         set->set.g[index] = NULL;
@@ -7114,6 +10402,14 @@ ly_set_rm_index(struct ly_set *set, unsigned int index)
         /* removing item somewhere in a middle, so put there the last item */
         set->set.g[index] = set->set.g[set->number - 1];
         set->set.g[set->number - 1] = NULL;
+
+        if (set->ht) {
+            /* update the index of the moved item */
+            rec.item = set->set.g[index];
+            rec.idx = set->number - 1;
+            lyht_remove(set->ht, &rec, ly_set_hash(rec.item));
+            ly_set_index_add(set, index);
+        }
     }
     set->number--;
 
@@ -7125,7 +10421,7 @@ ly_set_rm(struct ly_set *set, void *node)
 {
     FUN_IN;
 
-    unsigned int i;
+    int i;
 
     if (!set || !node) {
         LOGARG;
@@ -7133,12 +10429,8 @@ ly_set_rm(struct ly_set *set, void *node)
     }
 
     /* get index */
-    for (i = 0; i < set->number; i++) {
-        if (set->set.g[i] == node) {
-            break;
-        }
-    }
-    if (i == set->number) {
+    i = ly_set_find(set, node);
+    if (i == -1) {
         /* node is not in set */
         LOGARG;
         return EXIT_FAILURE;
@@ -7156,6 +10448,8 @@ ly_set_clean(struct ly_set *set)
         return EXIT_FAILURE;
     }
 
+    lyht_free(set->ht);
+    set->ht = NULL;
     set->number = 0;
     return EXIT_SUCCESS;
 }
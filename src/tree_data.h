@@ -172,6 +172,9 @@ struct lyd_attr {
  *
  * To traverse all the child elements or attributes, use #LY_TREE_FOR or #LY_TREE_FOR_SAFE macro. To traverse
  * the whole subtree, use #LY_TREE_DFS_BEGIN macro.
+ *
+ * The data nodes are always allocated by libyang. The internal members #pos_idx and #content_hash were appended
+ * in SO version 1.10, which changed the size of the structure but kept the offsets of all the other members.
  */
 struct lyd_node {
     struct lys_node *schema;         /**< pointer to the schema definition of this node */
@@ -179,6 +182,8 @@ struct lyd_node {
     uint8_t dflt:1;                  /**< flag for implicit default node */
     uint8_t when_status:3;           /**< bit for checking if the when-stmt condition is resolved - internal use only,
                                           do not use this value! */
+    uint8_t arena:1;                 /**< flag for a node allocated from the arena of its data tree (#LYD_OPT_ARENA) -
+                                          internal use only, do not use this value! */
 
     struct lyd_attr *attr;           /**< pointer to the list of attributes of this node */
     struct lyd_node *next;           /**< pointer to the next sibling node (NULL if there is no one) */
@@ -202,6 +207,12 @@ struct lyd_node {
                                           is replaced in those structures. Therefore, be careful with accessing
                                           this member without having information about the node type from the schema's
                                           ::lys_node#nodetype member. */
+#ifdef LY_ENABLED_CACHE
+    struct lyd_pos_idx *pos_idx;     /**< position indexes of large lists and leaf-lists among the children -
+                                          internal use only, do not use this value! */
+    uint64_t content_hash;           /**< cached hash of the whole subtree content (see lyd_subtree_hash()), 0 if not
+                                          known - internal use only, do not use this value! */
+#endif
 };
 
 /**
@@ -221,6 +232,8 @@ struct lyd_node_leaf_list {
     uint8_t dflt:1;                  /**< flag for implicit default node */
     uint8_t when_status:3;           /**< bit for checking if the when-stmt condition is resolved - internal use only,
                                           do not use this value! */
+    uint8_t arena:1;                 /**< flag for a node allocated from the arena of its data tree (#LYD_OPT_ARENA) -
+                                          internal use only, do not use this value! */
 
     struct lyd_attr *attr;           /**< pointer to the list of attributes of this node */
     struct lyd_node *next;           /**< pointer to the next sibling node (NULL if there is no one) */
@@ -282,6 +295,8 @@ struct lyd_node_anydata {
     uint8_t dflt:1;                  /**< flag for implicit default node */
     uint8_t when_status:3;           /**< bit for checking if the when-stmt condition is resolved - internal use only,
                                           do not use this value! */
+    uint8_t arena:1;                 /**< flag for a node allocated from the arena of its data tree (#LYD_OPT_ARENA) -
+                                          internal use only, do not use this value! */
 
     struct lyd_attr *attr;           /**< pointer to the list of attributes of this node */
     struct lyd_node *next;           /**< pointer to the next sibling node (NULL if there is no one) */
@@ -435,6 +450,40 @@ struct lyd_difflist *lyd_diff(struct lyd_node *first, struct lyd_node *second, i
                                              explicit default nodes. */
 /**@} diffoptions */
 
+/**
+ * @brief Get the hash of the content of a data subtree.
+ *
+ * The hash covers the module and name of every node in the subtree, the values of all the terminal nodes (including
+ * anydata/anyxml) and the default flags. It does not cover the attributes. The order of the nodes is significant
+ * (not only of the user-ordered instances), which is always the case for the validated data trees of the same schemas.
+ *
+ * With the data tree cache enabled, the hashes of all the inner nodes of the subtree are cached and stay valid until
+ * the subtree is modified, so getting the hash of a subtree that was modified only partially recomputes only the hashes
+ * of the modified nodes and their parents. Since the hashes are stored in the nodes, calling this function is considered
+ * a modification of the data tree when accessing it in multiple threads. Note that modifying a data tree stored
+ * in an anydata node does not invalidate the cached hashes of its parents.
+ *
+ * lyd_diff() uses the cached hashes to skip comparing the children of the inner nodes with the same hash in both trees,
+ * after confirming the subtrees are equal by a plain comparison, which is much cheaper than matching their children.
+ *
+ * @param[in] node Root of the subtree.
+ * @return Hash of the subtree, never 0. 0 if \p node is NULL.
+ */
+uint64_t lyd_subtree_hash(const struct lyd_node *node);
+
+/**
+ * @brief Learn whether two data subtrees have the same content, by comparing their hashes (see lyd_subtree_hash()).
+ *
+ * The subtrees can belong to different contexts. With the cached hashes, the check takes a constant time
+ * for unmodified different subtrees. The same hashes are confirmed by comparing the subtrees so that a hash
+ * collision never makes different subtrees equal.
+ *
+ * @param[in] node1 Root of the first subtree.
+ * @param[in] node2 Root of the second subtree.
+ * @return 1 if the subtrees are equal, 0 if not.
+ */
+int lyd_subtree_equal(const struct lyd_node *node1, const struct lyd_node *node2);
+
 /**
  * @brief Build data path (usable as path, see @ref howtoxpath) of the data node.
  * @param[in] node Data node to be processed. Note that the node should be from a complete data tree, having a subtree
@@ -537,6 +586,11 @@ char *lyd_path(const struct lyd_node *node);
 #define LYD_OPT_VAL_DIFF 0x40000 /**< Flag only for validation, store all the data node changes performed by the validation
                                       in a diff structure. */
 #define LYD_OPT_LYB_MOD_UPDATE 0x80000 /**< Allow to parse data using an updated revision of a module, relevant only for LYB format. */
+#define LYD_OPT_ARENA 0x100000 /**< Allocate the parsed data nodes and their attributes from bump-allocated memory slabs
+                                    shared by the whole tree instead of allocating each of them separately. The slabs are
+                                    released once all the nodes allocated from them are freed, so the tree can be
+                                    manipulated as any other tree. Suitable for large trees that are parsed, processed
+                                    and freed as a whole. */
 #define LYD_OPT_DATA_TEMPLATE 0x1000000 /**< Data represents YANG data template. */
 
 /**@} parseroptions */
@@ -590,7 +644,8 @@ struct lyd_node *lyd_parse_mem(struct ly_ctx *ctx, const char *data, LYD_FORMAT
  * This behavior can be changed by #LYD_OPT_NOSIBLINGS option.
  *
  * @param[in] ctx Context to connect with the data tree being built here.
- * @param[in] fd The standard file descriptor of the file containing the data tree in the specified format.
+ * @param[in] fd The file descriptor of the file containing the data tree in the specified format. Descriptors that
+ *               cannot be mapped into memory (pipes, sockets) are read until EOF as the data arrive.
  * @param[in] format Format of the input data to be parsed.
  * @param[in] options Parser options, see @ref parseroptions.
  * @param[in] ... Variable arguments depend on \p options. If they include:
@@ -657,6 +712,34 @@ struct lyd_node *lyd_parse_fd(struct ly_ctx *ctx, int fd, LYD_FORMAT format, int
  */
 struct lyd_node *lyd_parse_path(struct ly_ctx *ctx, const char *path, LYD_FORMAT format, int options, ...);
 
+/**
+ * @brief Parse (and validate) data from memory using several threads.
+ *
+ * The data are split at the boundaries of top-level siblings (XML root elements or members of the top-level
+ * JSON object) into parts that are parsed concurrently, each by one of the threads. Afterwards, the parsed
+ * top-level siblings are connected and the validation requiring the whole data tree (uniqueness of the top-level
+ * nodes, references, defaults, mandatory nodes) is performed in the calling thread. The result is the same
+ * as with lyd_parse_mem(), only the order of the error messages may differ if there are more errors in the data.
+ *
+ * Parallel parsing makes sense only for large data with many top-level siblings, for small data, data
+ * with a single top-level node, or JSON data with top-level metadata not adjacent to their nodes the function
+ * falls back to lyd_parse_mem(). Note that the logging callback
+ * and the callbacks of the data (user types, extensions) may be called from the worker threads.
+ *
+ * @param[in] ctx Context to connect with the data tree being built here. It must not be changed
+ *            while the data are being parsed.
+ * @param[in] data Serialized data in the specified format.
+ * @param[in] format Format of the input data to be parsed, #LYD_XML and #LYD_JSON can be parsed in parallel.
+ * @param[in] options Parser options, see @ref parseroptions. Only the data tree options (#LYD_OPT_DATA,
+ *            #LYD_OPT_CONFIG, #LYD_OPT_GET, #LYD_OPT_GETCONFIG, #LYD_OPT_EDIT) are supported and #LYD_OPT_DESTRUCT,
+ *            #LYD_OPT_NOSIBLINGS and #LYD_OPT_VAL_DIFF are not allowed.
+ * @param[in] threads Maximal number of threads to use including the calling thread, 1 means no parallelism.
+ * @return Pointer to the built data tree or NULL in case of empty \p data. To free the returned structure,
+ *         use lyd_free(). In these cases, the function sets #ly_errno to LY_SUCCESS. In case of error,
+ *         #ly_errno contains appropriate error code (see #LY_ERR).
+ */
+struct lyd_node *lyd_parse_mem_parallel(struct ly_ctx *ctx, const char *data, LYD_FORMAT format, int options, int threads);
+
 /**
  * @brief Parse (and validate) XML tree.
  *
@@ -705,6 +788,75 @@ struct lyd_node *lyd_parse_path(struct ly_ctx *ctx, const char *path, LYD_FORMAT
  */
 struct lyd_node *lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options,...);
 
+/**
+ * @defgroup parseclbret Return values of the node_open callback of ::lyd_parse_clb
+ * @ingroup datatree
+ * @{
+ */
+#define LYD_PARSE_CLB_CONTINUE 0 /**< Report the children of the node by the callbacks and close the node by node_close. */
+#define LYD_PARSE_CLB_SUBTREE 1  /**< Parse the whole node with its children into a data subtree and pass it to the
+                                      subtree callback, node_close is not called. */
+#define LYD_PARSE_CLB_SKIP 2     /**< Skip the node with all its children, node_close is not called. */
+/**@} parseclbret */
+
+/**
+ * @brief Callbacks of lyd_parse_mem_clb() and lyd_parse_fd_clb() called for the data being parsed instead of
+ * building a data tree. Any callback can be NULL and any negative value returned by a callback stops the parsing.
+ */
+struct lyd_parse_clb {
+    int (*node_open)(const struct lys_node *schema, void *data);  /**< an inner node (container, list instance,
+                                                                        RPC, action, notification) starts, the return
+                                                                        value decides how its content is processed,
+                                                                        see @ref parseclbret */
+    int (*leaf_value)(const struct lyd_node_leaf_list *leaf, void *data); /**< a leaf or a leaf-list instance was
+                                                                        parsed, \p leaf is a temporary node with no
+                                                                        parent holding the parsed value, it is freed
+                                                                        once the callback returns */
+    int (*node_close)(const struct lys_node *schema, void *data); /**< all the children of an inner node were
+                                                                        reported */
+    int (*subtree)(struct lyd_node *node, void *data); /**< a subtree selected by #LYD_PARSE_CLB_SUBTREE or an anydata
+                                                            or anyxml node was parsed, \p node has no parent and it is
+                                                            taken over by the callback (it is expected to free it),
+                                                            if the callback is not set, the node is freed */
+    void *data;                                        /**< arbitrary data passed to the callbacks */
+};
+
+/**
+ * @brief Parse data from a string in memory passing the parsed nodes to the callbacks instead of building
+ * a data tree.
+ *
+ * The data are parsed sequentially and every node is freed once it is reported so the memory needed does not depend
+ * on the size of the data, only on the depth of the data and the size of the subtrees requested by the callbacks.
+ * Leaves and leaf-lists are reported with their parsed values as any node parsed by lyd_parse_mem(), but the data
+ * are not validated as a whole - there are no checks requiring other data nodes (leafref and instance-identifier
+ * targets, "when" and "must" conditions, mandatory nodes, instance counts and duplicates). The same applies to
+ * the passed subtrees, unresolved leafrefs are marked by #LY_VALUE_UNRES. Metadata are available only in case of
+ * XML data (in the attributes of the nodes).
+ *
+ * @param[in] ctx Context with the schemas of the data.
+ * @param[in] data Serialized data in the specified format.
+ * @param[in] format Format of the input data, only #LYD_XML and #LYD_JSON are supported.
+ * @param[in] options Parser options, see @ref parseroptions. #LYD_OPT_RPCREPLY, #LYD_OPT_DATA_TEMPLATE,
+ *            #LYD_OPT_DATA_ADD_YANGLIB, #LYD_OPT_DESTRUCT, #LYD_OPT_VAL_DIFF and #LYD_OPT_ARENA are not supported.
+ * @param[in] clb Callbacks to call for the parsed nodes.
+ * @return 0 on success, 1 on error (including the parsing stopped by a callback).
+ */
+int lyd_parse_mem_clb(struct ly_ctx *ctx, const char *data, LYD_FORMAT format, int options,
+                      const struct lyd_parse_clb *clb);
+
+/**
+ * @brief Parse data from a file descriptor passing the parsed nodes to the callbacks instead of building
+ * a data tree, see lyd_parse_mem_clb().
+ *
+ * @param[in] ctx Context with the schemas of the data.
+ * @param[in] fd The file descriptor with the data in the specified format.
+ * @param[in] format Format of the input data, only #LYD_XML and #LYD_JSON are supported.
+ * @param[in] options Parser options, see lyd_parse_mem_clb().
+ * @param[in] clb Callbacks to call for the parsed nodes.
+ * @return 0 on success, 1 on error (including the parsing stopped by a callback).
+ */
+int lyd_parse_fd_clb(struct ly_ctx *ctx, int fd, LYD_FORMAT format, int options, const struct lyd_parse_clb *clb);
+
 /**
  * @brief Create a new container node in a data tree.
  *
@@ -893,6 +1045,66 @@ struct lyd_node *lyd_new_yangdata(const struct lys_module *module, const char *n
 struct lyd_node *lyd_new_path(struct lyd_node *data_tree, const struct ly_ctx *ctx, const char *path, void *value,
                               LYD_ANYDATA_VALUETYPE value_type, int options);
 
+/**
+ * @struct lyd_path_tmpl
+ * @brief Compiled data path template, see lyd_path_tmpl_compile().
+ */
+struct lyd_path_tmpl;
+
+/**
+ * @brief Compile a data path template for creating data nodes repeatedly with lyd_path_tmpl_new().
+ *
+ * The schema nodes of the path are resolved only once and so are the values specified in the template.
+ * The path syntax is the same as for lyd_new_path() with absolute \p path, but the value of any list key
+ * or leaf-list predicate can be the placeholder `?` (without quotes) filled in lyd_path_tmpl_new().
+ * All list predicates must include all the keys and no positional predicates are allowed,
+ * for example `/mod:interfaces/interface[name=?]/statistics/in-octets`. The path cannot point
+ * to anydata or anyxml nodes and cannot include yang-data templates.
+ *
+ * The template is valid as long as the schemas in \p ctx are not changed.
+ *
+ * @param[in] ctx Context to use.
+ * @param[in] path Path template.
+ * @param[in] options Bitmask of options flags, only #LYD_PATH_OPT_OUTPUT is used.
+ * @return Compiled template, NULL on error.
+ */
+struct lyd_path_tmpl *lyd_path_tmpl_compile(struct ly_ctx *ctx, const char *path, int options);
+
+/**
+ * @brief Get the number of placeholders in a data path template.
+ *
+ * @param[in] tmpl Compiled template.
+ * @return Number of values expected by lyd_path_tmpl_new().
+ */
+unsigned int lyd_path_tmpl_placeholder_count(const struct lyd_path_tmpl *tmpl);
+
+/**
+ * @brief Create a new data node based on a compiled data path template.
+ *
+ * __PARTIAL CHANGE__ - validate after the final change on the data tree (see @ref howtodatamanipulators).
+ *
+ * Behaves the same as lyd_new_path() with the template path after filling its placeholders with \p values.
+ *
+ * @param[in] data_tree Existing data tree to add to/modify (including siblings), can be NULL.
+ * @param[in] tmpl Compiled template from the context of \p data_tree.
+ * @param[in] values Values of all the placeholders of \p tmpl, in the order they appear in the template path.
+ * @param[in] value Value of the new leaf/leaf-list.
+ * @param[in] options Bitmask of options flags, see @ref pathoptions. #LYD_PATH_OPT_OUTPUT is ignored,
+ * it must be used when compiling \p tmpl.
+ * @return First created (or updated with #LYD_PATH_OPT_UPDATE) node,
+ * NULL if #LYD_PATH_OPT_UPDATE was used and the full path exists or the leaf original value matches \p value,
+ * NULL and ly_errno is set on error.
+ */
+struct lyd_node *lyd_path_tmpl_new(struct lyd_node *data_tree, const struct lyd_path_tmpl *tmpl, const char **values,
+                                   const char *value, int options);
+
+/**
+ * @brief Free a compiled data path template.
+ *
+ * @param[in] tmpl Template to free, can be NULL.
+ */
+void lyd_path_tmpl_free(struct lyd_path_tmpl *tmpl);
+
 /**
  * @brief Learn the relative instance position of a list or leaf-list within other instances of the
  * same schema node.
@@ -902,6 +1114,23 @@ struct lyd_node *lyd_new_path(struct lyd_node *data_tree, const struct ly_ctx *c
  */
 unsigned int lyd_list_pos(const struct lyd_node *node);
 
+/**
+ * @brief Get the instance of a list or leaf-list on a specific position within other instances of the
+ * same schema node.
+ *
+ * Positions of many instances of the same parent are indexed so that getting the position of an instance
+ * (lyd_list_pos()) as well as an instance on a position takes logarithmic time. The index is created when
+ * parsing the data or when inserting an instance makes the list large and is maintained by lyd_insert_before(),
+ * lyd_unlink(), and other functions modifying the siblings. Neither function modifies the tree, without an index
+ * they walk the siblings.
+ *
+ * @param[in] siblings Siblings of the instance (any of them).
+ * @param[in] schema List or leaf-list schema node of the instance.
+ * @param[in] pos Position of the instance, starting from 1.
+ * @return Found instance, NULL if there are fewer instances or on error.
+ */
+struct lyd_node *lyd_list_nth(const struct lyd_node *siblings, const struct lys_node *schema, unsigned int pos);
+
 /**
  * @defgroup dupoptions Data duplication options
  * @ingroup datatree
@@ -966,6 +1195,109 @@ struct lyd_node *lyd_dup_withsiblings(const struct lyd_node *node, int options);
  */
 struct lyd_node *lyd_dup_to_ctx(const struct lyd_node *node, int options, struct ly_ctx *ctx);
 
+/**
+ * @brief Read-only, reference counted version of a data tree (such as a datastore content),
+ * see @ref howtodatasnapshots.
+ */
+struct lyd_snapshot;
+
+/**
+ * @brief Make a snapshot from a data tree.
+ *
+ * The snapshot takes over the whole data tree (all the top-level siblings of \p node), which must not be
+ * modified or freed directly anymore. All the cached data of the tree are prepared, so the snapshot can be read
+ * (including lyd_diff() or lyd_snapshot_dup()) by any number of threads at once. The data tree should be
+ * validated, otherwise even validation would modify it.
+ *
+ * @param[in] node Top-level node of the data tree.
+ * @return New snapshot with a single reference, NULL on error.
+ */
+struct lyd_snapshot *lyd_snapshot(struct lyd_node *node);
+
+/**
+ * @brief Get the data tree of a snapshot.
+ *
+ * @param[in] snap Snapshot to use.
+ * @return First top-level sibling of the data tree, it must not be modified.
+ */
+struct lyd_node *lyd_snapshot_data(const struct lyd_snapshot *snap);
+
+/**
+ * @brief Add a reference to a snapshot.
+ *
+ * @param[in] snap Snapshot to reference.
+ * @return \p snap.
+ */
+struct lyd_snapshot *lyd_snapshot_ref(struct lyd_snapshot *snap);
+
+/**
+ * @brief Release a reference of a snapshot, the snapshot and its data tree are freed with the last one.
+ *
+ * @param[in] snap Snapshot to release, can be NULL.
+ */
+void lyd_snapshot_free(struct lyd_snapshot *snap);
+
+/**
+ * @brief Create a modifiable copy of the data tree of a snapshot.
+ *
+ * The copy is made faster than by lyd_dup_withsiblings(). All the node hashes including the
+ * cached subtree hashes (see lyd_subtree_hash()) are copied instead of being computed again and the nodes
+ * are allocated from memory slabs of the copy (the same way as with #LYD_OPT_ARENA). Since the hashes
+ * of the unmodified subtrees stay cached, lyd_diff() of the snapshot and the modified copy
+ * descends only into the modified subtrees.
+ *
+ * @param[in] snap Snapshot to copy.
+ * @return Copy of the snapshot data tree, NULL on error.
+ */
+struct lyd_node *lyd_snapshot_dup(const struct lyd_snapshot *snap);
+
+/**
+ * @brief Journal of the changes of a data tree, see @ref howtodatajournal.
+ */
+struct lyd_journal;
+
+/**
+ * @brief Start recording the changes of a data tree.
+ *
+ * All the following changes made by the \b lyd_new*(), lyd_change_leaf(), \b lyd_insert*(), lyd_unlink(),
+ * lyd_free*(), lyd_merge() and lyd_validate() functions are recorded, including the top-level nodes added to or removed
+ * from the tree. A data tree can have only a single journal.
+ *
+ * @param[in] node Any node of the data tree.
+ * @return New journal, NULL on error.
+ */
+struct lyd_journal *lyd_journal_new(struct lyd_node *node);
+
+/**
+ * @brief Get the changes recorded by a journal.
+ *
+ * The result has the same form as the lyd_diff() result (without #LYD_DIFFOPT_WITHDEFAULTS) of the data tree
+ * when the recording started and the current data tree, except that:
+ * - the current data tree is used as the second tree and also as the first tree for the nodes that exist in both,
+ * - the deleted nodes and the previous values of the changed nodes are copies (with all their parents) owned
+ *   by the journal,
+ * - a deleted subtree is recorded with its content from the time it was removed.
+ *
+ * @param[in] journal Journal to use.
+ * @return List of the changes to be freed by lyd_free_diff(), valid only until the data tree is modified or
+ * the journal cleared or freed. NULL on error.
+ */
+struct lyd_difflist *lyd_journal_diff(struct lyd_journal *journal);
+
+/**
+ * @brief Forget all the recorded changes and continue recording from the current state of the data tree.
+ *
+ * @param[in] journal Journal to clear.
+ */
+void lyd_journal_clear(struct lyd_journal *journal);
+
+/**
+ * @brief Stop recording and free a journal. It must be freed before the context of its data tree.
+ *
+ * @param[in] journal Journal to free, can be NULL.
+ */
+void lyd_journal_free(struct lyd_journal *journal);
+
 /**
  * @brief Merge a (sub)tree into a data tree.
  *
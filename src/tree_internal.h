@@ -153,6 +153,44 @@ int lyb_has_schema_model(struct lys_node *sibling, const struct lys_module **mod
  */
 #define LY_VALUE_UNRESGRP 0x80
 
+/**
+ * @brief Value flag of an attribute allocated from the arena of its data tree (#LYD_OPT_ARENA).
+ */
+#define LY_VALUE_ARENA 0x40
+
+/**
+ * @brief Minimum number of objects in a set for it to create an index of them, must be power of 2.
+ */
+#define LY_SET_INDEX_MIN 32
+
+/**
+ * @brief Maximum number of list keys of the list instances searched for directly by lyd_find_path()
+ * or created by lyd_path_tmpl_new().
+ */
+#define LYD_LOOKUP_MAX_VALS 8
+
+/**
+ * @brief Step of a compiled data path template.
+ */
+struct lyd_path_tmpl_step {
+    const struct lys_node *schema;          /**< data node of the step */
+    uint32_t hash;                          /**< hash of the schema node all the instance hashes start with */
+    uint8_t val_count;                      /**< number of list key values or 1 for a leaf-list value predicate */
+    uint8_t canonize;                       /**< bitmask of the placeholder values that need to be canonized */
+    const char *vals[LYD_LOOKUP_MAX_VALS];  /**< canonical values in the dictionary, NULL for placeholders */
+};
+
+/**
+ * @brief Compiled data path template.
+ */
+struct lyd_path_tmpl {
+    struct ly_ctx *ctx;                     /**< context of the schema nodes */
+    const char *path;                       /**< template path in the dictionary */
+    uint16_t step_count;                    /**< number of steps */
+    uint16_t placeholder_count;             /**< number of placeholders in all the steps */
+    struct lyd_path_tmpl_step *steps;       /**< steps from the top-level node to the target node */
+};
+
 #ifdef LY_ENABLED_CACHE
 
 /**
@@ -160,11 +198,62 @@ int lyb_has_schema_model(struct lys_node *sibling, const struct lys_module **mod
  */
 #   define LY_CACHE_HT_MIN_CHILDREN 4
 
+/**
+ * @brief Minimum number of adjacent list or leaf-list instances of a parent for it to create a position index
+ * of all the instances, when an instance is inserted or the data tree is parsed.
+ */
+#   define LYD_POS_IDX_MIN 64
+
+/**
+ * @brief Number of instances in a block of a position index when it is created, blocks twice
+ * this size are split.
+ */
+#   define LYD_POS_BLOCK_SIZE 64
+
+/**
+ * @brief Block of consecutive instances in a position index.
+ */
+struct lyd_pos_block {
+    struct lyd_node *first;          /**< first instance in the block */
+    uint32_t count;                  /**< number of instances in the block */
+    uint32_t idx;                    /**< index of the block in the blocks of the position index */
+};
+
+/**
+ * @brief Position index of the instances of a list or leaf-list of a parent. The instances are split
+ * into blocks whose instance counts are kept in a Fenwick tree so that both the position of an instance
+ * and the instance on a position can be learned in logarithmic time.
+ */
+struct lyd_pos_idx {
+    const struct lys_node *schema;   /**< list or leaf-list of the instances */
+    struct lyd_pos_block **blocks;   /**< blocks of the instances in their order */
+    uint32_t *tree;                  /**< Fenwick tree of the block instance counts */
+    uint32_t count;                  /**< number of blocks */
+    uint32_t size;                   /**< allocated number of blocks and Fenwick tree items */
+    struct hash_table *ht;           /**< block of every instance */
+    struct lyd_pos_idx *next;        /**< position index of other instances of the same parent */
+};
+
     int lyd_hash(struct lyd_node *node);
 
     void lyd_insert_hash(struct lyd_node *node);
 
     void lyd_unlink_hash(struct lyd_node *node, struct lyd_node *orig_parent);
+
+/**
+ * @brief Invalidate the cached content hashes (see lyd_subtree_hash()) of a modified node and all its parents.
+ *
+ * @param[in] node Modified node, its own content or a child changed.
+ */
+    void lyd_content_hash_invalidate(struct lyd_node *node);
+
+/**
+ * @brief Create the position indexes of all the large lists and leaf-lists in a parsed data tree,
+ * whose instances were not inserted by the functions maintaining the indexes.
+ *
+ * @param[in] root First top-level sibling of the data tree.
+ */
+    void lyd_pos_idx_tree(struct lyd_node *root);
 #endif
 
 /**
@@ -182,10 +271,8 @@ struct lys_submodule *lys_sub_parse_mem(struct lys_module *module, const char *d
 /**
  * @brief Create submodule structure by reading data from file descriptor.
  *
- * \note Current implementation supports only reading data from standard (disk) file, not from sockets, pipes, etc.
- *
  * @param[in] module Schema tree where to connect the submodule, belongs-to value must match.
- * @param[in] fd File descriptor of a regular file (e.g. sockets are not supported) containing the submodule
+ * @param[in] fd File descriptor (a regular file, pipe or socket) containing the submodule
  *            specification in the given \p format.
  * @param[in] format Format of the data to read.
  * @param[in] unres list of unresolved items
@@ -423,6 +510,28 @@ const struct lyd_node *lyd_attr_parent(const struct lyd_node *root, struct lyd_a
  */
 int lyd_unlink_internal(struct lyd_node *node, int permanent);
 
+/**
+ * @brief Record a node linked into a data tree in the tree journal, if any (see lyd_journal_new()).
+ *
+ * @param[in] node Inserted node, already linked.
+ * @param[in] moved Whether the node was only moved among its siblings.
+ */
+void lyd_journal_insert(struct lyd_node *node, int moved);
+
+/**
+ * @brief Record a node permanently unlinked from a data tree in the tree journal, if any.
+ *
+ * @param[in] node Node to be unlinked, still linked.
+ */
+void lyd_journal_unlink(struct lyd_node *node);
+
+/**
+ * @brief Record a leaf or anydata node whose value is going to be changed in the tree journal, if any.
+ *
+ * @param[in] node Node to be changed, still with its previous value.
+ */
+void lyd_journal_change(struct lyd_node *node);
+
 /**
  * @brief Get the canonical value.
  *
@@ -483,6 +592,57 @@ int lys_get_sibling(const struct lys_node *siblings, const char *mod_name, int m
 int lys_getnext_data(const struct lys_module *mod, const struct lys_node *parent, const char *name, int nam_len,
                      LYS_NODE type, int getnext_opts, const struct lys_node **ret);
 
+/**
+ * @brief Minimum number of data children (with choices, cases and uses being transparent) of a schema node
+ * for creating their index in the context.
+ */
+#define LYS_CHILD_INDEX_MIN 8
+
+/**
+ * @brief Number of child lookups of a schema node since the last schema change before creating the index
+ * of its children, so that the indexes are not created repeatedly while the schema is being built.
+ */
+#define LYS_CHILD_INDEX_LOOKUPS 4
+
+/**
+ * @brief Find a data schema node by name among the children of a schema node the same way lys_getnext()
+ * iterates them, so choices, cases and uses are transparent. Children of wider schema nodes are found
+ * in their index. Does not log.
+ *
+ * @param[in] parent Parent of the node, NULL for a top-level node.
+ * @param[in] module Module of the top-level node, must be set if \p parent is NULL.
+ * @param[in] mod_name Name of the main module of the node, NULL for any.
+ * @param[in] mod_ns Namespace of the main module of the node, NULL for any.
+ * @param[in] name Node name.
+ * @param[in] nam_len Node \p name length.
+ * @param[in] options lys_getnext() options, the index is used only for 0 and #LYS_GETNEXT_NOSTATECHECK.
+ * @return Found node, NULL if there is none.
+ */
+const struct lys_node *lys_child_find(const struct lys_node *parent, const struct lys_module *module, const char *mod_name,
+                                      const char *mod_ns, const char *name, int nam_len, int options);
+
+/**
+ * @brief Find a data schema node by its LYB hash among the children of a schema node, see lys_child_find().
+ *
+ * @param[in] parent Parent of the node, NULL for a top-level node.
+ * @param[in] module Module of the top-level node, must be set if \p parent is NULL.
+ * @param[in] hash LYB hash of the node with collision ID 0.
+ * @param[in] match Callback deciding whether a node with the matching \p hash is the one.
+ * @param[in] match_data Arbitrary data for \p match.
+ * @param[in] options lys_getnext() options, the index is used only for 0 and #LYS_GETNEXT_NOSTATECHECK.
+ * @return Found node, NULL if there is none.
+ */
+const struct lys_node *lys_child_find_lyb(const struct lys_node *parent, const struct lys_module *module, LYB_HASH hash,
+                                          int (*match)(const struct lys_node *node, void *data), void *match_data,
+                                          int options);
+
+/**
+ * @brief Drop all the schema child indexes of a context, must be called whenever the schema trees change.
+ *
+ * @param[in] ctx Context of the changed schema.
+ */
+void lys_child_index_clear(struct ly_ctx *ctx);
+
 int lyd_get_unique_default(const char* unique_expr, struct lyd_node *list, const char **dflt);
 
 int lyd_build_relative_data_path(const struct lys_module *module, const struct lyd_node *node, const char *schema_id,
@@ -493,6 +653,62 @@ void lyd_free_value(lyd_val value, LY_DATA_TYPE value_type, uint8_t value_flags,
 
 int lyd_list_equal(struct lyd_node *node1, struct lyd_node *node2, int with_defaults);
 
+/**
+ * @brief Create a new arena for allocating data nodes and attributes (#LYD_OPT_ARENA).
+ *
+ * The arena holds a reference for its creator, which must be released by lyd_arena_release().
+ * The memory is freed once the creator and all the objects allocated from the arena release it.
+ *
+ * @return New arena, NULL on error.
+ */
+struct lyd_arena *lyd_arena_new(void);
+
+/**
+ * @brief Release one reference of an arena, free it if it was the last one.
+ *
+ * @param[in] arena Arena to release, can be NULL.
+ */
+void lyd_arena_release(struct lyd_arena *arena);
+
+/**
+ * @brief Allocate a zeroed data node.
+ *
+ * @param[in] arena Arena to allocate from, NULL for standard allocation.
+ * @param[in] size Size of the specific data node structure.
+ * @return Allocated node, NULL on error.
+ */
+void *lyd_node_calloc(struct lyd_arena *arena, size_t size);
+
+/**
+ * @brief Allocate a zeroed attribute, from the arena of its parent if it has one.
+ *
+ * @param[in] parent Data node of the attribute, can be NULL.
+ * @return Allocated attribute, NULL on error.
+ */
+struct lyd_attr *lyd_attr_calloc(const struct lyd_node *parent);
+
+/**
+ * @brief Get the arena a data node was allocated from.
+ *
+ * @param[in] node Data node.
+ * @return Arena of \p node, NULL if not allocated from any.
+ */
+struct lyd_arena *lyd_node_arena(const struct lyd_node *node);
+
+/**
+ * @brief Free the memory of a data node allocated by lyd_node_calloc().
+ *
+ * @param[in] node Data node to free, its content must already be freed.
+ */
+void lyd_node_mem_free(struct lyd_node *node);
+
+/**
+ * @brief Free the memory of an attribute allocated by lyd_attr_calloc().
+ *
+ * @param[in] attr Attribute to free, its content must already be freed.
+ */
+void lyd_attr_mem_free(struct lyd_attr *attr);
+
 int lys_make_implemented_r(struct lys_module *module, struct unres_schema *unres);
 
 /**
@@ -223,6 +223,357 @@ lys_get_sibling(const struct lys_node *siblings, const char *mod_name, int mod_n
     return EXIT_FAILURE;
 }
 
+/**
+ * @brief Index of the data children of a schema node (or the top-level nodes of a module) stored in the context.
+ */
+struct lys_child_index {
+    const void *parent;             /**< schema node or module with the indexed children */
+    uint32_t lookups;               /**< number of lookups before the index was created,
+                                         0 if there are too few children to index them */
+    struct hash_table *names;       /**< children by their name */
+    struct hash_table *lyb;         /**< children by their LYB hash with collision ID 0 */
+};
+
+/**
+ * @brief Key of a child lookup, either by name and module or by LYB hash.
+ */
+struct lys_child_key {
+    const char *name;
+    int nam_len;
+    const char *mod_name;           /**< name of the main module of the child, NULL for any */
+    const char *mod_ns;             /**< namespace of the main module of the child, NULL for any */
+    int (*match)(const struct lys_node *node, void *data);  /**< LYB hash match callback */
+    void *match_data;
+    const struct lys_node *parent;  /**< parent of the children */
+    int options;                    /**< lys_getnext() options */
+};
+
+/**
+ * @brief Check whether a child is disabled by if-features the same way lys_getnext() does, also the schema-only
+ * nodes between the child and its \p parent are checked.
+ */
+static int
+lys_child_disabled(const struct lys_node *node, const struct lys_node *parent)
+{
+    do {
+        if (lys_is_disabled(node, 0)) {
+            return 1;
+        }
+        node = lys_parent(node);
+    } while (node && (node != parent) && (node->nodetype & (LYS_CHOICE | LYS_CASE | LYS_USES)));
+
+    return 0;
+}
+
+static int
+lys_child_index_equal(void *val1_p, void *val2_p, int UNUSED(mod), void *UNUSED(cb_data))
+{
+    return ((struct lys_child_index *)val1_p)->parent == ((struct lys_child_index *)val2_p)->parent;
+}
+
+static uint32_t
+lys_child_index_hash(const void *parent)
+{
+    return dict_hash_multi(dict_hash_multi(0, (const char *)&parent, sizeof parent), NULL, sizeof parent);
+}
+
+/**
+ * @brief Hash table callback for the children by name. Values are always compared
+ * when modifying the index, otherwise \p val1_p is the lookup key.
+ */
+static int
+lys_child_name_equal(void *val1_p, void *val2_p, int mod, void *UNUSED(cb_data))
+{
+    struct lys_child_key *key;
+    const struct lys_node *node = *(struct lys_node **)val2_p;
+    const struct lys_module *node_mod;
+
+    if (mod) {
+        return *(struct lys_node **)val1_p == node;
+    }
+
+    key = val1_p;
+    if (strncmp(node->name, key->name, key->nam_len) || node->name[key->nam_len]) {
+        return 0;
+    }
+    node_mod = lys_node_module(node);
+    if ((key->mod_name && strcmp(node_mod->name, key->mod_name)) || (key->mod_ns && strcmp(node_mod->ns, key->mod_ns))) {
+        return 0;
+    }
+    return (key->options & LYS_GETNEXT_NOSTATECHECK) || !lys_child_disabled(node, key->parent);
+}
+
+/**
+ * @brief Hash table callback for the children by LYB hash, see lys_child_name_equal().
+ */
+static int
+lys_child_lyb_equal(void *val1_p, void *val2_p, int mod, void *UNUSED(cb_data))
+{
+    struct lys_child_key *key;
+    const struct lys_node *node = *(struct lys_node **)val2_p;
+
+    if (mod) {
+        return *(struct lys_node **)val1_p == node;
+    }
+
+    key = val1_p;
+    if (!(key->options & LYS_GETNEXT_NOSTATECHECK) && lys_child_disabled(node, key->parent)) {
+        return 0;
+    }
+    return key->match(node, key->match_data);
+}
+
+static uint32_t
+lys_child_name_hash(const char *name, int nam_len)
+{
+    return dict_hash_multi(dict_hash_multi(0, name, nam_len), NULL, nam_len);
+}
+
+static void
+lys_child_index_free(struct lys_child_index *index)
+{
+    lyht_free(index->names);
+    lyht_free(index->lyb);
+    index->names = NULL;
+    index->lyb = NULL;
+}
+
+void
+lys_child_index_clear(struct ly_ctx *ctx)
+{
+    struct ht_rec *rec;
+    uint32_t i;
+
+    if (!ctx->schema_index) {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&ctx->schema_index_lock);
+    for (i = 0; i < ctx->schema_index->size; ++i) {
+        rec = lyht_get_rec(ctx->schema_index->recs, ctx->schema_index->rec_size, i);
+        if (rec->hits > 0) {
+            lys_child_index_free((struct lys_child_index *)rec->val);
+        }
+    }
+    lyht_free(ctx->schema_index);
+    ctx->schema_index = NULL;
+    pthread_rwlock_unlock(&ctx->schema_index_lock);
+}
+
+/**
+ * @brief Create the hash tables of a child index, they are left NULL if there are too few children.
+ *
+ * @return 0 on success, -1 on error.
+ */
+static int
+lys_child_index_build(const struct lys_node *parent, const struct lys_module *module, struct lys_child_index *index)
+{
+    const struct lys_node *node;
+    uint32_t count = 0, size;
+
+    node = NULL;
+    while ((node = lys_getnext(node, parent, module, LYS_GETNEXT_NOSTATECHECK))) {
+        ++count;
+    }
+    if (count < LYS_CHILD_INDEX_MIN) {
+        return 0;
+    }
+
+    for (size = LYS_CHILD_INDEX_MIN; size < count; size <<= 1);
+    index->names = lyht_new(size << 1, sizeof node, lys_child_name_equal, NULL, 1);
+    index->lyb = lyht_new(size << 1, sizeof node, lys_child_lyb_equal, NULL, 1);
+    if (!index->names || !index->lyb) {
+        goto error;
+    }
+
+    node = NULL;
+    while ((node = lys_getnext(node, parent, module, LYS_GETNEXT_NOSTATECHECK))) {
+        if ((lyht_insert(index->names, &node, lys_child_name_hash(node->name, strlen(node->name)), NULL) == -1)
+                || (lyht_insert(index->lyb, &node, lyb_hash((struct lys_node *)node, 0), NULL) == -1)) {
+            goto error;
+        }
+    }
+    return 0;
+
+error:
+    lys_child_index_free(index);
+    return -1;
+}
+
+/**
+ * @brief Find a child in the context schema index of its parent, the index is created when the parent
+ * has been searched LYS_CHILD_INDEX_LOOKUPS times since the last schema change.
+ *
+ * @param[in] parent Parent of the children, NULL for the top-level nodes of \p module.
+ * @param[in] module Module of the top-level nodes.
+ * @param[in] lyb Whether to use the index by LYB hash instead of the index by name.
+ * @param[in] key Lookup key.
+ * @param[in] hash Hash of \p key.
+ * @param[out] node Found child, NULL if there is none.
+ * @return 0 if the index was searched, 1 if the children should be searched without the index.
+ */
+static int
+lys_child_index_find(const struct lys_node *parent, const struct lys_module *module, int lyb, struct lys_child_key *key,
+                     uint32_t hash, const struct lys_node **node)
+{
+    struct ly_ctx *ctx = parent ? parent->module->ctx : module->ctx;
+    struct lys_child_index rec, *index;
+    struct hash_table *ht;
+    struct lys_node **match;
+    uint32_t lookups;
+    int ret = 1;
+
+    memset(&rec, 0, sizeof rec);
+    rec.parent = parent ? (const void *)parent : (const void *)module;
+    *node = NULL;
+
+    pthread_rwlock_rdlock(&ctx->schema_index_lock);
+    if (!ctx->schema_index || lyht_find(ctx->schema_index, &rec, lys_child_index_hash(rec.parent), (void **)&index)) {
+        pthread_rwlock_unlock(&ctx->schema_index_lock);
+
+        /* first lookup, only remember it */
+        rec.lookups = 1;
+        pthread_rwlock_wrlock(&ctx->schema_index_lock);
+        if (!ctx->schema_index) {
+            ctx->schema_index = lyht_new(16, sizeof rec, lys_child_index_equal, NULL, 1);
+        }
+        if (ctx->schema_index) {
+            lyht_insert(ctx->schema_index, &rec, lys_child_index_hash(rec.parent), NULL);
+        }
+        pthread_rwlock_unlock(&ctx->schema_index_lock);
+        return 1;
+    }
+
+    ht = lyb ? index->lyb : index->names;
+    if (ht) {
+        if (!lyht_find(ht, key, hash, (void **)&match)) {
+            *node = *match;
+        }
+        pthread_rwlock_unlock(&ctx->schema_index_lock);
+        return 0;
+    }
+    lookups = index->lookups ? __sync_add_and_fetch(&index->lookups, 1) : 0;
+    pthread_rwlock_unlock(&ctx->schema_index_lock);
+    if (lookups < LYS_CHILD_INDEX_LOOKUPS) {
+        /* too few children or lookups so far */
+        return 1;
+    }
+
+    /* create the index */
+    if (lys_child_index_build(parent, module, &rec)) {
+        return 1;
+    }
+
+    pthread_rwlock_wrlock(&ctx->schema_index_lock);
+    if (!ctx->schema_index || lyht_find(ctx->schema_index, &rec, lys_child_index_hash(rec.parent), (void **)&index)) {
+        /* cannot happen unless the schema is being changed */
+        lys_child_index_free(&rec);
+    } else if (!rec.names) {
+        /* too few children */
+        index->lookups = 0;
+    } else {
+        if (index->names) {
+            /* created concurrently */
+            lys_child_index_free(&rec);
+        } else {
+            index->names = rec.names;
+            index->lyb = rec.lyb;
+        }
+        if (!lyht_find(lyb ? index->lyb : index->names, key, hash, (void **)&match)) {
+            *node = *match;
+        }
+        ret = 0;
+    }
+    pthread_rwlock_unlock(&ctx->schema_index_lock);
+
+    return ret;
+}
+
+static int
+lys_child_indexable(const struct lys_node *parent, int options)
+{
+    if (options & ~LYS_GETNEXT_NOSTATECHECK) {
+        return 0;
+    }
+
+    /* RPC children are in both input and output, their names are not unique */
+    return !parent || (parent->nodetype & (LYS_CONTAINER | LYS_LIST | LYS_NOTIF | LYS_INPUT | LYS_OUTPUT | LYS_CHOICE | LYS_CASE));
+}
+
+const struct lys_node *
+lys_child_find(const struct lys_node *parent, const struct lys_module *module, const char *mod_name, const char *mod_ns,
+               const char *name, int nam_len, int options)
+{
+    struct lys_child_key key;
+    const struct lys_node *node = NULL;
+
+    assert((parent || module) && name);
+
+    if (parent) {
+        /* only the top-level nodes are from the module */
+        module = NULL;
+    } else if (!(options & LYS_GETNEXT_NOSTATECHECK) && (module->disabled || !module->implemented)) {
+        /* nothing to return from a disabled/imported module, as lys_getnext() */
+        return NULL;
+    }
+
+    memset(&key, 0, sizeof key);
+    key.name = name;
+    key.nam_len = nam_len;
+    key.mod_name = mod_name;
+    key.mod_ns = mod_ns;
+    key.parent = parent;
+    key.options = options;
+
+    if (lys_child_indexable(parent, options)
+            && !lys_child_index_find(parent, module, 0, &key, lys_child_name_hash(name, nam_len), &node)) {
+        return node;
+    }
+
+    /* few children, search them all */
+    while ((node = lys_getnext(node, parent, module, options | LYS_GETNEXT_NOSTATECHECK))) {
+        if (lys_child_name_equal(&key, &node, 0, NULL)) {
+            break;
+        }
+    }
+    return node;
+}
+
+const struct lys_node *
+lys_child_find_lyb(const struct lys_node *parent, const struct lys_module *module, LYB_HASH hash,
+                   int (*match)(const struct lys_node *node, void *data), void *match_data, int options)
+{
+    struct lys_child_key key;
+    const struct lys_node *node = NULL;
+
+    assert((parent || module) && match);
+
+    if (parent) {
+        /* only the top-level nodes are from the module */
+        module = NULL;
+    } else if (!(options & LYS_GETNEXT_NOSTATECHECK) && (module->disabled || !module->implemented)) {
+        /* nothing to return from a disabled/imported module, as lys_getnext() */
+        return NULL;
+    }
+
+    memset(&key, 0, sizeof key);
+    key.match = match;
+    key.match_data = match_data;
+    key.parent = parent;
+    key.options = options;
+
+    if (lys_child_indexable(parent, options) && !lys_child_index_find(parent, module, 1, &key, hash, &node)) {
+        return node;
+    }
+
+    while ((node = lys_getnext(node, parent, module, options | LYS_GETNEXT_NOSTATECHECK))) {
+        if (lys_child_lyb_equal(&key, &node, 0, NULL)) {
+            break;
+        }
+    }
+    return node;
+}
+
 int
 lys_getnext_data(const struct lys_module *mod, const struct lys_node *parent, const char *name, int nam_len,
                  LYS_NODE type, int getnext_opts, const struct lys_node **ret)
@@ -236,6 +587,17 @@ lys_getnext_data(const struct lys_module *mod, const struct lys_node *parent, co
         mod = lys_node_module(parent);
     }
 
+    if (lys_child_indexable(parent, getnext_opts)) {
+        node = lys_child_find(parent, mod, lys_main_module(mod)->name, NULL, name, nam_len, getnext_opts);
+        if (!node || (type && !(node->nodetype & type))) {
+            return EXIT_FAILURE;
+        }
+        if (ret) {
+            *ret = node;
+        }
+        return EXIT_SUCCESS;
+    }
+
     /* try to find the node */
     node = NULL;
     while ((node = lys_getnext(node, parent, mod, getnext_opts))) {
@@ -428,6 +790,8 @@ lys_node_unlink(struct lys_node *node)
 
     /* unlink from data model if necessary */
     if (node->module) {
+        lys_child_index_clear(node->module->ctx);
+
         /* get main module with data tree */
         main_module = lys_node_module(node);
         if (main_module->data == node) {
@@ -782,6 +1146,8 @@ lys_node_addchild(struct lys_node *parent, struct lys_module *module, struct lys
 
     assert(child);
 
+    lys_child_index_clear(ctx);
+
     if (parent) {
         type = parent->nodetype;
         module = parent->module;
@@ -1388,9 +1754,8 @@ lys_search_localfile(const char * const *searchpaths, int cwd, const char *name,
         free(wd);
         free(wn); wn = NULL;
 
-        dirs->number--;
-        wd = (char *)dirs->set.g[dirs->number];
-        dirs->set.g[dirs->number] = NULL;
+        wd = (char *)dirs->set.g[dirs->number - 1];
+        ly_set_rm_index(dirs, dirs->number - 1);
         LOGVRB("Searching for \"%s\" in %s.", name, wd);
 
         if (dir) {
@@ -1673,6 +2038,9 @@ lys_restr_free(struct ly_ctx *ctx, struct lys_restr *restr,
     }
 
     lys_extension_instances_free(ctx, restr->ext, restr->ext_size, private_destructor);
+#ifdef LY_ENABLED_CACHE
+    lyxp_expr_free(restr->compiled);
+#endif
     lydict_remove(ctx, restr->expr);
     lydict_remove(ctx, restr->dsc);
     lydict_remove(ctx, restr->ref);
@@ -2357,6 +2725,9 @@ lys_type_free(struct ly_ctx *ctx, struct lys_type *type,
 
     case LY_TYPE_LEAFREF:
         lydict_remove(ctx, type->info.lref.path);
+#ifdef LY_ENABLED_CACHE
+        lyxp_expr_free(type->info.lref.compiled);
+#endif
         break;
 
     case LY_TYPE_STRING:
@@ -2444,6 +2815,9 @@ lys_when_free(struct ly_ctx *ctx, struct lys_when *w,
     }
 
     lys_extension_instances_free(ctx, w->ext, w->ext_size, private_destructor);
+#ifdef LY_ENABLED_CACHE
+    lyxp_expr_free(w->compiled);
+#endif
     lydict_remove(ctx, w->cond);
     lydict_remove(ctx, w->dsc);
     lydict_remove(ctx, w->ref);
@@ -2807,6 +3181,7 @@ lys_node_free(struct lys_node *node, void (*private_destructor)(const struct lys
     assert(node->module->ctx);
 
     ctx = node->module->ctx;
+    lys_child_index_clear(ctx);
 
     /* remove private object */
     if (node->priv && private_destructor) {
@@ -3827,6 +4202,7 @@ lys_free(struct lys_module *module, void (*private_destructor)(const struct lys_
     if (remove_from_ctx && ctx->models.used) {
         for (i = 0; i < ctx->models.used; i++) {
             if (ctx->models.list[i] == module) {
+                ctx_modules_index_remove(module);
                 /* move all the models to not change the order in the list */
                 ctx->models.used--;
                 memmove(&ctx->models.list[i], ctx->models.list[i + 1], (ctx->models.used - i) * sizeof *ctx->models.list);
@@ -4525,6 +4901,7 @@ apply_aug(struct lys_node_augment *augment, struct unres_schema *unres)
     }
 
     /* reconnect augmenting data into the target - add them to the target child list */
+    lys_child_index_clear(augment->module->ctx);
     if (augment->target->child) {
         child = augment->target->child->prev;
         child->next = augment->child;
@@ -4552,6 +4929,7 @@ remove_aug(struct lys_node_augment *augment)
 
     elem = augment->child;
     if (elem) {
+        lys_child_index_clear(augment->module->ctx);
         LY_TREE_FOR(elem, last) {
             if (!last->next || (last->next->parent != (struct lys_node *)augment)) {
                 break;
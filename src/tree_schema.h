@@ -919,6 +919,10 @@ struct lys_type_info_lref {
                                   - -1 = false,
                                   - 0 not defined (true),
                                   - 1 = true */
+#ifdef LY_ENABLED_CACHE
+    void *compiled;          /**< compiled XPath expression of the path created on its first evaluation to avoid
+                                  parsing it repeatedly. For internal use only. */
+#endif
 };
 
 /**
@@ -2058,6 +2062,10 @@ struct lys_restr {
     struct lys_ext_instance **ext;   /**< array of pointers to the extension instances */
     uint8_t ext_size;                /**< number of elements in #ext array */
     uint16_t flags;                  /**< only flags #LYS_XPCONF_DEP and #LYS_XPSTATE_DEP can be specified */
+#ifdef LY_ENABLED_CACHE
+    void *compiled;                  /**< compiled XPath expression of a must restriction created on its first
+                                          evaluation to avoid parsing it repeatedly. For internal use only. */
+#endif
 };
 
 /**
@@ -2070,6 +2078,10 @@ struct lys_when {
     struct lys_ext_instance **ext;   /**< array of pointers to the extension instances */
     uint8_t ext_size;                /**< number of elements in #ext array */
     uint16_t flags;                  /**< only flags #LYS_XPCONF_DEP and #LYS_XPSTATE_DEP can be specified */
+#ifdef LY_ENABLED_CACHE
+    void *compiled;                  /**< compiled XPath expression of the condition created on its first
+                                          evaluation to avoid parsing it repeatedly. For internal use only. */
+#endif
 };
 
 /**
@@ -2111,10 +2123,8 @@ const struct lys_module *lys_parse_mem(struct ly_ctx *ctx, const char *data, LYS
 /**
  * @brief Read a schema from file descriptor into the specified context.
  *
- * \note Current implementation supports only reading data from standard (disk) file, not from sockets, pipes, etc.
- *
  * @param[in] ctx libyang context where to process the data model.
- * @param[in] fd File descriptor of a regular file (e.g. sockets are not supported) containing the schema
+ * @param[in] fd File descriptor (a regular file, pipe or socket) containing the schema
  *            in the specified format.
  * @param[in] format Format of the input data (YANG or YIN).
  * @return Pointer to the data model structure or NULL on error.
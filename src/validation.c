@@ -236,17 +236,51 @@ unique_errmsg_cleanup:
     return 0;
 }
 
+/**
+ * @brief Get the hash of the values of a unique constraint of a list instance.
+ *
+ * @param[in] node List instance.
+ * @param[in] uniq Index of the unique constraint.
+ * @param[out] hash Computed hash.
+ * @return 0 on success, 1 if the unique set of the instance is incomplete, -1 on error.
+ */
+static int
+lyv_list_uniq_hash(struct lyd_node *node, uint8_t uniq, uint32_t *hash)
+{
+    struct lys_node_list *slist = (struct lys_node_list *)node->schema;
+    struct lyd_node *diter;
+    const char *id;
+    uint8_t i;
+
+    for (i = *hash = 0; i < slist->unique[uniq].expr_size; i++) {
+        id = NULL;
+        diter = resolve_data_descendant_schema_nodeid(slist->unique[uniq].expr[i], node->child);
+        if (diter) {
+            id = ((struct lyd_node_leaf_list *)diter)->value_str;
+        } else if (lyd_get_unique_default(slist->unique[uniq].expr[i], node, &id)) {
+            /* use default value */
+            return -1;
+        }
+        if (!id) {
+            /* unique item not present nor has default value */
+            return 1;
+        }
+        *hash = dict_hash_multi(*hash, id, strlen(id));
+    }
+
+    /* finish the hash value */
+    *hash = dict_hash_multi(*hash, NULL, 0);
+    return 0;
+}
+
 int
 lyv_data_unique(struct lyd_node *list)
 {
-    struct lyd_node *diter;
-    struct ly_set *set;
-    uint32_t i, j, n = 0;
-    int ret = 0;
-    uint32_t hash, u, usize = 0;
+    struct lyd_node *diter, **instances = NULL;
+    uint32_t i, j, n = 0, count = 0, changed = 0, size = 0;
+    int ret = 0, r;
+    uint32_t hash, usize;
     struct hash_table **uniqtables = NULL;
-    const char *id;
-    char *path;
     struct lys_node_list *slist;
     struct ly_ctx *ctx = list->schema->module->ctx;
 
@@ -257,95 +291,68 @@ lyv_data_unique(struct lyd_node *list)
 
     slist = (struct lys_node_list *)list->schema;
 
-    /* get all list instances */
-    if (ly_vlog_build_path(LY_VLOG_LYD, list, &path, 0, 1)) {
-        return -1;
-    }
-    set = lyd_find_path(list, path);
-    free(path);
-    if (!set) {
-        return -1;
-    }
+    /* get all list instances directly from the siblings, the instances with changed unique values first */
+    for (diter = list->parent ? list->parent->child : lyd_first_sibling(list); diter; diter = diter->next) {
+        if (diter->schema != list->schema) {
+            continue;
+        }
 
-    for (i = 0; i < set->number; ++i) {
-        /* remove the flag */
-        set->set.d[i]->validity &= ~LYD_VAL_UNIQUE;
+        if (count == size) {
+            size = size ? size << 1 : 8;
+            instances = ly_realloc(instances, size * sizeof *instances);
+            LY_CHECK_ERR_RETURN(!instances, LOGMEM(ctx), -1);
+        }
+        if (diter->validity & LYD_VAL_UNIQUE) {
+            instances[count] = instances[changed];
+            instances[changed++] = diter;
+        } else {
+            instances[count] = diter;
+        }
+        ++count;
     }
 
-    if (set->number == 2) {
+    if (count == 2) {
         /* simple comparison */
-        if (lyv_list_uniq_equal(&set->set.d[0], &set->set.d[1], 0, (void *)0)) {
+        if (lyv_list_uniq_equal(&instances[0], &instances[1], 0, (void *)0)) {
             /* instance duplication */
-            ly_set_free(set);
-            return 1;
-        }
-    } else if (set->number > 2) {
-        /* use hashes for comparison */
-        /* first, allocate the table, the size depends on number of items in the set */
-        for (u = 31; u > 0; u--) {
-            usize = set->number << u;
-            usize = usize >> u;
-            if (usize == set->number) {
-                break;
-            }
-        }
-        if (u == 0) {
-            LOGINT(ctx);
-            ret = -1;
+            ret = 1;
             goto cleanup;
-        } else {
-            u = 32 - u;
-            usize = 1 << u;
         }
+    } else if (count > 2) {
+        /* use hashes for comparison, but only the instances with changed unique values are inserted,
+         * the rest has already been checked against each other so they are only searched for,
+         * the table size depends on the number of the inserted instances, it cannot be resized so it must
+         * never get full, searches would not end otherwise */
+        for (usize = LYHT_MIN_SIZE; usize <= changed; usize <<= 1);
 
+        uniqtables = calloc(slist->unique_size, sizeof *uniqtables);
+        LY_CHECK_ERR_GOTO(!uniqtables, LOGMEM(ctx); ret = -1, cleanup);
         n = slist->unique_size;
-        uniqtables = malloc(n * sizeof *uniqtables);
-        if (!uniqtables) {
-            LOGMEM(ctx);
-            ret = -1;
-            n = 0;
-            goto cleanup;
-        }
         for (j = 0; j < n; j++) {
             uniqtables[j] = lyht_new(usize, sizeof(struct lyd_node *), lyv_list_uniq_equal, (void *)(j + 1L), 0);
-            if (!uniqtables[j]) {
-                LOGMEM(ctx);
-                ret = -1;
-                goto cleanup;
-            }
+            LY_CHECK_ERR_GOTO(!uniqtables[j], LOGMEM(ctx); ret = -1, cleanup);
         }
 
-        for (u = 0; u < set->number; u++) {
+        for (i = 0; i < count; i++) {
             /* loop for unique - get the hash for the instances */
             for (j = 0; j < n; j++) {
-                id = NULL;
-                for (i = hash = 0; i < slist->unique[j].expr_size; i++) {
-                    diter = resolve_data_descendant_schema_nodeid(slist->unique[j].expr[i], set->set.d[u]->child);
-                    if (diter) {
-                        id = ((struct lyd_node_leaf_list *)diter)->value_str;
-                    } else {
-                        /* use default value */
-                        if (lyd_get_unique_default(slist->unique[j].expr[i], set->set.d[u], &id)) {
-                            ret = -1;
-                            goto cleanup;
-                        }
-                    }
-                    if (!id) {
-                        /* unique item not present nor has default value */
-                        break;
-                    }
-                    hash = dict_hash_multi(hash, id, strlen(id));
-                }
-                if (!id) {
+                r = lyv_list_uniq_hash(instances[i], j, &hash);
+                if (r == -1) {
+                    ret = -1;
+                    goto cleanup;
+                } else if (r) {
                     /* skip this list instance since its unique set is incomplete */
                     continue;
                 }
 
-                /* finish the hash value */
-                hash = dict_hash_multi(hash, NULL, 0);
-
-                /* insert into the hashtable */
-                if (lyht_insert(uniqtables[j], &set->set.d[u], hash, NULL)) {
+                if (i < changed) {
+                    /* insert into the hashtable */
+                    r = lyht_insert(uniqtables[j], &instances[i], hash, NULL);
+                } else {
+                    /* unchanged instance, it can only collide with a changed one */
+                    r = !lyht_find(uniqtables[j], &instances[i], hash, NULL);
+                }
+                if (r) {
                     ret = 1;
                     goto cleanup;
                 }
@@ -353,13 +360,14 @@ lyv_data_unique(struct lyd_node *list)
         }
     }
 
+    for (i = 0; i < changed; ++i) {
+        /* remove the flag, all the instances are valid */
+        instances[i]->validity &= ~LYD_VAL_UNIQUE;
+    }
+
 cleanup:
-    ly_set_free(set);
+    free(instances);
     for (j = 0; j < n; j++) {
-        if (!uniqtables[j]) {
-            /* failed when allocating uniquetables[j], following j are not allocated */
-            break;
-        }
         lyht_free(uniqtables[j]);
     }
     free(uniqtables);
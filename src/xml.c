@@ -648,10 +648,8 @@ parse_ignore(struct ly_ctx *ctx, const char *data, const char *endstr, unsigned
 
     slen = strlen(endstr);
 
-    while (*c && strncmp(c, endstr, slen)) {
-        c++;
-    }
-    if (!*c) {
+    c = strstr(c, endstr);
+    if (!c) {
         LOGVAL(ctx, LYE_XML_MISS, LY_VLOG_NONE, NULL, "closing sequence", endstr);
         return EXIT_FAILURE;
     }
@@ -770,6 +768,12 @@ loop:
                 o += r - 1;     /* o is ++ in for loop */
                 (*len)++;
             }
+        } else if ((r = lyp_plain_len(&data[*len], "<&]\"'", BUFSIZE - o))) {
+            /* copy the whole run of characters not needing any processing */
+            memcpy(&buf[o], &data[*len], r);
+
+            o += r - 1;     /* o is ++ in for loop */
+            (*len) = (*len) + r;
         } else {
             r = copyutf8(ctx, &buf[o], &data[*len]);
             if (!r) {
@@ -938,9 +942,10 @@ error:
     return NULL;
 }
 
-/* logs directly */
-struct lyxml_elem *
-lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct lyxml_elem *parent, int options)
+/* logs directly, \p result is NULL if the element was passed to the elem_end callback */
+static int
+lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct lyxml_elem *parent, int options,
+                 const struct lyxml_parse_clb *clb, struct lyxml_elem **result)
 {
     const char *c = data, *start, *e;
     const char *lws;    /* leading white space for handling mixed content */
@@ -951,12 +956,13 @@ lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct
     struct lyxml_elem *elem = NULL, *child;
     struct lyxml_attr *attr;
     unsigned int size;
-    int nons_flag = 0, closed_flag = 0;
+    int nons_flag = 0, closed_flag = 0, child_flag = 0;
 
     *len = 0;
+    *result = NULL;
 
     if (*c != '<') {
-        return NULL;
+        return EXIT_FAILURE;
     }
 
     /* locate element name */
@@ -966,7 +972,7 @@ lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct
     uc = lyxml_getutf8(ctx, e, &size);
     if (!is_xmlnamestartchar(uc)) {
         LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "NameStartChar of the element");
-        return NULL;
+        return EXIT_FAILURE;
     }
     e += size;
     uc = lyxml_getutf8(ctx, e, &size);
@@ -994,12 +1000,12 @@ lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct
     if (!*e) {
         LOGVAL(ctx, LYE_EOF, LY_VLOG_NONE, NULL);
         free(prefix);
-        return NULL;
+        return EXIT_FAILURE;
     }
 
     /* allocate element structure */
     elem = calloc(1, sizeof *elem);
-    LY_CHECK_ERR_RETURN(!elem, free(prefix); LOGMEM(ctx), NULL);
+    LY_CHECK_ERR_RETURN(!elem, free(prefix); LOGMEM(ctx), EXIT_FAILURE);
 
     elem->next = NULL;
     elem->prev = elem;
@@ -1013,19 +1019,66 @@ lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct
 
 process:
     ign_xmlws(c);
+    if (strncmp("/>", c, 2) && (*c != '>')) {
+        /* process attribute */
+        attr = parse_attr(ctx, c, &size, elem);
+        if (!attr) {
+            goto error;
+        }
+        c += size;              /* move after processed attribute */
+
+        /* check namespace */
+        if (attr->type == LYXML_ATTR_NS) {
+            if ((!prefix || !prefix[0]) && !attr->name) {
+                if (attr->value) {
+                    /* default prefix */
+                    elem->ns = (struct lyxml_ns *)attr;
+                } else {
+                    /* xmlns="" -> no namespace */
+                    nons_flag = 1;
+                }
+            } else if (prefix && prefix[0] && attr->name && !strncmp(attr->name, prefix, prefix_len + 1)) {
+                /* matching namespace with prefix */
+                elem->ns = (struct lyxml_ns *)attr;
+            }
+        }
+
+        /* go back to finish element processing */
+        goto process;
+    }
+
+    /* the start tag is complete, so all the namespace definitions are known,
+     * resolve all attribute prefixes */
+    LY_TREE_FOR(elem->attr, attr) {
+        if (attr->type == LYXML_ATTR_STD_UNRES) {
+            str = (char *)attr->ns;
+            attr->ns = lyxml_get_ns(elem, str);
+            free(str);
+            attr->type = LYXML_ATTR_STD;
+        }
+    }
+
+    if (!elem->ns && !nons_flag && parent) {
+        elem->ns = lyxml_get_ns(parent, prefix_len ? prefix : NULL);
+    }
+
+    if (clb && clb->elem_start && clb->elem_start(elem, clb->data)) {
+        goto error;
+    }
+
     if (!strncmp("/>", c, 2)) {
         /* we are done, it was EmptyElemTag */
         c += 2;
         elem->content = lydict_insert(ctx, "", 0);
         closed_flag = 1;
-    } else if (*c == '>') {
+    } else {
         /* process element content */
         c++;
         lws = NULL;
 
         while (*c) {
             if (!strncmp(c, "</", 2)) {
-                if (lws && !elem->child) {
+                if (lws && !child_flag) {
                     /* leading white spaces were actually content */
                     goto store_content;
                 }
@@ -1138,10 +1191,10 @@ process:
                     lyxml_add_child(ctx, elem, child);
                     elem->flags |= LYXML_ELEM_MIXED;
                 }
-                child = lyxml_parse_elem(ctx, c, &size, elem, options);
-                if (!child) {
+                if (lyxml_parse_elem(ctx, c, &size, elem, options, clb, &child)) {
                     goto error;
                 }
+                child_flag = 1;
                 c += size;      /* move after processed child element */
             } else if (is_xmlws(*c)) {
                 lws = c;
@@ -1161,7 +1214,7 @@ store_content:
                 elem->content = lydict_insert_zc(ctx, str);
                 c += size;      /* move after processed text content */
 
-                if (elem->child) {
+                if (child_flag) {
                     /* we have a mixed content */
                     if (options & LYXML_PARSE_NOMIXEDCONTENT) {
                         LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_XML, elem, "XML element with mixed content");
@@ -1176,32 +1229,6 @@ store_content:
                 }
             }
         }
-    } else {
-        /* process attribute */
-        attr = parse_attr(ctx, c, &size, elem);
-        if (!attr) {
-            goto error;
-        }
-        c += size;              /* move after processed attribute */
-
-        /* check namespace */
-        if (attr->type == LYXML_ATTR_NS) {
-            if ((!prefix || !prefix[0]) && !attr->name) {
-                if (attr->value) {
-                    /* default prefix */
-                    elem->ns = (struct lyxml_ns *)attr;
-                } else {
-                    /* xmlns="" -> no namespace */
-                    nons_flag = 1;
-                }
-            } else if (prefix && prefix[0] && attr->name && !strncmp(attr->name, prefix, prefix_len + 1)) {
-                /* matching namespace with prefix */
-                elem->ns = (struct lyxml_ns *)attr;
-            }
-        }
-
-        /* go back to finish element processing */
-        goto process;
     }
 
     *len = c - data;
@@ -1211,49 +1238,41 @@ store_content:
         goto error;
     }
 
-    /* resolve all attribute prefixes */
-    LY_TREE_FOR(elem->attr, attr) {
-        if (attr->type == LYXML_ATTR_STD_UNRES) {
-            str = (char *)attr->ns;
-            attr->ns = lyxml_get_ns(elem, str);
-            free(str);
-            attr->type = LYXML_ATTR_STD;
+    if (clb && clb->elem_end) {
+        /* the element is complete, from now on it is the callback's responsibility */
+        if (clb->elem_end(elem, clb->data)) {
+            goto error;
         }
-    }
-
-    if (!elem->ns && !nons_flag && parent) {
-        elem->ns = lyxml_get_ns(parent, prefix_len ? prefix : NULL);
+        elem = NULL;
     }
     free(prefix);
-    return elem;
+    *result = elem;
+    return EXIT_SUCCESS;
 
 error:
     lyxml_free(ctx, elem);
     free(prefix);
-    return NULL;
+    return EXIT_FAILURE;
 }
 
 /* logs directly */
-API struct lyxml_elem *
-lyxml_parse_mem(struct ly_ctx *ctx, const char *data, int options)
+int
+lyxml_parse_mem_clb(struct ly_ctx *ctx, const char *data, const char *end, int options,
+                    const struct lyxml_parse_clb *clb, struct lyxml_elem **result)
 {
-    FUN_IN;
-
     const char *c = data;
     unsigned int len;
     struct lyxml_elem *root, *first = NULL, *next;
 
-    if (!ctx) {
-        LOGARG;
-        return NULL;
-    }
+    *result = NULL;
 
 repeat:
     /* process document */
     while (1) {
-        if (!*c) {
+        if (!*c || (end && (c >= end))) {
             /* eof */
-            return first;
+            *result = first;
+            return EXIT_SUCCESS;
         } else if (is_xmlws(*c)) {
             /* skip whitespaces */
             ign_xmlws(c);
@@ -1287,9 +1306,10 @@ repeat:
         }
     }
 
-    root = lyxml_parse_elem(ctx, c, &len, NULL, options);
-    if (!root) {
+    if (lyxml_parse_elem(ctx, c, &len, NULL, options, clb, &root)) {
         goto error;
+    } else if (!root) {
+        /* passed to the callback */
     } else if (!first) {
         first = root;
     } else {
@@ -1298,6 +1318,10 @@ repeat:
         first->prev = root;
     }
     c += len;
+    if (end && (c > end)) {
+        LOGVAL(ctx, LYE_XML_INVAL, LY_VLOG_NONE, NULL, "top-level element boundary");
+        goto error;
+    }
 
     /* ignore the rest of document where can be comments, PIs and whitespaces,
      * note that we are not detecting syntax errors in these parts
@@ -1311,15 +1335,87 @@ repeat:
         }
     }
 
-    return first;
+    *result = first;
+    return EXIT_SUCCESS;
 
 error:
     LY_TREE_FOR_SAFE(first, next, root) {
         lyxml_free(ctx, root);
     }
+    return EXIT_FAILURE;
+}
+
+const char *
+lyxml_next_root(const char *data, const char *min)
+{
+    const char *c = data;
+    uint32_t depth = 0;
+
+    while ((c = strchr(c, '<'))) {
+        if (!strncmp(c, "<!--", 4)) {
+            c = strstr(c + 4, "-->");
+            LY_CHECK_RETURN(!c, NULL);
+            c += 3;
+        } else if (!strncmp(c, "<![CDATA[", 9)) {
+            c = strstr(c + 9, "]]>");
+            LY_CHECK_RETURN(!c, NULL);
+            c += 3;
+        } else if (c[1] == '?') {
+            c = strstr(c + 2, "?>");
+            LY_CHECK_RETURN(!c, NULL);
+            c += 2;
+        } else if (c[1] == '!') {
+            /* DOCTYPE is not supported */
+            return NULL;
+        } else if (c[1] == '/') {
+            /* end tag */
+            LY_CHECK_RETURN(!depth, NULL);
+            --depth;
+            c = strchr(c + 2, '>');
+            LY_CHECK_RETURN(!c, NULL);
+            ++c;
+        } else {
+            if (!depth && (c >= min)) {
+                return c;
+            }
+
+            /* start tag, attribute values can include '>' */
+            for (++c; *c && (*c != '>'); ++c) {
+                if ((*c == '\"') || (*c == '\'')) {
+                    c = strchr(c + 1, *c);
+                    LY_CHECK_RETURN(!c, NULL);
+                }
+            }
+            LY_CHECK_RETURN(!*c, NULL);
+            if (c[-1] != '/') {
+                ++depth;
+            }
+            ++c;
+        }
+    }
+
     return NULL;
 }
 
+/* logs directly */
+API struct lyxml_elem *
+lyxml_parse_mem(struct ly_ctx *ctx, const char *data, int options)
+{
+    FUN_IN;
+
+    struct lyxml_elem *result;
+
+    if (!ctx) {
+        LOGARG;
+        return NULL;
+    }
+
+    if (lyxml_parse_mem_clb(ctx, data, NULL, options, NULL, &result)) {
+        return NULL;
+    }
+    return result;
+}
+
 API struct lyxml_elem *
 lyxml_parse_path(struct ly_ctx *ctx, const char *filename, int options)
 {
@@ -1557,6 +1653,7 @@ lyxml_print_fd(int fd, const struct lyxml_elem *elem, int options)
     FUN_IN;
 
     struct lyout out;
+    int r;
 
     if (fd < 0 || !elem) {
         return 0;
@@ -1568,10 +1665,15 @@ lyxml_print_fd(int fd, const struct lyxml_elem *elem, int options)
     out.method.fd = fd;
 
     if (options & LYXML_PRINT_SIBLINGS) {
-        return dump_siblings(&out, elem, options);
+        r = dump_siblings(&out, elem, options);
     } else {
-        return dump_elem(&out, elem, 0, options, 1);
+        r = dump_elem(&out, elem, 0, options, 1);
+    }
+
+    if (ly_print_flush(&out)) {
+        r = -1;
     }
+    return r;
 }
 
 API int
@@ -1606,6 +1708,7 @@ lyxml_print_clb(ssize_t (*writeclb)(void *arg, const void *buf, size_t count), v
     FUN_IN;
 
     struct lyout out;
+    int r;
 
     if (!writeclb || !elem) {
         return 0;
@@ -1618,8 +1721,13 @@ lyxml_print_clb(ssize_t (*writeclb)(void *arg, const void *buf, size_t count), v
     out.method.clb.arg = arg;
 
     if (options & LYXML_PRINT_SIBLINGS) {
-        return dump_siblings(&out, elem, options);
+        r = dump_siblings(&out, elem, options);
     } else {
-        return dump_elem(&out, elem, 0, options, 1);
+        r = dump_elem(&out, elem, 0, options, 1);
+    }
+
+    if (ly_print_flush(&out)) {
+        r = -1;
     }
+    return r;
 }
@@ -109,6 +109,48 @@ void lyxml_unlink_attr(struct lyxml_attr *attr);
  */
 void lyxml_unlink_elem(struct ly_ctx *ctx, struct lyxml_elem *elem, int copy_ns);
 
+/**
+ * @brief Callbacks called by the XML parser for every element so that the elements
+ * can be processed while they are being parsed instead of from the complete XML tree.
+ */
+struct lyxml_parse_clb {
+    int (*elem_start)(struct lyxml_elem *elem, void *data); /**< called once the start tag of an element is parsed,
+                                                                 its name, namespace and attributes are filled, but
+                                                                 there is no content yet; non-zero return value stops
+                                                                 the parsing */
+    int (*elem_end)(struct lyxml_elem *elem, void *data);   /**< called once the element is completely parsed, on
+                                                                 success the element is taken over by the callback
+                                                                 (it is expected to free it), non-zero return value
+                                                                 stops the parsing and the element is freed */
+    void *data;                                             /**< arbitrary data passed to the callbacks */
+};
+
+/**
+ * @brief Parse XML from in-memory string, optionally passing all the elements to callbacks.
+ *
+ * @param[in] ctx libyang context to use.
+ * @param[in] data NULL-terminated string containing XML data to parse.
+ * @param[in] end Optional end of the data to parse, only the top-level elements starting before it are parsed and
+ *                the last one must end before it.
+ * @param[in] options Parser options, see @ref xmlreadoptions.
+ * @param[in] clb Callbacks to process the elements with, if NULL the whole XML tree is returned.
+ * @param[out] result Parsed XML tree, always NULL if \p clb with the elem_end callback was used.
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int lyxml_parse_mem_clb(struct ly_ctx *ctx, const char *data, const char *end, int options,
+                        const struct lyxml_parse_clb *clb, struct lyxml_elem **result);
+
+/**
+ * @brief Find the next top-level element in XML data without parsing them.
+ *
+ * Only the markup is followed, the data are not checked to be well-formed.
+ *
+ * @param[in] data XML data at the top level (the document beginning or a top-level element start).
+ * @param[in] min Minimal position of the returned element.
+ * @return Start of the first top-level element at or after \p min, NULL if there is none or the markup is invalid.
+ */
+const char *lyxml_next_root(const char *data, const char *min);
+
 /**
  * @brief Get the first UTF-8 character value (4bytes) from buffer
  * @param[in] ctx Context to store errors in.
@@ -2928,6 +2928,68 @@ error:
     return NULL;
 }
 
+struct lyxp_expr *
+lyxp_compile_expr(struct ly_ctx *ctx, const char *expr)
+{
+    struct lyxp_expr *exp;
+    uint16_t exp_idx = 0;
+
+    exp = lyxp_parse_expr(ctx, expr);
+    if (!exp) {
+        return NULL;
+    }
+
+    if (reparse_or_expr(ctx, exp, &exp_idx)) {
+        lyxp_expr_free(exp);
+        return NULL;
+    } else if (exp->used > exp_idx) {
+        LOGVAL(ctx, LYE_XPATH_INTOK, LY_VLOG_NONE, NULL, "Unknown", &exp->expr[exp->expr_pos[exp_idx]]);
+        LOGVAL(ctx, LYE_SPEC, LY_VLOG_NONE, NULL, "Unparsed characters \"%s\" left at the end of an XPath expression.",
+               &exp->expr[exp->expr_pos[exp_idx]]);
+        lyxp_expr_free(exp);
+        return NULL;
+    }
+
+    print_expr_struct_debug(exp);
+    return exp;
+}
+
+#ifdef LY_ENABLED_CACHE
+
+/**
+ * @brief Get the compiled form of a schema XPath expression, compile and store it if not yet done.
+ *
+ * @param[in] ctx Context for errors.
+ * @param[in] expr XPath expression.
+ * @param[in,out] compiled Storage of the compiled \p expr.
+ *
+ * @return Compiled expression or NULL on error.
+ */
+static struct lyxp_expr *
+lyxp_get_compiled(struct ly_ctx *ctx, const char *expr, void **compiled)
+{
+    struct lyxp_expr *exp;
+
+    exp = *(struct lyxp_expr * volatile *)compiled;
+    if (exp) {
+        return exp;
+    }
+
+    exp = lyxp_compile_expr(ctx, expr);
+    if (!exp) {
+        return NULL;
+    }
+
+    /* the schema can be shared by several threads evaluating data, the first one to finish stores the expression */
+    if (!__sync_bool_compare_and_swap(compiled, NULL, exp)) {
+        lyxp_expr_free(exp);
+        exp = *compiled;
+    }
+    return exp;
+}
+
+#endif
+
 /*
  * warn functions
  *
@@ -3661,7 +3723,7 @@ xpath_deref(struct lyxp_set **args, uint16_t UNUSED(arg_count), struct lyd_node
             if (leaf->value_flags & LY_VALUE_UNRES) {
                 /* this means that the target may exist except it cannot be stored in the value */
                 if (sleaf->type.base == LY_TYPE_LEAFREF) {
-                    resolve_leafref(leaf, sleaf->type.info.lref.path, -1, &target);
+                    resolve_leafref(leaf, &sleaf->type, -1, NULL, &target);
                 } else {
                     resolve_instid((struct lyd_node *)leaf, leaf->value_str, -1, &target);
                 }
@@ -8663,41 +8725,17 @@ eval_expr_select(struct lyxp_expr *exp, uint16_t *exp_idx, enum lyxp_expr_type e
 }
 
 int
-lyxp_eval(const char *expr, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
-          const struct lys_module *local_mod, struct lyxp_set *set, int options)
+lyxp_eval_expr(struct lyxp_expr *exp, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
+               const struct lys_module *local_mod, struct lyxp_set *set, int options)
 {
-    struct ly_ctx *ctx;
-    struct lyxp_expr *exp;
     uint16_t exp_idx = 0;
-    int rc = -1;
+    int rc;
 
-    if (!expr || !local_mod || !set) {
+    if (!exp || !local_mod || !set) {
         LOGARG;
         return EXIT_FAILURE;
     }
 
-    ctx = local_mod->ctx;
-
-    exp = lyxp_parse_expr(ctx, expr);
-    if (!exp) {
-        rc = -1;
-        goto finish;
-    }
-
-    rc = reparse_or_expr(ctx, exp, &exp_idx);
-    if (rc) {
-        goto finish;
-    } else if (exp->used > exp_idx) {
-        LOGVAL(ctx, LYE_XPATH_INTOK, LY_VLOG_NONE, NULL, "Unknown", &exp->expr[exp->expr_pos[exp_idx]]);
-        LOGVAL(ctx, LYE_SPEC, LY_VLOG_NONE, NULL, "Unparsed characters \"%s\" left at the end of an XPath expression.",
-               &exp->expr[exp->expr_pos[exp_idx]]);
-        rc = -1;
-        goto finish;
-    }
-
-    print_expr_struct_debug(exp);
-
-    exp_idx = 0;
     memset(set, 0, sizeof *set);
     set->type = LYXP_SET_EMPTY;
     if (cur_node) {
@@ -8709,15 +8747,62 @@ lyxp_eval(const char *expr, const struct lyd_node *cur_node, enum lyxp_node_type
         rc = EXIT_SUCCESS;
     }
     if ((rc == -1) && cur_node) {
-        LOGPATH(ctx, LY_VLOG_LYD, cur_node);
+        LOGPATH(local_mod->ctx, LY_VLOG_LYD, cur_node);
         lyxp_set_cast(set, LYXP_SET_EMPTY, cur_node, local_mod, options);
     }
 
-finish:
+    return rc;
+}
+
+int
+lyxp_eval(const char *expr, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
+          const struct lys_module *local_mod, struct lyxp_set *set, int options)
+{
+    struct lyxp_expr *exp;
+    int rc;
+
+    if (!expr || !local_mod || !set) {
+        LOGARG;
+        return EXIT_FAILURE;
+    }
+
+    exp = lyxp_compile_expr(local_mod->ctx, expr);
+    if (!exp) {
+        return -1;
+    }
+
+    rc = lyxp_eval_expr(exp, cur_node, cur_node_type, local_mod, set, options);
+
     lyxp_expr_free(exp);
     return rc;
 }
 
+int
+lyxp_eval_cached(const char *expr, void **compiled, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
+                 const struct lys_module *local_mod, struct lyxp_set *set, int options)
+{
+#ifdef LY_ENABLED_CACHE
+    struct lyxp_expr *exp;
+
+    if (!expr || !local_mod || !set) {
+        LOGARG;
+        return EXIT_FAILURE;
+    }
+
+    if (compiled) {
+        exp = lyxp_get_compiled(local_mod->ctx, expr, compiled);
+        if (!exp) {
+            return -1;
+        }
+        return lyxp_eval_expr(exp, cur_node, cur_node_type, local_mod, set, options);
+    }
+#else
+    (void)compiled;
+#endif
+
+    return lyxp_eval(expr, cur_node, cur_node_type, local_mod, set, options);
+}
+
 #if 0
 
 /* full xml printing of set elements, not used currently */
@@ -8964,34 +9049,17 @@ lyxp_set_cast(struct lyxp_set *set, enum lyxp_set_type target, const struct lyd_
     return EXIT_SUCCESS;
 }
 
-int
-lyxp_atomize(const char *expr, const struct lys_node *cur_snode, enum lyxp_node_type cur_snode_type,
+/**
+ * @brief Get all the partial XPath nodes (atoms) of an already compiled expression, see lyxp_atomize().
+ */
+static int
+atomize_expr(struct lyxp_expr *exp, const struct lys_node *cur_snode, enum lyxp_node_type cur_snode_type,
              struct lyxp_set *set, int options, const struct lys_node **ctx_snode)
 {
     struct lys_node *_ctx_snode;
     enum lyxp_node_type ctx_snode_type;
-    struct lyxp_expr *exp;
     uint16_t exp_idx = 0;
-    int rc = -1;
-
-    exp = lyxp_parse_expr(cur_snode->module->ctx, expr);
-    if (!exp) {
-        rc = -1;
-        goto finish;
-    }
-
-    rc = reparse_or_expr(cur_snode->module->ctx, exp, &exp_idx);
-    if (rc) {
-        goto finish;
-    } else if (exp->used > exp_idx) {
-        LOGVAL(cur_snode->module->ctx, LYE_XPATH_INTOK, LY_VLOG_NONE, NULL, "Unknown", &exp->expr[exp->expr_pos[exp_idx]]);
-        LOGVAL(cur_snode->module->ctx, LYE_SPEC, LY_VLOG_NONE, NULL, "Unparsed characters \"%s\" left at the end of an XPath expression.",
-               &exp->expr[exp->expr_pos[exp_idx]]);
-        rc = -1;
-        goto finish;
-    }
-
-    print_expr_struct_debug(exp);
+    int rc;
 
     if (options & LYXP_SNODE_WHEN) {
         /* for when the context node may need to be changed */
@@ -9005,7 +9073,6 @@ lyxp_atomize(const char *expr, const struct lys_node *cur_snode, enum lyxp_node_
         *ctx_snode = _ctx_snode;
     }
 
-    exp_idx = 0;
     memset(set, 0, sizeof *set);
     set->type = LYXP_SET_SNODE_SET;
     set_snode_insert_node(set, _ctx_snode, ctx_snode_type);
@@ -9015,11 +9082,48 @@ lyxp_atomize(const char *expr, const struct lys_node *cur_snode, enum lyxp_node_
         rc = EXIT_SUCCESS;
     }
 
-finish:
+    return rc;
+}
+
+int
+lyxp_atomize(const char *expr, const struct lys_node *cur_snode, enum lyxp_node_type cur_snode_type,
+             struct lyxp_set *set, int options, const struct lys_node **ctx_snode)
+{
+    struct lyxp_expr *exp;
+    int rc;
+
+    exp = lyxp_compile_expr(cur_snode->module->ctx, expr);
+    if (!exp) {
+        return -1;
+    }
+
+    rc = atomize_expr(exp, cur_snode, cur_snode_type, set, options, ctx_snode);
+
     lyxp_expr_free(exp);
     return rc;
 }
 
+/**
+ * @brief Atomize an XPath expression of a schema statement, use (and create) its compiled form if possible.
+ */
+static int
+atomize_cached(const char *expr, void **compiled, const struct lys_node *cur_snode, enum lyxp_node_type cur_snode_type,
+               struct lyxp_set *set, int options, const struct lys_node **ctx_snode)
+{
+#ifdef LY_ENABLED_CACHE
+    struct lyxp_expr *exp;
+
+    exp = lyxp_get_compiled(cur_snode->module->ctx, expr, compiled);
+    if (!exp) {
+        return -1;
+    }
+    return atomize_expr(exp, cur_snode, cur_snode_type, set, options, ctx_snode);
+#else
+    (void)compiled;
+    return lyxp_atomize(expr, cur_snode, cur_snode_type, set, options, ctx_snode);
+#endif
+}
+
 int
 lyxp_node_atomize(const struct lys_node *node, struct lyxp_set *set, int set_ext_dep_flags)
 {
@@ -9105,7 +9209,8 @@ lyxp_node_atomize(const struct lys_node *node, struct lyxp_set *set, int set_ext
 
     /* check "when" */
     if (when) {
-        if (lyxp_atomize(when->cond, node, LYXP_NODE_ELEM, &tmp_set, LYXP_SNODE_WHEN | opts, &ctx_snode)) {
+        if (atomize_cached(when->cond, LYXP_COMPILED(when), node, LYXP_NODE_ELEM, &tmp_set, LYXP_SNODE_WHEN | opts,
+                           &ctx_snode)) {
             free(tmp_set.val.snodes);
             if (ctx_snode) {
                 path = lys_path(ctx_snode, LYS_PATH_FIRST_PREFIX);
@@ -9152,7 +9257,8 @@ lyxp_node_atomize(const struct lys_node *node, struct lyxp_set *set, int set_ext
 
     /* check "must" */
     for (i = 0; i < must_size; ++i) {
-        if (lyxp_atomize(must[i].expr, node, LYXP_NODE_ELEM, &tmp_set, LYXP_SNODE_MUST | opts, &ctx_snode)) {
+        if (atomize_cached(must[i].expr, LYXP_COMPILED(&must[i]), node, LYXP_NODE_ELEM, &tmp_set,
+                           LYXP_SNODE_MUST | opts, &ctx_snode)) {
             free(tmp_set.val.snodes);
             if (ctx_snode) {
                 path = lys_path(ctx_snode, LYS_PATH_FIRST_PREFIX);
@@ -256,6 +256,51 @@ struct lyxp_set {
 int lyxp_eval(const char *expr, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
               const struct lys_module *local_mod, struct lyxp_set *set, int options);
 
+/**
+ * @brief Evaluate an already compiled XPath expression on data. Works exactly like lyxp_eval(), but the
+ * expression is not parsed again so it is suitable for expressions evaluated repeatedly.
+ *
+ * @param[in] exp Compiled XPath expression, see lyxp_compile_expr(). It is not modified.
+ * @param[in] cur_node Current (context) data node, see lyxp_eval().
+ * @param[in] cur_node_type Current (context) data node type, see lyxp_eval().
+ * @param[in] local_mod Local module relative to the \p exp.
+ * @param[out] set Result set, see lyxp_eval().
+ * @param[in] options Whether to apply some evaluation restrictions, see lyxp_eval().
+ *
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on unresolved when dependency, -1 on error.
+ */
+int lyxp_eval_expr(struct lyxp_expr *exp, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
+                   const struct lys_module *local_mod, struct lyxp_set *set, int options);
+
+/**
+ * @brief Evaluate an XPath expression of a schema statement on data, compile it only once.
+ * On the first evaluation, \p expr is compiled and stored in \p compiled, later evaluations
+ * use the stored expression. Storing the compiled expression is thread-safe.
+ *
+ * @param[in] expr XPath expression to evaluate. Must be in JSON format (prefixes are model names).
+ * @param[in,out] compiled Storage of the compiled \p expr, see #LYXP_COMPILED. If NULL, \p expr is simply
+ * evaluated using lyxp_eval().
+ * @param[in] cur_node Current (context) data node, see lyxp_eval().
+ * @param[in] cur_node_type Current (context) data node type, see lyxp_eval().
+ * @param[in] local_mod Local module relative to the \p expr.
+ * @param[out] set Result set, see lyxp_eval().
+ * @param[in] options Whether to apply some evaluation restrictions, see lyxp_eval().
+ *
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on unresolved when dependency, -1 on error.
+ */
+int lyxp_eval_cached(const char *expr, void **compiled, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
+                     const struct lys_module *local_mod, struct lyxp_set *set, int options);
+
+/**
+ * @brief Get the storage of a compiled XPath expression of ::lys_when, ::lys_restr (must)
+ * or ::lys_type_info_lref to be passed to lyxp_eval_cached(), NULL if caching is disabled.
+ */
+#ifdef LY_ENABLED_CACHE
+#   define LYXP_COMPILED(item) (&(item)->compiled)
+#else
+#   define LYXP_COMPILED(item) NULL
+#endif
+
 /**
  * @brief Get all the partial XPath nodes (atoms) that are required for \p expr to be evaluated.
  *
@@ -347,6 +392,17 @@ void lyxp_set_free(struct lyxp_set *set);
  */
 struct lyxp_expr *lyxp_parse_expr(struct ly_ctx *ctx, const char *expr);
 
+/**
+ * @brief Parse an XPath expression and check its full syntax so that it can be evaluated
+ *        repeatedly using lyxp_eval_expr(). Logs directly.
+ *
+ * @param[in] ctx Context for errors.
+ * @param[in] expr XPath expression to compile. It is duplicated.
+ *
+ * @return Compiled expression or NULL on error.
+ */
+struct lyxp_expr *lyxp_compile_expr(struct ly_ctx *ctx, const char *expr);
+
 /**
  * @brief Frees a parsed XPath expression. \p expr should not be used afterwards.
  *
@@ -346,7 +346,7 @@ test_move2(void **state)
 
     assert_int_equal(diff->type[0], LYD_DIFF_MOVEDAFTER1);
     assert_ptr_not_equal(diff->first[0], NULL);
-    assert_string_equal((str = lyd_path(diff->first[0])), "/defaults:df/llist[.='2']");
+    assert_string_equal((str = lyd_path(diff->first[0])), "/defaults:df/llist[.='3']");
     free(str);
     assert_ptr_not_equal(diff->second[0], NULL);
     assert_string_equal((str = lyd_path(diff->second[0])), "/defaults:df/llist[.='4']");
@@ -354,10 +354,10 @@ test_move2(void **state)
 
     assert_int_equal(diff->type[1], LYD_DIFF_MOVEDAFTER1);
     assert_ptr_not_equal(diff->first[1], NULL);
-    assert_string_equal((str = lyd_path(diff->first[1])), "/defaults:df/llist[.='4']");
+    assert_string_equal((str = lyd_path(diff->first[1])), "/defaults:df/llist[.='2']");
     free(str);
     assert_ptr_not_equal(diff->second[1], NULL);
-    assert_string_equal((str = lyd_path(diff->second[1])), "/defaults:df/llist[.='1']");
+    assert_string_equal((str = lyd_path(diff->second[1])), "/defaults:df/llist[.='3']");
     free(str);
 
     assert_int_equal(diff->type[2], LYD_DIFF_END);
@@ -405,6 +405,167 @@ test_move3(void **state)
     lyd_free_diff(diff);
 }
 
+static void
+test_move_random(void **state)
+{
+    struct state *st = (*state);
+    struct lyd_node *iter, *first_inst;
+    struct lyd_difflist *diff;
+    int perm[200], lis[200], count, moves, longest, i, j, r;
+    char buf[16], *str1, *str2;
+
+    srand(42);
+    for (r = 0; r < 20; r++) {
+        /* second is a random subset of the first in a random order */
+        for (i = 0; i < 200; i++) {
+            perm[i] = i;
+        }
+        for (i = 199; i > 0; i--) {
+            j = rand() % (i + 1);
+            count = perm[i];
+            perm[i] = perm[j];
+            perm[j] = count;
+        }
+        count = 200 - (r % 4) * 10;
+
+        assert_ptr_not_equal((st->first = lyd_new(NULL, st->mod, "df")), NULL);
+        assert_ptr_not_equal((st->second = lyd_new(NULL, st->mod, "df")), NULL);
+        for (i = 0; i < 200; i++) {
+            sprintf(buf, "%d", i);
+            assert_ptr_not_equal(lyd_new_leaf(st->first, st->mod, "llist", buf), NULL);
+        }
+        for (i = 0; i < count; i++) {
+            sprintf(buf, "%d", perm[i]);
+            assert_ptr_not_equal(lyd_new_leaf(st->second, st->mod, "llist", buf), NULL);
+        }
+
+        /* the minimal number of moves is given by the longest increasing subsequence */
+        longest = 0;
+        for (i = 0; i < count; i++) {
+            lis[i] = 1;
+            for (j = 0; j < i; j++) {
+                if ((perm[j] < perm[i]) && (lis[j] + 1 > lis[i])) {
+                    lis[i] = lis[j] + 1;
+                }
+            }
+            if (lis[i] > longest) {
+                longest = lis[i];
+            }
+        }
+
+        assert_ptr_not_equal((diff = lyd_diff(st->first, st->second, 0)), NULL);
+
+        /* apply the diff on the first tree */
+        moves = 0;
+        for (i = 0; diff->type[i] != LYD_DIFF_END; i++) {
+            switch (diff->type[i]) {
+            case LYD_DIFF_DELETED:
+                lyd_free(diff->first[i]);
+                break;
+            case LYD_DIFF_MOVEDAFTER1:
+                ++moves;
+                if (diff->second[i]) {
+                    assert_int_equal(lyd_insert_after(diff->second[i], diff->first[i]), 0);
+                } else {
+                    first_inst = NULL;
+                    LY_TREE_FOR(st->first->child, iter) {
+                        if (iter->schema == diff->first[i]->schema) {
+                            first_inst = iter;
+                            break;
+                        }
+                    }
+                    if (first_inst != diff->first[i]) {
+                        assert_int_equal(lyd_insert_before(first_inst, diff->first[i]), 0);
+                    }
+                }
+                break;
+            default:
+                fail();
+            }
+        }
+        lyd_free_diff(diff);
+        assert_int_equal(moves, count - longest);
+
+        assert_int_equal(lyd_print_mem(&str1, st->first, LYD_XML, 0), 0);
+        assert_int_equal(lyd_print_mem(&str2, st->second, LYD_XML, 0), 0);
+        assert_string_equal(str1, str2);
+        free(str1);
+        free(str2);
+
+        lyd_free(st->first);
+        lyd_free(st->second);
+        st->first = st->second = NULL;
+    }
+}
+
+static void
+test_hashed(void **state)
+{
+    struct state *st = (*state);
+    const char *xml1 = "<df xmlns=\"urn:libyang:tests:defaults\">"
+                         "<list><name>a</name><value>1</value></list>"
+                         "<list><name>b</name><value>2</value></list>"
+                         "<llist>1</llist>"
+                       "</df>";
+    const char *xml2 = "<df xmlns=\"urn:libyang:tests:defaults\">"
+                         "<list><name>a</name><value>1</value></list>"
+                         "<list><name>b</name><value>3</value></list>"
+                         "<llist>1</llist>"
+                       "</df>";
+    char *str;
+    struct lyd_node *list1, *list2;
+    struct lyd_difflist *diff;
+
+    assert_ptr_not_equal((st->first = lyd_parse_mem(st->ctx, xml1, LYD_XML, LYD_OPT_CONFIG)), NULL);
+    assert_ptr_not_equal((st->second = lyd_parse_mem(st->ctx, xml2, LYD_XML, LYD_OPT_CONFIG)), NULL);
+    list1 = st->first->child;
+    list2 = st->second->child->next;
+
+    /* the cached hashes of the same subtrees are used */
+    lyd_subtree_hash(st->first);
+    lyd_subtree_hash(st->second);
+    assert_ptr_not_equal((diff = lyd_diff(st->first, st->second, 0)), NULL);
+    assert_int_equal(diff->type[0], LYD_DIFF_CHANGED);
+    assert_string_equal((str = lyd_path(diff->first[0])), "/defaults:df/list[name='b']/value");
+    free(str);
+    assert_int_equal(diff->type[1], LYD_DIFF_END);
+    lyd_free_diff(diff);
+
+    /* modified after hashing */
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)list2->child->next, "2"), 0);
+    assert_ptr_not_equal((diff = lyd_diff(st->first, st->second, 0)), NULL);
+    assert_int_equal(diff->type[0], LYD_DIFF_END);
+    lyd_free_diff(diff);
+
+    lyd_subtree_hash(st->second);
+    assert_int_equal(lyd_subtree_equal(st->first, st->second), 1);
+    assert_ptr_not_equal((diff = lyd_diff(st->first, st->second, 0)), NULL);
+    assert_int_equal(diff->type[0], LYD_DIFF_END);
+    lyd_free_diff(diff);
+
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)list1->child->next, "5"), 0);
+    assert_ptr_not_equal((diff = lyd_diff(st->first, st->second, 0)), NULL);
+    assert_int_equal(diff->type[0], LYD_DIFF_CHANGED);
+    assert_string_equal((str = lyd_path(diff->first[0])), "/defaults:df/list[name='a']/value");
+    free(str);
+    assert_int_equal(diff->type[1], LYD_DIFF_END);
+    lyd_free_diff(diff);
+
+#ifdef LY_ENABLED_CACHE
+    /* colliding hashes of different subtrees */
+    lyd_subtree_hash(st->first);
+    lyd_subtree_hash(st->second);
+    st->second->content_hash = st->first->content_hash;
+    assert_int_equal(lyd_subtree_equal(st->first, st->second), 0);
+    assert_ptr_not_equal((diff = lyd_diff(st->first, st->second, 0)), NULL);
+    assert_int_equal(diff->type[0], LYD_DIFF_CHANGED);
+    assert_string_equal((str = lyd_path(diff->first[0])), "/defaults:df/list[name='a']/value");
+    free(str);
+    assert_int_equal(diff->type[1], LYD_DIFF_END);
+    lyd_free_diff(diff);
+#endif
+}
+
 static void
 test_mix1(void **state)
 {
@@ -573,6 +734,8 @@ int main(void)
                     cmocka_unit_test_setup_teardown(test_move1, setup_f, teardown_f),
                     cmocka_unit_test_setup_teardown(test_move2, setup_f, teardown_f),
                     cmocka_unit_test_setup_teardown(test_move3, setup_f, teardown_f),
+                    cmocka_unit_test_setup_teardown(test_move_random, setup_f, teardown_f),
+                    cmocka_unit_test_setup_teardown(test_hashed, setup_f, teardown_f),
                     cmocka_unit_test_setup_teardown(test_mix1, setup_f, teardown_f),
                     cmocka_unit_test_setup_teardown(test_mix2, setup_f, teardown_f),
                     cmocka_unit_test_setup_teardown(test_wd1, setup_f, teardown_f), };
@@ -38,6 +38,18 @@ struct ly_ctx *ctx = NULL;
 struct lyd_node *root = NULL;
 const struct lys_module *module = NULL;
 
+static uint32_t
+dict_used_count(struct ly_ctx *ctx)
+{
+    uint32_t i, used = 0;
+
+    for (i = 0; i < LYDICT_SHARD_COUNT; ++i) {
+        used += ctx->dict.shards[i].hash_tab->used;
+    }
+
+    return used;
+}
+
 static int
 setup_f(void **state)
 {
@@ -464,25 +476,25 @@ test_ly_ctx_clean(void **state)
     /* remember starting values */
     setid = ctx->models.module_set_id;
     modules_count = ctx->models.used;
-    dict_used = ctx->dict.hash_tab->used;
+    dict_used = dict_used_count(ctx);
 
     /* add a module */
     mod = ly_ctx_load_module(ctx, "x", NULL);
     assert_ptr_not_equal(mod, NULL);
     assert_int_equal(modules_count + 1, ctx->models.used);
-    assert_int_not_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_not_equal(dict_used, dict_used_count(ctx));
 
     /* clean the context */
     ly_ctx_clean(ctx, NULL);
     assert_int_equal(setid + 2, ctx->models.module_set_id);
     assert_int_equal(modules_count, ctx->models.used);
-    assert_int_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_equal(dict_used, dict_used_count(ctx));
 
     /* add a module again ... */
     mod = ly_ctx_load_module(ctx, "x", NULL);
     assert_ptr_not_equal(mod, NULL);
     assert_int_equal(modules_count + 1, ctx->models.used);
-    assert_int_not_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_not_equal(dict_used, dict_used_count(ctx));
 
     /* .. and add some string into dictionary */
     assert_ptr_not_equal(lydict_insert(ctx, "qwertyuiop", 0), NULL);
@@ -492,7 +504,7 @@ test_ly_ctx_clean(void **state)
     ly_ctx_clean(ctx, NULL);
     assert_int_equal(setid + 4, ctx->models.module_set_id);
     assert_int_equal(modules_count, ctx->models.used);
-    assert_int_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_equal(dict_used, dict_used_count(ctx));
 
     /* cleanup */
     lydict_remove(ctx, "qwertyuiop");
@@ -512,7 +524,7 @@ test_ly_ctx_remove_module(void **state)
     /* remember starting values */
     setid = ctx->models.module_set_id;
     modules_count = ctx->models.used;
-    dict_used = ctx->dict.hash_tab->used;
+    dict_used = dict_used_count(ctx);
 
     mod = ly_ctx_load_module(ctx, "x", NULL);
     ly_ctx_remove_module(mod, NULL);
@@ -523,7 +535,7 @@ test_ly_ctx_remove_module(void **state)
     assert_true(setid < ctx->models.module_set_id);
     setid = ctx->models.module_set_id;
     assert_int_equal(modules_count + 2, ctx->models.used);
-    assert_int_not_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_not_equal(dict_used, dict_used_count(ctx));
 
     /* remove the imported module (x), that should cause removing also the loaded module (y) */
     mod = ly_ctx_get_module(ctx, "x", NULL, 0);
@@ -532,7 +544,7 @@ test_ly_ctx_remove_module(void **state)
     assert_true(setid < ctx->models.module_set_id);
     setid = ctx->models.module_set_id;
     assert_int_equal(modules_count, ctx->models.used);
-    assert_int_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_equal(dict_used, dict_used_count(ctx));
 
     /* add a module again ... */
     mod = ly_ctx_load_module(ctx, "y", NULL);
@@ -540,14 +552,14 @@ test_ly_ctx_remove_module(void **state)
     assert_true(setid < ctx->models.module_set_id);
     setid = ctx->models.module_set_id;
     assert_int_equal(modules_count + 2, ctx->models.used);
-    assert_int_not_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_not_equal(dict_used, dict_used_count(ctx));
     /* ... now remove the loaded module, the imported module is supposed to be removed because it is not
      * used in any other module */
     ly_ctx_remove_module(mod, NULL);
     assert_true(setid < ctx->models.module_set_id);
     setid = ctx->models.module_set_id;
     assert_int_equal(modules_count, ctx->models.used);
-    assert_int_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_equal(dict_used, dict_used_count(ctx));
 
     /* add a module again ... */
     mod = ly_ctx_load_module(ctx, "y", NULL);
@@ -555,7 +567,7 @@ test_ly_ctx_remove_module(void **state)
     assert_true(setid < ctx->models.module_set_id);
     setid = ctx->models.module_set_id;
     assert_int_equal(modules_count + 2, ctx->models.used);
-    assert_int_not_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_not_equal(dict_used, dict_used_count(ctx));
     /* and mark even the imported module 'x' as implemented ... */
     assert_int_equal(lys_set_implemented(mod->imp[0].module), EXIT_SUCCESS);
     /* ... now remove the loaded module, the imported module is supposed to be kept because it is implemented */
@@ -563,7 +575,7 @@ test_ly_ctx_remove_module(void **state)
     assert_true(setid < ctx->models.module_set_id);
     setid = ctx->models.module_set_id;
     assert_int_equal(modules_count + 1, ctx->models.used);
-    assert_int_not_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_not_equal(dict_used, dict_used_count(ctx));
     mod = ly_ctx_get_module(ctx, "y", NULL, 0);
     assert_ptr_equal(mod, NULL);
     mod = ly_ctx_get_module(ctx, "x", NULL, 0);
@@ -575,7 +587,7 @@ test_ly_ctx_remove_module(void **state)
     assert_true(setid < ctx->models.module_set_id);
     setid = ctx->models.module_set_id;
     assert_int_equal(modules_count + 2, ctx->models.used);
-    assert_int_not_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_not_equal(dict_used, dict_used_count(ctx));
     /* and add another one also importing module 'x' ... */
     assert_ptr_not_equal(ly_ctx_load_module(ctx, "z", NULL), NULL);
     assert_true(setid < ctx->models.module_set_id);
@@ -587,7 +599,7 @@ test_ly_ctx_remove_module(void **state)
     assert_true(setid < ctx->models.module_set_id);
     setid = ctx->models.module_set_id;
     assert_int_equal(modules_count + 2, ctx->models.used);
-    assert_int_not_equal(dict_used, ctx->dict.hash_tab->used);
+    assert_int_not_equal(dict_used, dict_used_count(ctx));
     mod = ly_ctx_get_module(ctx, "y", NULL, 0);
     assert_ptr_equal(mod, NULL);
     mod = ly_ctx_get_module(ctx, "x", NULL, 0);
@@ -765,6 +777,45 @@ test_ly_ctx_get_module_by_ns(void **state)
     assert_string_equal("b", module->name);
 }
 
+static void
+test_ly_ctx_get_module_revisions(void **state)
+{
+    (void) state; /* unused */
+    const struct lys_module *module, *imp;
+
+    /* imports a@2015-01-01 and b@2015-01-01 */
+    module = ly_ctx_load_module(ctx, "c", NULL);
+    assert_ptr_not_equal(module, NULL);
+
+    /* the newest and the implemented revision */
+    imp = ly_ctx_get_module(ctx, "a", NULL, 0);
+    assert_ptr_not_equal(imp, NULL);
+    assert_string_equal(imp->rev[0].date, "2016-03-01");
+    assert_ptr_equal(ly_ctx_get_module(ctx, "a", NULL, 1), imp);
+    assert_ptr_equal(ly_ctx_get_module_by_ns(ctx, "urn:a", NULL, 0), imp);
+
+    /* specific revisions */
+    imp = ly_ctx_get_module(ctx, "a", "2015-01-01", 0);
+    assert_ptr_not_equal(imp, NULL);
+    assert_int_equal(imp->implemented, 0);
+    assert_ptr_equal(ly_ctx_get_module_by_ns(ctx, "urn:a", "2015-01-01", 0), imp);
+
+    /* disabled modules are skipped */
+    assert_int_equal(lys_set_disabled(module), 0);
+    assert_ptr_equal(ly_ctx_get_module(ctx, "c", NULL, 0), NULL);
+    assert_ptr_equal(ly_ctx_get_module_by_ns(ctx, "urn:c", NULL, 0), NULL);
+    assert_int_equal(lys_set_enabled(module), 0);
+    assert_ptr_equal(ly_ctx_get_module(ctx, "c", NULL, 0), module);
+
+    /* removed modules are not found, including the no longer needed imports */
+    assert_int_equal(ly_ctx_remove_module(module, NULL), 0);
+    assert_ptr_equal(ly_ctx_get_module(ctx, "c", NULL, 0), NULL);
+    assert_ptr_equal(ly_ctx_get_module(ctx, "a", "2015-01-01", 0), NULL);
+    imp = ly_ctx_get_module(ctx, "a", NULL, 0);
+    assert_ptr_not_equal(imp, NULL);
+    assert_string_equal(imp->rev[0].date, "2016-03-01");
+}
+
 static void
 test_ly_ctx_get_submodule(void **state)
 {
@@ -1388,6 +1439,81 @@ test_ly_ctx_get_node(void **state)
     }
 }
 
+void
+test_ly_ctx_child_index(void **state)
+{
+    (void) state;
+    const char *yang =
+        "module wide {namespace urn:wide; prefix w; feature f;"
+        "  grouping g {leaf g1 {type string;} leaf g2 {type string;}}"
+        "  container c {"
+        "    leaf l0 {type string;} leaf l1 {type string;} leaf l2 {type string;} leaf l3 {type string;}"
+        "    leaf l4 {type string;} leaf l5 {type string;} leaf l6 {type string;} leaf l7 {type string;}"
+        "    choice ch {case a {leaf ca {type string;}} leaf cb {type string;}}"
+        "    uses g;"
+        "    leaf lf {if-feature f; type string;}"
+        "  }"
+        "}";
+    const char *yang_aug =
+        "module wide-aug {namespace urn:wide-aug; prefix a; import wide {prefix w;}"
+        "  augment /w:c {leaf extra {type string;}}"
+        "}";
+    const struct lys_module *mod, *aug;
+    struct lyd_node *data;
+    char name[8], *str;
+    LYD_FORMAT formats[] = {LYD_XML, LYD_JSON, LYD_LYB};
+    int i;
+
+    ctx = ly_ctx_new(NULL, 0);
+    assert_non_null(ctx);
+    mod = lys_parse_mem(ctx, yang, LYS_IN_YANG);
+    assert_non_null(mod);
+
+    /* enough lookups in a wide container to have its children indexed */
+    root = lyd_new(NULL, mod, "c");
+    assert_non_null(root);
+    for (i = 0; i < 8; ++i) {
+        sprintf(name, "l%d", i);
+        assert_non_null(lyd_new_leaf(root, NULL, name, "value"));
+    }
+    assert_non_null(ctx->schema_index);
+
+    /* choice, case and uses are transparent */
+    assert_non_null(lyd_new_leaf(root, NULL, "ca", "value"));
+    assert_non_null(lyd_new_leaf(root, NULL, "g2", "value"));
+    assert_non_null(ly_ctx_get_node(ctx, NULL, "/wide:c/cb", 0));
+    assert_non_null(ly_ctx_get_node(ctx, NULL, "/wide:c/g1", 0));
+    assert_null(ly_ctx_get_node(ctx, NULL, "/wide:c/ch", 0));
+    assert_null(ly_ctx_get_node(ctx, NULL, "/wide:c/none", 0));
+
+    /* the feature state is checked on every lookup */
+    assert_null(lyd_new_leaf(root, NULL, "lf", "value"));
+    assert_int_equal(lys_features_enable(mod, "f"), 0);
+    assert_non_null(lyd_new_leaf(root, NULL, "lf", "value"));
+
+    /* data in all the formats is matched through the index */
+    for (i = 0; i < 3; ++i) {
+        assert_int_equal(lyd_print_mem(&str, root, formats[i], LYP_WITHSIBLINGS), 0);
+        data = lyd_parse_mem(ctx, str, formats[i], LYD_OPT_CONFIG | LYD_OPT_STRICT);
+        free(str);
+        assert_non_null(data);
+        assert_non_null(data->child);
+        assert_string_equal(data->child->prev->schema->name, "lf");
+        lyd_free_withsiblings(data);
+    }
+
+    /* any schema change drops the indexes, the augment is then found */
+    aug = lys_parse_mem(ctx, yang_aug, LYS_IN_YANG);
+    assert_non_null(aug);
+    assert_null(ctx->schema_index);
+    for (i = 0; i < 8; ++i) {
+        assert_non_null(ly_ctx_get_node(ctx, NULL, "/wide:c/wide-aug:extra", 0));
+    }
+    assert_non_null(ctx->schema_index);
+    assert_non_null(lyd_new_leaf(root, aug, "extra", "value"));
+    assert_null(lyd_new_leaf(root, NULL, "extra", "value"));
+}
+
 void
 test_ly_ctx_find_path(void **state)
 {
@@ -1563,6 +1689,89 @@ test_ly_set_contains(void **state)
     }
 }
 
+static void
+test_ly_set_index(void **state)
+{
+    (void) state;
+    struct ly_set *set, *set2, *dup;
+    char items[1000];
+    int i;
+
+    set = ly_set_new();
+    assert_ptr_not_equal(set, NULL);
+
+    /* big enough set to be indexed */
+    for (i = 0; i < 1000; ++i) {
+        assert_int_equal(ly_set_add(set, &items[i], 0), i);
+    }
+    for (i = 999; i >= 0; --i) {
+        assert_int_equal(ly_set_add(set, &items[i], 0), i);
+        assert_int_equal(ly_set_contains(set, &items[i]), i);
+    }
+    assert_int_equal(set->number, 1000);
+    assert_true(set->size >= 1000);
+    assert_true(set->size < 2000);
+
+    /* duplicates allowed explicitly, the first occurrence is found */
+    assert_int_equal(ly_set_add(set, &items[0], LY_SET_OPT_USEASLIST), 1000);
+    assert_int_equal(ly_set_contains(set, &items[0]), 0);
+
+    /* removing moves the last item */
+    assert_int_equal(ly_set_rm_index(set, 1), 0);
+    assert_int_equal(ly_set_contains(set, &items[1]), -1);
+    assert_ptr_equal(set->set.g[1], &items[0]);
+    assert_int_equal(ly_set_contains(set, &items[0]), 0);
+    assert_int_equal(ly_set_rm(set, &items[0]), 0);
+    assert_ptr_equal(set->set.g[0], &items[999]);
+    assert_int_equal(ly_set_contains(set, &items[0]), 1);
+    assert_int_equal(ly_set_rm(set, &items[0]), 0);
+    assert_int_equal(ly_set_contains(set, &items[0]), -1);
+    assert_int_equal(set->number, 998);
+    for (i = 2; i < 1000; ++i) {
+        assert_ptr_equal(set->set.g[ly_set_contains(set, &items[i])], &items[i]);
+    }
+
+    /* a duplicate moved before the previous first occurrence */
+    assert_int_equal(ly_set_contains(set, &items[500]), 500);
+    assert_int_equal(ly_set_add(set, &items[500], LY_SET_OPT_USEASLIST), 998);
+    assert_int_equal(ly_set_rm_index(set, 2), 0);
+    assert_ptr_equal(set->set.g[2], &items[500]);
+    assert_int_equal(ly_set_contains(set, &items[500]), 2);
+    assert_int_equal(ly_set_rm(set, &items[500]), 0);
+    assert_int_equal(ly_set_contains(set, &items[500]), 500);
+    assert_int_equal(ly_set_add(set, &items[2], 0), 997);
+    assert_int_equal(set->number, 998);
+
+    /* merge overlapping sets */
+    set2 = ly_set_new();
+    assert_ptr_not_equal(set2, NULL);
+    for (i = 0; i < 100; ++i) {
+        assert_int_equal(ly_set_add(set2, &items[i], 0), i);
+    }
+    dup = ly_set_dup(set2);
+    assert_ptr_not_equal(dup, NULL);
+    assert_int_equal(ly_set_merge(set, set2, 0), 2);
+    assert_int_equal(set->number, 1000);
+    assert_int_equal(ly_set_contains(set, &items[0]), 998);
+    assert_int_equal(ly_set_contains(set, &items[1]), 999);
+    assert_int_equal(ly_set_merge(set, dup, LY_SET_OPT_USEASLIST), 100);
+    assert_int_equal(set->number, 1100);
+
+    /* the set can be reused after cleaning */
+    assert_int_equal(ly_set_clean(set), 0);
+    assert_int_equal(ly_set_contains(set, &items[5]), -1);
+    for (i = 0; i < 100; ++i) {
+        assert_int_equal(ly_set_add(set, &items[i], 0), i);
+    }
+    dup = ly_set_dup(set);
+    assert_ptr_not_equal(dup, NULL);
+    assert_int_equal(ly_set_add(dup, &items[50], 0), 50);
+    assert_int_equal(ly_set_add(dup, &items[500], 0), 100);
+
+    ly_set_free(dup);
+    ly_set_free(set);
+}
+
 void
 test_ly_vecode(void **state)
 {
@@ -1620,6 +1829,7 @@ int main(void)
         cmocka_unit_test_teardown(test_lys_set_disabled, teardown_f),
         cmocka_unit_test(test_ly_ctx_clean),
         cmocka_unit_test_setup_teardown(test_ly_ctx_get_module_by_ns, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_ly_ctx_get_module_revisions, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_ly_ctx_get_submodule, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_ly_ctx_get_submodule2, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lys_find_path, setup_f, teardown_f),
@@ -1628,6 +1838,7 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_ly_set_rm, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_ly_set_rm_index, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_ly_set_free, setup_f, teardown_f),
+        cmocka_unit_test(test_ly_set_index),
         cmocka_unit_test(test_ly_verb),
         cmocka_unit_test(test_ly_get_log_clb),
         cmocka_unit_test(test_ly_set_log_clb),
@@ -1640,6 +1851,7 @@ int main(void)
         cmocka_unit_test(test_ly_ctx_get_module_iter),
         cmocka_unit_test_setup_teardown(test_ly_ctx_set_trusted, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_ly_ctx_get_node, setup_f, teardown_f),
+        cmocka_unit_test_teardown(test_ly_ctx_child_index, teardown_f),
         cmocka_unit_test_setup_teardown(test_ly_ctx_find_path, setup_f, teardown_f),
         cmocka_unit_test(test_ly_ctx_destroy),
         cmocka_unit_test_setup_teardown(test_ly_path_xml2json, setup_f, teardown_f),
@@ -0,0 +1,297 @@
+/**
+ * @file test_snapshot.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief Cmocka tests for storing a context into a schema snapshot and loading it back.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "tests/config.h"
+#include "libyang.h"
+#include "../../src/context.h"
+
+struct state {
+    struct ly_ctx *ctx;
+    struct ly_ctx *snap_ctx;
+    char path[32];
+};
+
+static int
+setup_f(void **state)
+{
+    struct state *st;
+    const struct lys_module *mod;
+    int fd;
+
+    (*state) = st = calloc(1, sizeof *st);
+    if (!st) {
+        fprintf(stderr, "Memory allocation error");
+        return -1;
+    }
+
+    /* libyang context */
+    st->ctx = ly_ctx_new(TESTS_DIR"/data/files", 0);
+    if (!st->ctx) {
+        fprintf(stderr, "Failed to create context.\n");
+        goto error;
+    }
+
+    /* schemas */
+    mod = lys_parse_path(st->ctx, TESTS_DIR"/data/files/all.yin", LYS_IN_YIN);
+    if (!mod) {
+        fprintf(stderr, "Failed to load data model \"all\".\n");
+        goto error;
+    }
+    lys_features_enable(mod, "*");
+    if (!lys_parse_path(st->ctx, TESTS_DIR"/data/files/all-imp.yin", LYS_IN_YIN)
+            || !lys_parse_path(st->ctx, TESTS_DIR"/data/files/all-dev.yin", LYS_IN_YIN)
+            || !lys_parse_path(st->ctx, TESTS_DIR"/data/files/annotations.yang", LYS_IN_YANG)
+            || !lys_parse_path(st->ctx, TESTS_DIR"/data/files/leafrefs.yin", LYS_IN_YIN)
+            || !lys_parse_path(st->ctx, TESTS_DIR"/data/files/types.yang", LYS_IN_YANG)
+            || !lys_parse_path(st->ctx, TESTS_DIR"/data/files/statements.yang", LYS_IN_YANG)
+            || !ly_ctx_load_module(st->ctx, "ietf-restconf", NULL)) {
+        fprintf(stderr, "Failed to load data models.\n");
+        goto error;
+    }
+
+    /* snapshot */
+    strcpy(st->path, "/tmp/libyang-snapshot-XXXXXX");
+    fd = mkstemp(st->path);
+    if (fd == -1) {
+        fprintf(stderr, "Failed to create a temporary file.\n");
+        goto error;
+    }
+    close(fd);
+    if (ly_ctx_print_snapshot(st->ctx, st->path)) {
+        fprintf(stderr, "Failed to print the snapshot.\n");
+        goto error;
+    }
+    st->snap_ctx = ly_ctx_new_snapshot(TESTS_DIR"/data/files", st->path, 0);
+    if (!st->snap_ctx) {
+        fprintf(stderr, "Failed to load the snapshot.\n");
+        goto error;
+    }
+
+    return 0;
+
+error:
+    if (st->path[0]) {
+        unlink(st->path);
+    }
+    ly_ctx_destroy(st->ctx, NULL);
+    free(st);
+    (*state) = NULL;
+
+    return -1;
+}
+
+static int
+teardown_f(void **state)
+{
+    struct state *st = (*state);
+
+    unlink(st->path);
+    ly_ctx_destroy(st->ctx, NULL);
+    ly_ctx_destroy(st->snap_ctx, NULL);
+    free(st);
+    (*state) = NULL;
+
+    return 0;
+}
+
+static void
+test_snapshot_schema(void **state)
+{
+    struct state *st = (*state);
+    const struct lys_module *mod, *snap_mod;
+    uint32_t idx = 0, snap_idx = 0;
+    char *str1, *str2;
+
+    assert_int_equal(ly_ctx_internal_modules_count(st->snap_ctx), ly_ctx_internal_modules_count(st->ctx));
+    assert_int_equal(ly_ctx_get_module_set_id(st->snap_ctx), ly_ctx_get_module_set_id(st->ctx));
+
+    while ((mod = ly_ctx_get_module_iter(st->ctx, &idx))) {
+        snap_mod = ly_ctx_get_module(st->snap_ctx, mod->name, mod->rev_size ? mod->rev[0].date : NULL, 0);
+        assert_ptr_not_equal(snap_mod, NULL);
+        assert_ptr_equal(snap_mod->ctx, st->snap_ctx);
+        assert_int_equal(snap_mod->implemented, mod->implemented);
+
+        assert_int_equal(lys_print_mem(&str1, mod, LYS_OUT_YANG, NULL, 0, 0), 0);
+        assert_int_equal(lys_print_mem(&str2, snap_mod, LYS_OUT_YANG, NULL, 0, 0), 0);
+        assert_string_equal(str1, str2);
+        free(str1);
+        free(str2);
+
+        assert_int_equal(lys_print_mem(&str1, mod, LYS_OUT_TREE, NULL, 0, 0), 0);
+        assert_int_equal(lys_print_mem(&str2, snap_mod, LYS_OUT_TREE, NULL, 0, 0), 0);
+        assert_string_equal(str1, str2);
+        free(str1);
+        free(str2);
+    }
+    while (ly_ctx_get_module_iter(st->snap_ctx, &snap_idx));
+    assert_int_equal(snap_idx, idx);
+}
+
+static struct lyd_node *
+parse_data(struct ly_ctx *ctx)
+{
+    const char *files[] = {
+        TESTS_DIR"/data/files/annotations.xml",
+        TESTS_DIR"/data/files/leafrefs.xml",
+        TESTS_DIR"/data/files/types.xml",
+        NULL
+    };
+    struct lyd_node *root, *data;
+    int i;
+
+    /* all-dev makes the data of the other modules valid only together with all-data */
+    root = lyd_parse_path(ctx, TESTS_DIR"/data/files/all-data.xml", LYD_XML, LYD_OPT_CONFIG | LYD_OPT_STRICT);
+    if (!root) {
+        return NULL;
+    }
+    for (i = 0; files[i]; ++i) {
+        data = lyd_parse_path(ctx, files[i], LYD_XML, LYD_OPT_CONFIG | LYD_OPT_STRICT | LYD_OPT_TRUSTED);
+        if (!data || lyd_merge(root, data, LYD_OPT_DESTRUCT)) {
+            lyd_free_withsiblings(data);
+            lyd_free_withsiblings(root);
+            return NULL;
+        }
+    }
+    if (lyd_validate(&root, LYD_OPT_CONFIG, NULL)) {
+        lyd_free_withsiblings(root);
+        return NULL;
+    }
+
+    return root;
+}
+
+static void
+test_snapshot_data(void **state)
+{
+    struct state *st = (*state);
+    struct lyd_node *data1, *data2;
+    char *str1, *str2;
+
+    data1 = parse_data(st->ctx);
+    assert_ptr_not_equal(data1, NULL);
+    data2 = parse_data(st->snap_ctx);
+    assert_ptr_not_equal(data2, NULL);
+
+    assert_int_equal(lyd_print_mem(&str1, data1, LYD_XML, LYP_WITHSIBLINGS | LYP_FORMAT), 0);
+    assert_int_equal(lyd_print_mem(&str2, data2, LYD_XML, LYP_WITHSIBLINGS | LYP_FORMAT), 0);
+    assert_string_equal(str1, str2);
+    free(str1);
+    free(str2);
+
+    lyd_free_withsiblings(data1);
+    lyd_free_withsiblings(data2);
+}
+
+static void
+test_snapshot_modify(void **state)
+{
+    struct state *st = (*state);
+    const struct lys_module *mod;
+    struct lyd_node *data;
+    const char *schema =
+        "module snap-aug {"
+            "namespace \"urn:libyang:tests:snap-aug\";"
+            "prefix sa;"
+            "import all { prefix a; }"
+            "augment /a:cont1 {"
+                "leaf snap-leaf { type leafref { path \"../a:leaf3\"; } }"
+            "}"
+        "}";
+
+    /* the loaded context can be extended */
+    mod = lys_parse_mem(st->snap_ctx, schema, LYS_IN_YANG);
+    assert_ptr_not_equal(mod, NULL);
+
+    data = parse_data(st->snap_ctx);
+    assert_ptr_not_equal(data, NULL);
+    assert_ptr_not_equal(lyd_new_path(data, st->snap_ctx, "/all:cont1/snap-aug:snap-leaf", "-100000", 0, 0), NULL);
+    assert_int_equal(lyd_validate(&data, LYD_OPT_CONFIG, NULL), 0);
+    lyd_free_withsiblings(data);
+
+    /* and modules loaded from the snapshot removed */
+    assert_int_equal(ly_ctx_remove_module(mod, NULL), 0);
+    mod = ly_ctx_get_module(st->snap_ctx, "statements", NULL, 0);
+    assert_ptr_not_equal(mod, NULL);
+    assert_int_equal(ly_ctx_remove_module(mod, NULL), 0);
+    assert_ptr_equal(ly_ctx_get_module(st->snap_ctx, "statements", NULL, 0), NULL);
+}
+
+static void
+test_snapshot_invalid(void **state)
+{
+    struct state *st = (*state);
+    struct stat sb;
+    uint64_t obj_size;
+    uint32_t sizes[2];
+    char *data;
+    int fd;
+
+    ly_log_options(0);
+
+    /* objects not fitting into the objects section, the first object size is not aligned */
+    assert_int_equal(stat(st->path, &sb), 0);
+    data = malloc(sb.st_size);
+    assert_non_null(data);
+    fd = open(st->path, O_RDWR);
+    assert_int_not_equal(fd, -1);
+    assert_int_equal(read(fd, data, sb.st_size), sb.st_size);
+    assert_true((size_t)sb.st_size >= LYSNAP_ALIGN(sizeof(struct lysnap_hdr)) + sizeof sizes);
+    assert_true(((struct lysnap_hdr *)data)->obj_count >= 2);
+    obj_size = 12;
+    memcpy(data + offsetof(struct lysnap_hdr, obj_size), &obj_size, sizeof obj_size);
+    sizes[0] = 12;
+    sizes[1] = 4000;
+    memcpy(data + LYSNAP_ALIGN(sizeof(struct lysnap_hdr)), sizes, sizeof sizes);
+    assert_int_equal(pwrite(fd, data, sb.st_size, 0), sb.st_size);
+    close(fd);
+    free(data);
+    assert_ptr_equal(ly_ctx_new_snapshot(NULL, st->path, 0), NULL);
+
+    /* truncated snapshot */
+    assert_int_equal(stat(st->path, &sb), 0);
+    assert_int_equal(truncate(st->path, sb.st_size / 2), 0);
+    assert_ptr_equal(ly_ctx_new_snapshot(NULL, st->path, 0), NULL);
+
+    /* not a snapshot */
+    assert_ptr_equal(ly_ctx_new_snapshot(NULL, TESTS_DIR"/data/files/all.yang", 0), NULL);
+    assert_ptr_equal(ly_ctx_new_snapshot(NULL, TESTS_DIR"/data/files/nonexisting", 0), NULL);
+
+    ly_log_options(LY_LOLOG | LY_LOSTORE_LAST);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_snapshot_schema, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_snapshot_data, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_snapshot_modify, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_snapshot_invalid, setup_f, teardown_f),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,356 @@
+/**
+ * @file test_threads.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief Cmocka tests for concurrent read-only access to a single data tree and modifications of separate trees.
+ *
+ * Build with -fsanitize=thread to also check for data races.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <cmocka.h>
+
+#include "tests/config.h"
+#include "libyang.h"
+
+#define THREADS 8
+#define ITERATIONS 50
+#define ITEMS 500
+
+struct state {
+    struct ly_ctx *ctx;
+    struct lyd_node *first;
+    struct lyd_node *second;
+    char *printed;
+    int diff_count;
+};
+
+static const char *schema =
+    "module threads {"
+        "namespace \"urn:libyang:tests:threads\";"
+        "prefix t;"
+        "container cont {"
+            "list item {"
+                "key \"name\";"
+                "leaf name { type string; }"
+                "leaf value { type uint32; }"
+            "}"
+            "leaf-list ordered {"
+                "type string;"
+                "ordered-by user;"
+            "}"
+            "list stats {"
+                "config false;"
+                "leaf counter { type uint32; }"
+            "}"
+        "}"
+    "}";
+
+static struct lyd_node *
+create_tree(struct ly_ctx *ctx, int modified)
+{
+    struct lyd_node *root = NULL, *node;
+    char path[64], value[16];
+    int i;
+
+    for (i = 0; i < ITEMS; ++i) {
+        sprintf(path, "/threads:cont/item[name='i%d']/value", i);
+        sprintf(value, "%d", (modified && !(i % 10)) ? i + 1 : i);
+        node = lyd_new_path(root, ctx, path, value, 0, 0);
+        if (!node) {
+            goto error;
+        }
+        if (!root) {
+            root = node;
+        }
+
+        if (i < 20) {
+            sprintf(value, "o%d", modified ? 19 - i : i);
+            if (!lyd_new_path(root, ctx, "/threads:cont/ordered", value, 0, 0)) {
+                goto error;
+            }
+
+            /* keyless state list instances with repeating values */
+            sprintf(value, "%d", i % 5);
+            if (!lyd_new_path(root, ctx, "/threads:cont/stats/counter", value, 0, 0)) {
+                goto error;
+            }
+        }
+    }
+
+    if (lyd_validate(&root, LYD_OPT_GET, NULL)) {
+        goto error;
+    }
+    return root;
+
+error:
+    lyd_free_withsiblings(root);
+    return NULL;
+}
+
+static int
+setup_f(void **state)
+{
+    struct state *st;
+    struct lyd_difflist *diff;
+
+    (*state) = st = calloc(1, sizeof *st);
+    if (!st) {
+        fprintf(stderr, "Memory allocation error");
+        return -1;
+    }
+
+    /* libyang context */
+    st->ctx = ly_ctx_new(NULL, 0);
+    if (!st->ctx) {
+        fprintf(stderr, "Failed to create context.\n");
+        goto error;
+    }
+
+    /* schema */
+    if (!lys_parse_mem(st->ctx, schema, LYS_IN_YANG)) {
+        fprintf(stderr, "Failed to load data model.\n");
+        goto error;
+    }
+
+    /* data */
+    st->first = create_tree(st->ctx, 0);
+    st->second = create_tree(st->ctx, 1);
+    if (!st->first || !st->second) {
+        fprintf(stderr, "Failed to create data trees.\n");
+        goto error;
+    }
+
+    /* expected results */
+    if (lyd_print_mem(&st->printed, st->first, LYD_XML, LYP_WITHSIBLINGS)) {
+        goto error;
+    }
+    diff = lyd_diff(st->first, st->second, 0);
+    if (!diff) {
+        goto error;
+    }
+    for (st->diff_count = 0; diff->type[st->diff_count] != LYD_DIFF_END; ++st->diff_count);
+    lyd_free_diff(diff);
+
+    return 0;
+
+error:
+    lyd_free_withsiblings(st->first);
+    lyd_free_withsiblings(st->second);
+    ly_ctx_destroy(st->ctx, NULL);
+    free(st);
+    (*state) = NULL;
+
+    return -1;
+}
+
+static int
+teardown_f(void **state)
+{
+    struct state *st = (*state);
+
+    lyd_free_withsiblings(st->first);
+    lyd_free_withsiblings(st->second);
+    ly_ctx_destroy(st->ctx, NULL);
+    free(st->printed);
+    free(st);
+    (*state) = NULL;
+
+    return 0;
+}
+
+static void *
+query_thread(void *arg)
+{
+    struct state *st = arg;
+    struct ly_set *set;
+    struct lyd_node *node, *match;
+    struct lyd_difflist *diff;
+    char path[64], *str;
+    int i, j, count;
+
+    for (i = 0; i < ITERATIONS; ++i) {
+        /* find a list instance by its key */
+        sprintf(path, "/threads:cont/item[name='i%d']/value", (i * 7) % ITEMS);
+        set = lyd_find_path(st->first, path);
+        if (!set || (set->number != 1) || (((struct lyd_node_leaf_list *)set->set.d[0])->value.uint32 != (uint32_t)((i * 7) % ITEMS))) {
+            ly_set_free(set);
+            return (void *)1;
+        }
+        ly_set_free(set);
+
+        /* find a list instance by its position */
+        j = (i * 11) % ITEMS;
+        sprintf(path, "/threads:cont/item[%d]/name", ITEMS - j);
+        set = lyd_find_path(st->first, path);
+        if (!set || (set->number != 1) || !set->set.d[0]->parent
+                || (lyd_list_pos(set->set.d[0]->parent) != (unsigned)(ITEMS - j))) {
+            ly_set_free(set);
+            return (void *)1;
+        }
+        sprintf(path, "i%d", ITEMS - j - 1);
+        count = strcmp(((struct lyd_node_leaf_list *)set->set.d[0])->value_str, path);
+        ly_set_free(set);
+        if (count) {
+            return (void *)1;
+        }
+
+        /* evaluate a more complex expression */
+        set = lyd_find_path(st->first, "/threads:cont/item[value < 100]/name | //threads:counter[. = 3]");
+        if (!set || (set->number != 104)) {
+            ly_set_free(set);
+            return (void *)1;
+        }
+        ly_set_free(set);
+
+        /* find the sibling by hash */
+        node = lyd_dup(st->second->child, LYD_DUP_OPT_RECURSIVE);
+        if (!node || lyd_find_sibling(st->first->child, node, &match) || !match) {
+            lyd_free(node);
+            return (void *)1;
+        }
+        lyd_free(node);
+
+        /* compare the trees */
+        diff = lyd_diff(st->first, st->second, 0);
+        if (!diff) {
+            return (void *)1;
+        }
+        for (count = 0; diff->type[count] != LYD_DIFF_END; ++count);
+        lyd_free_diff(diff);
+        if (count != st->diff_count) {
+            return (void *)1;
+        }
+
+        /* print the tree */
+        if (lyd_print_mem(&str, st->first, LYD_XML, LYP_WITHSIBLINGS)) {
+            return (void *)1;
+        }
+        j = strcmp(str, st->printed);
+        free(str);
+        if (j) {
+            return (void *)1;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+test_concurrent_queries(void **state)
+{
+    struct state *st = (*state);
+    pthread_t threads[THREADS];
+    void *ret;
+    char *str;
+    int i, failed = 0;
+
+    assert_int_not_equal(st->diff_count, 0);
+
+    for (i = 0; i < THREADS; ++i) {
+        assert_int_equal(pthread_create(&threads[i], NULL, query_thread, st), 0);
+    }
+    for (i = 0; i < THREADS; ++i) {
+        assert_int_equal(pthread_join(threads[i], &ret), 0);
+        if (ret) {
+            ++failed;
+        }
+    }
+    assert_int_equal(failed, 0);
+
+    /* the tree was not changed */
+    assert_int_equal(lyd_print_mem(&str, st->first, LYD_XML, LYP_WITHSIBLINGS), 0);
+    assert_string_equal(str, st->printed);
+    free(str);
+}
+
+static void *
+journal_thread(void *arg)
+{
+    struct state *st = arg;
+    struct lyd_node *tree;
+    struct lyd_journal *journal = NULL;
+    struct lyd_difflist *diff;
+    struct ly_set *set;
+    char value[16];
+    int i, ret = 0;
+
+    for (i = 0; i < ITERATIONS && !ret; ++i) {
+        /* every thread modifies its own copy, some of them record the changes while others do not */
+        tree = lyd_dup_withsiblings(st->first, LYD_DUP_OPT_RECURSIVE);
+        if (!tree) {
+            return (void *)1;
+        }
+        if ((i % 2) && !(journal = lyd_journal_new(tree))) {
+            lyd_free_withsiblings(tree);
+            return (void *)1;
+        }
+
+        set = lyd_find_path(tree, "/threads:cont/item[name='i7']/value");
+        sprintf(value, "%d", 1000 + i);
+        if (!set || (set->number != 1) || lyd_change_leaf((struct lyd_node_leaf_list *)set->set.d[0], value)) {
+            ret = 1;
+        } else {
+            lyd_free(set->set.d[0]->parent);
+        }
+        ly_set_free(set);
+
+        if (journal) {
+            diff = lyd_journal_diff(journal);
+            if (!diff || (diff->type[0] != LYD_DIFF_DELETED) || (diff->type[1] != LYD_DIFF_END)) {
+                ret = 1;
+            }
+            lyd_free_diff(diff);
+            lyd_journal_free(journal);
+            journal = NULL;
+        }
+        lyd_free_withsiblings(tree);
+    }
+
+    return ret ? (void *)1 : NULL;
+}
+
+static void
+test_concurrent_journals(void **state)
+{
+    struct state *st = (*state);
+    pthread_t threads[THREADS];
+    void *ret;
+    int i, failed = 0;
+
+    for (i = 0; i < THREADS; ++i) {
+        assert_int_equal(pthread_create(&threads[i], NULL, journal_thread, st), 0);
+    }
+    for (i = 0; i < THREADS; ++i) {
+        assert_int_equal(pthread_join(threads[i], &ret), 0);
+        if (ret) {
+            ++failed;
+        }
+    }
+    assert_int_equal(failed, 0);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_concurrent_queries, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_concurrent_journals, setup_f, teardown_f),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -24,8 +24,10 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
 
 #include "tests/config.h"
 #include "libyang.h"
@@ -402,6 +404,60 @@ error:
     fail();
 }
 
+static void
+test_lyd_parse_fd_pipe(void **state)
+{
+    (void) state; /* unused */
+    const char *start = "<x xmlns=\"urn:a\"><bubba>", *end = "</bubba></x>";
+    char *value;
+    struct lyd_node *node;
+    int fds[2], status;
+    size_t len = 100000;
+    pid_t pid;
+
+    lyd_free_withsiblings(root);
+    root = NULL;
+
+    /* more data than fits into the pipe buffer */
+    value = malloc(len + 1);
+    assert_non_null(value);
+    memset(value, 'a', len);
+    value[len] = '\0';
+
+    assert_int_equal(pipe(fds), 0);
+    pid = fork();
+    assert_int_not_equal(pid, -1);
+    if (!pid) {
+        close(fds[0]);
+        if ((write(fds[1], start, strlen(start)) == -1) || (write(fds[1], value, len) == -1)
+                || (write(fds[1], end, strlen(end)) == -1)) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+
+    root = lyd_parse_fd(ctx, fds[0], LYD_XML, LYD_OPT_CONFIG);
+    close(fds[0]);
+    assert_int_equal(waitpid(pid, &status, 0), pid);
+    assert_int_equal(WEXITSTATUS(status), 0);
+    assert_non_null(root);
+    assert_string_equal(root->schema->name, "x");
+
+    node = root->child;
+    assert_non_null(node);
+    assert_string_equal(node->schema->name, "bubba");
+    assert_string_equal(((struct lyd_node_leaf_list *)node)->value_str, value);
+    free(value);
+
+    /* empty input */
+    assert_int_equal(pipe(fds), 0);
+    close(fds[1]);
+    assert_null(lyd_parse_fd(ctx, fds[0], LYD_XML, LYD_OPT_CONFIG));
+    assert_int_equal(ly_errno, LY_SUCCESS);
+    close(fds[0]);
+}
+
 static void
 test_lyd_parse_path(void **state)
 {
@@ -1009,6 +1065,1020 @@ test_lyd_find_instance(void **state)
     ly_set_free(set);
 }
 
+static char *
+parallel_data(LYD_FORMAT format, int count, const char *extra)
+{
+    char *data, *ptr;
+    int i;
+
+    data = malloc(count * 160 + strlen(extra) + 16);
+    assert_non_null(data);
+
+    ptr = data;
+    if (format == LYD_JSON) {
+        ptr += sprintf(ptr, "{\"par:item\": [");
+    }
+    for (i = 0; i < count; ++i) {
+        /* the references point to instances in different parts */
+        if (format == LYD_XML) {
+            ptr += sprintf(ptr, "<item xmlns=\"urn:par\"><name>item%d</name><ref>item%d</ref><descr>description</descr></item>\n",
+                           i, (i + count / 2) % count);
+        } else {
+            ptr += sprintf(ptr, "%s{\"name\": \"item%d\", \"ref\": \"item%d\", \"descr\": \"description\"}\n",
+                           i ? ", " : "", i, (i + count / 2) % count);
+        }
+    }
+    if (format == LYD_JSON) {
+        ptr += sprintf(ptr, "], ");
+    }
+    strcpy(ptr, extra);
+
+    return data;
+}
+
+static void
+test_lyd_parse_mem_parallel(void **state)
+{
+    struct ly_ctx *ctx = (struct ly_ctx *)*state;
+    const char *yang =
+    "module par {"
+        "namespace \"urn:par\";"
+        "prefix p;"
+        "import ietf-yang-metadata {"
+            "prefix md;"
+        "}"
+        "md:annotation flag {"
+            "type string;"
+        "}"
+        "leaf top {"
+            "type string;"
+        "}"
+        "list item {"
+            "key name;"
+            "leaf name {"
+                "type string;"
+            "}"
+            "leaf ref {"
+                "type leafref {"
+                    "path \"/p:item/p:name\";"
+                "}"
+            "}"
+            "leaf descr {"
+                "type string;"
+            "}"
+            "leaf def {"
+                "type uint8;"
+                "default 8;"
+            "}"
+        "}"
+        "container cont {"
+            "leaf l {"
+                "type string;"
+            "}"
+        "}"
+    "}";
+    struct lyd_node *data, *data2;
+    char *str, *str1, *str2;
+    int count = 4000;
+
+    assert_ptr_not_equal(lys_parse_mem(ctx, yang, LYS_IN_YANG), NULL);
+
+    /* the same trees as from lyd_parse_mem() */
+    str = parallel_data(LYD_XML, count, "<cont xmlns=\"urn:par\"><l>val</l></cont>");
+    data = lyd_parse_mem(ctx, str, LYD_XML, LYD_OPT_CONFIG);
+    assert_ptr_not_equal(data, NULL);
+    data2 = lyd_parse_mem_parallel(ctx, str, LYD_XML, LYD_OPT_CONFIG, 4);
+    assert_ptr_not_equal(data2, NULL);
+    free(str);
+    lyd_print_mem(&str1, data, LYD_XML, LYP_WITHSIBLINGS | LYP_WD_ALL);
+    lyd_print_mem(&str2, data2, LYD_XML, LYP_WITHSIBLINGS | LYP_WD_ALL);
+    assert_string_equal(str1, str2);
+    free(str2);
+    lyd_free_withsiblings(data2);
+
+    str = parallel_data(LYD_JSON, count, "\"par:cont\": {\"l\": \"val\"}}");
+    data2 = lyd_parse_mem_parallel(ctx, str, LYD_JSON, LYD_OPT_CONFIG | LYD_OPT_ARENA, 4);
+    assert_ptr_not_equal(data2, NULL);
+    free(str);
+    lyd_print_mem(&str2, data2, LYD_XML, LYP_WITHSIBLINGS | LYP_WD_ALL);
+    assert_string_equal(str1, str2);
+    free(str1);
+    free(str2);
+    lyd_free_withsiblings(data2);
+    lyd_free_withsiblings(data);
+
+    /* metadata not adjacent to their node, which can be in another part */
+    str = parallel_data(LYD_JSON, count, "\"par:top\": \"t\", \"@par:cont\": {\"par:flag\": \"f\"}}");
+    str1 = malloc(strlen(str) + 64);
+    assert_non_null(str1);
+    sprintf(str1, "{\"par:cont\": {\"l\": \"val\"}, %s", str + 1);
+    free(str);
+    data = lyd_parse_mem(ctx, str1, LYD_JSON, LYD_OPT_CONFIG);
+    assert_ptr_not_equal(data, NULL);
+    data2 = lyd_parse_mem_parallel(ctx, str1, LYD_JSON, LYD_OPT_CONFIG, 4);
+    assert_ptr_not_equal(data2, NULL);
+    free(str1);
+    lyd_print_mem(&str1, data, LYD_XML, LYP_WITHSIBLINGS);
+    lyd_print_mem(&str2, data2, LYD_XML, LYP_WITHSIBLINGS);
+    assert_non_null(strstr(str1, "flag=\"f\""));
+    assert_string_equal(str1, str2);
+    free(str1);
+    free(str2);
+    lyd_free_withsiblings(data2);
+    lyd_free_withsiblings(data);
+
+    /* duplicate instances in different parts */
+    str = parallel_data(LYD_XML, count, "<item xmlns=\"urn:par\"><name>item0</name></item>");
+    assert_ptr_equal(lyd_parse_mem_parallel(ctx, str, LYD_XML, LYD_OPT_CONFIG, 4), NULL);
+    assert_int_equal(ly_vecode(ctx), LYVE_DUPLIST);
+    free(str);
+
+    str = parallel_data(LYD_XML, count, "<cont xmlns=\"urn:par\"/>");
+    str1 = malloc(strlen(str) + 64);
+    assert_non_null(str1);
+    sprintf(str1, "<cont xmlns=\"urn:par\"/>%s", str);
+    assert_ptr_equal(lyd_parse_mem_parallel(ctx, str1, LYD_XML, LYD_OPT_CONFIG, 4), NULL);
+    assert_int_equal(ly_vecode(ctx), LYVE_TOOMANY);
+    free(str1);
+    free(str);
+
+    /* missing leafref target */
+    str = parallel_data(LYD_JSON, count, "\"par:item\": [{\"name\": \"last\", \"ref\": \"none\"}]}");
+    assert_ptr_equal(lyd_parse_mem_parallel(ctx, str, LYD_JSON, LYD_OPT_CONFIG, 4), NULL);
+    assert_int_equal(ly_vecode(ctx), LYVE_NOLEAFREF);
+    free(str);
+
+    /* error in one of the parts */
+    str = parallel_data(LYD_XML, count, "<item xmlns=\"urn:par\"><name>last</name><def>x</def></item>");
+    assert_ptr_equal(lyd_parse_mem_parallel(ctx, str, LYD_XML, LYD_OPT_CONFIG, 4), NULL);
+    assert_int_equal(ly_errno, LY_EVALID);
+    free(str);
+
+    /* unsupported options */
+    assert_ptr_equal(lyd_parse_mem_parallel(ctx, "", LYD_XML, LYD_OPT_RPC, 4), NULL);
+    assert_int_equal(ly_errno, LY_EINVAL);
+}
+
+static void
+test_lyd_path_tmpl(void **state)
+{
+    struct ly_ctx *ctx = (struct ly_ctx *)*state;
+    const char *yang =
+    "module test {"
+        "namespace urn:test;"
+        "prefix t;"
+        "container cont {"
+            "list lt {"
+                "key \"k1 k2\";"
+                "leaf k1 {"
+                    "type string;"
+                "}"
+                "leaf k2 {"
+                    "type uint8;"
+                "}"
+                "container c {"
+                    "leaf l {"
+                        "type string;"
+                    "}"
+                "}"
+                "leaf-list ll {"
+                    "type int16;"
+                "}"
+            "}"
+        "}"
+        "leaf top {"
+            "type string;"
+        "}"
+    "}";
+    struct lyd_path_tmpl *tmpl, *ll_tmpl;
+    struct lyd_node *data = NULL, *data2 = NULL, *node;
+    const char *values[2];
+    char path[64], val[8], *str1, *str2;
+    int i;
+
+    assert_ptr_not_equal(lys_parse_mem(ctx, yang, LYS_IN_YANG), NULL);
+
+    tmpl = lyd_path_tmpl_compile(ctx, "/test:cont/lt[k1=?][k2 = ?]/c/l", 0);
+    assert_ptr_not_equal(tmpl, NULL);
+    assert_int_equal(lyd_path_tmpl_placeholder_count(tmpl), 2);
+    ll_tmpl = lyd_path_tmpl_compile(ctx, "/test:cont/lt[k1='a'][k2='01']/ll[.=?]", 0);
+    assert_ptr_not_equal(ll_tmpl, NULL);
+    assert_int_equal(lyd_path_tmpl_placeholder_count(ll_tmpl), 1);
+
+    /* the same trees as from lyd_new_path() */
+    for (i = 0; i < 20; ++i) {
+        sprintf(path, "k%d", i);
+        sprintf(val, "%d", i);
+        values[0] = path;
+        values[1] = val;
+        node = lyd_path_tmpl_new(data, tmpl, values, "val", 0);
+        assert_ptr_not_equal(node, NULL);
+        if (!data) {
+            data = node;
+        }
+
+        sprintf(path, "/test:cont/lt[k1='k%d'][k2='%d']/c/l", i, i);
+        node = lyd_new_path(data2, ctx, path, "val", 0, 0);
+        assert_ptr_not_equal(node, NULL);
+        if (!data2) {
+            data2 = node;
+        }
+    }
+    values[0] = "-2";
+    assert_ptr_not_equal(lyd_path_tmpl_new(data, ll_tmpl, values, NULL, 0), NULL);
+    assert_ptr_not_equal(lyd_new_path(data2, NULL, "/test:cont/lt[k1='a'][k2='1']/ll", "-2", 0, 0), NULL);
+
+    assert_int_equal(lyd_print_mem(&str1, data, LYD_XML, LYP_WITHSIBLINGS), 0);
+    assert_int_equal(lyd_print_mem(&str2, data2, LYD_XML, LYP_WITHSIBLINGS), 0);
+    assert_string_equal(str1, str2);
+    free(str1);
+    free(str2);
+    lyd_free_withsiblings(data2);
+
+    /* existing nodes with non-canonical values */
+    values[0] = "k5";
+    values[1] = "005";
+    assert_ptr_equal(lyd_path_tmpl_new(data, tmpl, values, "val", 0), NULL);
+    assert_int_equal(ly_vecode(ctx), LYVE_PATH_EXISTS);
+    node = lyd_path_tmpl_new(data, tmpl, values, "val2", LYD_PATH_OPT_UPDATE);
+    assert_ptr_not_equal(node, NULL);
+    assert_string_equal(((struct lyd_node_leaf_list *)node)->value_str, "val2");
+    assert_ptr_equal(lyd_path_tmpl_new(data, tmpl, values, "val2", LYD_PATH_OPT_UPDATE), NULL);
+    values[0] = "-02";
+    assert_ptr_equal(lyd_path_tmpl_new(data, ll_tmpl, values, NULL, 0), NULL);
+    assert_int_equal(ly_vecode(ctx), LYVE_PATH_EXISTS);
+
+    /* parents must exist */
+    values[0] = "k20";
+    values[1] = "20";
+    assert_ptr_equal(lyd_path_tmpl_new(data, tmpl, values, "val", LYD_PATH_OPT_NOPARENT), NULL);
+    assert_int_equal(ly_vecode(ctx), LYVE_PATH_MISSPAR);
+
+    /* last created node */
+    node = lyd_path_tmpl_new(data, tmpl, values, "val", LYD_PATH_OPT_NOPARENTRET);
+    assert_ptr_not_equal(node, NULL);
+    assert_string_equal(node->schema->name, "l");
+    assert_string_equal(node->parent->parent->child->schema->name, "k1");
+
+    /* invalid values */
+    values[1] = "256";
+    assert_ptr_equal(lyd_path_tmpl_new(data, tmpl, values, "val", 0), NULL);
+    values[1] = NULL;
+    assert_ptr_equal(lyd_path_tmpl_new(data, tmpl, values, "val", 0), NULL);
+
+    lyd_path_tmpl_free(tmpl);
+    lyd_path_tmpl_free(ll_tmpl);
+
+    /* top-level sibling */
+    tmpl = lyd_path_tmpl_compile(ctx, "/test:top", 0);
+    assert_ptr_not_equal(tmpl, NULL);
+    assert_int_equal(lyd_path_tmpl_placeholder_count(tmpl), 0);
+    node = lyd_path_tmpl_new(data, tmpl, NULL, "t", 0);
+    assert_ptr_not_equal(node, NULL);
+    assert_ptr_equal(data->next, node);
+    lyd_path_tmpl_free(tmpl);
+    lyd_free_withsiblings(data);
+
+    /* invalid templates */
+    assert_ptr_equal(lyd_path_tmpl_compile(ctx, "test:cont", 0), NULL);
+    assert_ptr_equal(lyd_path_tmpl_compile(ctx, "/cont", 0), NULL);
+    assert_ptr_equal(lyd_path_tmpl_compile(ctx, "/test:cont/lt[k1=?]", 0), NULL);
+    assert_int_equal(ly_vecode(ctx), LYVE_PATH_MISSKEY);
+    assert_ptr_equal(lyd_path_tmpl_compile(ctx, "/test:cont/lt[k2=?][k1=?]", 0), NULL);
+    assert_int_equal(ly_vecode(ctx), LYVE_PATH_INKEY);
+    assert_ptr_equal(lyd_path_tmpl_compile(ctx, "/test:cont/lt[1]", 0), NULL);
+    assert_ptr_equal(lyd_path_tmpl_compile(ctx, "/test:cont/lt[k1=?][k2='x']", 0), NULL);
+    assert_ptr_equal(lyd_path_tmpl_compile(ctx, "/test:cont/lt[k1=?][k2=?]/c/l2", 0), NULL);
+    assert_int_equal(ly_vecode(ctx), LYVE_PATH_INNODE);
+}
+
+/* compare the result of a path with the same path evaluated as XPath, which is forced by the parentheses */
+static void
+check_find_path(struct lyd_node *ctx_node, const char *path, unsigned int count)
+{
+    struct ly_set *set, *xp_set;
+    char xpath[128];
+    unsigned int i;
+
+    set = lyd_find_path(ctx_node, path);
+    assert_ptr_not_equal(set, NULL);
+    assert_int_equal(set->number, count);
+
+    snprintf(xpath, sizeof xpath, "(%s)", path);
+    xp_set = lyd_find_path(ctx_node, xpath);
+    assert_ptr_not_equal(xp_set, NULL);
+    assert_int_equal(xp_set->number, count);
+
+    for (i = 0; i < count; ++i) {
+        assert_ptr_equal(set->set.d[i], xp_set->set.d[i]);
+    }
+
+    ly_set_free(set);
+    ly_set_free(xp_set);
+}
+
+static void
+test_lyd_find_path_simple(void **state)
+{
+    struct ly_ctx *ctx = (struct ly_ctx *)*state;
+    const char *yang =
+    "module test {"
+        "namespace urn:test;"
+        "prefix t;"
+        "container cont {"
+            "list lt {"
+                "key \"k1 k2\";"
+                "leaf k1 {"
+                    "type string;"
+                "}"
+                "leaf k2 {"
+                    "type uint8;"
+                "}"
+                "container c {"
+                    "leaf l {"
+                        "type string;"
+                    "}"
+                "}"
+            "}"
+            "leaf-list ll {"
+                "type int16;"
+            "}"
+            "leaf ref {"
+                "type leafref {"
+                    "path \"../ll\";"
+                "}"
+            "}"
+            "list st {"
+                "config false;"
+                "key k;"
+                "leaf k {"
+                    "type string;"
+                "}"
+            "}"
+        "}"
+    "}";
+    struct lyd_node *data;
+    struct ly_set *set;
+    char path[64];
+    int i;
+
+    assert_ptr_not_equal(lys_parse_mem(ctx, yang, LYS_IN_YANG), NULL);
+
+    /* enough children for the parent hash table */
+    data = lyd_new_path(NULL, ctx, "/test:cont", NULL, 0, 0);
+    assert_ptr_not_equal(data, NULL);
+    for (i = 0; i < 20; ++i) {
+        sprintf(path, "/test:cont/lt[k1='a%d'][k2='%d']/c/l", i, i);
+        assert_ptr_not_equal(lyd_new_path(data, NULL, path, "val", 0, 0), NULL);
+        sprintf(path, "/test:cont/ll[.='%d']", i * 10);
+        assert_ptr_not_equal(lyd_new_path(data, NULL, path, NULL, 0, 0), NULL);
+    }
+    assert_ptr_not_equal(lyd_new_path(data, NULL, "/test:cont/ref", "30", 0, 0), NULL);
+    assert_ptr_not_equal(lyd_new_path(data, NULL, "/test:cont/st[k='s']", NULL, 0, 0), NULL);
+    assert_ptr_not_equal(lyd_new_path(data, NULL, "/test:cont/st[k='s2']", NULL, 0, 0), NULL);
+
+    /* found directly */
+    check_find_path(data, "/test:cont", 1);
+    check_find_path(data, "/test:cont/lt[k1='a5'][k2='5']", 1);
+    check_find_path(data, "/test:cont/lt[k2='5'][k1='a5']", 1);
+    check_find_path(data, "/test:cont/lt[k1='a5'][k2='05']/c/l", 1);
+    check_find_path(data, "/test:cont/lt[k1='a5'][k2='6']", 0);
+    check_find_path(data, "/test:cont/lt", 20);
+    check_find_path(data, "/test:cont/lt/c", 20);
+    check_find_path(data, "/test:cont/lt/k1", 20);
+    check_find_path(data, "/test:cont/ll[.='+50']", 1);
+    check_find_path(data, "/test:cont/ll[.='5']", 0);
+    check_find_path(data, "/test:cont/ll", 20);
+    check_find_path(data, "/test:cont/ref", 1);
+    check_find_path(data, "/test:cont/st[k='s2']", 1);
+    check_find_path(data, "/test:cont/st", 2);
+    check_find_path(data->child, "c/l", 1);
+    check_find_path(data, "lt[k1='a19'][k2='19']/test:c", 1);
+
+    /* evaluated as XPath */
+    check_find_path(data, "/test:cont/lt[k1='a5']", 1);
+    check_find_path(data, "/test:cont/lt[2]", 1);
+    check_find_path(data, "/test:cont/lt[c/l='val']", 20);
+    check_find_path(data, "/test:cont/*", 43);
+    check_find_path(data, "//l", 20);
+    check_find_path(data, "/test:cont/lt[k1='a5'][k2='5']/..", 1);
+
+    /* invalid */
+    ly_log_options(0);
+    set = lyd_find_path(data, "/test:cont/lt[k1='a5'");
+    assert_ptr_equal(set, NULL);
+    ly_log_options(LY_LOLOG | LY_LOSTORE_LAST);
+
+    lyd_free_withsiblings(data);
+}
+
+static void
+check_list_pos(struct lyd_node *parent, const struct lys_node *schema)
+{
+    struct lyd_node *iter;
+    unsigned int i = 0;
+
+    LY_TREE_FOR(parent->child, iter) {
+        if (iter->schema != schema) {
+            continue;
+        }
+        ++i;
+        assert_int_equal(lyd_list_pos(iter), i);
+        assert_ptr_equal(lyd_list_nth(parent->child, schema, i), iter);
+    }
+    assert_ptr_equal(lyd_list_nth(parent->child, schema, i + 1), NULL);
+}
+
+static void
+test_lyd_list_nth(void **state)
+{
+    struct ly_ctx *ctx = (struct ly_ctx *)*state;
+    const char *yang =
+    "module test {"
+        "namespace urn:test;"
+        "prefix t;"
+        "container cont {"
+            "list ul {"
+                "key \"k\";"
+                "ordered-by user;"
+                "leaf k {"
+                    "type uint32;"
+                "}"
+                "leaf val {"
+                    "type string;"
+                "}"
+            "}"
+            "leaf-list ll {"
+                "type uint32;"
+                "ordered-by user;"
+            "}"
+        "}"
+    "}";
+    const struct lys_module *mod;
+    struct lyd_node *data = NULL, *node, *first, *next;
+    const struct lys_node *sul, *sll;
+    struct ly_set *set;
+    char path[64], val[16], *str;
+    int i;
+
+    mod = lys_parse_mem(ctx, yang, LYS_IN_YANG);
+    assert_ptr_not_equal(mod, NULL);
+    sul = mod->data->child;
+    sll = sul->next;
+
+    for (i = 0; i < 1000; ++i) {
+        sprintf(path, "/test:cont/ul[k='%d']", i);
+        node = lyd_new_path(data, ctx, path, NULL, 0, 0);
+        assert_ptr_not_equal(node, NULL);
+        if (!data) {
+            data = node;
+        }
+        if (!(i % 4)) {
+            sprintf(val, "%d", i);
+            assert_ptr_not_equal(lyd_new_leaf(data, mod, "ll", val), NULL);
+        }
+    }
+    assert_ptr_equal(lyd_list_nth(data->child, sul, 0), NULL);
+    check_list_pos(data, sul);
+    check_list_pos(data, sll);
+
+    /* move every third instance before the first one */
+    first = lyd_list_nth(data->child, sul, 1);
+    for (i = 999; i > 0; i -= 3) {
+        node = lyd_list_nth(data->child, sul, i);
+        assert_int_equal(lyd_insert_before(first, node), 0);
+        first = node;
+    }
+    check_list_pos(data, sul);
+
+    /* and some after the last one */
+    for (i = 0; i < 100; ++i) {
+        node = lyd_list_nth(data->child, sul, 2 * i + 1);
+        assert_int_equal(lyd_insert_after(lyd_list_nth(data->child, sul, 1000), node), 0);
+    }
+    check_list_pos(data, sul);
+
+    /* remove and add instances */
+    for (i = 0; i < 300; ++i) {
+        lyd_free(lyd_list_nth(data->child, sul, (i % 2) ? 1 : 700 - 2 * i));
+    }
+    check_list_pos(data, sul);
+    for (i = 1000; i < 1100; ++i) {
+        node = lyd_new(data, mod, "ul");
+        assert_ptr_not_equal(node, NULL);
+        sprintf(val, "%d", i);
+        assert_ptr_not_equal(lyd_new_leaf(node, mod, "k", val), NULL);
+    }
+    LY_TREE_FOR_SAFE(data->child, next, node) {
+        if ((node->schema == sll) && (lyd_list_pos(node) % 3)) {
+            assert_int_equal(lyd_unlink(node), 0);
+            lyd_free(node);
+        }
+    }
+    check_list_pos(data, sul);
+    check_list_pos(data, sll);
+
+    /* positional paths */
+    set = lyd_find_path(data, "/test:cont/ul[500]");
+    assert_ptr_not_equal(set, NULL);
+    assert_int_equal(set->number, 1);
+    assert_ptr_equal(set->set.d[0], lyd_list_nth(data->child, sul, 500));
+    ly_set_free(set);
+    node = lyd_new_path(data, NULL, "/test:cont/ul[750]/val", "x", 0, 0);
+    assert_ptr_not_equal(node, NULL);
+    assert_ptr_equal(node->parent, lyd_list_nth(data->child, sul, 750));
+
+    assert_int_equal(lyd_schema_sort(data, 1), 0);
+    check_list_pos(data, sul);
+    check_list_pos(data, sll);
+
+    /* parsed data */
+    assert_int_equal(lyd_print_mem(&str, data, LYD_XML, LYP_WITHSIBLINGS), 0);
+    lyd_free_withsiblings(data);
+    data = lyd_parse_mem(ctx, str, LYD_XML, LYD_OPT_CONFIG);
+    free(str);
+    assert_ptr_not_equal(data, NULL);
+    check_list_pos(data, sul);
+    check_list_pos(data, sll);
+    for (i = 1; i < 200; i += 2) {
+        node = lyd_list_nth(data->child, sul, i);
+        assert_int_equal(lyd_insert_before(lyd_list_nth(data->child, sul, 1), node), 0);
+        if (i < 80) {
+            lyd_free(lyd_list_nth(data->child, sll, i));
+        }
+    }
+    check_list_pos(data, sul);
+    check_list_pos(data, sll);
+
+    lyd_free_withsiblings(data);
+}
+
+static void
+test_lyd_subtree_hash(void **state)
+{
+    struct ly_ctx *ctx = (struct ly_ctx *)*state;
+    const char *yang =
+    "module test {"
+        "namespace urn:test;"
+        "prefix t;"
+        "container cont {"
+            "list l {"
+                "key \"k\";"
+                "leaf k {"
+                    "type string;"
+                "}"
+                "container inner {"
+                    "leaf val {"
+                        "type string;"
+                    "}"
+                "}"
+            "}"
+            "leaf-list ll {"
+                "type string;"
+                "ordered-by user;"
+            "}"
+        "}"
+    "}";
+    const char *xml =
+    "<cont xmlns=\"urn:test\">"
+        "<l><k>a</k><inner><val>1</val></inner></l>"
+        "<l><k>b</k><inner><val>2</val></inner></l>"
+        "<ll>x</ll><ll>y</ll>"
+    "</cont>";
+    struct lyd_node *data1, *data2, *list, *node;
+    uint64_t hash;
+
+    assert_ptr_not_equal(lys_parse_mem(ctx, yang, LYS_IN_YANG), NULL);
+    data1 = lyd_parse_mem(ctx, xml, LYD_XML, LYD_OPT_CONFIG);
+    assert_ptr_not_equal(data1, NULL);
+    data2 = lyd_parse_mem(ctx, xml, LYD_XML, LYD_OPT_CONFIG);
+    assert_ptr_not_equal(data2, NULL);
+
+    assert_int_equal(lyd_subtree_hash(NULL), 0);
+    hash = lyd_subtree_hash(data1);
+    assert_int_not_equal(hash, 0);
+    assert_int_equal(lyd_subtree_hash(data2), hash);
+    assert_int_equal(lyd_subtree_equal(data1, data2), 1);
+    assert_int_equal(lyd_subtree_equal(data1->child, data2->child), 1);
+    assert_int_equal(lyd_subtree_equal(data1->child, data2->child->next), 0);
+
+    /* changed value deep in the subtree */
+    list = data2->child->next;
+    node = list->child->next->child;
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)node, "3"), 0);
+    assert_int_equal(lyd_subtree_equal(data1, data2), 0);
+    assert_int_equal(lyd_subtree_equal(data1->child, data2->child), 1);
+    assert_int_equal(lyd_subtree_equal(data1->child->next, list), 0);
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)node, "2"), 0);
+    assert_int_equal(lyd_subtree_hash(data2), hash);
+
+    /* removed and inserted nodes */
+    node = list->child->next;
+    assert_int_equal(lyd_unlink(node), 0);
+    assert_int_equal(lyd_subtree_equal(data1, data2), 0);
+    assert_int_equal(lyd_insert(list, node), 0);
+    assert_int_equal(lyd_subtree_hash(data2), hash);
+
+    /* user-ordered instances moved */
+    node = data2->child->prev;
+    assert_int_equal(lyd_insert_before(node->prev, node), 0);
+    assert_int_equal(lyd_subtree_equal(data1, data2), 0);
+    assert_int_equal(lyd_insert_after(node->next, node), 0);
+    assert_int_equal(lyd_subtree_hash(data2), hash);
+
+    /* new node */
+    node = lyd_new_path(data2, NULL, "/test:cont/l[k='c']", NULL, 0, 0);
+    assert_ptr_not_equal(node, NULL);
+    assert_int_equal(lyd_subtree_equal(data1, data2), 0);
+    lyd_free(node);
+    assert_int_equal(lyd_subtree_hash(data2), hash);
+    lyd_free_withsiblings(data2);
+
+    /* a duplicate is equal */
+    data2 = lyd_dup(data1, LYD_DUP_OPT_RECURSIVE);
+    assert_ptr_not_equal(data2, NULL);
+    assert_int_equal(lyd_subtree_equal(data1, data2), 1);
+
+    lyd_free_withsiblings(data1);
+    lyd_free_withsiblings(data2);
+}
+
+static void
+test_lyd_snapshot(void **state)
+{
+    struct ly_ctx *ctx = (struct ly_ctx *)*state;
+    const char *yang =
+    "module test {"
+        "namespace urn:test;"
+        "prefix t;"
+        "container cont {"
+            "list l {"
+                "key \"k\";"
+                "leaf k {"
+                    "type string;"
+                "}"
+                "leaf val {"
+                    "type uint8;"
+                "}"
+            "}"
+            "leaf-list ll {"
+                "type string;"
+                "ordered-by user;"
+            "}"
+        "}"
+        "leaf top {"
+            "type string;"
+        "}"
+    "}";
+    const char *xml =
+    "<cont xmlns=\"urn:test\">"
+        "<l><k>a</k><val>1</val></l>"
+        "<l><k>b</k><val>2</val></l>"
+        "<l><k>c</k><val>3</val></l>"
+        "<l><k>d</k><val>4</val></l>"
+        "<ll>x</ll><ll>y</ll>"
+    "</cont>"
+    "<top xmlns=\"urn:test\">t</top>";
+    struct lyd_snapshot *snap;
+    struct lyd_node *data, *copy, *node;
+    struct lyd_difflist *diff;
+    struct ly_set *set;
+
+    assert_ptr_not_equal(lys_parse_mem(ctx, yang, LYS_IN_YANG), NULL);
+    data = lyd_parse_mem(ctx, xml, LYD_XML, LYD_OPT_CONFIG);
+    assert_ptr_not_equal(data, NULL);
+
+    assert_ptr_equal(lyd_snapshot(NULL), NULL);
+    assert_ptr_equal(lyd_snapshot(data->child), NULL);
+    snap = lyd_snapshot(data->next);
+    assert_ptr_not_equal(snap, NULL);
+    assert_ptr_equal(lyd_snapshot_data(snap), data);
+    assert_ptr_equal(lyd_snapshot_ref(snap), snap);
+
+    /* the copy is the same and can be searched in */
+    copy = lyd_snapshot_dup(snap);
+    assert_ptr_not_equal(copy, NULL);
+    assert_ptr_not_equal(copy, data);
+    assert_int_equal(lyd_subtree_equal(data, copy), 1);
+    assert_int_equal(lyd_subtree_equal(data->next, copy->next), 1);
+    set = lyd_find_path(copy, "/test:cont/l[k='c']/val");
+    assert_ptr_not_equal(set, NULL);
+    assert_int_equal(set->number, 1);
+    assert_string_equal(((struct lyd_node_leaf_list *)set->set.d[0])->value_str, "3");
+    node = set->set.d[0];
+    ly_set_free(set);
+    assert_int_equal(lyd_validate(&copy, LYD_OPT_CONFIG, NULL), 0);
+
+    /* a released reference keeps the snapshot */
+    lyd_snapshot_free(snap);
+    assert_ptr_equal(lyd_snapshot_data(snap), data);
+
+    /* modified copy, the snapshot stays unchanged */
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)node, "5"), 0);
+    assert_ptr_not_equal(lyd_new_path(copy, NULL, "/test:cont/l[k='e']/val", "6", 0, 0), NULL);
+    assert_int_equal(lyd_validate(&copy, LYD_OPT_CONFIG, NULL), 0);
+    assert_int_equal(lyd_subtree_equal(data, copy), 0);
+    assert_int_equal(lyd_subtree_equal(data->next, copy->next), 1);
+    diff = lyd_diff(lyd_snapshot_data(snap), copy, 0);
+    assert_ptr_not_equal(diff, NULL);
+    assert_int_equal(diff->type[0], LYD_DIFF_CHANGED);
+    assert_ptr_equal(diff->second[0], node);
+    assert_int_equal(diff->type[1], LYD_DIFF_CREATED);
+    assert_int_equal(diff->type[2], LYD_DIFF_END);
+    lyd_free_diff(diff);
+    assert_string_equal(((struct lyd_node_leaf_list *)data->child->next->next->child->next)->value_str, "3");
+
+    lyd_free_withsiblings(copy);
+    lyd_snapshot_free(snap);
+    lyd_snapshot_free(NULL);
+}
+
+static void
+test_lyd_journal(void **state)
+{
+    struct ly_ctx *ctx = (struct ly_ctx *)*state;
+    const char *yang =
+    "module test {"
+        "namespace urn:test;"
+        "prefix t;"
+        "container cont {"
+            "list l {"
+                "key \"k\";"
+                "leaf k {"
+                    "type string;"
+                "}"
+                "leaf val {"
+                    "type uint8;"
+                "}"
+            "}"
+            "leaf-list ll {"
+                "type string;"
+                "ordered-by user;"
+            "}"
+        "}"
+        "leaf top {"
+            "type string;"
+        "}"
+    "}";
+    const char *xml =
+    "<cont xmlns=\"urn:test\">"
+        "<l><k>a</k><val>1</val></l>"
+        "<l><k>b</k><val>2</val></l>"
+        "<l><k>c</k><val>3</val></l>"
+        "<ll>x</ll><ll>y</ll>"
+    "</cont>"
+    "<top xmlns=\"urn:test\">t</top>";
+    struct lyd_journal *journal;
+    struct lyd_node *data, *list_a, *list_b, *list_c, *node;
+    struct lyd_difflist *diff;
+    char *path;
+
+    assert_ptr_not_equal(lys_parse_mem(ctx, yang, LYS_IN_YANG), NULL);
+    data = lyd_parse_mem(ctx, xml, LYD_XML, LYD_OPT_CONFIG);
+    assert_ptr_not_equal(data, NULL);
+    list_a = data->child;
+    list_b = list_a->next;
+    list_c = list_b->next;
+
+    assert_ptr_equal(lyd_journal_new(NULL), NULL);
+    journal = lyd_journal_new(list_a->child);
+    assert_ptr_not_equal(journal, NULL);
+    assert_ptr_equal(lyd_journal_new(data->next), NULL);
+
+    /* changed twice, changed back, created and deleted again */
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)list_a->child->next, "9"), 0);
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)list_a->child->next, "8"), 0);
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)list_b->child->next, "5"), 0);
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)list_b->child->next, "2"), 0);
+    node = lyd_new_path(data, NULL, "/test:cont/l[k='f']/val", "6", 0, 0);
+    assert_ptr_not_equal(node, NULL);
+    lyd_free(node);
+
+    /* deleted, moved and created nodes */
+    lyd_free(list_c);
+    lyd_free(data->next);
+    assert_int_equal(lyd_insert_before(data->child->next->next, data->child->next->next->next), 0);
+    node = lyd_new_path(data, NULL, "/test:cont/l[k='e']/val", "7", 0, 0);
+    assert_ptr_not_equal(node, NULL);
+    assert_ptr_not_equal(lyd_new_path(data, NULL, "/test:top", "u", 0, 0), NULL);
+    assert_int_equal(lyd_validate(&data, LYD_OPT_CONFIG, NULL), 0);
+
+    diff = lyd_journal_diff(journal);
+    assert_ptr_not_equal(diff, NULL);
+    assert_int_equal(diff->type[0], LYD_DIFF_CHANGED);
+    assert_string_equal(((struct lyd_node_leaf_list *)diff->first[0])->value_str, "1");
+    assert_ptr_equal(diff->second[0], list_a->child->next);
+    assert_int_equal(diff->type[1], LYD_DIFF_DELETED);
+    path = lyd_path(diff->first[1]);
+    assert_string_equal(path, "/test:cont/l[k='c']");
+    free(path);
+    assert_int_equal(diff->type[2], LYD_DIFF_DELETED);
+    assert_string_equal(diff->first[2]->schema->name, "top");
+    assert_int_equal(diff->type[3], LYD_DIFF_MOVEDAFTER1);
+    assert_string_equal(((struct lyd_node_leaf_list *)diff->first[3])->value_str, "y");
+    assert_ptr_equal(diff->second[3], NULL);
+    assert_int_equal(diff->type[4], LYD_DIFF_CREATED);
+    assert_ptr_equal(diff->first[4], data);
+    assert_ptr_equal(diff->second[4], node);
+    assert_int_equal(diff->type[5], LYD_DIFF_CREATED);
+    assert_ptr_equal(diff->first[5], NULL);
+    assert_ptr_equal(diff->second[5], data->next);
+    assert_int_equal(diff->type[6], LYD_DIFF_END);
+    lyd_free_diff(diff);
+
+    /* only the new changes are recorded */
+    lyd_journal_clear(journal);
+    assert_int_equal(lyd_insert_after(data->child->next->next->next, data->child->next->next), 0);
+    diff = lyd_journal_diff(journal);
+    assert_ptr_not_equal(diff, NULL);
+    assert_int_equal(diff->type[0], LYD_DIFF_MOVEDAFTER1);
+    assert_string_equal(((struct lyd_node_leaf_list *)diff->first[0])->value_str, "y");
+    assert_string_equal(((struct lyd_node_leaf_list *)diff->second[0])->value_str, "x");
+    assert_int_equal(diff->type[1], LYD_DIFF_END);
+    lyd_free_diff(diff);
+
+    lyd_journal_free(journal);
+    lyd_journal_free(NULL);
+    lyd_free_withsiblings(data);
+}
+
+struct parse_clb_log {
+    char buf[256];
+    int subtree;
+    int stop;
+    int sum;
+};
+
+static int
+parse_clb_open(const struct lys_node *schema, void *data)
+{
+    struct parse_clb_log *log = data;
+
+    sprintf(log->buf + strlen(log->buf), "<%s>", schema->name);
+    if (log->stop && !strcmp(schema->name, "l")) {
+        return -1;
+    } else if (log->subtree && !strcmp(schema->name, "sub")) {
+        return LYD_PARSE_CLB_SUBTREE;
+    } else if (!strcmp(schema->name, "skip")) {
+        return LYD_PARSE_CLB_SKIP;
+    }
+    return LYD_PARSE_CLB_CONTINUE;
+}
+
+static int
+parse_clb_leaf(const struct lyd_node_leaf_list *leaf, void *data)
+{
+    struct parse_clb_log *log = data;
+
+    sprintf(log->buf + strlen(log->buf), "%s=%s;", leaf->schema->name, leaf->value_str);
+    if (leaf->value_type == LY_TYPE_UINT8) {
+        log->sum += leaf->value.uint8;
+    }
+    return 0;
+}
+
+static int
+parse_clb_close(const struct lys_node *schema, void *data)
+{
+    struct parse_clb_log *log = data;
+
+    sprintf(log->buf + strlen(log->buf), "</%s>", schema->name);
+    return 0;
+}
+
+static int
+parse_clb_subtree(struct lyd_node *node, void *data)
+{
+    struct parse_clb_log *log = data;
+    char *str = NULL;
+
+    assert_ptr_equal(node->parent, NULL);
+    lyd_print_mem(&str, node, LYD_JSON, 0);
+    sprintf(log->buf + strlen(log->buf), "[%s]", str);
+    free(str);
+    lyd_free(node);
+    return 0;
+}
+
+static void
+test_lyd_parse_clb(void **state)
+{
+    struct ly_ctx *ctx = (struct ly_ctx *)*state;
+    const char *yang =
+    "module test {"
+        "namespace urn:test;"
+        "prefix t;"
+        "container cont {"
+            "list l {"
+                "key \"k\";"
+                "leaf k {"
+                    "type string;"
+                "}"
+                "leaf val {"
+                    "type uint8;"
+                "}"
+                "container sub {"
+                    "leaf n {"
+                        "type uint8;"
+                    "}"
+                "}"
+                "container skip {"
+                    "leaf n {"
+                        "type uint8;"
+                    "}"
+                "}"
+            "}"
+            "leaf-list ll {"
+                "type uint16;"
+            "}"
+        "}"
+        "leaf top {"
+            "type string;"
+        "}"
+    "}";
+    const char *xml =
+    "<cont xmlns=\"urn:test\">"
+        "<l><k>a</k><val>1</val><sub><n>5</n></sub></l>"
+        "<l><k>b</k><val>2</val><skip><n>abc</n></skip></l>"
+        "<ll>3</ll><ll>4</ll>"
+    "</cont>"
+    "<top xmlns=\"urn:test\">t</top>";
+    const char *json =
+    "{\"test:cont\":{"
+        "\"l\":[{\"k\":\"a\",\"val\":1,\"sub\":{\"n\":5}},{\"k\":\"b\",\"val\":2,\"skip\":{\"n\":\"abc\"}}],"
+        "\"ll\":[3,4]"
+    "},"
+    "\"test:top\":\"t\"}";
+    struct lyd_parse_clb clb = {parse_clb_open, parse_clb_leaf, parse_clb_close, parse_clb_subtree, NULL};
+    struct parse_clb_log log;
+    char file_name[20];
+    int fd;
+
+    assert_ptr_not_equal(lys_parse_mem(ctx, yang, LYS_IN_YANG), NULL);
+    clb.data = &log;
+
+    /* all the nodes reported */
+    memset(&log, 0, sizeof log);
+    assert_int_equal(lyd_parse_mem_clb(ctx, xml, LYD_XML, LYD_OPT_CONFIG, &clb), 0);
+    assert_string_equal(log.buf, "<cont><l>k=a;val=1;<sub>n=5;</sub></l><l>k=b;val=2;<skip></l>ll=3;ll=4;</cont>top=t;");
+    assert_int_equal(log.sum, 8);
+
+    memset(&log, 0, sizeof log);
+    assert_int_equal(lyd_parse_mem_clb(ctx, json, LYD_JSON, LYD_OPT_CONFIG, &clb), 0);
+    assert_string_equal(log.buf, "<cont><l>k=a;val=1;<sub>n=5;</sub></l><l>k=b;val=2;<skip></l>ll=3;ll=4;</cont>top=t;");
+    assert_int_equal(log.sum, 8);
+
+    /* a subtree materialized */
+    memset(&log, 0, sizeof log);
+    log.subtree = 1;
+    assert_int_equal(lyd_parse_mem_clb(ctx, xml, LYD_XML, LYD_OPT_CONFIG, &clb), 0);
+    assert_string_equal(log.buf, "<cont><l>k=a;val=1;<sub>[{\"test:sub\":{\"n\":5}}]</l><l>k=b;val=2;<skip></l>ll=3;ll=4;</cont>top=t;");
+
+    memset(&log, 0, sizeof log);
+    log.subtree = 1;
+    assert_int_equal(lyd_parse_mem_clb(ctx, json, LYD_JSON, LYD_OPT_CONFIG, &clb), 0);
+    assert_string_equal(log.buf, "<cont><l>k=a;val=1;<sub>[{\"test:sub\":{\"n\":5}}]</l><l>k=b;val=2;<skip></l>ll=3;ll=4;</cont>top=t;");
+
+    /* from a file */
+    memset(&log, 0, sizeof log);
+    strcpy(file_name, TMP_TEMPLATE);
+    fd = mkstemp(file_name);
+    assert_int_not_equal(fd, -1);
+    assert_int_equal(write(fd, json, strlen(json)), strlen(json));
+    assert_int_equal(lyd_parse_fd_clb(ctx, fd, LYD_JSON, LYD_OPT_CONFIG, &clb), 0);
+    assert_string_equal(log.buf, "<cont><l>k=a;val=1;<sub>n=5;</sub></l><l>k=b;val=2;<skip></l>ll=3;ll=4;</cont>top=t;");
+    close(fd);
+    unlink(file_name);
+
+    /* stopped by a callback */
+    memset(&log, 0, sizeof log);
+    log.stop = 1;
+    assert_int_equal(lyd_parse_mem_clb(ctx, xml, LYD_XML, LYD_OPT_CONFIG, &clb), 1);
+    assert_string_equal(log.buf, "<cont><l>");
+
+    memset(&log, 0, sizeof log);
+    log.stop = 1;
+    assert_int_equal(lyd_parse_mem_clb(ctx, json, LYD_JSON, LYD_OPT_CONFIG, &clb), 1);
+    assert_string_equal(log.buf, "<cont><l>");
+
+    /* invalid value in a materialized subtree */
+    memset(&log, 0, sizeof log);
+    log.subtree = 1;
+    assert_int_equal(lyd_parse_mem_clb(ctx, "<cont xmlns=\"urn:test\"><l><k>a</k><sub><n>300</n></sub></l></cont>",
+                                       LYD_XML, LYD_OPT_CONFIG, &clb), 1);
+    assert_int_equal(ly_errno, LY_EVALID);
+
+    memset(&log, 0, sizeof log);
+    log.subtree = 1;
+    assert_int_equal(lyd_parse_mem_clb(ctx, "{\"test:cont\":{\"l\":[{\"k\":\"a\",\"sub\":{\"n\":300}}]}}",
+                                       LYD_JSON, LYD_OPT_CONFIG, &clb), 1);
+    assert_int_equal(ly_errno, LY_EVALID);
+
+    /* unsupported options */
+    assert_int_equal(lyd_parse_mem_clb(ctx, xml, LYD_XML, LYD_OPT_CONFIG | LYD_OPT_ARENA, &clb), 1);
+    assert_int_equal(lyd_parse_mem_clb(ctx, xml, LYD_LYB, LYD_OPT_CONFIG, &clb), 1);
+}
+
 static void
 test_lyd_find_sibling(void **state)
 {
@@ -1260,6 +2330,76 @@ test_lyd_free_attr(void **state)
 
 }
 
+static void
+test_lyd_parse_arena(void **state)
+{
+    (void) state; /* unused */
+    struct lyd_node *data, *dup, *node;
+    char *mem, *str, *printed;
+    size_t size = 0;
+    int i, j;
+
+    /* enough list instances for several arena slabs */
+    mem = malloc(20 * 255 * 100 + 100);
+    if (!mem) {
+        fail();
+    }
+    size += sprintf(mem + size, "<x xmlns=\"urn:a\" xmlns:a=\"urn:a\" a:test=\"attr\"><bubba>test</bubba></x>");
+    for (i = 0; i < 20; ++i) {
+        for (j = 0; j < 255; ++j) {
+            size += sprintf(mem + size, "<l xmlns=\"urn:a\"><key1>%d</key1><key2>%d</key2><value>v</value></l>", i, j);
+        }
+    }
+
+    data = lyd_parse_mem(ctx, mem, LYD_XML, LYD_OPT_CONFIG | LYD_OPT_STRICT | LYD_OPT_ARENA);
+    free(mem);
+    assert_ptr_not_equal(data, NULL);
+    assert_ptr_not_equal(data->attr, NULL);
+    assert_string_equal(data->attr->value_str, "attr");
+    assert_int_equal(lyd_print_mem(&printed, data, LYD_XML, LYP_WITHSIBLINGS), 0);
+
+    /* arena trees can be freed partially and combined with standard trees */
+    dup = lyd_dup(data, 1);
+    assert_ptr_not_equal(dup, NULL);
+    lyd_free_attr(ctx, data, data->attr, 1);
+    node = data->next;
+    assert_int_equal(lyd_unlink(node), 0);
+    assert_int_equal(lyd_insert_after(root->prev, node), 0);
+    lyd_free(data->next);
+
+    /* arena trees can be printed and parsed again */
+    assert_ptr_not_equal(dup->attr, NULL);
+    lyd_free(dup);
+    assert_int_equal(lyd_print_mem(&str, data, LYD_JSON, LYP_WITHSIBLINGS), 0);
+    lyd_free_withsiblings(data);
+    data = lyd_parse_mem(ctx, str, LYD_JSON, LYD_OPT_CONFIG | LYD_OPT_STRICT | LYD_OPT_ARENA);
+    free(str);
+    assert_ptr_not_equal(data, NULL);
+    lyd_free_withsiblings(data);
+
+    data = lyd_parse_mem(ctx, printed, LYD_XML, LYD_OPT_CONFIG | LYD_OPT_STRICT);
+    free(printed);
+    assert_ptr_not_equal(data, NULL);
+    assert_int_equal(lyd_print_mem(&str, data, LYD_LYB, LYP_WITHSIBLINGS), 0);
+    lyd_free_withsiblings(data);
+    data = lyd_parse_mem(ctx, str, LYD_LYB, LYD_OPT_CONFIG | LYD_OPT_STRICT | LYD_OPT_ARENA);
+    free(str);
+    assert_ptr_not_equal(data, NULL);
+    assert_string_equal(data->attr->value_str, "attr");
+
+    /* free the nodes in a different order than allocated */
+    while (data->prev != data) {
+        lyd_free(data->prev);
+    }
+    lyd_free(data);
+
+    /* invalid data */
+    ly_log_options(0);
+    assert_ptr_equal(lyd_parse_mem(ctx, "<x xmlns=\"urn:a\"><bubba>test</bubba><bubba>test</bubba></x>", LYD_XML,
+                                   LYD_OPT_CONFIG | LYD_OPT_STRICT | LYD_OPT_ARENA), NULL);
+    ly_log_options(LY_LOLOG | LY_LOSTORE_LAST);
+}
+
 static void
 test_lyd_print_mem_xml(void **state)
 {
@@ -1697,6 +2837,68 @@ test_lyd_print_clb_json(void **state)
     free(buf);
 }
 
+static ssize_t
+partial_lyd_print_clb(void *arg, const void *buf, size_t count)
+{
+    struct buff *pos = arg;
+    static int interrupt;
+
+    /* interrupt every other call and accept a single byte otherwise */
+    interrupt = !interrupt;
+    if (interrupt) {
+        errno = EINTR;
+        return -1;
+    }
+
+    assert_true(count > 0);
+    assert_int_equal(*(const char *)buf, pos->cmp[pos->len]);
+    ++pos->len;
+    return 1;
+}
+
+static ssize_t
+failing_lyd_print_clb(void *arg, const void *buf, size_t count)
+{
+    (void)buf;
+    (void)count;
+
+    errno = *(int *)arg;
+    return errno ? -1 : 0;
+}
+
+static void
+test_lyd_print_partial(void **state)
+{
+    (void) state; /* unused */
+    struct buff buf = {0, result_xml};
+
+    assert_int_equal(lyd_print_clb(partial_lyd_print_clb, &buf, root, LYD_XML, 0), 0);
+    assert_int_equal(buf.len, strlen(result_xml));
+}
+
+static void
+test_lyd_print_fail(void **state)
+{
+    (void) state; /* unused */
+    int fd, err;
+
+    /* not writable descriptor */
+    fd = open("/dev/null", O_RDONLY);
+    assert_int_not_equal(fd, -1);
+    assert_int_not_equal(lyd_print_fd(fd, root, LYD_XML, 0), 0);
+    assert_int_not_equal(lyd_print_fd(fd, root, LYD_JSON, 0), 0);
+    assert_int_not_equal(lyd_print_fd(fd, root, LYD_LYB, 0), 0);
+    assert_int_not_equal(lys_print_fd(fd, root->schema->module, LYS_OUT_YANG, NULL, 0, 0), 0);
+    close(fd);
+
+    /* callback failing or writing nothing */
+    err = ENOSPC;
+    assert_int_not_equal(lyd_print_clb(failing_lyd_print_clb, &err, root, LYD_XML, 0), 0);
+    assert_int_not_equal(lys_print_clb(failing_lyd_print_clb, &err, root->schema->module, LYS_OUT_TREE, NULL, 0, 0), 0);
+    err = 0;
+    assert_int_not_equal(lyd_print_clb(failing_lyd_print_clb, &err, root, LYD_JSON, 0), 0);
+}
+
 static void
 test_lyd_path(void **state)
 {
@@ -2025,6 +3227,7 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_lyd_parse_mem),
         cmocka_unit_test(test_lyd_parse_fd),
+        cmocka_unit_test_setup_teardown(test_lyd_parse_fd_pipe, setup_f, teardown_f),
         cmocka_unit_test(test_lyd_parse_path),
         cmocka_unit_test(test_lyd_parse_xml),
         cmocka_unit_test_setup_teardown(test_lyd_new, setup_f, teardown_f),
@@ -2040,6 +3243,14 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_lyd_schema_sort, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_find_path, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_find_instance, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_lyd_find_path_simple, setup_f2, teardown_f2),
+        cmocka_unit_test_setup_teardown(test_lyd_parse_mem_parallel, setup_f2, teardown_f2),
+        cmocka_unit_test_setup_teardown(test_lyd_path_tmpl, setup_f2, teardown_f2),
+        cmocka_unit_test_setup_teardown(test_lyd_list_nth, setup_f2, teardown_f2),
+        cmocka_unit_test_setup_teardown(test_lyd_subtree_hash, setup_f2, teardown_f2),
+        cmocka_unit_test_setup_teardown(test_lyd_snapshot, setup_f2, teardown_f2),
+        cmocka_unit_test_setup_teardown(test_lyd_journal, setup_f2, teardown_f2),
+        cmocka_unit_test_setup_teardown(test_lyd_parse_clb, setup_f2, teardown_f2),
         cmocka_unit_test_setup_teardown(test_lyd_find_sibling, setup_f2, teardown_f2),
         cmocka_unit_test_setup_teardown(test_lyd_validate, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_unlink, setup_f, teardown_f),
@@ -2047,6 +3258,7 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_lyd_free_withsiblings, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_insert_attr, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_free_attr, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_lyd_parse_arena, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_print_mem_xml, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_print_mem_xml_format, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_print_mem_json, setup_f, teardown_f),
@@ -2059,6 +3271,8 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_lyd_print_clb_xml, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_print_clb_xml_format, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_print_clb_json, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_lyd_print_partial, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_lyd_print_fail, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_path, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyd_leaf_type, setup_f2, teardown_f2),
         cmocka_unit_test_setup_teardown(test_lyd_validation_dflt_empty_containers, setup_f, teardown_f),
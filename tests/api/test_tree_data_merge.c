@@ -732,6 +732,69 @@ test_merge_leafrefs(void **state)
     free(prt);
 }
 
+static void
+test_merge_toplevel_hash(void **state)
+{
+    struct state *st = (*state);
+    const char *sch = "module x {"
+                      "  namespace urn:x;"
+                      "  prefix x;"
+                      "  list l {"
+                      "    key n;"
+                      "    leaf n { type string; }"
+                      "    leaf t { type string; }}"
+                      "  leaf-list ll { type string; }"
+                      "  list s {"
+                      "    config false;"
+                      "    leaf v { type string; }}"
+                      "  leaf x { type string; }}";
+    const char *trg = "<l xmlns=\"urn:x\"><n>a</n></l>"
+                      "<l xmlns=\"urn:x\"><n>b</n><t>1</t></l>"
+                      "<l xmlns=\"urn:x\"><n>c</n></l>"
+                      "<ll xmlns=\"urn:x\">a</ll>"
+                      "<ll xmlns=\"urn:x\">b</ll>"
+                      "<s xmlns=\"urn:x\"><v>a</v></s>"
+                      "<x xmlns=\"urn:x\">x</x>";
+    const char *src = "<l xmlns=\"urn:x\"><n>d</n></l>"
+                      "<l xmlns=\"urn:x\"><n>b</n><t>2</t></l>"
+                      "<ll xmlns=\"urn:x\">c</ll>"
+                      "<ll xmlns=\"urn:x\">a</ll>"
+                      "<s xmlns=\"urn:x\"><v>a</v></s>"
+                      "<s xmlns=\"urn:x\"><v>a</v></s>"
+                      "<x xmlns=\"urn:x\">y</x>";
+    const char *res = "<l xmlns=\"urn:x\"><n>a</n></l>"
+                      "<l xmlns=\"urn:x\"><n>b</n><t>2</t></l>"
+                      "<l xmlns=\"urn:x\"><n>c</n></l>"
+                      "<ll xmlns=\"urn:x\">a</ll>"
+                      "<ll xmlns=\"urn:x\">b</ll>"
+                      "<s xmlns=\"urn:x\"><v>a</v></s>"
+                      "<x xmlns=\"urn:x\">y</x>"
+                      "<l xmlns=\"urn:x\"><n>d</n></l>"
+                      "<ll xmlns=\"urn:x\">c</ll>"
+                      "<s xmlns=\"urn:x\"><v>a</v></s>";
+    char *prt = NULL;
+
+    /* enough top-level siblings to be matched using a hash table */
+    assert_ptr_not_equal(lys_parse_mem(st->ctx1, sch, LYS_IN_YANG), NULL);
+
+    st->target = lyd_parse_mem(st->ctx1, trg, LYD_XML, LYD_OPT_GET);
+    assert_ptr_not_equal(st->target, NULL);
+
+    st->source = lyd_parse_mem(st->ctx1, src, LYD_XML, LYD_OPT_GET);
+    assert_ptr_not_equal(st->source, NULL);
+
+    assert_int_equal(lyd_merge(st->target, st->source, 0), 0);
+
+    lyd_print_mem(&prt, st->target, LYD_XML, LYP_WITHSIBLINGS);
+    assert_string_equal(prt, res);
+    free(prt);
+
+    /* the source is not modified */
+    lyd_print_mem(&prt, st->source, LYD_XML, LYP_WITHSIBLINGS);
+    assert_string_equal(prt, src);
+    free(prt);
+}
+
 int
 main(void)
 {
@@ -749,6 +812,7 @@ main(void)
                     cmocka_unit_test_setup_teardown(test_merge_to_ctx, setup_mctx, teardown_mctx),
                     cmocka_unit_test_setup_teardown(test_merge_to_ctx_with_missing_schema, setup_mctx, teardown_mctx),
                     cmocka_unit_test_setup_teardown(test_merge_leafrefs, setup_dflt, teardown_dflt),
+                    cmocka_unit_test_setup_teardown(test_merge_toplevel_hash, setup_dflt, teardown_dflt),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -592,6 +592,51 @@ test_lyxml_xmlns_correct_format(void **state)
     lyxml_free(ctx, xml);
 }
 
+static void
+test_lyxml_long_text(void **state)
+{
+    (void)state;
+    const char *in = "plain text &lt;&amp;&#x3b1; α阳𪐕 <![CDATA[x<y&]]> and more ",
+               *out = "plain text <&α α阳𪐕 x<y& and more ";
+    struct lyxml_elem *xml;
+    char *data, *content, *dptr, *cptr;
+    int i;
+
+    /* the content is longer than the internal buffer and the special characters are at various offsets */
+    data = malloc(2 * 200 * strlen(in) + 64);
+    content = malloc(200 * strlen(out) + 1);
+    assert_non_null(data);
+    assert_non_null(content);
+
+    dptr = data + sprintf(data, "<a attr=\"");
+    cptr = content;
+    for (i = 0; i < 200; ++i) {
+        /* no CDATA in the attribute value */
+        dptr += sprintf(dptr, "%.*s", (int)(strchr(in, '<') - in), in);
+        cptr += sprintf(cptr, "%.*s", (int)(strstr(out, "x<") - out), out);
+    }
+    dptr += sprintf(dptr, "\">");
+    for (i = 0; i < 200; ++i) {
+        dptr += sprintf(dptr, "%s", in);
+    }
+    sprintf(dptr, "</a>");
+
+    xml = lyxml_parse_mem(ctx, data, 0);
+    assert_non_null(xml);
+    assert_non_null(xml->attr);
+    assert_string_equal(xml->attr->value, content);
+
+    cptr = content;
+    for (i = 0; i < 200; ++i) {
+        cptr += sprintf(cptr, "%s", out);
+    }
+    assert_string_equal(xml->content, content);
+
+    lyxml_free(ctx, xml);
+    free(data);
+    free(content);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -609,6 +654,7 @@ int main(void)
         cmocka_unit_test_setup_teardown(test_lyxml_free_withsiblings, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyxml_xmlns_wrong_format, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_lyxml_xmlns_correct_format, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_lyxml_long_text, setup_f, teardown_f),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
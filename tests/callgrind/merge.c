@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <valgrind/callgrind.h>
+
+#include "tests/config.h"
+#include "libyang.h"
+
+#define SCHEMA TESTS_DIR "/callgrind/files/merge.yang"
+
+/* number of list instances in each tree, half of them in both */
+#define INSTANCES 20000
+
+static struct lyd_node *
+create_data(struct ly_ctx *ctx, int first, int value)
+{
+    struct lyd_node *data;
+    char *xml, *ptr;
+    int i;
+
+    xml = malloc(INSTANCES * 160 + 128);
+    if (!xml) {
+        return NULL;
+    }
+
+    ptr = xml;
+    for (i = first; i < first + INSTANCES; ++i) {
+        ptr += sprintf(ptr, "<top xmlns=\"urn:libyang:test:merge\"><key1>%d</key1><leaf1>%d</leaf1></top>", i, value);
+    }
+    ptr += sprintf(ptr, "<cont xmlns=\"urn:libyang:test:merge\">");
+    for (i = first; i < first + INSTANCES; ++i) {
+        ptr += sprintf(ptr, "<list1><key1>%d</key1><leaf1>%d</leaf1></list1>", i, value);
+    }
+    sprintf(ptr, "</cont>");
+
+    data = lyd_parse_mem(ctx, xml, LYD_XML, LYD_OPT_CONFIG | LYD_OPT_STRICT);
+    free(xml);
+    return data;
+}
+
+int
+main(void)
+{
+    int ret = 0;
+    struct ly_ctx *ctx = NULL;
+    struct lyd_node *data1 = NULL, *data2 = NULL;
+
+    ctx = ly_ctx_new(NULL, 0);
+    if (!ctx) {
+        ret = 1;
+        goto finish;
+    }
+
+    if (!lys_parse_path(ctx, SCHEMA, LYS_YANG)) {
+        ret = 1;
+        goto finish;
+    }
+
+    data1 = create_data(ctx, 0, 1);
+    data2 = create_data(ctx, INSTANCES / 2, 2);
+    if (!data1 || !data2) {
+        ret = 1;
+        goto finish;
+    }
+
+    CALLGRIND_START_INSTRUMENTATION;
+    if (lyd_merge(data1, data2, 0)) {
+        ret = 1;
+        goto finish;
+    }
+    CALLGRIND_STOP_INSTRUMENTATION;
+
+finish:
+    lyd_free_withsiblings(data1);
+    lyd_free_withsiblings(data2);
+    ly_ctx_destroy(ctx, NULL);
+    return ret;
+}
@@ -144,6 +144,74 @@ test_un_empty(void **state)
     assert_ptr_not_equal(st->dt, NULL);
 }
 
+static void
+test_un_revalidate(void **state)
+{
+    struct state *st = (*state);
+    struct ly_set *set;
+    const char *xml = "<un xmlns=\"urn:libyang:tests:unique\">"
+                        "<list><name>x</name><value>1</value></list>"
+                        "<list><name>y</name></list>"
+                        "<list><name>z</name><value>3</value></list>"
+                      "</un>";
+
+    st->dt = lyd_parse_mem(st->ctx, xml, LYD_XML, LYD_OPT_CONFIG);
+    assert_ptr_not_equal(st->dt, NULL);
+
+    /* changed value of a single instance */
+    set = lyd_find_path(st->dt, "/unique:un/list[name='z']/value");
+    assert_ptr_not_equal(set, NULL);
+    assert_int_equal(set->number, 1);
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)set->set.d[0], "1"), 0);
+    assert_int_not_equal(lyd_validate(&st->dt, LYD_OPT_CONFIG, NULL), 0);
+    assert_string_equal(ly_errmsg(st->ctx), "Unique data leaf(s) \"value a\" not satisfied in \"/unique:un/list[name='x']\" and \"/unique:un/list[name='z']\".");
+
+    /* the instances stay invalid until fixed */
+    assert_int_not_equal(lyd_validate(&st->dt, LYD_OPT_CONFIG, NULL), 0);
+    assert_int_equal(lyd_change_leaf((struct lyd_node_leaf_list *)set->set.d[0], "3"), 0);
+    assert_int_equal(lyd_validate(&st->dt, LYD_OPT_CONFIG, NULL), 0);
+
+    /* removed value replaced by the default one */
+    lyd_free(set->set.d[0]);
+    ly_set_free(set);
+    assert_int_not_equal(lyd_validate(&st->dt, LYD_OPT_CONFIG, NULL), 0);
+    assert_string_equal(ly_errmsg(st->ctx), "Unique data leaf(s) \"value a\" not satisfied in \"/unique:un/list[name='y']\" and \"/unique:un/list[name='z']\".");
+}
+
+static void
+test_un_revalidate_many(void **state)
+{
+    struct state *st = (*state);
+    struct lyd_node *list;
+    char name[64], value[16];
+    int i;
+
+    st->dt = lyd_new(NULL, st->mod, "un");
+    assert_ptr_not_equal(st->dt, NULL);
+    for (i = 0; i < 16; ++i) {
+        sprintf(name, "l%d", i);
+        sprintf(value, "%d", i + 10);
+        list = lyd_new(st->dt, NULL, "list");
+        assert_ptr_not_equal(list, NULL);
+        assert_ptr_not_equal(lyd_new_leaf(list, NULL, "name", name), NULL);
+        assert_ptr_not_equal(lyd_new_leaf(list, NULL, "value", value), NULL);
+    }
+    assert_int_equal(lyd_validate(&st->dt, LYD_OPT_CONFIG, NULL), 0);
+
+    /* exactly 8 changed instances are checked against the 8 unchanged ones */
+    for (i = 0; i < 8; ++i) {
+        sprintf(name, "/unique:un/list[name='l%d']/value", i);
+        sprintf(value, "%d", i + 100);
+        assert_ptr_not_equal(lyd_new_path(st->dt, NULL, name, value, 0, LYD_PATH_OPT_UPDATE), NULL);
+    }
+    assert_int_equal(lyd_validate(&st->dt, LYD_OPT_CONFIG, NULL), 0);
+
+    /* and a duplicate among them is still found */
+    assert_ptr_not_equal(lyd_new_path(st->dt, NULL, "/unique:un/list[name='l0']/value", "25", 0, LYD_PATH_OPT_UPDATE), NULL);
+    assert_int_not_equal(lyd_validate(&st->dt, LYD_OPT_CONFIG, NULL), 0);
+    assert_int_equal(ly_vecode(st->ctx), LYVE_NOUNIQ);
+}
+
 static void
 test_schema_inpath(void **state)
 {
@@ -170,6 +238,8 @@ int main(void)
                     cmocka_unit_test_setup_teardown(test_un_correct, setup_f, teardown_f),
                     cmocka_unit_test_setup_teardown(test_un_defaults, setup_f, teardown_f),
                     cmocka_unit_test_setup_teardown(test_un_empty, setup_f, teardown_f),
+                    cmocka_unit_test_setup_teardown(test_un_revalidate, setup_f, teardown_f),
+                    cmocka_unit_test_setup_teardown(test_un_revalidate_many, setup_f, teardown_f),
                     cmocka_unit_test_setup_teardown(test_schema_inpath, setup_f, teardown_f),
     };
 
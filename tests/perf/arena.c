@@ -0,0 +1,121 @@
+/**
+ * @file arena.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - parsing and freeing a large data tree with and without the node arena.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* number of data nodes in the parsed tree (every list instance has 3) */
+#define NODES 300000
+
+#define ROUNDS 5
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+parse_free(struct ly_ctx *ctx, const char *str, int options, double *parse_time, double *free_time)
+{
+	struct lyd_node *data;
+	double start;
+	int i;
+
+	*parse_time = 0;
+	*free_time = 0;
+	for (i = 0; i < ROUNDS; ++i) {
+		start = now();
+		data = lyd_parse_mem(ctx, str, LYD_XML, options);
+		if (!data) {
+			return 1;
+		}
+		*parse_time += now() - start;
+
+		start = now();
+		lyd_free_withsiblings(data);
+		*free_time += now() - start;
+	}
+	*parse_time /= ROUNDS;
+	*free_time /= ROUNDS;
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	char *str = NULL;
+	double parse_time, free_time, arena_parse_time, arena_free_time;
+	size_t len;
+	int i, ret = 1, nodes = NODES;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s model.yin [nodes]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 2) {
+		nodes = atoi(argv[2]);
+	}
+
+	/* libyang context */
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+
+	/* schema */
+	if (!lys_parse_path(ctx, argv[1], LYS_IN_YIN)) {
+		fprintf(stderr, "Failed to load data model.\n");
+		goto cleanup;
+	}
+
+	/* data */
+	str = malloc(nodes / 3 * 128 + 1);
+	if (!str) {
+		fprintf(stderr, "Memory allocation failed.\n");
+		goto cleanup;
+	}
+	len = 0;
+	for (i = 0; i < nodes / 3; ++i) {
+		len += sprintf(str + len, "<ptest1 xmlns=\"urn:libyang:performance:test\"><index>%d</index><p1>%d</p1></ptest1>", i, i);
+	}
+	str[len] = '\0';
+
+	if (parse_free(ctx, str, LYD_OPT_CONFIG, &parse_time, &free_time)
+			|| parse_free(ctx, str, LYD_OPT_CONFIG | LYD_OPT_ARENA, &arena_parse_time, &arena_free_time)) {
+		fprintf(stderr, "Failed to load data.\n");
+		goto cleanup;
+	}
+
+	printf(" malloc: parse %.3fs, free %.3fs\n arena : parse %.3fs, free %.3fs\n", parse_time, free_time,
+	       arena_parse_time, arena_free_time);
+	ret = 0;
+
+cleanup:
+	free(str);
+	ly_ctx_destroy(ctx, NULL);
+
+	return ret;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file ctx.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - creating empty contexts with the internal modules.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+#define ROUNDS 1000
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	double start, first, rest;
+	int i, rounds = ROUNDS;
+
+	if (argc > 1) {
+		rounds = atoi(argv[1]);
+	}
+	if (rounds < 1) {
+		fprintf(stderr, "Usage: %s [rounds]\n", argv[0]);
+		return 1;
+	}
+
+	/* the first context in the process prepares the internal modules */
+	start = now();
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+	ly_ctx_destroy(ctx, NULL);
+	first = now() - start;
+
+	start = now();
+	for (i = 0; i < rounds; ++i) {
+		ctx = ly_ctx_new(NULL, 0);
+		if (!ctx) {
+			fprintf(stderr, "Failed to create context.\n");
+			return 1;
+		}
+		ly_ctx_destroy(ctx, NULL);
+	}
+	rest = (now() - start) / rounds;
+
+	printf(" first: %.1fus\n next : %.1fus\n", first * 1e6, rest * 1e6);
+
+	return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file dict.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - concurrent dictionary insert/remove.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* distinct strings used by every thread */
+#define STRINGS 4096
+/* insert+remove pairs performed by every thread */
+#define OPS 1000000
+
+static struct ly_ctx *ctx;
+static char **strings;
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *
+worker(void *arg)
+{
+	unsigned int seed = (unsigned int)(long)arg, i, idx;
+	const char *str;
+
+	for (i = 0; i < OPS; ++i) {
+		/* mix of strings shared with other threads and the ones (mostly) used by this thread only */
+		idx = rand_r(&seed) % STRINGS;
+		str = lydict_insert(ctx, strings[idx], 0);
+		if (!str) {
+			fprintf(stderr, "Dictionary insert failed.\n");
+			exit(1);
+		}
+		lydict_remove(ctx, str);
+	}
+
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	int max_threads = 32, threads, i;
+	pthread_t *tids;
+	const char **held;
+	double start, elapsed, base = 0;
+
+	if (argc > 1) {
+		max_threads = atoi(argv[1]);
+		if (max_threads < 1) {
+			fprintf(stderr, "Usage: %s [max-threads]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+
+	strings = malloc(STRINGS * sizeof *strings);
+	held = malloc(STRINGS * sizeof *held);
+	tids = malloc(max_threads * sizeof *tids);
+	for (i = 0; i < STRINGS; ++i) {
+		if (asprintf(&strings[i], "urn:example:perf:dictionary:string-%d", i) == -1) {
+			return 1;
+		}
+		/* keep half of the strings referenced the whole time, the other half gets inserted and removed */
+		held[i] = (i % 2) ? lydict_insert(ctx, strings[i], 0) : NULL;
+	}
+
+	printf("threads  ops/s (total)   speedup\n");
+	for (threads = 1; threads <= max_threads; threads *= 2) {
+		start = now();
+		for (i = 0; i < threads; ++i) {
+			pthread_create(&tids[i], NULL, worker, (void *)(long)(i + 1));
+		}
+		for (i = 0; i < threads; ++i) {
+			pthread_join(tids[i], NULL);
+		}
+		elapsed = now() - start;
+
+		if (threads == 1) {
+			base = OPS / elapsed;
+		}
+		printf("%7d  %14.0f   %6.2fx\n", threads, ((double)OPS * threads) / elapsed, ((OPS * threads) / elapsed) / base);
+	}
+
+	for (i = 0; i < STRINGS; ++i) {
+		lydict_remove(ctx, held[i]);
+		free(strings[i]);
+	}
+	free(strings);
+	free(held);
+	free(tids);
+	ly_ctx_destroy(ctx, NULL);
+
+	return 0;
+}
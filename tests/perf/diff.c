@@ -0,0 +1,174 @@
+/**
+ * @file diff.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - diff of reordered user-ordered leaf-list instances.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* default number of leaf-list instances */
+#define INSTANCES 100000
+
+/* number of instances swapped in pairs */
+#define MOVES 100
+
+static const char *schema =
+	"module diff {"
+		"namespace urn:libyang:performance:diff;"
+		"prefix d;"
+		"container cont {"
+			"leaf-list llist {"
+				"type string;"
+				"ordered-by user;"
+			"}"
+		"}"
+	"}";
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static struct lyd_node *
+create_data(const struct lys_module *mod, int *order, int instances)
+{
+	struct lyd_node *data;
+	char value[32];
+	int i;
+
+	data = lyd_new(NULL, mod, "cont");
+	for (i = 0; i < instances; ++i) {
+		sprintf(value, "item%d", order ? order[i] : i);
+		if (!lyd_new_leaf(data, mod, "llist", value)) {
+			lyd_free(data);
+			return NULL;
+		}
+	}
+
+	return data;
+}
+
+static int
+run_diff(const struct lys_module *mod, const char *name, int *order, int instances)
+{
+	struct lyd_node *first, *second;
+	struct lyd_difflist *diff;
+	double start, diff_time;
+	int i;
+
+	first = create_data(mod, NULL, instances);
+	second = create_data(mod, order, instances);
+	if (!first || !second) {
+		fprintf(stderr, "Failed to create the data.\n");
+		lyd_free(first);
+		lyd_free(second);
+		return 1;
+	}
+
+	start = now();
+	diff = lyd_diff(first, second, 0);
+	diff_time = now() - start;
+	if (!diff) {
+		fprintf(stderr, "Failed to diff the data.\n");
+		lyd_free(first);
+		lyd_free(second);
+		return 1;
+	}
+
+	for (i = 0; diff->type[i] != LYD_DIFF_END; ++i);
+	printf(" %-9s: %.6fs (%d moves)\n", name, diff_time, i);
+
+	lyd_free_diff(diff);
+	lyd_free(first);
+	lyd_free(second);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	const struct lys_module *mod;
+	int *order = NULL, i, j, k, tmp, instances, ret = 1;
+
+	instances = (argc > 1) ? atoi(argv[1]) : INSTANCES;
+	if (instances < 2) {
+		fprintf(stderr, "Usage: %s [instances]\n", argv[0]);
+		return 1;
+	}
+
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+	mod = lys_parse_mem(ctx, schema, LYS_IN_YANG);
+	order = malloc(instances * sizeof *order);
+	if (!mod || !order) {
+		fprintf(stderr, "Failed to load data model.\n");
+		goto cleanup;
+	}
+	srand(42);
+
+	/* a few pairs of instances swapped */
+	for (i = 0; i < instances; ++i) {
+		order[i] = i;
+	}
+	for (i = 0; i < MOVES / 2; ++i) {
+		j = rand() % instances;
+		k = rand() % instances;
+		tmp = order[j];
+		order[j] = order[k];
+		order[k] = tmp;
+	}
+	if (run_diff(mod, "swapped", order, instances)) {
+		goto cleanup;
+	}
+
+	/* reversed order */
+	for (i = 0; i < instances; ++i) {
+		order[i] = instances - i - 1;
+	}
+	if (run_diff(mod, "reversed", order, instances)) {
+		goto cleanup;
+	}
+
+	/* random permutation */
+	for (i = 0; i < instances; ++i) {
+		order[i] = i;
+	}
+	for (i = instances - 1; i > 0; --i) {
+		j = rand() % (i + 1);
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+	if (run_diff(mod, "shuffled", order, instances)) {
+		goto cleanup;
+	}
+
+	ret = 0;
+
+cleanup:
+	free(order);
+	ly_ctx_destroy(ctx, NULL);
+	return ret;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file dup.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - copying a data tree directly and from its snapshot, diff of a modified copy
+ * by comparing the trees and from its journal.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* default number of list instances (every one has 6 data nodes) */
+#define INSTANCES 100000
+
+#define ROUNDS 5
+
+static const char *schema =
+	"module dup {"
+		"namespace urn:libyang:performance:dup;"
+		"prefix d;"
+		"container cont {"
+			"list item {"
+				"key name;"
+				"leaf name {"
+					"type string;"
+				"}"
+				"leaf mtu {"
+					"type uint32;"
+				"}"
+				"leaf descr {"
+					"type string;"
+				"}"
+				"container stats {"
+					"leaf in {"
+						"type uint64;"
+					"}"
+				"}"
+			"}"
+		"}"
+	"}";
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static struct lyd_node *
+create_data(struct ly_ctx *ctx, int instances)
+{
+	struct lyd_node *data, *item;
+	struct lyd_path_tmpl *tmpl;
+	char name[32], mtu[16], in[16];
+	const char *keys[1] = {name};
+	int i;
+
+	tmpl = lyd_path_tmpl_compile(ctx, "/dup:cont/item[name=?]/stats/in", 0);
+	data = lyd_new_path(NULL, ctx, "/dup:cont", NULL, 0, 0);
+	if (!tmpl || !data) {
+		lyd_path_tmpl_free(tmpl);
+		lyd_free(data);
+		return NULL;
+	}
+
+	for (i = 0; i < instances; ++i) {
+		sprintf(name, "eth%d", i);
+		sprintf(mtu, "%d", 1500 + i % 100);
+		sprintf(in, "%d", i * 7);
+		item = lyd_path_tmpl_new(data, tmpl, keys, in, 0);
+		if (!item || !lyd_new_leaf(item, NULL, "mtu", mtu)
+				|| !lyd_new_leaf(item, NULL, "descr", "interface description")) {
+			lyd_path_tmpl_free(tmpl);
+			lyd_free(data);
+			return NULL;
+		}
+	}
+	lyd_path_tmpl_free(tmpl);
+
+	if (lyd_validate(&data, LYD_OPT_CONFIG, NULL)) {
+		lyd_free(data);
+		return NULL;
+	}
+	return data;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	struct lyd_node *data, *copy;
+	struct lyd_snapshot *snap = NULL;
+	struct lyd_journal *journal;
+	struct lyd_difflist *diff;
+	double start, dup_time = 0, snap_time = 0, diff_time = 0, journal_time = 0, free_time = 0;
+	int i, changes, journal_changes, instances, ret = 1;
+
+	instances = (argc > 1) ? atoi(argv[1]) : INSTANCES;
+	if (instances < 1) {
+		fprintf(stderr, "Usage: %s [instances]\n", argv[0]);
+		return 1;
+	}
+
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+	if (!lys_parse_mem(ctx, schema, LYS_IN_YANG)) {
+		fprintf(stderr, "Failed to load data model.\n");
+		goto cleanup;
+	}
+	data = create_data(ctx, instances);
+	if (!data) {
+		fprintf(stderr, "Failed to create the data.\n");
+		goto cleanup;
+	}
+
+	/* standard duplicate */
+	for (i = 0; i < ROUNDS; ++i) {
+		start = now();
+		copy = lyd_dup_withsiblings(data, LYD_DUP_OPT_RECURSIVE);
+		dup_time += now() - start;
+		if (!copy) {
+			fprintf(stderr, "Failed to duplicate the data.\n");
+			lyd_free_withsiblings(data);
+			goto cleanup;
+		}
+		lyd_free_withsiblings(copy);
+	}
+
+	/* copy of a snapshot, a single leaf changed */
+	snap = lyd_snapshot(data);
+	if (!snap) {
+		fprintf(stderr, "Failed to create the snapshot.\n");
+		lyd_free_withsiblings(data);
+		goto cleanup;
+	}
+	for (i = 0; i < ROUNDS; ++i) {
+		start = now();
+		copy = lyd_snapshot_dup(snap);
+		snap_time += now() - start;
+		journal = copy ? lyd_journal_new(copy) : NULL;
+		if (!journal || !lyd_new_path(copy, NULL, "/dup:cont/item[name='eth1']/mtu", "9000", 0, LYD_PATH_OPT_UPDATE)) {
+			fprintf(stderr, "Failed to copy the snapshot.\n");
+			lyd_journal_free(journal);
+			lyd_free_withsiblings(copy);
+			goto cleanup;
+		}
+
+		start = now();
+		diff = lyd_diff(lyd_snapshot_data(snap), copy, 0);
+		diff_time += now() - start;
+		if (!diff) {
+			fprintf(stderr, "Failed to diff the data.\n");
+			lyd_journal_free(journal);
+			lyd_free_withsiblings(copy);
+			goto cleanup;
+		}
+		for (changes = 0; diff->type[changes] != LYD_DIFF_END; ++changes);
+		lyd_free_diff(diff);
+
+		start = now();
+		diff = lyd_journal_diff(journal);
+		journal_time += now() - start;
+		if (!diff) {
+			fprintf(stderr, "Failed to get the journal diff.\n");
+			lyd_journal_free(journal);
+			lyd_free_withsiblings(copy);
+			goto cleanup;
+		}
+		for (journal_changes = 0; diff->type[journal_changes] != LYD_DIFF_END; ++journal_changes);
+		lyd_free_diff(diff);
+		lyd_journal_free(journal);
+
+		start = now();
+		lyd_free_withsiblings(copy);
+		free_time += now() - start;
+	}
+
+	printf(" dup      : %.6fs\n snapshot : %.6fs (free %.6fs)\n diff     : %.6fs (%d changes)\n journal  : %.6fs (%d changes)\n",
+	       dup_time / ROUNDS, snap_time / ROUNDS, free_time / ROUNDS, diff_time / ROUNDS, changes, journal_time / ROUNDS,
+	       journal_changes);
+	ret = 0;
+
+cleanup:
+	lyd_snapshot_free(snap);
+	ly_ctx_destroy(ctx, NULL);
+	return ret;
+}
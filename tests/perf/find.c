@@ -0,0 +1,117 @@
+/**
+ * @file find.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - finding list instances by their keys with simple paths and with XPath.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* number of list instances */
+#define INSTANCES 10000
+
+/* number of lookups */
+#define LOOKUPS 100000
+
+static const char *schema =
+	"module find {"
+		"namespace urn:libyang:performance:find;"
+		"prefix f;"
+		"container cont {"
+			"list lst {"
+				"key \"name idx\";"
+				"leaf name { type string; }"
+				"leaf idx { type uint32; }"
+				"leaf value { type string; }"
+			"}"
+		"}"
+	"}";
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the path in parentheses is not simple and is always evaluated as XPath */
+static double
+find(struct lyd_node *data, int instances, int xpath)
+{
+	struct ly_set *set;
+	char path[128];
+	double start;
+	int i, idx;
+
+	start = now();
+	for (i = 0; i < LOOKUPS; ++i) {
+		idx = (i * 7919) % instances;
+		sprintf(path, xpath ? "(/find:cont/lst[name='n%d'][idx='%d']/value)" : "/find:cont/lst[name='n%d'][idx='%d']/value",
+		        idx, idx);
+		set = lyd_find_path(data, path);
+		if (!set || (set->number != 1)) {
+			fprintf(stderr, "Lookup of \"%s\" failed.\n", path);
+			exit(1);
+		}
+		ly_set_free(set);
+	}
+
+	return (now() - start) / LOOKUPS;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	struct lyd_node *data;
+	char path[128];
+	double simple_time, xpath_time;
+	int i, instances = INSTANCES;
+
+	if (argc > 1) {
+		instances = atoi(argv[1]);
+	}
+
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx || !lys_parse_mem(ctx, schema, LYS_IN_YANG)) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+
+	data = lyd_new_path(NULL, ctx, "/find:cont", NULL, 0, 0);
+	for (i = 0; data && (i < instances); ++i) {
+		sprintf(path, "/find:cont/lst[name='n%d'][idx='%d']/value", i, i);
+		if (!lyd_new_path(data, NULL, path, "val", 0, 0)) {
+			lyd_free(data);
+			data = NULL;
+		}
+	}
+	if (!data) {
+		fprintf(stderr, "Failed to create data.\n");
+		ly_ctx_destroy(ctx, NULL);
+		return 1;
+	}
+
+	simple_time = find(data, instances, 0);
+	xpath_time = find(data, instances, 1);
+	printf(" xpath : %.2fus\n simple: %.2fus (%.1fx)\n", xpath_time * 1e6, simple_time * 1e6, xpath_time / simple_time);
+
+	lyd_free(data);
+	ly_ctx_destroy(ctx, NULL);
+	return 0;
+}
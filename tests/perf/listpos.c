@@ -0,0 +1,126 @@
+/**
+ * @file listpos.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - learning positions of user-ordered list instances and moving them.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* default number of list instances */
+#define INSTANCES 50000
+
+/* number of instances moved */
+#define MOVES 10000
+
+static const char *schema =
+	"module listpos {"
+		"namespace urn:libyang:performance:listpos;"
+		"prefix lp;"
+		"container rules {"
+			"list rule {"
+				"key \"name\";"
+				"ordered-by user;"
+				"leaf name { type string; }"
+			"}"
+		"}"
+	"}";
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	const struct lys_module *mod;
+	struct lyd_node *data, *node, *sibling;
+	char name[32];
+	double start, pos_time, nth_time, move_time;
+	unsigned long sum = 0;
+	int i, instances;
+
+	instances = (argc > 1) ? atoi(argv[1]) : INSTANCES;
+	if (instances < 2) {
+		fprintf(stderr, "Usage: %s [instances]\n", argv[0]);
+		return 1;
+	}
+
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+	mod = lys_parse_mem(ctx, schema, LYS_IN_YANG);
+	if (!mod) {
+		fprintf(stderr, "Failed to load data model.\n");
+		goto error;
+	}
+
+	data = lyd_new(NULL, mod, "rules");
+	for (i = 0; i < instances; ++i) {
+		node = lyd_new(data, mod, "rule");
+		sprintf(name, "rule%d", i);
+		if (!node || !lyd_new_leaf(node, mod, "name", name)) {
+			fprintf(stderr, "Failed to create the data.\n");
+			goto error;
+		}
+	}
+
+	/* position of every instance */
+	start = now();
+	for (node = data->child; node; node = node->next) {
+		sum += lyd_list_pos(node);
+	}
+	pos_time = now() - start;
+
+	/* instance on every position */
+	start = now();
+	for (i = 1; i <= instances; ++i) {
+		sum += (lyd_list_nth(data->child, data->child->schema, i) != NULL);
+	}
+	nth_time = now() - start;
+
+	/* move random instances to random positions and learn their new position */
+	srand(42);
+	start = now();
+	for (i = 0; i < MOVES; ++i) {
+		node = lyd_list_nth(data->child, data->child->schema, rand() % instances + 1);
+		sibling = lyd_list_nth(data->child, data->child->schema, rand() % instances + 1);
+		if (node != sibling) {
+			lyd_insert_before(sibling, node);
+		}
+		sum += lyd_list_pos(node);
+	}
+	move_time = now() - start;
+
+	printf(" position: %.3fus per instance\n nth     : %.3fus per instance\n move    : %.3fus per instance (%lu)\n",
+	       pos_time * 1e6 / instances, nth_time * 1e6 / instances, move_time * 1e6 / MOVES, sum);
+
+	lyd_free_withsiblings(data);
+	ly_ctx_destroy(ctx, NULL);
+	return 0;
+
+error:
+	ly_ctx_destroy(ctx, NULL);
+	return 1;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file parallel.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - parsing many top-level list instances in XML and JSON data using several threads.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* default number of top-level list instances (every one has 4 data nodes) */
+#define INSTANCES 100000
+
+#define ROUNDS 5
+
+static const char *schema =
+	"module parallel {"
+		"namespace urn:libyang:performance:parallel;"
+		"prefix p;"
+		"list item {"
+			"key name;"
+			"leaf name {"
+				"type string;"
+			"}"
+			"leaf mtu {"
+				"type uint32;"
+			"}"
+			"leaf descr {"
+				"type string;"
+			"}"
+		"}"
+	"}";
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *
+create_data(LYD_FORMAT format, int instances)
+{
+	char *data, *ptr;
+	int i;
+
+	data = malloc(instances * 160 + 128);
+	if (!data) {
+		return NULL;
+	}
+
+	ptr = data;
+	if (format == LYD_XML) {
+		for (i = 0; i < instances; ++i) {
+			ptr += sprintf(ptr, "<item xmlns=\"urn:libyang:performance:parallel\">\n  <name>eth%d</name>\n"
+			               "  <mtu>%d</mtu>\n  <descr>interface description</descr>\n</item>\n", i, 1500 + i % 100);
+		}
+	} else {
+		ptr += sprintf(ptr, "{\n  \"parallel:item\": [\n");
+		for (i = 0; i < instances; ++i) {
+			ptr += sprintf(ptr, "    {\n      \"name\": \"eth%d\",\n      \"mtu\": %d,\n"
+			               "      \"descr\": \"interface description\"\n    }%s\n", i, 1500 + i % 100,
+			               (i < instances - 1) ? "," : "");
+		}
+		sprintf(ptr, "  ]\n}\n");
+	}
+
+	return data;
+}
+
+static int
+run_parse(struct ly_ctx *ctx, LYD_FORMAT format, const char *name, int instances)
+{
+	struct lyd_node *data;
+	char *str;
+	double start, parse_time;
+	int i, threads;
+
+	str = create_data(format, instances);
+	if (!str) {
+		fprintf(stderr, "Failed to create the data.\n");
+		return 1;
+	}
+
+	for (threads = 1; threads <= 8; threads *= 2) {
+		parse_time = 0;
+		for (i = 0; i < ROUNDS; ++i) {
+			start = now();
+			data = lyd_parse_mem_parallel(ctx, str, format, LYD_OPT_CONFIG, threads);
+			parse_time += now() - start;
+			if (!data) {
+				fprintf(stderr, "Failed to parse the data.\n");
+				free(str);
+				return 1;
+			}
+			lyd_free_withsiblings(data);
+		}
+
+		printf(" %-5s %d thread%s: %.6fs (%.1f MB/s)\n", name, threads, (threads > 1) ? "s" : " ", parse_time / ROUNDS,
+		       strlen(str) / (parse_time / ROUNDS) / 1e6);
+	}
+
+	free(str);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	int instances, ret = 1;
+
+	instances = (argc > 1) ? atoi(argv[1]) : INSTANCES;
+	if (instances < 1) {
+		fprintf(stderr, "Usage: %s [instances]\n", argv[0]);
+		return 1;
+	}
+
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+	if (!lys_parse_mem(ctx, schema, LYS_IN_YANG)) {
+		fprintf(stderr, "Failed to load data model.\n");
+		goto cleanup;
+	}
+
+	if (run_parse(ctx, LYD_XML, "XML", instances) || run_parse(ctx, LYD_JSON, "JSON", instances)) {
+		goto cleanup;
+	}
+	ret = 0;
+
+cleanup:
+	ly_ctx_destroy(ctx, NULL);
+	return ret;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file parse.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - parsing XML data directly, through the XML tree and for callbacks without a data tree.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include <libyang/libyang.h>
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *
+read_file(const char *path)
+{
+	FILE *f;
+	char *buf;
+	long size;
+
+	f = fopen(path, "r");
+	if (!f) {
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	buf = malloc(size + 1);
+	if (buf && (fread(buf, 1, size, f) != (size_t)size)) {
+		free(buf);
+		buf = NULL;
+	} else if (buf) {
+		buf[size] = '\0';
+	}
+	fclose(f);
+	return buf;
+}
+
+static int
+count_leaf(const struct lyd_node_leaf_list *leaf, void *data)
+{
+	(void)leaf;
+	++*(int *)data;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	struct lyd_node *data = NULL;
+	struct lyxml_elem *xml;
+	struct lyd_parse_clb clb = {NULL, count_leaf, NULL, NULL, NULL};
+	struct rusage usage;
+	char *str;
+	double start;
+	int tree, events, leaves = 0, ret = 0;
+
+	if ((argc < 4) || (strcmp(argv[3], "tree") && strcmp(argv[3], "stream") && strcmp(argv[3], "events"))) {
+		fprintf(stderr, "Usage: %s model.yin data.xml tree|stream|events\n", argv[0]);
+		return 1;
+	}
+	tree = !strcmp(argv[3], "tree");
+	events = !strcmp(argv[3], "events");
+	clb.data = &leaves;
+
+	/* libyang context */
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+
+	/* schema */
+	if (!lys_parse_path(ctx, argv[1], LYS_IN_YIN)) {
+		fprintf(stderr, "Failed to load data model.\n");
+		goto cleanup;
+	}
+
+	str = read_file(argv[2]);
+	if (!str) {
+		fprintf(stderr, "Failed to read data.\n");
+		goto cleanup;
+	}
+
+	/* data */
+	start = now();
+	if (tree) {
+		/* the whole XML tree is built first */
+		xml = lyxml_parse_mem(ctx, str, LYXML_PARSE_MULTIROOT);
+		data = lyd_parse_xml(ctx, &xml, LYD_OPT_CONFIG);
+		lyxml_free_withsiblings(ctx, xml);
+	} else if (events) {
+		/* the values are only passed to the callback, no data tree is built */
+		ret = lyd_parse_mem_clb(ctx, str, LYD_XML, LYD_OPT_CONFIG, &clb);
+	} else {
+		/* the data nodes are created while the XML is being parsed */
+		data = lyd_parse_mem(ctx, str, LYD_XML, LYD_OPT_CONFIG);
+	}
+	if (events ? ret : !data) {
+		fprintf(stderr, "Failed to load data.\n");
+	}
+	free(str);
+
+	getrusage(RUSAGE_SELF, &usage);
+	printf(" time  : %.3fs\n memory: %ldKb\n", now() - start, usage.ru_maxrss);
+
+cleanup:
+	lyd_free_withsiblings(data);
+	ly_ctx_destroy(ctx, NULL);
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file print.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - printing a large data tree into memory and a file descriptor.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libyang/libyang.h>
+
+/* number of data nodes in the printed tree (every list instance has 3) */
+#define NODES 1000000
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	struct lyd_node *data = NULL;
+	char *str;
+	double start;
+	size_t len;
+	int i, fd, nodes = NODES;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s model.yin [nodes]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 2) {
+		nodes = atoi(argv[2]);
+	}
+
+	/* libyang context */
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+
+	/* schema */
+	if (!lys_parse_path(ctx, argv[1], LYS_IN_YIN)) {
+		fprintf(stderr, "Failed to load data model.\n");
+		goto cleanup;
+	}
+
+	/* data */
+	str = malloc(nodes / 3 * 128 + 1);
+	if (!str) {
+		fprintf(stderr, "Memory allocation failed.\n");
+		goto cleanup;
+	}
+	len = 0;
+	for (i = 0; i < nodes / 3; ++i) {
+		len += sprintf(str + len, "<ptest1 xmlns=\"urn:libyang:performance:test\"><index>%d</index><p1>%d</p1></ptest1>", i, i);
+	}
+	str[len] = '\0';
+	data = lyd_parse_mem(ctx, str, LYD_XML, LYD_OPT_CONFIG);
+	free(str);
+	if (!data) {
+		fprintf(stderr, "Failed to load data.\n");
+		goto cleanup;
+	}
+
+	start = now();
+	if (lyd_print_mem(&str, data, LYD_XML, LYP_WITHSIBLINGS | LYP_FORMAT)) {
+		fprintf(stderr, "Failed to print data.\n");
+		goto cleanup;
+	}
+	printf(" lyd_print_mem: %.3fs (%zu bytes)\n", now() - start, strlen(str));
+	free(str);
+
+	fd = open("/dev/null", O_WRONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open /dev/null.\n");
+		goto cleanup;
+	}
+	start = now();
+	if (lyd_print_fd(fd, data, LYD_XML, LYP_WITHSIBLINGS | LYP_FORMAT)) {
+		fprintf(stderr, "Failed to print data.\n");
+	}
+	printf(" lyd_print_fd : %.3fs\n", now() - start);
+	close(fd);
+
+cleanup:
+	lyd_free_withsiblings(data);
+	ly_ctx_destroy(ctx, NULL);
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file set.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - building big sets and searching them.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* number of objects in the set */
+#define ITEMS 200000
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_set *set, *set2;
+	char *items;
+	double start, list_time, add_time, merge_time;
+	int i, count = ITEMS;
+
+	if (argc > 1) {
+		count = atoi(argv[1]);
+	}
+
+	items = malloc(2 * count);
+	set = ly_set_new();
+	set2 = ly_set_new();
+	if (!items || !set || !set2) {
+		fprintf(stderr, "Memory allocation failed.\n");
+		return 1;
+	}
+
+	/* list without duplicate checks */
+	start = now();
+	for (i = 0; i < count; ++i) {
+		ly_set_add(set, &items[i], LY_SET_OPT_USEASLIST);
+	}
+	list_time = now() - start;
+	ly_set_clean(set);
+
+	/* set with duplicate checks */
+	start = now();
+	for (i = 0; i < count; ++i) {
+		ly_set_add(set, &items[i], 0);
+	}
+	add_time = now() - start;
+
+	/* merge half overlapping sets */
+	for (i = count / 2; i < count + count / 2; ++i) {
+		ly_set_add(set2, &items[i], 0);
+	}
+	start = now();
+	ly_set_merge(set, set2, 0);
+	merge_time = now() - start;
+
+	printf(" list : %.3fs\n set  : %.3fs\n merge: %.3fs\n", list_time, add_time, merge_time);
+
+	ly_set_free(set);
+	free(items);
+
+	return 0;
+}
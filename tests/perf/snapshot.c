@@ -0,0 +1,110 @@
+/**
+ * @file snapshot.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - creating a context by parsing the schemas and by loading a schema snapshot.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libyang/libyang.h>
+
+#define ROUNDS 20
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static struct ly_ctx *
+parse_ctx(const char *search_dir, int count, char *models[])
+{
+	struct ly_ctx *ctx;
+	const struct lys_module *mod;
+	int i;
+
+	ctx = ly_ctx_new(search_dir, 0);
+	if (!ctx) {
+		return NULL;
+	}
+
+	for (i = 0; i < count; ++i) {
+		mod = lys_parse_path(ctx, models[i], strstr(models[i], ".yin") ? LYS_IN_YIN : LYS_IN_YANG);
+		if (!mod) {
+			ly_ctx_destroy(ctx, NULL);
+			return NULL;
+		}
+		lys_features_enable(mod, "*");
+	}
+
+	return ctx;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	const char *path = "snapshot.lys";
+	double start, parse_time, load_time;
+	int i;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s search-dir model.yang|model.yin ...\n", argv[0]);
+		return 1;
+	}
+
+	/* cold start, parsing all the schemas */
+	start = now();
+	for (i = 0; i < ROUNDS; ++i) {
+		ctx = parse_ctx(argv[1], argc - 2, argv + 2);
+		if (!ctx) {
+			fprintf(stderr, "Failed to create context.\n");
+			return 1;
+		}
+		ly_ctx_destroy(ctx, NULL);
+	}
+	parse_time = (now() - start) / ROUNDS;
+
+	/* snapshot */
+	ctx = parse_ctx(argv[1], argc - 2, argv + 2);
+	if (!ctx || ly_ctx_print_snapshot(ctx, path)) {
+		fprintf(stderr, "Failed to create snapshot.\n");
+		ly_ctx_destroy(ctx, NULL);
+		return 1;
+	}
+	ly_ctx_destroy(ctx, NULL);
+
+	/* warm start, loading the snapshot */
+	start = now();
+	for (i = 0; i < ROUNDS; ++i) {
+		ctx = ly_ctx_new_snapshot(argv[1], path, 0);
+		if (!ctx) {
+			fprintf(stderr, "Failed to load snapshot.\n");
+			unlink(path);
+			return 1;
+		}
+		ly_ctx_destroy(ctx, NULL);
+	}
+	load_time = (now() - start) / ROUNDS;
+	unlink(path);
+
+	printf(" parse   : %.6fs\n snapshot: %.6fs (%.1fx)\n", parse_time, load_time, parse_time / load_time);
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file text.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - parsing long string values in XML and JSON data.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* default number of list instances */
+#define INSTANCES 20000
+
+/* length of the string values */
+#define VALUE_LEN 1000
+
+#define ROUNDS 5
+
+static const char *schema =
+	"module text {"
+		"namespace urn:libyang:performance:text;"
+		"prefix t;"
+		"container cont {"
+			"list item {"
+				"key name;"
+				"leaf name {"
+					"type string;"
+				"}"
+				"leaf descr {"
+					"type string;"
+				"}"
+			"}"
+		"}"
+	"}";
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *
+create_data(LYD_FORMAT format, int instances)
+{
+	char *data, *ptr, value[VALUE_LEN + 1];
+	int i;
+
+	/* plain ASCII text with a few spaces, as in descriptions */
+	for (i = 0; i < VALUE_LEN; ++i) {
+		value[i] = (i % 8 == 7) ? ' ' : 'a' + i % 26;
+	}
+	value[VALUE_LEN] = '\0';
+
+	data = malloc(instances * (VALUE_LEN + 128) + 128);
+	if (!data) {
+		return NULL;
+	}
+
+	ptr = data;
+	if (format == LYD_XML) {
+		ptr += sprintf(ptr, "<cont xmlns=\"urn:libyang:performance:text\">\n");
+		for (i = 0; i < instances; ++i) {
+			ptr += sprintf(ptr, "  <item>\n    <name>item%d</name>\n    <descr>%s</descr>\n  </item>\n", i, value);
+		}
+		sprintf(ptr, "</cont>\n");
+	} else {
+		ptr += sprintf(ptr, "{\n  \"text:cont\": {\n    \"item\": [\n");
+		for (i = 0; i < instances; ++i) {
+			ptr += sprintf(ptr, "      {\n        \"name\": \"item%d\",\n        \"descr\": \"%s\"\n      }%s\n", i, value,
+			               (i < instances - 1) ? "," : "");
+		}
+		sprintf(ptr, "    ]\n  }\n}\n");
+	}
+
+	return data;
+}
+
+static int
+run_parse(struct ly_ctx *ctx, LYD_FORMAT format, const char *name, int instances)
+{
+	struct lyd_node *data;
+	char *str;
+	double start, parse_time = 0;
+	int i;
+
+	str = create_data(format, instances);
+	if (!str) {
+		fprintf(stderr, "Failed to create the data.\n");
+		return 1;
+	}
+
+	for (i = 0; i < ROUNDS; ++i) {
+		start = now();
+		data = lyd_parse_mem(ctx, str, format, LYD_OPT_CONFIG | LYD_OPT_TRUSTED);
+		parse_time += now() - start;
+		if (!data) {
+			fprintf(stderr, "Failed to parse the data.\n");
+			free(str);
+			return 1;
+		}
+		lyd_free_withsiblings(data);
+	}
+
+	printf(" %-5s: %.6fs (%.1f MB/s)\n", name, parse_time / ROUNDS, strlen(str) / (parse_time / ROUNDS) / 1e6);
+	free(str);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	int instances, ret = 1;
+
+	instances = (argc > 1) ? atoi(argv[1]) : INSTANCES;
+	if (instances < 1) {
+		fprintf(stderr, "Usage: %s [instances]\n", argv[0]);
+		return 1;
+	}
+
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+	if (!lys_parse_mem(ctx, schema, LYS_IN_YANG)) {
+		fprintf(stderr, "Failed to load data model.\n");
+		goto cleanup;
+	}
+
+	if (run_parse(ctx, LYD_XML, "XML", instances) || run_parse(ctx, LYD_JSON, "JSON", instances)) {
+		goto cleanup;
+	}
+	ret = 0;
+
+cleanup:
+	ly_ctx_destroy(ctx, NULL);
+	return ret;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file tmpl.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - creating and updating data nodes with paths and with compiled path templates.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* number of list instances, each with all the counters */
+#define INSTANCES 10000
+
+static const char *schema =
+	"module tmpl {"
+		"namespace urn:libyang:performance:tmpl;"
+		"prefix t;"
+		"container interfaces {"
+			"list interface {"
+				"key \"name\";"
+				"leaf name { type string; }"
+				"container statistics {"
+					"leaf in-octets { type uint64; }"
+					"leaf out-octets { type uint64; }"
+					"leaf in-errors { type uint32; }"
+					"leaf out-errors { type uint32; }"
+				"}"
+			"}"
+		"}"
+	"}";
+
+static const char *counters[] = {"in-octets", "out-octets", "in-errors", "out-errors"};
+
+#define COUNTERS (sizeof counters / sizeof *counters)
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* create (or update) all the counters of all the instances */
+static double
+fill(struct ly_ctx *ctx, struct lyd_node **data, struct lyd_path_tmpl **tmpls, int instances, int options)
+{
+	struct lyd_node *node;
+	const char *values[1];
+	char path[128], name[32], value[32];
+	double start;
+	int i;
+	unsigned int j;
+
+	start = now();
+	for (i = 0; i < instances; ++i) {
+		sprintf(name, "eth%d", i);
+		sprintf(value, "%d", i * 1000 + options);
+		for (j = 0; j < COUNTERS; ++j) {
+			if (tmpls) {
+				values[0] = name;
+				node = lyd_path_tmpl_new(*data, tmpls[j], values, value, options);
+			} else {
+				sprintf(path, "/tmpl:interfaces/interface[name='%s']/statistics/%s", name, counters[j]);
+				node = lyd_new_path(*data, ctx, path, value, 0, options);
+			}
+			if (!node) {
+				fprintf(stderr, "Failed to create a node.\n");
+				exit(1);
+			}
+			if (!*data) {
+				*data = node;
+			}
+		}
+	}
+
+	return now() - start;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	struct lyd_node *data = NULL, *tmpl_data = NULL;
+	struct lyd_path_tmpl *tmpls[COUNTERS];
+	char path[128];
+	double path_time, tmpl_time, path_upd_time, tmpl_upd_time;
+	int instances = INSTANCES;
+	unsigned int j;
+
+	if (argc > 1) {
+		instances = atoi(argv[1]);
+	}
+
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx || !lys_parse_mem(ctx, schema, LYS_IN_YANG)) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+	for (j = 0; j < COUNTERS; ++j) {
+		sprintf(path, "/tmpl:interfaces/interface[name=?]/statistics/%s", counters[j]);
+		tmpls[j] = lyd_path_tmpl_compile(ctx, path, 0);
+		if (!tmpls[j]) {
+			fprintf(stderr, "Failed to compile a template.\n");
+			return 1;
+		}
+	}
+
+	path_time = fill(ctx, &data, NULL, instances, 0);
+	tmpl_time = fill(ctx, &tmpl_data, tmpls, instances, 0);
+	path_upd_time = fill(ctx, &data, NULL, instances, LYD_PATH_OPT_UPDATE);
+	tmpl_upd_time = fill(ctx, &tmpl_data, tmpls, instances, LYD_PATH_OPT_UPDATE);
+
+	printf(" create path    : %.6fs\n create template: %.6fs (%.1fx)\n", path_time, tmpl_time, path_time / tmpl_time);
+	printf(" update path    : %.6fs\n update template: %.6fs (%.1fx)\n", path_upd_time, tmpl_upd_time,
+	       path_upd_time / tmpl_upd_time);
+
+	for (j = 0; j < COUNTERS; ++j) {
+		lyd_path_tmpl_free(tmpls[j]);
+	}
+	lyd_free_withsiblings(data);
+	lyd_free_withsiblings(tmpl_data);
+	ly_ctx_destroy(ctx, NULL);
+	return 0;
+}
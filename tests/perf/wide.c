@@ -0,0 +1,207 @@
+/**
+ * @file wide.c
+ * @author Michal Vasko <mvasko@cesnet.cz>
+ * @brief performance test - parsing, finding and creating data of a list with hundreds of children,
+ * some of them in a choice and a grouping.
+ *
+ * Copyright (c) 2019 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+/* default number of list instances */
+#define INSTANCES 200
+
+/* number of the list children besides the key, a half directly in the list,
+ * a quarter in a choice and a quarter in a grouping */
+#define CHILDREN 500
+
+#define ROUNDS 5
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char *
+child_name(int i, char *name)
+{
+	if (i < CHILDREN / 2) {
+		sprintf(name, "f%d", i);
+	} else if (i < 3 * CHILDREN / 4) {
+		sprintf(name, "c%d", i);
+	} else {
+		sprintf(name, "g%d", i);
+	}
+	return name;
+}
+
+static char *
+create_schema(void)
+{
+	char *schema, *ptr, name[16];
+	int i;
+
+	schema = malloc(CHILDREN * 48 + 512);
+	if (!schema) {
+		return NULL;
+	}
+
+	ptr = schema;
+	ptr += sprintf(ptr, "module wide {namespace urn:libyang:performance:wide; prefix w; grouping g {");
+	for (i = 3 * CHILDREN / 4; i < CHILDREN; ++i) {
+		ptr += sprintf(ptr, "leaf %s {type string;}", child_name(i, name));
+	}
+	ptr += sprintf(ptr, "} container cont {list item {key name; leaf name {type string;}");
+	for (i = 0; i < CHILDREN / 2; ++i) {
+		ptr += sprintf(ptr, "leaf %s {type string;}", child_name(i, name));
+	}
+	ptr += sprintf(ptr, "choice ch {case a {");
+	for (i = CHILDREN / 2; i < 3 * CHILDREN / 4; ++i) {
+		ptr += sprintf(ptr, "leaf %s {type string;}", child_name(i, name));
+	}
+	sprintf(ptr, "}} uses g;}}}");
+
+	return schema;
+}
+
+static struct lyd_node *
+create_data(struct ly_ctx *ctx, int instances)
+{
+	struct lyd_node *data, *item;
+	char name[16], value[16];
+	int i, j;
+
+	data = lyd_new_path(NULL, ctx, "/wide:cont", NULL, 0, 0);
+	if (!data) {
+		return NULL;
+	}
+
+	for (i = 0; i < instances; ++i) {
+		sprintf(value, "item%d", i);
+		item = lyd_new(data, NULL, "item");
+		if (!item || !lyd_new_leaf(item, NULL, "name", value)) {
+			lyd_free(data);
+			return NULL;
+		}
+		for (j = 0; j < CHILDREN; ++j) {
+			if (!lyd_new_leaf(item, NULL, child_name(j, name), value)) {
+				lyd_free(data);
+				return NULL;
+			}
+		}
+	}
+
+	return data;
+}
+
+static int
+run_parse(struct ly_ctx *ctx, struct lyd_node *data, LYD_FORMAT format, const char *name)
+{
+	struct lyd_node *parsed;
+	char *str;
+	double start, parse_time = 0;
+	int i;
+
+	if (lyd_print_mem(&str, data, format, LYP_WITHSIBLINGS)) {
+		fprintf(stderr, "Failed to print the data.\n");
+		return 1;
+	}
+
+	for (i = 0; i < ROUNDS; ++i) {
+		start = now();
+		parsed = lyd_parse_mem(ctx, str, format, LYD_OPT_CONFIG | LYD_OPT_TRUSTED);
+		parse_time += now() - start;
+		if (!parsed) {
+			fprintf(stderr, "Failed to parse the data.\n");
+			free(str);
+			return 1;
+		}
+		lyd_free_withsiblings(parsed);
+	}
+
+	printf(" parse %-4s  : %.6fs\n", name, parse_time / ROUNDS);
+	free(str);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ly_ctx *ctx;
+	struct lyd_node *data = NULL;
+	char *schema, path[64], name[16];
+	double start, find_time = 0, new_time = 0;
+	int i, j, instances, ret = 1;
+
+	instances = (argc > 1) ? atoi(argv[1]) : INSTANCES;
+	if (instances < 1) {
+		fprintf(stderr, "Usage: %s [instances]\n", argv[0]);
+		return 1;
+	}
+
+	ctx = ly_ctx_new(NULL, 0);
+	if (!ctx) {
+		fprintf(stderr, "Failed to create context.\n");
+		return 1;
+	}
+	schema = create_schema();
+	if (!schema || !lys_parse_mem(ctx, schema, LYS_IN_YANG)) {
+		fprintf(stderr, "Failed to load data model.\n");
+		free(schema);
+		goto cleanup;
+	}
+	free(schema);
+
+	/* creating every child of every instance */
+	start = now();
+	data = create_data(ctx, instances);
+	new_time = now() - start;
+	if (!data) {
+		fprintf(stderr, "Failed to create the data.\n");
+		goto cleanup;
+	}
+
+	/* finding every child schema node */
+	for (i = 0; i < ROUNDS; ++i) {
+		start = now();
+		for (j = 0; j < CHILDREN; ++j) {
+			sprintf(path, "/wide:cont/item/%s", child_name(j, name));
+			if (!ly_ctx_get_node(ctx, NULL, path, 0)) {
+				fprintf(stderr, "Failed to find \"%s\".\n", path);
+				goto cleanup;
+			}
+		}
+		find_time += now() - start;
+	}
+
+	printf(" new         : %.6fs (%d nodes)\n get node    : %.6fs (%d paths)\n", new_time,
+	       instances * (CHILDREN + 1), find_time / ROUNDS, CHILDREN);
+
+	if (run_parse(ctx, data, LYD_XML, "XML") || run_parse(ctx, data, LYD_JSON, "JSON")
+			|| run_parse(ctx, data, LYD_LYB, "LYB")) {
+		goto cleanup;
+	}
+	ret = 0;
+
+cleanup:
+	lyd_free_withsiblings(data);
+	ly_ctx_destroy(ctx, NULL);
+	return ret;
+}